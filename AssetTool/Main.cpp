@@ -0,0 +1,2932 @@
+//--------------------------------------------------------------------------------------
+// AssetTool: offline asset cooking for Tutorial04.
+//
+//   AssetTool encode <in.dds> <out.dds> [-f BC1|BC3|BC5|BC7] [-q fast|normal|best] [-m box|kaiser] [-srgb]
+//   AssetTool mipbench [size]
+//   AssetTool pack <out.arc> [-lz] <files...>
+//   AssetTool openbench <archive.arc> <files...>
+//   AssetTool compress <in.dds> <out.dds> [-chunk KB] [-high]
+//   AssetTool lzbench <files...>
+//   AssetTool meshbench [vertices]
+//   AssetTool meshopt [segments]
+//   AssetTool quantize <file.mesh>
+//   AssetTool simplify [segments]
+//   AssetTool meshlets [segments]
+//   AssetTool tangents [segments]
+//   AssetTool arenas [operations]
+//   AssetTool objbench [file.obj | MB]
+//   AssetTool scenebench [entities]
+//   AssetTool transforms [count]
+//   AssetTool statecache [entities]
+//   AssetTool drawsort [packets]
+//   AssetTool ring [allocations]
+//   AssetTool bcdecode [size]
+//   AssetTool texcache [operations]
+//   AssetTool loadqueue [files]
+//
+// encode compresses an uncompressed 32bpp DDS into a block-compressed one. Existing mips
+// are encoded as they are; a source without mips gets a chain from GenerateMipChain.
+// Throughput and the PSNR of the decoded result against the source are printed per file.
+//
+// mipbench times GenerateMipChain against naive scalar downsampling on a synthetic image.
+//
+// pack writes the files into an asset archive under the names given on the command line,
+// so run it from the directory the game loads from. DDS files without mips are stored
+// with a generated chain, so the game can create them straight from the mapping. With -lz
+// they are stored LZ-chunked as compress writes them, and expanded when loaded.
+//
+// openbench times opening and reading the files loose against finding them in an archive.
+// The first pass is only cold if the file cache was flushed before running it.
+//
+// compress writes a DDS file LZ-chunked (see LZCodec.h), which the loaders read as they
+// read a plain one. -high packs smaller and slower and decodes just as fast.
+//
+// lzbench prints the ratio and the compress and decompress throughput of both levels per
+// file, with decoding on one thread and on the pool, against reading the file loose.
+//
+// meshbench times InterleaveVertices against the per-vertex push_back loop the sphere
+// loader used, on synthetic attribute streams.
+//
+// meshopt runs the MeshOptimize passes over a UV sphere whose triangles were shuffled and
+// prints the time of each and the ACMR and ATVR it leaves.
+//
+// quantize encodes the vertices of a cooked mesh (Sphere.obj.mesh after a run of the game)
+// as CompactVertex and prints the size saved and the largest error per attribute.
+//
+// simplify times SimplifyMesh on a UV sphere at a range of error bounds, printing the
+// triangles each keeps, then prints the level-of-detail chain BuildLodChain cooks from it.
+//
+// meshlets times BuildMeshlets on a UV sphere, then CullMeshlets from cameras around and
+// inside it, printing the share of triangles culled. Each culled meshlet is checked
+// triangle by triangle against the rasterizer's own facing and clipping rules.
+//
+// tangents times GenerateTangents on a UV sphere on one thread and on the pool, and prints
+// the largest angle between the tangents and bitangents it builds and the sphere's exact
+// ones, away from the poles where those are undefined.
+//
+// arenas checks the OffsetAllocator behind MeshRegistry against a map of which units are
+// in use, over random allocations and frees of mesh-like sizes, then times the same
+// sequence unchecked. It returns 1 if a range was handed out twice, the free total drifted
+// or the free ranges did not merge back into one.
+//
+// objbench times Assimp's ReadFile on an OBJ file against ReadObj on one thread and on the
+// pool, and checks that every triangle corner comes out with the same attributes. Without
+// a file it writes a UV sphere of about that many MB (100 by default) to objbench.obj and
+// deletes it afterwards.
+//
+// scenebench generates scenes of 1k, 10k and 100k entities (or the count given) as scene
+// text, then times parsing it, reading it back cooked and walking the entities the way
+// Render does, sorting their draws first. It returns 1 if the cooked scene does not match the parsed one.
+//
+// transforms times TransformSystem::Update over 100k transforms (or the count given), flat
+// and in chains of four, with all of them moved, one in a hundred and none, on one thread
+// and on the pool, against building each matrix from XMMatrixScaling, the three rotations
+// and XMMatrixTranslation. It returns 1 if the matrices differ from those.
+//
+// statecache makes a million random binding calls, then two frames of a generated scene
+// of 10k entities (or the count given) the way Render makes them, once straight to a
+// context that records them and once through a StateCache in front of it. It prints the
+// calls the cache issued and filtered, and returns 1 if any draw saw different state.
+//
+// drawsort times DrawQueue::Sort on 100k draw packets (or the count given) against
+// std::stable_sort, and prints the material changes drawing them in either order makes.
+// It returns 1 if the two orders differ.
+//
+// ring checks the RingAllocator behind ConstantRing over a million random allocations (or
+// the count given) in rings of several sizes and alignments, against a map of the bytes
+// each pass has handed out, then the edge cases: a ring filled exactly, sizes of 0 and
+// larger than the ring, and Reset. It prints the constant bytes each draw uploads and how
+// often a frame's ring wraps, and returns 1 if a range was misaligned, out of the ring,
+// handed out twice in one pass, or wrapped when it still fit or did not when it no longer did.
+//
+// bcdecode decodes a block of every format whose pixels were worked out from the format
+// descriptions, BC1's three-colour mode, BC3/BC4/BC5's six-value mode and two BC7 modes
+// among them, then times DecodeBCSurface per format on a 1024x1024 surface (or the size
+// given) of random blocks. It returns 1 if a block decodes to anything else.
+//
+// texcache drives a TextureCache over a device that only counts views: finds by path and
+// by content, a failed create and evictions by insert and by SetBudget, then 100k random
+// finds and inserts (or the count given), some of them new paths to cached data, against
+// a model of the LRU list. It returns 1 if the hit, miss and eviction counts, the resident
+// bytes or the live views differ from what the model says, or if the cache ends up over
+// its budget.
+//
+// loadqueue writes 256 small DDS files (or the count given) and loads them through a
+// TextureLoadQueue into a sink that creates nothing, with some missing, corrupt, refused
+// by the sink or already held by it. It returns 1 if the ready queue grows past its bound
+// or does not hold the readers back while nothing is pumped, if a future is left unset or
+// carries the wrong result, or if the sink is handed anything but the file with its mips.
+//--------------------------------------------------------------------------------------
+#include <windows.h>
+#include <DirectXPackedVector.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AssetArchive.h"
+#include "BCDecode.h"
+#include "BCEncode.h"
+#include "DDS.h"
+#include "DDSTextureLoader.h"
+#include "DrawQueue.h"
+#include "Hash.h"
+#include "LZCodec.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshCluster.h"
+#include "MeshConvert.h"
+#include "MeshOptimize.h"
+#include "OffsetAllocator.h"
+#include "MeshSimplify.h"
+#include "MeshTangents.h"
+#include "MipGenerator.h"
+#include "ObjReader.h"
+#include "RingAllocator.h"
+#include "SceneStore.h"
+#include "StateCache.h"
+#include "TextureCache.h"
+#include "TextureLoadQueue.h"
+#include "ThreadPool.h"
+#include "TransformSystem.h"
+#include "VertexQuantize.h"
+
+namespace
+{
+	const wchar_t* const s_usage =
+		L"usage: AssetTool encode <in.dds> <out.dds> [-f BC1|BC3|BC5|BC7] [-q fast|normal|best] [-m box|kaiser] [-srgb]\n"
+		L"       AssetTool mipbench [size]\n"
+		L"       AssetTool pack <out.arc> [-lz] <files...>\n"
+		L"       AssetTool openbench <archive.arc> <files...>\n"
+		L"       AssetTool compress <in.dds> <out.dds> [-chunk KB] [-high]\n"
+		L"       AssetTool lzbench <files...>\n"
+		L"       AssetTool meshbench [vertices]\n"
+		L"       AssetTool meshopt [segments]\n"
+		L"       AssetTool quantize <file.mesh>\n"
+		L"       AssetTool simplify [segments]\n"
+		L"       AssetTool meshlets [segments]\n"
+		L"       AssetTool tangents [segments]\n"
+		L"       AssetTool arenas [operations]\n"
+		L"       AssetTool objbench [file.obj | MB]\n"
+		L"       AssetTool scenebench [entities]\n"
+		L"       AssetTool transforms [count]\n"
+		L"       AssetTool statecache [entities]\n"
+		L"       AssetTool drawsort [packets]\n"
+		L"       AssetTool ring [allocations]\n"
+		L"       AssetTool bcdecode [size]\n"
+		L"       AssetTool texcache [operations]\n"
+		L"       AssetTool loadqueue [files]\n";
+
+	struct Image
+	{
+		size_t width;
+		size_t height;
+		std::vector<uint8_t> rgba;
+	};
+
+	unsigned int MaskShift(const uint32_t mask)
+	{
+		unsigned int shift = 0;
+		while (shift < 32 && !(mask & (1u << shift)))
+			++shift;
+		return shift;
+	}
+
+	// Reads every mip of an uncompressed 32bpp DDS into RGBA8, whatever order its channel
+	// masks put the bytes in
+	HRESULT LoadRGBAMips(const wchar_t* fileName, std::vector<Image>& mips)
+	{
+		MappedFile file;
+		HRESULT hr = file.Open(fileName);
+		if (FAILED(hr))
+			return hr;
+
+		if (file.Size() < sizeof(uint32_t) + sizeof(DDS_HEADER) || *reinterpret_cast<const uint32_t*>(file.Data()) != DDS_MAGIC)
+			return E_FAIL;
+
+		const DDS_HEADER* header = reinterpret_cast<const DDS_HEADER*>(file.Data() + sizeof(uint32_t));
+		if (!(header->ddspf.flags & DDS_RGB) || header->ddspf.RGBBitCount != 32 || (header->caps2 & DDS_CUBEMAP) ||
+		    (header->flags & DDS_HEADER_FLAGS_VOLUME))
+		{
+			wprintf(L"%s: only uncompressed 32bpp 2D textures can be encoded\n", fileName);
+			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+		}
+
+		const uint32_t masks[4] = { header->ddspf.RBitMask, header->ddspf.GBitMask, header->ddspf.BBitMask,
+		                            (header->ddspf.flags & DDS_ALPHAPIXELS) ? header->ddspf.ABitMask : 0 };
+		const size_t mipCount = (header->flags & DDS_HEADER_FLAGS_MIPMAP) ? std::max<uint32_t>(header->mipMapCount, 1) : 1;
+
+		const uint8_t* bits = file.Data() + sizeof(uint32_t) + sizeof(DDS_HEADER);
+		const uint8_t* const end = file.Data() + file.Size();
+		size_t width = header->width;
+		size_t height = header->height;
+		mips.resize(mipCount);
+		for (size_t level = 0; level < mipCount; ++level)
+		{
+			const size_t pixelCount = width * height;
+			if (static_cast<size_t>(end - bits) < pixelCount * 4)
+				return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+			Image& image = mips[level];
+			image.width = width;
+			image.height = height;
+			image.rgba.resize(pixelCount * 4);
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				const uint32_t pixel = reinterpret_cast<const uint32_t*>(bits)[i];
+				for (int c = 0; c < 4; ++c)
+					image.rgba[i * 4 + c] = masks[c] ? static_cast<uint8_t>((pixel & masks[c]) >> MaskShift(masks[c])) : (c == 3 ? 255 : 0);
+			}
+
+			bits += pixelCount * 4;
+			width = std::max<size_t>(width / 2, 1);
+			height = std::max<size_t>(height / 2, 1);
+		}
+		return S_OK;
+	}
+
+	// The baseline mipbench measures against: a byte-wise 2x2 average of each level, one
+	// thread, no gamma handling. Odd edges reuse their last row or column.
+	void NaiveMipChain(std::vector<Image>& mips)
+	{
+		while (mips.back().width > 1 || mips.back().height > 1)
+		{
+			const Image& source = mips.back();
+			Image mip;
+			mip.width = std::max<size_t>(source.width / 2, 1);
+			mip.height = std::max<size_t>(source.height / 2, 1);
+			mip.rgba.resize(mip.width * mip.height * 4);
+
+			for (size_t y = 0; y < mip.height; ++y)
+			{
+				const size_t y0 = std::min(y * 2, source.height - 1);
+				const size_t y1 = std::min(y * 2 + 1, source.height - 1);
+				for (size_t x = 0; x < mip.width; ++x)
+				{
+					const size_t x0 = std::min(x * 2, source.width - 1);
+					const size_t x1 = std::min(x * 2 + 1, source.width - 1);
+					for (size_t c = 0; c < 4; ++c)
+					{
+						const unsigned int sum = source.rgba[(y0 * source.width + x0) * 4 + c] + source.rgba[(y0 * source.width + x1) * 4 + c] +
+						                         source.rgba[(y1 * source.width + x0) * 4 + c] + source.rgba[(y1 * source.width + x1) * 4 + c];
+						mip.rgba[(y * mip.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+			mips.push_back(std::move(mip));
+		}
+	}
+
+	HRESULT BuildMipChain(std::vector<Image>& mips, const MIP_FILTER filter, const bool srgb, ThreadPool* pool)
+	{
+		const Image top = std::move(mips[0]);
+		std::vector<uint8_t> chain(MipChainSize(DXGI_FORMAT_R8G8B8A8_UNORM, top.width, top.height, 1));
+		const HRESULT hr = GenerateMipChain(DXGI_FORMAT_R8G8B8A8_UNORM, top.width, top.height, 1, top.rgba.data(), filter, srgb, chain.data(), pool);
+		if (FAILED(hr))
+			return hr;
+
+		mips.resize(MipLevelCount(top.width, top.height));
+		const uint8_t* bits = chain.data();
+		size_t width = top.width;
+		size_t height = top.height;
+		for (Image& mip : mips)
+		{
+			mip.width = width;
+			mip.height = height;
+			mip.rgba.assign(bits, bits + width * height * 4);
+			bits += width * height * 4;
+			width = std::max<size_t>(width / 2, 1);
+			height = std::max<size_t>(height / 2, 1);
+		}
+		return S_OK;
+	}
+
+	int Encode(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		const wchar_t* inputName = argv[0];
+		const wchar_t* outputName = argv[1];
+		const wchar_t* formatName = L"BC7";
+		BC_ENCODE_QUALITY quality = BC_ENCODE_NORMAL;
+		MIP_FILTER mipFilter = MIP_FILTER_KAISER;
+		bool srgb = false;
+		for (int i = 2; i < argc; ++i)
+		{
+			if (_wcsicmp(argv[i], L"-f") == 0 && i + 1 < argc)
+				formatName = argv[++i];
+			else if (_wcsicmp(argv[i], L"-q") == 0 && i + 1 < argc)
+			{
+				++i;
+				quality = _wcsicmp(argv[i], L"fast") == 0 ? BC_ENCODE_FAST : _wcsicmp(argv[i], L"best") == 0 ? BC_ENCODE_BEST : BC_ENCODE_NORMAL;
+			}
+			else if (_wcsicmp(argv[i], L"-m") == 0 && i + 1 < argc)
+				mipFilter = _wcsicmp(argv[++i], L"box") == 0 ? MIP_FILTER_BOX : MIP_FILTER_KAISER;
+			else if (_wcsicmp(argv[i], L"-srgb") == 0)
+				srgb = true;
+			else
+			{
+				wprintf(L"unknown option %s\n", argv[i]);
+				return 1;
+			}
+		}
+
+		// Channels that take part in the PSNR: BC5 only keeps red and green
+		DXGI_FORMAT format;
+		uint32_t fourCC;
+		int channels = 4;
+		if (_wcsicmp(formatName, L"BC1") == 0)
+		{
+			format = srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+			fourCC = MAKEFOURCC('D', 'X', 'T', '1');
+		}
+		else if (_wcsicmp(formatName, L"BC3") == 0)
+		{
+			format = srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+			fourCC = MAKEFOURCC('D', 'X', 'T', '5');
+		}
+		else if (_wcsicmp(formatName, L"BC5") == 0 && !srgb)
+		{
+			format = DXGI_FORMAT_BC5_UNORM;
+			fourCC = MAKEFOURCC('A', 'T', 'I', '2');
+			channels = 2;
+		}
+		else if (_wcsicmp(formatName, L"BC7") == 0)
+		{
+			format = srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+			fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		}
+		else
+		{
+			wprintf(L"unsupported format %s%s\n", formatName, srgb ? L" with -srgb" : L"");
+			return 1;
+		}
+
+		// sRGB variants have no legacy FourCC
+		if (srgb)
+			fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		std::vector<Image> mips;
+		HRESULT hr = LoadRGBAMips(inputName, mips);
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: could not be read (0x%08X)\n", inputName, static_cast<unsigned int>(hr));
+			return 1;
+		}
+		ThreadPool pool;
+		if (mips.size() == 1)
+		{
+			hr = BuildMipChain(mips, mipFilter, srgb, &pool);
+			if (FAILED(hr))
+			{
+				wprintf(L"mip generation failed (0x%08X)\n", static_cast<unsigned int>(hr));
+				return 1;
+			}
+		}
+
+		const size_t blockBytes = format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB ? 8 : 16;
+
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | (mips.size() > 1 ? DDS_HEADER_FLAGS_MIPMAP : 0);
+		header.height = static_cast<uint32_t>(mips[0].height);
+		header.width = static_cast<uint32_t>(mips[0].width);
+		header.pitchOrLinearSize = static_cast<uint32_t>(((mips[0].width + 3) / 4) * ((mips[0].height + 3) / 4) * blockBytes);
+		header.mipMapCount = static_cast<uint32_t>(mips.size());
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = fourCC;
+		header.caps = DDS_SURFACE_FLAGS_TEXTURE | (mips.size() > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+		std::vector<uint8_t> output(sizeof(uint32_t) + sizeof(DDS_HEADER));
+		memcpy(output.data(), &DDS_MAGIC, sizeof(uint32_t));
+		memcpy(output.data() + sizeof(uint32_t), &header, sizeof(DDS_HEADER));
+		if (fourCC == MAKEFOURCC('D', 'X', '1', '0'))
+		{
+			DDS_HEADER_DXT10 extended = {};
+			extended.dxgiFormat = format;
+			extended.resourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+			extended.arraySize = 1;
+			output.resize(output.size() + sizeof(DDS_HEADER_DXT10));
+			memcpy(output.data() + output.size() - sizeof(DDS_HEADER_DXT10), &extended, sizeof(DDS_HEADER_DXT10));
+		}
+
+		double encodeSeconds = 0.0;
+		double squaredError = 0.0;
+		size_t pixelCount = 0;
+		std::vector<uint8_t> decoded;
+		for (const Image& mip : mips)
+		{
+			const size_t rowPitch = ((mip.width + 3) / 4) * blockBytes;
+			const size_t offset = output.size();
+			output.resize(offset + rowPitch * ((mip.height + 3) / 4));
+
+			const auto start = std::chrono::steady_clock::now();
+			hr = EncodeBCSurface(format, mip.width, mip.height, mip.rgba.data(), mip.width * 4, quality, output.data() + offset, rowPitch, &pool);
+			encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (FAILED(hr))
+			{
+				wprintf(L"encoding failed (0x%08X)\n", static_cast<unsigned int>(hr));
+				return 1;
+			}
+
+			D3D11_SUBRESOURCE_DATA source = { output.data() + offset, static_cast<UINT>(rowPitch), 0 };
+			decoded.resize(mip.rgba.size());
+			DecodeBCSurface(format, mip.width, mip.height, source, BC_DECODE_RGBA8, decoded.data(), mip.width * 4);
+			for (size_t i = 0; i < decoded.size(); i += 4)
+			{
+				for (int c = 0; c < channels; ++c)
+				{
+					const double difference = static_cast<double>(decoded[i + c]) - mip.rgba[i + c];
+					squaredError += difference * difference;
+				}
+			}
+			pixelCount += mip.width * mip.height;
+		}
+
+		hr = WriteWholeFile(outputName, output.data(), output.size());
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: could not be written (0x%08X)\n", outputName, static_cast<unsigned int>(hr));
+			return 1;
+		}
+
+		const double meanSquaredError = squaredError / (static_cast<double>(pixelCount) * channels);
+		const double psnr = meanSquaredError > 0.0 ? 10.0 * log10(255.0 * 255.0 / meanSquaredError) : 99.0;
+		wprintf(L"%s -> %s: %s, %zu mips, %.1f MPixels/s on %u threads, PSNR %.2f dB\n", inputName, outputName, formatName, mips.size(),
+		        pixelCount / encodeSeconds / 1e6, pool.ThreadCount() + 1, psnr);
+		return 0;
+	}
+
+	// Best of a few runs, in milliseconds
+	template <typename Function>
+	double TimeBest(const Function& function)
+	{
+		double best = 1e30;
+		for (int run = 0; run < 5; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	int MipBench(int argc, wchar_t* argv[])
+	{
+		const size_t size = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 2048;
+
+		// Fine stripes over a gradient, so the filters have detail to remove
+		Image top;
+		top.width = top.height = size;
+		top.rgba.resize(size * size * 4);
+		for (size_t y = 0; y < size; ++y)
+		{
+			for (size_t x = 0; x < size; ++x)
+			{
+				uint8_t* texel = &top.rgba[(y * size + x) * 4];
+				texel[0] = static_cast<uint8_t>(x * 255 / size);
+				texel[1] = static_cast<uint8_t>(y * 255 / size);
+				texel[2] = ((x + y) & 2) ? 255 : 0;
+				texel[3] = 255;
+			}
+		}
+
+		ThreadPool pool;
+		std::vector<uint8_t> chain(MipChainSize(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1));
+		const double megapixels = static_cast<double>(size * size) / 1e6;
+
+		const double naive = TimeBest([&]
+		{
+			std::vector<Image> mips(1, top);
+			NaiveMipChain(mips);
+		});
+		wprintf(L"%zux%zu RGBA8, %u threads\n", size, size, pool.ThreadCount() + 1);
+		wprintf(L"  %-26s %8.2f ms %8.1f MPixels/s\n", L"naive scalar box", naive, megapixels / naive * 1000.0);
+
+		const struct
+		{
+			const wchar_t* name;
+			MIP_FILTER filter;
+			bool srgb;
+		} runs[] =
+		{
+			{ L"box", MIP_FILTER_BOX, false },
+			{ L"box, sRGB", MIP_FILTER_BOX, true },
+			{ L"kaiser", MIP_FILTER_KAISER, false },
+			{ L"kaiser, sRGB", MIP_FILTER_KAISER, true },
+		};
+
+		for (const auto& run : runs)
+		{
+			for (ThreadPool* threads : { static_cast<ThreadPool*>(nullptr), &pool })
+			{
+				const double ms = TimeBest([&]
+				{
+					GenerateMipChain(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, top.rgba.data(), run.filter, run.srgb, chain.data(), threads);
+				});
+				wprintf(L"  %-16s %-9s %8.2f ms %8.1f MPixels/s  %5.2fx\n", run.name, threads ? L"threaded" : L"1 thread",
+				        ms, megapixels / ms * 1000.0, naive / ms);
+			}
+		}
+		return 0;
+	}
+
+	int Pack(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		const wchar_t* archiveName = argv[0];
+		const bool compress = _wcsicmp(argv[1], L"-lz") == 0;
+		const int firstInput = compress ? 2 : 1;
+		if (argc <= firstInput)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		struct Input
+		{
+			std::wstring name;
+			uint64_t hash;
+			std::vector<uint8_t> data;
+		};
+
+		ThreadPool pool;
+		std::vector<Input> inputs;
+		for (int i = firstInput; i < argc; ++i)
+		{
+			Input input;
+			input.name = AssetArchive::NormalizeName(argv[i]);
+			input.hash = AssetArchive::HashName(input.name);
+			if (input.name.size() > 0xFFFF)
+			{
+				wprintf(L"%s: name too long\n", argv[i]);
+				return 1;
+			}
+
+			for (const Input& other : inputs)
+			{
+				if (other.name == input.name)
+				{
+					wprintf(L"%s: given twice\n", argv[i]);
+					return 1;
+				}
+			}
+
+			MappedFile file;
+			HRESULT hr = file.Open(argv[i]);
+			if (FAILED(hr))
+			{
+				wprintf(L"%s: could not be read (0x%08X)\n", argv[i], static_cast<unsigned int>(hr));
+				return 1;
+			}
+
+			const wchar_t* extension = wcsrchr(argv[i], L'.');
+			if (extension && _wcsicmp(extension, L".dds") == 0)
+			{
+				std::unique_ptr<uint8_t[]> ddsData(new (std::nothrow) uint8_t[file.Size()]);
+				if (!ddsData)
+					return 1;
+				memcpy(ddsData.get(), file.Data(), file.Size());
+
+				size_t ddsDataSize = file.Size();
+				hr = DirectX::GenerateDDSMipChain(ddsData, &ddsDataSize, MIP_FILTER_KAISER, false, &pool);
+				if (FAILED(hr))
+				{
+					wprintf(L"%s: mip generation failed (0x%08X)\n", argv[i], static_cast<unsigned int>(hr));
+					return 1;
+				}
+				if (hr == S_OK)
+					wprintf(L"%s: generated mips\n", argv[i]);
+
+				if (compress)
+				{
+					hr = LZCompressChunked(ddsData.get(), ddsDataSize, LZ_DEFAULT_CHUNK_SIZE, LZ_LEVEL_HIGH, input.data, &pool);
+					if (FAILED(hr))
+					{
+						wprintf(L"%s: compression failed (0x%08X)\n", argv[i], static_cast<unsigned int>(hr));
+						return 1;
+					}
+				}
+				else
+				{
+					input.data.assign(ddsData.get(), ddsData.get() + ddsDataSize);
+				}
+			}
+			else
+			{
+				input.data.assign(file.Data(), file.Data() + file.Size());
+			}
+			inputs.push_back(std::move(input));
+		}
+
+		std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) { return a.hash < b.hash; });
+
+		size_t nameChars = 0;
+		for (const Input& input : inputs)
+			nameChars += input.name.size();
+
+		const auto align = [](const size_t offset) { return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~(ASSET_ARCHIVE_ALIGNMENT - 1); };
+
+		ASSET_ARCHIVE_HEADER header = {};
+		header.magic = ASSET_ARCHIVE_MAGIC;
+		header.version = ASSET_ARCHIVE_VERSION;
+		header.entryCount = static_cast<uint32_t>(inputs.size());
+		header.tocOffset = sizeof(ASSET_ARCHIVE_HEADER);
+		header.namesOffset = header.tocOffset + inputs.size() * sizeof(ASSET_ARCHIVE_ENTRY);
+		header.namesSize = nameChars * sizeof(uint16_t);
+
+		std::vector<ASSET_ARCHIVE_ENTRY> entries(inputs.size());
+		std::vector<uint16_t> names;
+		names.reserve(nameChars);
+		size_t offset = align(static_cast<size_t>(header.namesOffset + header.namesSize));
+		for (size_t i = 0; i < inputs.size(); ++i)
+		{
+			ASSET_ARCHIVE_ENTRY& entry = entries[i];
+			entry.nameHash = inputs[i].hash;
+			entry.offset = offset;
+			entry.storedSize = inputs[i].data.size();
+			entry.size = inputs[i].data.size();
+			entry.nameOffset = static_cast<uint32_t>(names.size());
+			entry.nameLength = static_cast<uint16_t>(inputs[i].name.size());
+			entry.compression = ASSET_COMPRESSION_NONE;
+			names.insert(names.end(), inputs[i].name.begin(), inputs[i].name.end());
+			offset = align(offset + inputs[i].data.size());
+		}
+
+		std::vector<uint8_t> archive(offset, 0);
+		memcpy(archive.data(), &header, sizeof(header));
+		memcpy(archive.data() + header.tocOffset, entries.data(), entries.size() * sizeof(ASSET_ARCHIVE_ENTRY));
+		memcpy(archive.data() + header.namesOffset, names.data(), names.size() * sizeof(uint16_t));
+		for (size_t i = 0; i < inputs.size(); ++i)
+			memcpy(archive.data() + entries[i].offset, inputs[i].data.data(), inputs[i].data.size());
+
+		const HRESULT hr = WriteWholeFile(archiveName, archive.data(), archive.size());
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: could not be written (0x%08X)\n", archiveName, static_cast<unsigned int>(hr));
+			return 1;
+		}
+
+		wprintf(L"%s: %zu entries, %zu bytes\n", archiveName, inputs.size(), archive.size());
+		return 0;
+	}
+
+	// What the loaders did per loose file: open it, size it and read it into the heap
+	HRESULT ReadLooseFile(const wchar_t* fileName, std::vector<uint8_t>& data)
+	{
+		HANDLE hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return HRESULT_FROM_WIN32(GetLastError());
+
+		LARGE_INTEGER fileSize = {};
+		HRESULT hr = GetFileSizeEx(hFile, &fileSize) ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+		if (SUCCEEDED(hr))
+		{
+			data.resize(static_cast<size_t>(fileSize.QuadPart));
+			DWORD bytesRead = 0;
+			if (!ReadFile(hFile, data.data(), static_cast<DWORD>(data.size()), &bytesRead, nullptr) || bytesRead != data.size())
+				hr = E_FAIL;
+		}
+		CloseHandle(hFile);
+		return hr;
+	}
+
+	int OpenBench(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		const wchar_t* archiveName = argv[0];
+		const int fileCount = argc - 1;
+		wchar_t** const fileNames = argv + 1;
+
+		bool failed = false;
+		volatile uint32_t checksum = 0;
+		std::vector<uint8_t> data;
+
+		const auto loose = [&]
+		{
+			for (int i = 0; i < fileCount; ++i)
+			{
+				if (FAILED(ReadLooseFile(fileNames[i], data)))
+					failed = true;
+				checksum += data.empty() ? 0 : data.back();
+			}
+		};
+
+		// Reading an archived asset is faulting its pages in, so touch one byte in each
+		const auto archived = [&]
+		{
+			AssetArchive archive;
+			if (FAILED(archive.Open(archiveName)))
+			{
+				failed = true;
+				return;
+			}
+
+			for (int i = 0; i < fileCount; ++i)
+			{
+				const uint8_t* asset = nullptr;
+				size_t size = 0;
+				if (FAILED(archive.Find(fileNames[i], &asset, &size)))
+				{
+					failed = true;
+					continue;
+				}
+
+				uint32_t sum = 0;
+				for (size_t offset = 0; offset < size; offset += ASSET_ARCHIVE_ALIGNMENT)
+					sum += asset[offset];
+				checksum += sum;
+			}
+		};
+
+		const auto timeOnce = [](const std::function<void()>& function)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		// The first pass over each set goes before any warm run, so neither warms the other's cache
+		const double looseFirst = timeOnce(loose);
+		const double archiveFirst = timeOnce(archived);
+		const double looseWarm = TimeBest(loose);
+		const double archiveWarm = TimeBest(archived);
+
+		if (failed)
+		{
+			wprintf(L"some files could not be read, or are missing from %s\n", archiveName);
+			return 1;
+		}
+
+		wprintf(L"%d files\n", fileCount);
+		wprintf(L"  %-10s %10s %10s\n", L"", L"first ms", L"warm ms");
+		wprintf(L"  %-10s %10.3f %10.3f\n", L"loose", looseFirst, looseWarm);
+		wprintf(L"  %-10s %10.3f %10.3f\n", L"archive", archiveFirst, archiveWarm);
+		return 0;
+	}
+
+	int Compress(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		const wchar_t* inputName = argv[0];
+		const wchar_t* outputName = argv[1];
+		size_t chunkSize = LZ_DEFAULT_CHUNK_SIZE;
+		LZ_LEVEL level = LZ_LEVEL_FAST;
+		for (int i = 2; i < argc; ++i)
+		{
+			if (_wcsicmp(argv[i], L"-chunk") == 0 && i + 1 < argc)
+				chunkSize = static_cast<size_t>(std::max<int>(_wtoi(argv[++i]), 1)) * 1024;
+			else if (_wcsicmp(argv[i], L"-high") == 0)
+				level = LZ_LEVEL_HIGH;
+		}
+
+		MappedFile file;
+		HRESULT hr = file.Open(inputName);
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: could not be read (0x%08X)\n", inputName, static_cast<unsigned int>(hr));
+			return 1;
+		}
+
+		if (file.Size() < sizeof(uint32_t) + sizeof(DDS_HEADER) || *reinterpret_cast<const uint32_t*>(file.Data()) != DDS_MAGIC)
+		{
+			wprintf(L"%s: not a plain DDS file\n", inputName);
+			return 1;
+		}
+
+		ThreadPool pool;
+		std::vector<uint8_t> stream;
+		const auto start = std::chrono::steady_clock::now();
+		hr = LZCompressChunked(file.Data(), file.Size(), chunkSize, level, stream, &pool);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: compression failed (0x%08X)\n", inputName, static_cast<unsigned int>(hr));
+			return 1;
+		}
+
+		// Never write a file the loaders would reject
+		std::unique_ptr<uint8_t[]> check;
+		size_t checkSize = 0;
+		if (FAILED(LZDecompressChunked(stream.data(), stream.size(), check, &checkSize, &pool)) || checkSize != file.Size() ||
+		    memcmp(check.get(), file.Data(), checkSize) != 0)
+		{
+			wprintf(L"%s: round trip mismatch\n", inputName);
+			return 1;
+		}
+
+		hr = WriteWholeFile(outputName, stream.data(), stream.size());
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: could not be written (0x%08X)\n", outputName, static_cast<unsigned int>(hr));
+			return 1;
+		}
+
+		wprintf(L"%s -> %s: %zu -> %zu bytes, %.2fx, %.1f MB/s\n", inputName, outputName, file.Size(), stream.size(),
+		        static_cast<double>(file.Size()) / stream.size(), file.Size() / seconds / 1e6);
+		return 0;
+	}
+
+	int LZBench(int argc, wchar_t* argv[])
+	{
+		if (argc < 1)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		ThreadPool pool;
+		wprintf(L"%u threads, %zu KB chunks\n", pool.ThreadCount() + 1, LZ_DEFAULT_CHUNK_SIZE / 1024);
+		wprintf(L"  %-24s %-5s %7s %12s %12s %12s %12s\n", L"", L"", L"ratio", L"pack MB/s", L"1 thr MB/s", L"pool MB/s", L"loose MB/s");
+
+		for (int i = 0; i < argc; ++i)
+		{
+			std::vector<uint8_t> data;
+			if (FAILED(ReadLooseFile(argv[i], data)) || data.empty())
+			{
+				wprintf(L"%s: could not be read\n", argv[i]);
+				return 1;
+			}
+
+			const double megabytes = data.size() / 1e6;
+			std::vector<uint8_t> reread;
+			const double loose = TimeBest([&] { ReadLooseFile(argv[i], reread); });
+
+			for (const LZ_LEVEL level : { LZ_LEVEL_FAST, LZ_LEVEL_HIGH })
+			{
+				std::vector<uint8_t> stream;
+				const double pack = TimeBest([&] { LZCompressChunked(data.data(), data.size(), LZ_DEFAULT_CHUNK_SIZE, level, stream, &pool); });
+
+				std::vector<uint8_t> decoded(data.size());
+				bool matched = true;
+				double unpack[2] = {};
+				ThreadPool* const threads[2] = { nullptr, &pool };
+				for (int t = 0; t < 2; ++t)
+				{
+					unpack[t] = TimeBest([&]
+					{
+						if (FAILED(LZDecompressChunked(stream.data(), stream.size(), decoded.data(), decoded.size(), threads[t])))
+							matched = false;
+					});
+					matched = matched && decoded == data;
+				}
+
+				if (!matched)
+				{
+					wprintf(L"%s: round trip mismatch\n", argv[i]);
+					return 1;
+				}
+
+				wprintf(L"  %-24s %-5s %6.2fx %12.1f %12.1f %12.1f %12.1f\n", argv[i], level == LZ_LEVEL_HIGH ? L"high" : L"fast",
+				        static_cast<double>(data.size()) / stream.size(), megabytes / pack * 1000.0, megabytes / unpack[0] * 1000.0,
+				        megabytes / unpack[1] * 1000.0, megabytes / loose * 1000.0);
+			}
+		}
+		return 0;
+	}
+
+	int MeshBench(int argc, wchar_t* argv[])
+	{
+		const size_t vertexCount = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 2 * 1024 * 1024;
+
+		// Five streams of three floats per vertex, laid out as aiMesh holds them
+		std::vector<float> streamData[5];
+		uint32_t seed = 1;
+		for (std::vector<float>& stream : streamData)
+		{
+			stream.resize(vertexCount * 3);
+			for (float& value : stream)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				value = static_cast<float>(seed >> 8) / 16777216.0f;
+			}
+		}
+
+		MESH_STREAMS streams = {};
+		streams.positions = streamData[0].data();
+		streams.normals = streamData[1].data();
+		streams.texCoords = streamData[2].data();
+		streams.tangents = streamData[3].data();
+		streams.bitangents = streamData[4].data();
+
+		// The loop the sphere loader had: a stack vertex per iteration, pushed back unreserved
+		std::vector<SimpleVertex> reference;
+		const double naive = TimeBest([&]
+		{
+			std::vector<SimpleVertex> vertices;
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				SimpleVertex vertex;
+				vertex.Pos = XMFLOAT3(streams.positions[i * 3], streams.positions[i * 3 + 1], streams.positions[i * 3 + 2]);
+				vertex.Normal = XMFLOAT3(streams.normals[i * 3], streams.normals[i * 3 + 1], streams.normals[i * 3 + 2]);
+				vertex.TexCoord = XMFLOAT2(streams.texCoords[i * 3], streams.texCoords[i * 3 + 1]);
+				vertex.Tangent = XMFLOAT3(streams.tangents[i * 3], streams.tangents[i * 3 + 1], streams.tangents[i * 3 + 2]);
+				vertex.BiNormal = XMFLOAT3(streams.bitangents[i * 3], streams.bitangents[i * 3 + 1], streams.bitangents[i * 3 + 2]);
+				vertices.push_back(vertex);
+			}
+			reference.swap(vertices);
+		});
+
+		ThreadPool pool;
+		const double megavertices = vertexCount / 1e6;
+		wprintf(L"%zu vertices, %u threads\n", vertexCount, pool.ThreadCount() + 1);
+		wprintf(L"  %-26s %8.2f ms %8.1f MVertices/s\n", L"push_back loop", naive, megavertices / naive * 1000.0);
+
+		for (ThreadPool* threads : { static_cast<ThreadPool*>(nullptr), &pool })
+		{
+			std::vector<SimpleVertex> vertices;
+			const double ms = TimeBest([&]
+			{
+				vertices.resize(vertexCount);
+				InterleaveVertices(streams, vertexCount, vertices.data(), threads);
+			});
+
+			if (memcmp(vertices.data(), reference.data(), vertexCount * sizeof(SimpleVertex)) != 0)
+			{
+				wprintf(L"InterleaveVertices does not match the push_back loop\n");
+				return 1;
+			}
+
+			wprintf(L"  %-16s %-9s %8.2f ms %8.1f MVertices/s  %5.2fx\n", L"interleave", threads ? L"threaded" : L"1 thread",
+			        ms, megavertices / ms * 1000.0, naive / ms);
+		}
+		return 0;
+	}
+
+	// A UV sphere with a seam column, so the vertex count matches an imported one. The seam
+	// and the poles repeat their positions exactly, as the wedges of an imported seam do.
+	void BuildUvSphere(const size_t segments, std::vector<SimpleVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const size_t rings = segments / 2;
+		vertices.clear();
+		for (size_t ring = 0; ring <= rings; ++ring)
+		{
+			const float theta = 3.14159265f * ring / rings;
+			const float sinTheta = ring == 0 || ring == rings ? 0.0f : sinf(theta);
+			const float cosTheta = ring == 0 ? 1.0f : ring == rings ? -1.0f : cosf(theta);
+			for (size_t segment = 0; segment <= segments; ++segment)
+			{
+				const float phi = 6.28318531f * (segment % segments) / segments;
+				SimpleVertex vertex = {};
+				vertex.Normal = XMFLOAT3(sinTheta * cosf(phi), cosTheta, sinTheta * sinf(phi));
+				vertex.Pos = vertex.Normal;
+				vertex.TexCoord = XMFLOAT2(float(segment) / segments, float(ring) / rings);
+				vertices.push_back(vertex);
+			}
+		}
+
+		indices.clear();
+		for (size_t ring = 0; ring < rings; ++ring)
+		{
+			for (size_t segment = 0; segment < segments; ++segment)
+			{
+				const uint32_t a = static_cast<uint32_t>(ring * (segments + 1) + segment);
+				const uint32_t b = static_cast<uint32_t>(a + segments + 1);
+				const uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	int MeshOpt(int argc, wchar_t* argv[])
+	{
+		const size_t segments = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 3) : 256;
+
+		std::vector<SimpleVertex> sourceVertices;
+		std::vector<uint32_t> sourceIndices;
+		BuildUvSphere(segments, sourceVertices, sourceIndices);
+
+		// Shuffle whole triangles, as an exporter that knows nothing of the cache might
+		const size_t triangleCount = sourceIndices.size() / 3;
+		uint32_t seed = 1;
+		for (size_t t = triangleCount - 1; t > 0; --t)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			const size_t other = (seed >> 8) % (t + 1);
+			std::swap_ranges(sourceIndices.begin() + t * 3, sourceIndices.begin() + t * 3 + 3, sourceIndices.begin() + other * 3);
+		}
+
+		wprintf(L"%zu vertices, %zu triangles\n", sourceVertices.size(), triangleCount);
+		const auto report = [&](const wchar_t* const pass, const double ms, const std::vector<uint32_t>& indices, const size_t vertexCount)
+		{
+			const VERTEX_CACHE_STATS stats = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+			wprintf(L"  %-20s %8.2f ms  ACMR %.3f  ATVR %.3f\n", pass, ms, stats.acmr, stats.atvr);
+		};
+		report(L"shuffled", 0.0, sourceIndices, sourceVertices.size());
+
+		// Each pass is timed on a fresh copy of the previous pass's output
+		std::vector<uint32_t> cacheIndices;
+		const double cacheMs = TimeBest([&]
+		{
+			cacheIndices = sourceIndices;
+			OptimizeVertexCache(cacheIndices.data(), cacheIndices.size(), sourceVertices.size());
+		});
+		report(L"OptimizeVertexCache", cacheMs, cacheIndices, sourceVertices.size());
+
+		std::vector<uint32_t> overdrawIndices;
+		const double overdrawMs = TimeBest([&]
+		{
+			overdrawIndices = cacheIndices;
+			OptimizeOverdraw(overdrawIndices.data(), overdrawIndices.size(), sourceVertices.data(), sourceVertices.size());
+		});
+		report(L"OptimizeOverdraw", overdrawMs, overdrawIndices, sourceVertices.size());
+
+		std::vector<SimpleVertex> vertices;
+		std::vector<uint32_t> indices;
+		size_t vertexCount = 0;
+		const double fetchMs = TimeBest([&]
+		{
+			vertices = sourceVertices;
+			indices = overdrawIndices;
+			vertexCount = OptimizeVertexFetch(vertices.data(), vertices.size(), indices.data(), indices.size());
+		});
+		report(L"OptimizeVertexFetch", fetchMs, indices, vertexCount);
+		return 0;
+	}
+
+	int Quantize(int argc, wchar_t* argv[])
+	{
+		if (argc != 1)
+		{
+			wprintf(L"%s", s_usage);
+			return 1;
+		}
+
+		// There is no source to check the cooked file against, so it is opened under the
+		// hash it carries
+		uint64_t sourceHash = 0;
+		{
+			MappedFile file;
+			if (SUCCEEDED(file.Open(argv[0])) && file.Size() >= sizeof(MESH_CACHE_HEADER))
+				sourceHash = reinterpret_cast<const MESH_CACHE_HEADER*>(file.Data())->sourceHash;
+		}
+
+		CookedMesh mesh;
+		const HRESULT hr = mesh.Open(argv[0], sourceHash);
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: not a cooked mesh (%08x)\n", argv[0], static_cast<unsigned>(hr));
+			return 1;
+		}
+
+		const size_t vertexCount = mesh.VertexCount();
+		const VERTEX_QUANTIZATION quantization = ComputeVertexQuantization(mesh.Vertices(), vertexCount);
+		std::vector<CompactVertex> compact(vertexCount);
+		QuantizeVertices(mesh.Vertices(), vertexCount, quantization, compact.data());
+		const VERTEX_QUANTIZATION_ERROR error = MeasureQuantizationError(mesh.Vertices(), compact.data(), vertexCount, quantization);
+
+		const float extent = std::max(std::max(quantization.scale[0], quantization.scale[1]), quantization.scale[2]);
+		wprintf(L"%s: %zu vertices, %zu -> %zu bytes (%.2fx)\n", argv[0], vertexCount, vertexCount * sizeof(SimpleVertex),
+		        vertexCount * sizeof(CompactVertex), double(sizeof(SimpleVertex)) / sizeof(CompactVertex));
+		wprintf(L"  position   %.6f (%.2e of the bounds)\n", error.position, extent > 0.0f ? error.position / extent : 0.0f);
+		wprintf(L"  normal     %.4f deg\n", error.normal);
+		wprintf(L"  tangent    %.4f deg\n", error.tangent);
+		wprintf(L"  bitangent  %.4f deg\n", error.bitangent);
+		wprintf(L"  texcoord   %.6f\n", error.texCoord);
+		return 0;
+	}
+
+	int Simplify(int argc, wchar_t* argv[])
+	{
+		const size_t segments = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 4) : 256;
+
+		std::vector<SimpleVertex> vertices;
+		std::vector<uint32_t> indices;
+		BuildUvSphere(segments, vertices, indices);
+		const size_t triangleCount = indices.size() / 3;
+		wprintf(L"%zu vertices, %zu triangles\n", vertices.size(), triangleCount);
+
+		// With no triangle target, the error bound alone decides where collapsing stops
+		const float bounds[] = { 0.001f, 0.005f, 0.01f, 0.05f };
+		std::vector<uint32_t> simplified(indices.size());
+		for (const float bound : bounds)
+		{
+			size_t count = 0;
+			float error = 0.0f;
+			const double ms = TimeBest([&]
+			{
+				count = SimplifyMesh(simplified.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), 0, bound, &error);
+			});
+			wprintf(L"  error <= %-6.3f %8.2f ms %8.1f MTriangles/s %8zu triangles (%5.1f%%), error %.5f\n", bound, ms,
+			        triangleCount / ms / 1000.0, count / 3, 100.0 * count / indices.size(), error);
+		}
+
+		std::vector<uint32_t> lodIndices;
+		MESH_CACHE_LOD lods[MESH_CACHE_MAX_LODS];
+		size_t lodCount = 0;
+		const double chainMs = TimeBest([&]
+		{
+			lodCount = BuildLodChain(indices.data(), indices.size(), vertices.data(), vertices.size(), MESH_CACHE_MAX_LODS, 0.05f,
+			                         lodIndices, lods);
+		});
+		wprintf(L"BuildLodChain: %zu levels in %.2f ms, %zu indices in all\n", lodCount, chainMs, lodIndices.size());
+		for (size_t lod = 0; lod < lodCount; ++lod)
+		{
+			// The radius is 1, so SelectMeshLod draws a level once the sphere is small enough
+			// for its error to be under a pixel: 2 / error pixels across
+			wprintf(L"  LOD %zu %8u triangles  error %.5f", lod, lods[lod].indexCount / 3, lods[lod].error);
+			if (lods[lod].error > 0.0f)
+				wprintf(L"  below %.0f pixels across", 2.0f / lods[lod].error);
+			wprintf(L"\n");
+		}
+		return 0;
+	}
+
+	// Triangles of the culled meshlets the rasterizer would have drawn: facing the way it
+	// keeps, in front of the camera and not wholly off one side of the screen
+	size_t CountWronglyCulled(const std::vector<uint32_t>& indices, const std::vector<SimpleVertex>& vertices,
+	                          const std::vector<MESH_CACHE_MESHLET>& meshlets, const MESHLET_DRAW_RANGE* const ranges,
+	                          const size_t rangeCount, FXMMATRIX worldViewProjection, const D3D11_CULL_MODE cullMode)
+	{
+		std::vector<uint8_t> drawn(indices.size() / 3, 0);
+		for (size_t r = 0; r < rangeCount; ++r)
+			std::fill(drawn.begin() + ranges[r].indexOffset / 3, drawn.begin() + (ranges[r].indexOffset + ranges[r].indexCount) / 3, 1);
+
+		size_t wrong = 0;
+		for (const MESH_CACHE_MESHLET& meshlet : meshlets)
+		{
+			for (size_t t = meshlet.indexOffset / 3; t < (meshlet.indexOffset + meshlet.indexCount) / 3; ++t)
+			{
+				if (drawn[t])
+					continue;
+
+				XMFLOAT4 clip[3];
+				bool behind = false;
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const XMFLOAT3& p = vertices[indices[t * 3 + corner]].Pos;
+					XMStoreFloat4(&clip[corner], XMVector3Transform(XMLoadFloat3(&p), worldViewProjection));
+					behind = behind || clip[corner].w <= 0.0f;
+				}
+				if (behind)
+					continue;
+
+				bool offScreen = false;
+				for (int axis = 0; axis < 2 && !offScreen; ++axis)
+				{
+					for (const float side : { -1.0f, 1.0f })
+					{
+						int outside = 0;
+						for (const XMFLOAT4& c : clip)
+							outside += (axis ? c.y : c.x) * side > c.w;
+						offScreen = offScreen || outside == 3;
+					}
+				}
+				if (offScreen)
+					continue;
+
+				// Clockwise on screen is front facing, and y is up in clip space
+				const float x0 = clip[0].x / clip[0].w, y0 = clip[0].y / clip[0].w;
+				const float area = (clip[1].x / clip[1].w - x0) * (clip[2].y / clip[2].w - y0) -
+				                   (clip[2].x / clip[2].w - x0) * (clip[1].y / clip[1].w - y0);
+				wrong += cullMode == D3D11_CULL_BACK ? area < 0.0f : area > 0.0f;
+			}
+		}
+		return wrong;
+	}
+
+	int Meshlets(int argc, wchar_t* argv[])
+	{
+		const size_t segments = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 4) : 256;
+
+		std::vector<SimpleVertex> vertices;
+		std::vector<uint32_t> sourceIndices;
+		BuildUvSphere(segments, vertices, sourceIndices);
+		OptimizeVertexCache(sourceIndices.data(), sourceIndices.size(), vertices.size());
+		const size_t triangleCount = sourceIndices.size() / 3;
+		wprintf(L"%zu vertices, %zu triangles\n", vertices.size(), triangleCount);
+
+		std::vector<uint32_t> indices;
+		std::vector<MESH_CACHE_MESHLET> meshlets;
+		const double buildMs = TimeBest([&]
+		{
+			indices = sourceIndices;
+			meshlets.clear();
+			BuildMeshlets(indices.data(), 0, indices.size(), vertices.data(), vertices.size(), meshlets);
+		});
+
+		size_t meshletVertices = 0;
+		size_t cullable = 0;
+		std::vector<uint32_t> stamp(vertices.size(), UINT32_MAX);
+		for (size_t m = 0; m < meshlets.size(); ++m)
+		{
+			for (size_t i = meshlets[m].indexOffset; i < meshlets[m].indexOffset + meshlets[m].indexCount; ++i)
+			{
+				meshletVertices += stamp[indices[i]] != m;
+				stamp[indices[i]] = static_cast<uint32_t>(m);
+			}
+			cullable += meshlets[m].coneCutoff < 1.0f;
+		}
+		wprintf(L"BuildMeshlets: %.2f ms, %zu meshlets of %.1f vertices and %.1f triangles on average, %zu with cones\n", buildMs,
+		        meshlets.size(), double(meshletVertices) / meshlets.size(), double(triangleCount) / meshlets.size(), cullable);
+		const VERTEX_CACHE_STATS before = AnalyzeVertexCache(sourceIndices.data(), sourceIndices.size(), vertices.size());
+		const VERTEX_CACHE_STATS after = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		wprintf(L"  ACMR %.3f -> %.3f\n", before.acmr, after.acmr);
+
+		// Cameras on a ring around the sphere, then one inside its bounds looking at the
+		// surface, where the frustum rather than facing does the culling
+		struct Camera
+		{
+			const wchar_t* name;
+			XMFLOAT3 eye;
+			float fov;
+		};
+		const Camera cameras[] =
+		{
+			{ L"outside +x", XMFLOAT3(4.0f, 0.0f, 0.0f), XM_PIDIV4 },
+			{ L"outside +y", XMFLOAT3(0.0f, 4.0f, 0.0f), XM_PIDIV4 },
+			{ L"outside -z", XMFLOAT3(0.3f, 1.0f, -4.0f), XM_PIDIV4 },
+			{ L"close up", XMFLOAT3(0.0f, 0.0f, 1.2f), XM_PIDIV4 * 0.5f },
+		};
+		const D3D11_CULL_MODE cullModes[] = { D3D11_CULL_BACK, D3D11_CULL_FRONT };
+
+		std::vector<MESHLET_DRAW_RANGE> ranges(meshlets.size());
+		for (const Camera& camera : cameras)
+		{
+			const XMVECTOR eye = XMLoadFloat3(&camera.eye);
+			const XMVECTOR up = fabsf(camera.eye.y) > fabsf(camera.eye.x) + fabsf(camera.eye.z)
+				? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			const XMMATRIX world = XMMatrixIdentity();
+			const XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), up);
+			const XMMATRIX projection = XMMatrixPerspectiveFovLH(camera.fov, 16.0f / 9.0f, 0.01f, 100.0f);
+
+			for (const D3D11_CULL_MODE cullMode : cullModes)
+			{
+				MESHLET_CULL_STATS stats = {};
+				size_t rangeCount = 0;
+				const double ms = TimeBest([&]
+				{
+					for (int repeat = 0; repeat < 100; ++repeat)
+						rangeCount = CullMeshlets(meshlets.data(), meshlets.size(), world, view, projection, cullMode, FALSE, ranges.data(), &stats);
+				}) / 100.0;
+
+				const size_t wrong = CountWronglyCulled(indices, vertices, meshlets, ranges.data(), rangeCount,
+				                                        XMMatrixMultiply(XMMatrixMultiply(world, view), projection), cullMode);
+				wprintf(L"  %-10s %-10s %7.1f us  %5.1f%% of triangles culled (%zu frustum, %zu backface meshlets), %zu ranges, %zu wrongly culled\n",
+				        camera.name, cullMode == D3D11_CULL_BACK ? L"cull back" : L"cull front", ms * 1000.0,
+				        100.0 * (triangleCount - stats.trianglesDrawn) / triangleCount, stats.frustumCulled, stats.backfaceCulled, rangeCount, wrong);
+			}
+		}
+		return 0;
+	}
+
+	int Tangents(int argc, wchar_t* argv[])
+	{
+		const size_t segments = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 4) : 1024;
+
+		std::vector<SimpleVertex> vertices;
+		std::vector<uint32_t> indices;
+		BuildUvSphere(segments, vertices, indices);
+		OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+		const double megatriangles = indices.size() / 3 / 1e6;
+		wprintf(L"%zu vertices, %zu triangles\n", vertices.size(), indices.size() / 3);
+
+		ThreadPool pool;
+		std::vector<SimpleVertex> single = vertices;
+		const double singleMs = TimeBest([&] { GenerateTangents(indices.data(), indices.size(), single.data(), single.size()); });
+		const double threadedMs = TimeBest([&] { GenerateTangents(indices.data(), indices.size(), vertices.data(), vertices.size(), &pool); });
+		wprintf(L"  %-9s %8.2f ms %8.1f MTriangles/s\n", L"1 thread", singleMs, megatriangles / singleMs * 1000.0);
+		wprintf(L"  %-9s %8.2f ms %8.1f MTriangles/s  %5.2fx on %zu threads\n", L"threaded", threadedMs, megatriangles / threadedMs * 1000.0,
+		        singleMs / threadedMs, pool.ThreadCount() + 1);
+
+		// u runs with phi and v with theta, so the exact tangent is dP/dphi and the exact
+		// bitangent dP/dtheta
+		const size_t rings = segments / 2;
+		float tangentError = 0.0f;
+		float bitangentError = 0.0f;
+		float threadedDifference = 0.0f;
+		for (size_t v = 0; v < vertices.size(); ++v)
+		{
+			const size_t ring = v / (segments + 1);
+			const float phi = 6.28318531f * vertices[v].TexCoord.x;
+			const float theta = 3.14159265f * ring / rings;
+			threadedDifference = std::max(threadedDifference, fabsf(vertices[v].Tangent.x - single[v].Tangent.x));
+			threadedDifference = std::max(threadedDifference, fabsf(vertices[v].BiNormal.y - single[v].BiNormal.y));
+			if (ring <= 1 || ring + 1 >= rings)
+				continue;
+
+			const XMFLOAT3 tangent(-sinf(phi), 0.0f, cosf(phi));
+			const XMFLOAT3 bitangent(cosf(theta) * cosf(phi), -sinf(theta), cosf(theta) * sinf(phi));
+			const auto angle = [](const XMFLOAT3& a, const XMFLOAT3& b)
+			{
+				return acosf(std::min(std::max(a.x * b.x + a.y * b.y + a.z * b.z, -1.0f), 1.0f));
+			};
+			tangentError = std::max(tangentError, angle(vertices[v].Tangent, tangent));
+			bitangentError = std::max(bitangentError, angle(vertices[v].BiNormal, bitangent));
+		}
+		wprintf(L"  largest error %.3f degrees in tangents, %.3f in bitangents; threaded differs by %g\n",
+		        tangentError * 57.2957795f, bitangentError * 57.2957795f, threadedDifference);
+		return 0;
+	}
+
+	int Arenas(int argc, wchar_t* argv[])
+	{
+		const size_t operations = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 200000;
+		const uint32_t capacity = 1u << 20;
+
+		struct Range
+		{
+			uint32_t offset;
+			uint32_t size;
+		};
+
+		// The same sequence for both passes: mostly small meshes, some up to a sixteenth of
+		// the arena, allocating a little more often than freeing until the arena is full
+		const auto run = [&](const bool check, size_t* const errors, size_t* const failures)
+		{
+			OffsetAllocator allocator(capacity);
+			std::vector<Range> live;
+			std::vector<uint8_t> used(check ? capacity : 0);
+			uint64_t liveSize = 0;
+			uint32_t seed = 1;
+			const auto next = [&seed]
+			{
+				seed = seed * 1664525u + 1013904223u;
+				return seed >> 8;
+			};
+
+			for (size_t op = 0; op < operations; ++op)
+			{
+				if (live.empty() || next() % 100 < 55)
+				{
+					const uint32_t size = next() % 8 == 0 ? 1 + next() % (capacity / 16) : 1 + next() % 1024;
+					const uint32_t offset = allocator.Allocate(size);
+					if (offset == OffsetAllocator::INVALID_OFFSET)
+					{
+						// Only a failure of the allocator when one free range could have held it
+						*errors += check && allocator.LargestFree() >= size;
+						++*failures;
+						continue;
+					}
+					if (check)
+					{
+						*errors += offset + size > capacity;
+						for (uint32_t i = offset; i < offset + size && i < capacity; ++i)
+						{
+							*errors += used[i] != 0;
+							used[i] = 1;
+						}
+					}
+					live.push_back(Range{ offset, size });
+					liveSize += size;
+				}
+				else
+				{
+					const size_t victim = next() % live.size();
+					const Range range = live[victim];
+					live[victim] = live.back();
+					live.pop_back();
+					allocator.Free(range.offset, range.size);
+					liveSize -= range.size;
+					if (check)
+						std::fill(used.begin() + range.offset, used.begin() + range.offset + range.size, uint8_t(0));
+				}
+				if (check)
+					*errors += allocator.FreeSize() != capacity - liveSize;
+			}
+
+			for (const Range& range : live)
+				allocator.Free(range.offset, range.size);
+			if (check)
+				*errors += allocator.FreeRangeCount() != 1 || allocator.LargestFree() != capacity;
+		};
+
+		size_t errors = 0;
+		size_t failures = 0;
+		run(true, &errors, &failures);
+		wprintf(L"%zu operations on %u units: %zu allocations did not fit, %zu errors\n", operations, capacity, failures, errors);
+
+		size_t ignored = 0;
+		const double ms = TimeBest([&] { size_t unchecked = 0; run(false, &ignored, &unchecked); });
+		wprintf(L"  %.2f ms, %.1f ns per operation\n", ms, ms * 1e6 / operations);
+		return errors ? 1 : 0;
+	}
+
+	// A UV sphere as exporters write OBJ: six decimals, and p/t/n corners into separate
+	// position, texture coordinate and normal lists. Roughly 100 bytes per segment squared.
+	std::vector<uint8_t> BuildObjText(const size_t bytes)
+	{
+		std::vector<SimpleVertex> vertices;
+		std::vector<uint32_t> indices;
+		BuildUvSphere(std::max<size_t>(static_cast<size_t>(sqrt(bytes / 100.0)), 4), vertices, indices);
+
+		std::string text;
+		text.reserve(bytes + bytes / 4);
+		char line[128];
+		for (const SimpleVertex& vertex : vertices)
+			text.append(line, snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", vertex.Pos.x, vertex.Pos.y, vertex.Pos.z));
+		for (const SimpleVertex& vertex : vertices)
+			text.append(line, snprintf(line, sizeof(line), "vt %.6f %.6f\n", vertex.TexCoord.x, vertex.TexCoord.y));
+		for (const SimpleVertex& vertex : vertices)
+			text.append(line, snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", vertex.Normal.x, vertex.Normal.y, vertex.Normal.z));
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const unsigned a = indices[i] + 1, b = indices[i + 1] + 1, c = indices[i + 2] + 1;
+			text.append(line, snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c));
+		}
+		return std::vector<uint8_t>(text.begin(), text.end());
+	}
+
+	int ObjBench(int argc, wchar_t* argv[])
+	{
+		const bool generated = argc == 0 || _wtoi(argv[0]) > 0;
+		const wchar_t* const fileName = generated ? L"objbench.obj" : argv[0];
+		if (generated)
+		{
+			const size_t megabytes = argc > 0 ? _wtoi(argv[0]) : 100;
+			const std::vector<uint8_t> text = BuildObjText(megabytes * 1024 * 1024);
+			const HRESULT hr = WriteWholeFile(fileName, text.data(), text.size());
+			if (FAILED(hr))
+			{
+				wprintf(L"%s: cannot write (%08x)\n", fileName, static_cast<unsigned>(hr));
+				return 1;
+			}
+		}
+
+		// Once only: it takes seconds on files this size
+		char narrowName[MAX_PATH];
+		WideCharToMultiByte(CP_ACP, 0, fileName, -1, narrowName, MAX_PATH, nullptr, nullptr);
+		Assimp::Importer importer;
+		const auto start = std::chrono::steady_clock::now();
+		const aiScene* const scene = importer.ReadFile(narrowName, aiProcess_Triangulate);
+		const double assimpMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		ThreadPool pool;
+		std::vector<SimpleVertex> vertices;
+		std::vector<uint32_t> indices;
+		size_t fileSize = 0;
+		HRESULT hr = S_OK;
+		const auto read = [&](ThreadPool* const readPool)
+		{
+			MappedFile file;
+			hr = file.Open(fileName);
+			if (SUCCEEDED(hr))
+				hr = ReadObj(file.Data(), file.Size(), vertices, indices, readPool);
+			fileSize = file.Size();
+		};
+		const double singleMs = TimeBest([&] { read(nullptr); });
+		const double threadedMs = TimeBest([&] { read(&pool); });
+		if (generated)
+			DeleteFileW(fileName);
+		if (FAILED(hr))
+		{
+			wprintf(L"%s: ReadObj failed (%08x)\n", fileName, static_cast<unsigned>(hr));
+			return 1;
+		}
+
+		const double megabytes = fileSize / (1024.0 * 1024.0);
+		wprintf(L"%.1f MB, %zu triangles, %zu vertices after merging corners\n", megabytes, indices.size() / 3, vertices.size());
+		if (scene && scene->mNumMeshes)
+			wprintf(L"  %-17s %9.2f ms %8.1f MB/s, %u vertices\n", L"Assimp ReadFile", assimpMs, megabytes / assimpMs * 1000.0,
+			        scene->mMeshes[0]->mNumVertices);
+		else
+			wprintf(L"  Assimp ReadFile failed: %hs\n", importer.GetErrorString());
+		wprintf(L"  %-17s %9.2f ms %8.1f MB/s\n", L"ReadObj, 1 thread", singleMs, megabytes / singleMs * 1000.0);
+		wprintf(L"  %-17s %9.2f ms %8.1f MB/s  %5.2fx on %zu threads\n", L"ReadObj, threaded", threadedMs, megabytes / threadedMs * 1000.0,
+		        singleMs / threadedMs, pool.ThreadCount() + 1);
+
+		// Assimp gives every corner a vertex of its own, in face order
+		if (!scene || scene->mNumMeshes != 1)
+			return 0;
+		const aiMesh* const mesh = scene->mMeshes[0];
+		if (mesh->mNumFaces != indices.size() / 3)
+		{
+			wprintf(L"  Assimp read %u triangles\n", mesh->mNumFaces);
+			return 1;
+		}
+		float difference = 0.0f;
+		for (size_t face = 0; face < mesh->mNumFaces; ++face)
+		{
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const unsigned int theirs = mesh->mFaces[face].mIndices[corner];
+				const SimpleVertex& ours = vertices[indices[face * 3 + corner]];
+				const float pairs[][2] =
+				{
+					{ ours.Pos.x, mesh->mVertices[theirs].x }, { ours.Pos.y, mesh->mVertices[theirs].y }, { ours.Pos.z, mesh->mVertices[theirs].z },
+					{ ours.Normal.x, mesh->HasNormals() ? mesh->mNormals[theirs].x : 0.0f },
+					{ ours.Normal.y, mesh->HasNormals() ? mesh->mNormals[theirs].y : 0.0f },
+					{ ours.Normal.z, mesh->HasNormals() ? mesh->mNormals[theirs].z : 0.0f },
+					{ ours.TexCoord.x, mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][theirs].x : 0.0f },
+					{ ours.TexCoord.y, mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][theirs].y : 0.0f },
+				};
+				for (const auto& pair : pairs)
+					difference = std::max(difference, fabsf(pair[0] - pair[1]));
+			}
+		}
+		wprintf(L"  largest difference from Assimp's corners: %g\n", difference);
+		return 0;
+	}
+
+	// A scene of 'entityCount' cubes and spheres scattered through a box, as Scene.txt text,
+	// with the materials Tutorial04 has
+	std::string BuildSceneText(const size_t entityCount)
+	{
+		std::string text =
+			"mesh cube\n"
+			"mesh sphere\n"
+			"material skybox cube cubemap box box box box opaque debugvs background\n"
+			"material tiles sphere lighting tile tile objects objects opaque\n"
+			"material stones sphere bump stones stones+stonesnormal objects objects opaque\n"
+			"material ink cube ink - - objects objects blend\n"
+			"material glass cube transparent box box objects objects blend\n";
+		text.reserve(text.size() + entityCount * 80);
+
+		const char* const cubeMaterials[] = { "skybox", "ink", "glass" };
+		const char* const sphereMaterials[] = { "tiles", "stones" };
+		const float extent = 3.0f * static_cast<float>(cbrt(static_cast<double>(entityCount)));
+		uint32_t seed = 1;
+		const auto next = [&seed]
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return (seed >> 8) / 16777216.0f;
+		};
+
+		char line[256];
+		for (size_t i = 0; i < entityCount; ++i)
+		{
+			const bool sphere = next() < 0.5f;
+			const char* const material = sphere ? sphereMaterials[static_cast<size_t>(next() * 2) % 2] : cubeMaterials[static_cast<size_t>(next() * 3) % 3];
+			const float scale = 0.1f + next() * (sphere ? 0.1f : 2.0f);
+			const float x = (next() - 0.5f) * extent, y = (next() - 0.5f) * extent, z = (next() - 0.5f) * extent;
+			const float rx = next() * 360.0f, ry = next() * 360.0f, rz = next() * 360.0f;
+			text.append(line, snprintf(line, sizeof(line), "entity %s %s %.3f %.3f %.3f %.3f %.3f %.3f %.1f %.1f %.1f%s\n", sphere ? "sphere" : "cube",
+			                           material, x, y, z, scale, scale, scale, rx, ry, rz, i % 1000 == 0 ? " scroll" : ""));
+		}
+		return text;
+	}
+
+	bool SameScene(const SceneStore& a, const SceneStore& b)
+	{
+		const size_t count = a.EntityCount();
+		if (count != b.EntityCount() || a.MeshCount() != b.MeshCount() || a.MaterialCount() != b.MaterialCount() || a.NameCount() != b.NameCount())
+			return false;
+		for (size_t i = 0; i < a.MaterialCount(); ++i)
+		{
+			if (memcmp(&a.Material(i), &b.Material(i), sizeof(SCENE_MATERIAL)) != 0)
+				return false;
+		}
+		const TransformSystem& ta = a.Transforms();
+		const TransformSystem& tb = b.Transforms();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const XMFLOAT3 pa = ta.Position(i), pb = tb.Position(i), sa = ta.Scale(i), sb = tb.Scale(i);
+			const XMFLOAT4 ra = ta.Rotation(i), rb = tb.Rotation(i);
+			if (memcmp(&pa, &pb, sizeof(pa)) != 0 || memcmp(&sa, &sb, sizeof(sa)) != 0 || memcmp(&ra, &rb, sizeof(ra)) != 0 ||
+			    ta.Parent(i) != tb.Parent(i))
+				return false;
+		}
+		return memcmp(a.EntityMeshes(), b.EntityMeshes(), count * sizeof(uint16_t)) == 0 &&
+		       memcmp(a.EntityMaterials(), b.EntityMaterials(), count * sizeof(uint16_t)) == 0 &&
+		       memcmp(a.EntityFlags(), b.EntityFlags(), count * sizeof(uint32_t)) == 0;
+	}
+
+	int SceneBench(int argc, wchar_t* argv[])
+	{
+		std::vector<size_t> sizes;
+		if (argc > 0)
+			sizes.push_back(std::max<size_t>(_wtoi(argv[0]), 1));
+		else
+			sizes = { 1000, 10000, 100000 };
+
+		ThreadPool pool;
+		const wchar_t* const cookedName = L"scenebench.scene";
+		int result = 0;
+		for (const size_t entityCount : sizes)
+		{
+			const std::string text = BuildSceneText(entityCount);
+			SceneStore parsed;
+			size_t errorLine = 0;
+			HRESULT hr = ParseSceneText(text.data(), text.size(), parsed, &errorLine);
+			if (FAILED(hr))
+			{
+				wprintf(L"generated scene: line %zu does not parse\n", errorLine);
+				return 1;
+			}
+			const double parseMs = TimeBest([&] { ParseSceneText(text.data(), text.size(), parsed); });
+
+			const uint64_t hash = HashBytes(text.data(), text.size(), SCENE_FILE_VERSION);
+			hr = parsed.Write(cookedName, hash);
+			MappedFile cooked;
+			if (SUCCEEDED(hr))
+				hr = cooked.Open(cookedName);
+			if (FAILED(hr))
+			{
+				wprintf(L"%s: cannot write (%08x)\n", cookedName, static_cast<unsigned>(hr));
+				return 1;
+			}
+			SceneStore read;
+			hr = read.Read(cooked.Data(), cooked.Size(), hash);
+			const double readMs = TimeBest([&] { read.Read(cooked.Data(), cooked.Size(), hash); });
+			const bool same = SUCCEEDED(hr) && SameScene(parsed, read);
+
+			read.UpdateWorlds(&pool);
+
+			// What Render does per entity short of calling D3D: queue and sort the draws, then
+			// the world to upload, whether the material changes, and the mesh to draw. Depth is
+			// along z, as for a camera at the origin looking down it.
+			DrawQueue queue;
+			queue.Reserve(read.EntityCount());
+			size_t materialChanges = 0;
+			float checksum = 0.0f;
+			const double walkMs = TimeBest([&]
+			{
+				const uint16_t* const meshes = read.EntityMeshes();
+				const uint16_t* const materials = read.EntityMaterials();
+				const XMFLOAT4X4* const worlds = read.Worlds();
+				queue.Clear();
+				for (size_t i = 0; i < read.EntityCount(); ++i)
+				{
+					const SCENE_MATERIAL& material = read.Material(materials[i]);
+					const uint32_t layer = material.flags & SCENE_MATERIAL_BACKGROUND ? 0 : 1;
+					const bool blended = strcmp(read.Name(material.blendState), "blend") == 0;
+					queue.Push(MakeDrawKey(layer, blended, material.pixelShader, materials[i], meshes[i], worlds[i].m[3][2]), static_cast<uint32_t>(i));
+				}
+				queue.Sort();
+
+				size_t boundMaterial = SIZE_MAX;
+				materialChanges = 0;
+				XMMATRIX sum = XMMatrixIdentity();
+				for (size_t draw = 0; draw < queue.Count(); ++draw)
+				{
+					const size_t i = queue.Packets()[draw].payload;
+					const XMMATRIX world = XMMatrixTranspose(XMLoadFloat4x4(&worlds[i]));
+					sum.r[meshes[i] & 3] = XMVectorAdd(sum.r[meshes[i] & 3], world.r[0]);
+					if (materials[i] != boundMaterial)
+					{
+						boundMaterial = materials[i];
+						++materialChanges;
+					}
+				}
+				checksum = XMVectorGetX(sum.r[0]);
+			});
+
+			wprintf(L"%zu entities: %.1f KB of text, %.1f KB cooked%s\n", entityCount, text.size() / 1024.0, cooked.Size() / 1024.0,
+			        same ? L"" : L", COOKED SCENE DIFFERS");
+			wprintf(L"  %-17s %9.3f ms %8.1f ns per entity\n", L"parse text", parseMs, parseMs * 1e6 / entityCount);
+			wprintf(L"  %-17s %9.3f ms %8.1f ns per entity\n", L"read cooked", readMs, readMs * 1e6 / entityCount);
+			wprintf(L"  %-17s %9.3f ms %8.1f ns per entity, %zu material changes (checksum %g)\n", L"walk", walkMs,
+			        walkMs * 1e6 / entityCount, materialChanges, checksum);
+
+			cooked.Close();
+			DeleteFileW(cookedName);
+			result |= same ? 0 : 1;
+		}
+		return result;
+	}
+
+	int Transforms(int argc, wchar_t* argv[])
+	{
+		const size_t count = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 4) : 100000;
+
+		std::vector<XMFLOAT3> positions(count), angles(count), scales(count);
+		uint32_t seed = 1;
+		const auto next = [&seed]
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return (seed >> 8) / 16777216.0f;
+		};
+		for (size_t i = 0; i < count; ++i)
+		{
+			positions[i] = XMFLOAT3((next() - 0.5f) * 20.0f, (next() - 0.5f) * 20.0f, (next() - 0.5f) * 20.0f);
+			angles[i] = XMFLOAT3(next() * XM_2PI, next() * XM_2PI, next() * XM_2PI);
+			scales[i] = XMFLOAT3(0.5f + next(), 0.5f + next(), 0.5f + next());
+		}
+
+		// Each world matrix the way SceneStore built them before TransformSystem
+		std::vector<XMFLOAT4X4> reference(count);
+		const auto composeAll = [&](const bool chains)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				XMMATRIX world = XMMatrixScaling(scales[i].x, scales[i].y, scales[i].z) * XMMatrixRotationX(angles[i].x) *
+				                 XMMatrixRotationY(angles[i].y) * XMMatrixRotationZ(angles[i].z) *
+				                 XMMatrixTranslation(positions[i].x, positions[i].y, positions[i].z);
+				if (chains && i % 4 != 0)
+					world = world * XMLoadFloat4x4(&reference[i - 1]);
+				XMStoreFloat4x4(&reference[i], world);
+			}
+		};
+
+		ThreadPool pool;
+		int result = 0;
+		for (int chains = 0; chains < 2; ++chains)
+		{
+			TransformSystem transforms;
+			transforms.Reserve(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t parent = chains && i % 4 != 0 ? i - 1 : TransformSystem::NO_PARENT;
+				transforms.Add(positions[i], TransformSystem::RotationFromEuler(angles[i]), scales[i], parent);
+			}
+			transforms.Update();
+
+			const double referenceMs = TimeBest([&] { composeAll(chains != 0); });
+			float worst = 0.0f;
+			const XMFLOAT4X4* const worlds = transforms.Worlds();
+			for (size_t i = 0; i < count; ++i)
+			{
+				for (int r = 0; r < 4; ++r)
+				{
+					for (int c = 0; c < 4; ++c)
+						worst = std::max(worst, fabsf(worlds[i].m[r][c] - reference[i].m[r][c]));
+				}
+			}
+
+			wprintf(L"%zu transforms, %s: largest difference %g\n", count, chains ? L"in chains of four" : L"flat", worst);
+			wprintf(L"  %-22s %9.3f ms %7.1f ns per transform\n", L"XMMatrix per object", referenceMs, referenceMs * 1e6 / count);
+
+			// Moving some transforms is not part of the time, only the Update after it
+			const size_t strides[] = { 1, 100, 0 };
+			const wchar_t* const strideNames[] = { L"all moved", L"1 in 100 moved", L"none moved" };
+			for (size_t s = 0; s < 3; ++s)
+			{
+				double ms[2] = {};
+				size_t rebuilt = 0;
+				for (int threaded = 0; threaded < 2; ++threaded)
+				{
+					double best = 1e30;
+					for (int run = 0; run < 5; ++run)
+					{
+						for (size_t i = 0; strides[s] && i < count; i += strides[s])
+							transforms.SetPosition(static_cast<uint32_t>(i), positions[i]);
+						const auto start = std::chrono::steady_clock::now();
+						rebuilt = transforms.Update(threaded ? &pool : nullptr);
+						best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+					}
+					ms[threaded] = best;
+				}
+				wprintf(L"  %-22s %9.3f ms %7.1f ns per transform, %zu rebuilt, %9.3f ms on %zu threads\n", strideNames[s], ms[0],
+				        ms[0] * 1e6 / count, rebuilt, ms[1], pool.ThreadCount());
+			}
+			result |= worst < 1e-3f ? 0 : 1;
+		}
+		return result;
+	}
+
+	// Stands in for ID3D11DeviceContext when checking StateCache: it keeps what the calls it
+	// is given bind, and what was bound at each draw. It tracks more slots than the cache
+	// shadows, so the calls reaching past those are checked too.
+	const UINT RECORDED_SLOTS = 2 * STATE_CACHE_SLOTS;
+
+	struct RECORDED_STATE
+	{
+		const void* inputLayout;
+		const void* vertexShader;
+		const void* pixelShader;
+		const void* indexBuffer;
+		const void* rasterState;
+		const void* depthState;
+		const void* blendState;
+		const void* vertexBuffers[RECORDED_SLOTS];
+		const void* vertexConstants[RECORDED_SLOTS];
+		const void* pixelConstants[RECORDED_SLOTS];
+		const void* pixelResources[RECORDED_SLOTS];
+		const void* pixelSamplers[RECORDED_SLOTS];
+		UINT vertexStrides[RECORDED_SLOTS];
+		UINT vertexOffsets[RECORDED_SLOTS];
+		UINT topology;
+		UINT indexFormat;
+		UINT indexOffset;
+		UINT stencilRef;
+		UINT sampleMask;
+		FLOAT blendFactor[4];
+	};
+
+	bool SameState(const RECORDED_STATE& a, const RECORDED_STATE& b)
+	{
+		const auto same = [](const void* x, const void* y, const size_t size) { return memcmp(x, y, size) == 0; };
+		return a.inputLayout == b.inputLayout && a.vertexShader == b.vertexShader && a.pixelShader == b.pixelShader &&
+		       a.indexBuffer == b.indexBuffer && a.rasterState == b.rasterState && a.depthState == b.depthState &&
+		       a.blendState == b.blendState && same(a.vertexBuffers, b.vertexBuffers, sizeof(a.vertexBuffers)) &&
+		       same(a.vertexConstants, b.vertexConstants, sizeof(a.vertexConstants)) &&
+		       same(a.pixelConstants, b.pixelConstants, sizeof(a.pixelConstants)) &&
+		       same(a.pixelResources, b.pixelResources, sizeof(a.pixelResources)) &&
+		       same(a.pixelSamplers, b.pixelSamplers, sizeof(a.pixelSamplers)) &&
+		       same(a.vertexStrides, b.vertexStrides, sizeof(a.vertexStrides)) &&
+		       same(a.vertexOffsets, b.vertexOffsets, sizeof(a.vertexOffsets)) && a.topology == b.topology &&
+		       a.indexFormat == b.indexFormat && a.indexOffset == b.indexOffset && a.stencilRef == b.stencilRef &&
+		       a.sampleMask == b.sampleMask && same(a.blendFactor, b.blendFactor, sizeof(a.blendFactor));
+	}
+
+	class RecordingContext
+	{
+	public:
+		RecordingContext() : m_state() {}
+
+		size_t Calls() const { return m_calls; }
+		const std::vector<RECORDED_STATE>& Draws() const { return m_draws; }
+
+		void IASetInputLayout(ID3D11InputLayout* const layout) { ++m_calls; m_state.inputLayout = layout; }
+		void IASetPrimitiveTopology(const D3D11_PRIMITIVE_TOPOLOGY topology) { ++m_calls; m_state.topology = topology; }
+		void IASetVertexBuffers(const UINT startSlot, const UINT count, ID3D11Buffer* const* const buffers, const UINT* const strides,
+		                        const UINT* const offsets)
+		{
+			++m_calls;
+			for (UINT i = 0; i < count; ++i)
+			{
+				m_state.vertexBuffers[startSlot + i] = buffers[i];
+				m_state.vertexStrides[startSlot + i] = strides[i];
+				m_state.vertexOffsets[startSlot + i] = offsets[i];
+			}
+		}
+		void IASetIndexBuffer(ID3D11Buffer* const buffer, const DXGI_FORMAT format, const UINT offset)
+		{
+			++m_calls;
+			m_state.indexBuffer = buffer;
+			m_state.indexFormat = format;
+			m_state.indexOffset = offset;
+		}
+
+		void VSSetShader(ID3D11VertexShader* const shader, ID3D11ClassInstance* const*, UINT) { ++m_calls; m_state.vertexShader = shader; }
+		void VSSetConstantBuffers(const UINT startSlot, const UINT count, ID3D11Buffer* const* const buffers)
+		{
+			SetSlots(m_state.vertexConstants, startSlot, count, buffers);
+		}
+
+		void PSSetShader(ID3D11PixelShader* const shader, ID3D11ClassInstance* const*, UINT) { ++m_calls; m_state.pixelShader = shader; }
+		void PSSetConstantBuffers(const UINT startSlot, const UINT count, ID3D11Buffer* const* const buffers)
+		{
+			SetSlots(m_state.pixelConstants, startSlot, count, buffers);
+		}
+		void PSSetShaderResources(const UINT startSlot, const UINT count, ID3D11ShaderResourceView* const* const views)
+		{
+			SetSlots(m_state.pixelResources, startSlot, count, views);
+		}
+		void PSSetSamplers(const UINT startSlot, const UINT count, ID3D11SamplerState* const* const samplers)
+		{
+			SetSlots(m_state.pixelSamplers, startSlot, count, samplers);
+		}
+
+		void RSSetState(ID3D11RasterizerState* const state) { ++m_calls; m_state.rasterState = state; }
+		void OMSetDepthStencilState(ID3D11DepthStencilState* const state, const UINT stencilRef)
+		{
+			++m_calls;
+			m_state.depthState = state;
+			m_state.stencilRef = stencilRef;
+		}
+		void OMSetBlendState(ID3D11BlendState* const state, const FLOAT blendFactor[4], const UINT sampleMask)
+		{
+			++m_calls;
+			m_state.blendState = state;
+			m_state.sampleMask = sampleMask;
+			for (int i = 0; i < 4; ++i)
+				m_state.blendFactor[i] = blendFactor ? blendFactor[i] : 1.0f;
+		}
+
+		void DrawIndexed(UINT, UINT, INT) { m_draws.push_back(m_state); }
+
+	private:
+		template <typename T>
+		void SetSlots(const void** const slots, const UINT startSlot, const UINT count, T* const* const values)
+		{
+			++m_calls;
+			for (UINT i = 0; i < count; ++i)
+				slots[startSlot + i] = values[i];
+		}
+
+		RECORDED_STATE m_state;
+		size_t m_calls = 0;
+		std::vector<RECORDED_STATE> m_draws;
+	};
+
+	// The recording context under a cache or on its own, so the same calls can be made on
+	// either; binding behind the cache's back is followed by Invalidate
+	RecordingContext& Recorder(RecordingContext& context) { return context; }
+	RecordingContext& Recorder(BasicStateCache<RecordingContext>& cache) { return *cache.Get(); }
+	void Invalidate(RecordingContext&) {}
+	void Invalidate(BasicStateCache<RecordingContext>& cache) { cache.Invalidate(); }
+
+	// An address for the index'th object of a kind; the recording context only compares them
+	template <typename T>
+	T* StandIn(const size_t kind, const size_t index)
+	{
+		static uint64_t objects[16][256];
+		return reinterpret_cast<T*>(&objects[kind % 16][index % 256]);
+	}
+
+	// Random calls over a few objects of each kind, null among them, with some ranges
+	// reaching past the slots the cache shadows and some calls made behind its back
+	template <typename Target>
+	void MakeRandomCalls(Target& target, const size_t callCount)
+	{
+		uint32_t seed = 1;
+		const auto next = [&seed](const uint32_t range)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return (seed >> 8) % range;
+		};
+		const auto pick = [&](const size_t kind) { return next(4) ? StandIn<void>(kind, next(3)) : nullptr; };
+		const FLOAT factors[2][4] = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 0.0f } };
+
+		for (size_t call = 0; call < callCount; ++call)
+		{
+			const UINT count = 1 + next(3);
+			const UINT startSlot = next(RECORDED_SLOTS - count + 1);
+			void* objects[3] = { pick(0), pick(0), pick(0) };
+			const UINT strides[3] = { 12 + 4 * next(2), 32, 32 };
+			const UINT offsets[3] = { 0, 16 * next(2), 0 };
+			switch (next(14))
+			{
+			case 0: target.IASetInputLayout(static_cast<ID3D11InputLayout*>(pick(1))); break;
+			case 1: target.IASetPrimitiveTopology(next(2) ? D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST : D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED); break;
+			case 2: target.IASetVertexBuffers(startSlot, count, reinterpret_cast<ID3D11Buffer* const*>(objects), strides, offsets); break;
+			case 3: target.IASetIndexBuffer(static_cast<ID3D11Buffer*>(pick(2)), next(2) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0); break;
+			case 4: target.VSSetShader(static_cast<ID3D11VertexShader*>(pick(3)), nullptr, 0); break;
+			case 5: target.VSSetConstantBuffers(startSlot, count, reinterpret_cast<ID3D11Buffer* const*>(objects)); break;
+			case 6: target.PSSetShader(static_cast<ID3D11PixelShader*>(pick(4)), nullptr, 0); break;
+			case 7: target.PSSetConstantBuffers(startSlot, count, reinterpret_cast<ID3D11Buffer* const*>(objects)); break;
+			case 8: target.PSSetShaderResources(startSlot, count, reinterpret_cast<ID3D11ShaderResourceView* const*>(objects)); break;
+			case 9: target.PSSetSamplers(startSlot, count, reinterpret_cast<ID3D11SamplerState* const*>(objects)); break;
+			case 10: target.RSSetState(static_cast<ID3D11RasterizerState*>(pick(5))); break;
+			case 11: target.OMSetDepthStencilState(static_cast<ID3D11DepthStencilState*>(pick(6)), next(2)); break;
+			case 12: target.OMSetBlendState(static_cast<ID3D11BlendState*>(pick(7)), next(3) ? factors[next(2)] : nullptr, 0xffffffff); break;
+			default:
+				if (next(8))
+				{
+					Recorder(target).DrawIndexed(3, 0, 0);
+				}
+				else
+				{
+					Recorder(target).RSSetState(static_cast<ID3D11RasterizerState*>(pick(5)));
+					Recorder(target).PSSetShaderResources(startSlot, count, reinterpret_cast<ID3D11ShaderResourceView* const*>(objects));
+					Invalidate(target);
+				}
+				break;
+			}
+		}
+	}
+
+	// A frame of the scene, calling what Render and MeshRegistry call with stand-ins for
+	// what the names name. Each mesh has a vertex arena of its own and they share the index
+	// arena.
+	template <typename Target>
+	void DrawScene(Target& target, const SceneStore& scene)
+	{
+		ID3D11Buffer* const constants = StandIn<ID3D11Buffer>(8, 0);
+		target.VSSetConstantBuffers(0, 1, &constants);
+		target.PSSetConstantBuffers(0, 1, &constants);
+
+		const FLOAT blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		size_t boundMaterial = SIZE_MAX;
+		for (size_t i = 0; i < scene.EntityCount(); ++i)
+		{
+			const uint16_t materialIndex = scene.EntityMaterials()[i];
+			if (materialIndex != boundMaterial)
+			{
+				const SCENE_MATERIAL& material = scene.Material(materialIndex);
+				if (material.vertexShader != SCENE_NO_NAME)
+				{
+					target.IASetInputLayout(StandIn<ID3D11InputLayout>(1, material.vertexShader));
+					target.VSSetShader(StandIn<ID3D11VertexShader>(3, material.vertexShader), nullptr, 0);
+				}
+				if (material.pixelShader != SCENE_NO_NAME)
+					target.PSSetShader(StandIn<ID3D11PixelShader>(4, material.pixelShader), nullptr, 0);
+				if (material.sampler != SCENE_NO_NAME)
+				{
+					ID3D11SamplerState* const sampler = StandIn<ID3D11SamplerState>(9, material.sampler);
+					target.PSSetSamplers(0, 1, &sampler);
+				}
+				for (UINT slot = 0; slot < SCENE_MATERIAL_TEXTURES; ++slot)
+				{
+					if (material.textures[slot] != SCENE_NO_NAME)
+					{
+						ID3D11ShaderResourceView* const view = StandIn<ID3D11ShaderResourceView>(10, material.textures[slot]);
+						target.PSSetShaderResources(slot, 1, &view);
+					}
+				}
+				if (material.depthState != SCENE_NO_NAME)
+					target.OMSetDepthStencilState(StandIn<ID3D11DepthStencilState>(6, material.depthState), 1);
+				if (material.rasterState != SCENE_NO_NAME)
+					target.RSSetState(StandIn<ID3D11RasterizerState>(5, material.rasterState));
+				if (material.blendState != SCENE_NO_NAME)
+					target.OMSetBlendState(StandIn<ID3D11BlendState>(7, material.blendState), blendFactor, 0xffffffff);
+				boundMaterial = materialIndex;
+			}
+
+			ID3D11Buffer* const vertexArena = StandIn<ID3D11Buffer>(11, scene.EntityMeshes()[i]);
+			const UINT stride = 32;
+			const UINT offset = 0;
+			target.IASetVertexBuffers(0, 1, &vertexArena, &stride, &offset);
+			target.IASetIndexBuffer(StandIn<ID3D11Buffer>(12, 0), DXGI_FORMAT_R16_UINT, 0);
+			Recorder(target).DrawIndexed(36, 0, 0);
+		}
+	}
+
+	bool SameDraws(const RecordingContext& a, const RecordingContext& b)
+	{
+		if (a.Draws().size() != b.Draws().size())
+			return false;
+		for (size_t i = 0; i < a.Draws().size(); ++i)
+		{
+			if (!SameState(a.Draws()[i], b.Draws()[i]))
+				return false;
+		}
+		return true;
+	}
+
+	int StateCacheCheck(int argc, wchar_t* argv[])
+	{
+		const size_t entityCount = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 10000;
+
+		const size_t callCount = 1000000;
+		RecordingContext direct;
+		MakeRandomCalls(direct, callCount);
+		RecordingContext recorded;
+		BasicStateCache<RecordingContext> cache(&recorded);
+		MakeRandomCalls(cache, callCount);
+		const bool randomSame = SameDraws(direct, recorded);
+		wprintf(L"%zu random calls: %zu draws, %zu calls reached the context through the cache%s\n", callCount, direct.Draws().size(),
+		        recorded.Calls(), randomSame ? L"" : L", DRAWN WITH DIFFERENT STATE");
+
+		const std::string text = BuildSceneText(entityCount);
+		SceneStore scene;
+		if (FAILED(ParseSceneText(text.data(), text.size(), scene)))
+		{
+			wprintf(L"generated scene does not parse\n");
+			return 1;
+		}
+
+		// Two frames, so the second starts with what the first left bound
+		RecordingContext sceneDirect;
+		RecordingContext sceneRecorded;
+		BasicStateCache<RecordingContext> sceneCache(&sceneRecorded);
+		for (int frame = 0; frame < 2; ++frame)
+		{
+			sceneCache.BeginFrame();
+			DrawScene(sceneDirect, scene);
+			DrawScene(sceneCache, scene);
+		}
+		const bool sceneSame = SameDraws(sceneDirect, sceneRecorded);
+		const STATE_CACHE_STATS& stats = sceneCache.ThisFrame();
+		const size_t frameCalls = stats.issued + stats.filtered;
+		wprintf(L"%zu entities, one frame: %zu state calls, %u issued and %u filtered (%.1f%%)%s\n", entityCount, frameCalls, stats.issued,
+		        stats.filtered, 100.0 * stats.filtered / frameCalls, sceneSame ? L"" : L", DRAWN WITH DIFFERENT STATE");
+
+		return randomSame && sceneSame ? 0 : 1;
+	}
+
+	// drawsort: packets shaped like a scene's, a handful of shaders, materials and meshes
+	// and one draw in five blended, at random depths
+	int DrawSort(int argc, wchar_t* argv[])
+	{
+		const size_t count = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 100000;
+
+		uint32_t seed = 1;
+		const auto next = [&seed]
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return (seed >> 8) / 16777216.0f;
+		};
+		std::vector<DRAW_PACKET> packets(count);
+		std::vector<uint32_t> materials(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t material = static_cast<uint32_t>(next() * 64);
+			materials[i] = material;
+			const bool blended = material % 5 == 0;
+			const uint32_t layer = i == 0 ? 0 : 1;
+			packets[i].key = MakeDrawKey(layer, blended, material / 8, material, static_cast<uint32_t>(next() * 16), next() * 1000.0f);
+			packets[i].payload = static_cast<uint32_t>(i);
+		}
+
+		// What Sort has to match: equal keys keep the order they were pushed in
+		std::vector<DRAW_PACKET> expected = packets;
+		const auto byKey = [](const DRAW_PACKET& a, const DRAW_PACKET& b) { return a.key < b.key; };
+		std::stable_sort(expected.begin(), expected.end(), byKey);
+
+		// Filling the queue is not part of the time, only the sort
+		DrawQueue queue;
+		queue.Reserve(count);
+		const auto timeSort = [&](const std::function<void()>& sort)
+		{
+			double best = 1e30;
+			for (int run = 0; run < 5; ++run)
+			{
+				queue.Clear();
+				for (const DRAW_PACKET& packet : packets)
+					queue.Push(packet.key, packet.payload);
+				const auto start = std::chrono::steady_clock::now();
+				sort();
+				best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			return best;
+		};
+
+		std::vector<DRAW_PACKET> sorted;
+		const double stableMs = timeSort([&]
+		{
+			sorted.assign(queue.Packets(), queue.Packets() + queue.Count());
+			std::stable_sort(sorted.begin(), sorted.end(), byKey);
+		});
+		const double radixMs = timeSort([&] { queue.Sort(); });
+
+		bool same = queue.Count() == count;
+		for (size_t i = 0; same && i < count; ++i)
+			same = queue.Packets()[i].key == expected[i].key && queue.Packets()[i].payload == expected[i].payload;
+
+		// The material changes drawing in this order makes, against the order pushed
+		const auto changes = [&materials](const DRAW_PACKET* const order, const size_t count)
+		{
+			size_t materialChanges = 0;
+			for (size_t i = 1; i < count; ++i)
+				materialChanges += materials[order[i].payload] != materials[order[i - 1].payload];
+			return materialChanges;
+		};
+
+		wprintf(L"%zu packets%s\n", count, same ? L"" : L", SORTED DIFFERENTLY FROM std::stable_sort");
+		wprintf(L"  %-18s %9.3f ms %6.2f ns per packet\n", L"std::stable_sort", stableMs, stableMs * 1e6 / count);
+		wprintf(L"  %-18s %9.3f ms %6.2f ns per packet  %5.1fx\n", L"DrawQueue::Sort", radixMs, radixMs * 1e6 / count, stableMs / radixMs);
+		wprintf(L"  material changes: %zu in the order pushed, %zu sorted\n", changes(packets.data(), count), changes(queue.Packets(), count));
+		return same ? 0 : 1;
+	}
+
+	// ring: one ring's random allocations against what a ring should do. 'owner' holds the
+	// pass that last handed out each byte, so a byte handed out twice in one pass shows.
+	bool CheckRing(const uint32_t capacity, const uint32_t alignment, const uint32_t largest, const size_t allocations, uint32_t& seed)
+	{
+		RingAllocator ring(capacity, alignment);
+		std::vector<uint64_t> owner(capacity, 0);
+		uint64_t head = 0;
+		bool started = false;
+		size_t wraps = 0;
+		for (size_t i = 0; i < allocations; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			const uint32_t size = 1 + (seed >> 8) % largest;
+			const uint64_t aligned = (head + alignment - 1) / alignment * alignment;
+			const bool mustWrap = !started || aligned + size > capacity;
+
+			bool wrapped = false;
+			const uint32_t offset = ring.Allocate(size, &wrapped);
+			if (offset == RingAllocator::INVALID_OFFSET || wrapped != mustWrap || offset % alignment != 0 ||
+			    uint64_t(offset) + size > capacity || offset != (mustWrap ? 0 : aligned))
+			{
+				wprintf(L"ring of %u aligned to %u: allocation %zu of %u at %u%s, expected %llu%s\n", capacity, alignment, i, size, offset,
+				        wrapped ? L" wrapped" : L"", mustWrap ? 0ull : static_cast<unsigned long long>(aligned), mustWrap ? L" wrapped" : L"");
+				return false;
+			}
+
+			const uint64_t pass = ring.Passes();
+			for (uint32_t byte = offset; byte < offset + size; ++byte)
+			{
+				if (owner[byte] == pass)
+				{
+					wprintf(L"ring of %u aligned to %u: byte %u handed out twice in pass %llu\n", capacity, alignment, byte,
+					        static_cast<unsigned long long>(pass));
+					return false;
+				}
+				owner[byte] = pass;
+			}
+			head = offset + size;
+			started = true;
+			wraps += wrapped ? 1 : 0;
+		}
+		if (ring.Passes() != wraps)
+		{
+			wprintf(L"ring of %u aligned to %u: %llu passes counted, %zu wraps seen\n", capacity, alignment,
+			        static_cast<unsigned long long>(ring.Passes()), wraps);
+			return false;
+		}
+		wprintf(L"  %8u bytes aligned to %3u, sizes 1-%-5u %8zu passes\n", capacity, alignment, largest, wraps);
+		return true;
+	}
+
+	int Ring(int argc, wchar_t* argv[])
+	{
+		const size_t allocations = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 1000000;
+
+		// Rings one range just fits, rings of a few ranges and rings of thousands, with sizes
+		// that are and are not multiples of the alignment
+		struct RING_CASE { uint32_t capacity, alignment, largest; };
+		const RING_CASE cases[] = {
+			{ 256, 256, 256 }, { 1000, 16, 1000 }, { 4096, 256, 256 }, { 4096, 256, 300 },
+			{ 65536, 16, 4096 }, { 65536, 256, 64 }, { 4 * 1024 * 1024, 256, 256 },
+		};
+		wprintf(L"%zu random allocations per ring\n", allocations);
+		uint32_t seed = 1;
+		bool ok = true;
+		for (const RING_CASE& ringCase : cases)
+			ok = CheckRing(ringCase.capacity, ringCase.alignment, ringCase.largest, allocations, seed) && ok;
+
+		// Four slots fill the ring exactly and the fifth wraps; what does not fit at all
+		// leaves the ring where it was
+		RingAllocator ring(1024, 256);
+		bool wrapped = false;
+		bool edges = ring.Allocate(256, &wrapped) == 0 && wrapped;
+		for (uint32_t slot = 1; slot < 4; ++slot)
+			edges = ring.Allocate(256, &wrapped) == slot * 256 && !wrapped && edges;
+		edges = ring.Allocate(0, &wrapped) == RingAllocator::INVALID_OFFSET && !wrapped && edges;
+		edges = ring.Allocate(1025, &wrapped) == RingAllocator::INVALID_OFFSET && !wrapped && edges;
+		edges = ring.Allocate(1, &wrapped) == 0 && wrapped && ring.Passes() == 2 && edges;
+		edges = ring.Allocate(1024, &wrapped) == 0 && wrapped && ring.Passes() == 3 && edges;
+		edges = ring.Allocate(64, &wrapped) == 0 && wrapped && edges;
+		edges = ring.Allocate(64, &wrapped) == 256 && !wrapped && edges;
+		ring.Reset();
+		edges = ring.Allocate(64, &wrapped) == 0 && wrapped && ring.Passes() == 5 && edges;
+		wprintf(L"  edge cases%s\n", edges ? L"" : L" FAILED");
+		ok = ok && edges;
+
+		// What a draw uploads: the one buffer Render rewrote for every draw held the frame's
+		// matrices and lights as well, where the ring only takes the world matrix. A slot is
+		// sixteen constants, the least a *SetConstantBuffers1 offset can step.
+		const size_t before = 3 * sizeof(XMMATRIX) + 5 * sizeof(XMVECTOR);
+		const size_t after = sizeof(XMMATRIX);
+		const uint32_t ringBytes = 4 * 1024 * 1024;
+		const uint32_t slotBytes = 256;
+		wprintf(L"constants uploaded per draw: %zu bytes before, %zu now (%.2fx less)\n", before, after, double(before) / after);
+		for (const uint32_t draws : { 1000u, 10000u, 100000u })
+		{
+			RingAllocator frames(ringBytes, slotBytes);
+			for (uint32_t draw = 0; draw < draws * 10; ++draw)
+				frames.Allocate(slotBytes, &wrapped);
+			wprintf(L"  %6u draws a frame: %.2f wraps (DISCARD maps) a frame in a %u KB ring\n", draws, frames.Passes() / 10.0,
+			        ringBytes / 1024);
+		}
+		return ok ? 0 : 1;
+	}
+
+	// bcdecode: one block per case with the pixels it decodes to worked out by hand from
+	// the format descriptions, not from BCDecode.cpp. The BC1-BC5 endpoints were picked so
+	// the reference decoder's rounding and the hardware's agree; 0x2204 is (4,16,4) in
+	// 5:6:5, which has to come out as (33,65,33).
+	struct BC_KNOWN_ANSWER
+	{
+		const wchar_t* name;
+		DXGI_FORMAT format;
+		uint8_t block[16];
+		int expected[64];   // RGBA8, the SNORM channels as signed values, or BC6H half bits
+	};
+
+	const BC_KNOWN_ANSWER s_bcKnownAnswers[] =
+	{
+		{ L"BC1, four colours", DXGI_FORMAT_BC1_UNORM,
+			{ 0xFF, 0xFF, 0x04, 0x22, 0xE4, 0xE4, 0xE4, 0xE4 },
+			{
+				255, 255, 255, 255, 33, 65, 33, 255, 181, 192, 181, 255, 107, 128, 107, 255,
+				255, 255, 255, 255, 33, 65, 33, 255, 181, 192, 181, 255, 107, 128, 107, 255,
+				255, 255, 255, 255, 33, 65, 33, 255, 181, 192, 181, 255, 107, 128, 107, 255,
+				255, 255, 255, 255, 33, 65, 33, 255, 181, 192, 181, 255, 107, 128, 107, 255,
+			} },
+		{ L"BC1, three colours and transparent", DXGI_FORMAT_BC1_UNORM,
+			{ 0x04, 0x22, 0xFF, 0xFF, 0xE4, 0xE4, 0xE4, 0xE4 },
+			{
+				33, 65, 33, 255, 255, 255, 255, 255, 144, 160, 144, 255, 0, 0, 0, 0,
+				33, 65, 33, 255, 255, 255, 255, 255, 144, 160, 144, 255, 0, 0, 0, 0,
+				33, 65, 33, 255, 255, 255, 255, 255, 144, 160, 144, 255, 0, 0, 0, 0,
+				33, 65, 33, 255, 255, 255, 255, 255, 144, 160, 144, 255, 0, 0, 0, 0,
+			} },
+		{ L"BC2", DXGI_FORMAT_BC2_UNORM,
+			{ 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x04, 0x22, 0xFF, 0xFF, 0xE4, 0xE4, 0xE4, 0xE4 },
+			{
+				33, 65, 33, 0, 255, 255, 255, 17, 107, 128, 107, 34, 181, 192, 181, 51,
+				33, 65, 33, 68, 255, 255, 255, 85, 107, 128, 107, 102, 181, 192, 181, 119,
+				33, 65, 33, 136, 255, 255, 255, 153, 107, 128, 107, 170, 181, 192, 181, 187,
+				33, 65, 33, 204, 255, 255, 255, 221, 107, 128, 107, 238, 181, 192, 181, 255,
+			} },
+		{ L"BC3, eight alphas", DXGI_FORMAT_BC3_UNORM,
+			{ 0xD9, 0x07, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x04, 0x22, 0xFF, 0xFF, 0xE4, 0xE4, 0xE4, 0xE4 },
+			{
+				33, 65, 33, 217, 255, 255, 255, 7, 107, 128, 107, 187, 181, 192, 181, 157,
+				33, 65, 33, 127, 255, 255, 255, 97, 107, 128, 107, 67, 181, 192, 181, 37,
+				33, 65, 33, 217, 255, 255, 255, 7, 107, 128, 107, 187, 181, 192, 181, 157,
+				33, 65, 33, 127, 255, 255, 255, 97, 107, 128, 107, 67, 181, 192, 181, 37,
+			} },
+		{ L"BC4, six values, 0 and 255", DXGI_FORMAT_BC4_UNORM,
+			{ 0x07, 0xD9, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+			{
+				7, 0, 0, 255, 217, 0, 0, 255, 49, 0, 0, 255, 91, 0, 0, 255,
+				133, 0, 0, 255, 175, 0, 0, 255, 0, 0, 0, 255, 255, 0, 0, 255,
+				7, 0, 0, 255, 217, 0, 0, 255, 49, 0, 0, 255, 91, 0, 0, 255,
+				133, 0, 0, 255, 175, 0, 0, 255, 0, 0, 0, 255, 255, 0, 0, 255,
+			} },
+		{ L"BC4 SNORM", DXGI_FORMAT_BC4_SNORM,
+			{ 0x69, 0x97, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+			{
+				105, 0, 0, 127, -105, 0, 0, 127, 75, 0, 0, 127, 45, 0, 0, 127,
+				15, 0, 0, 127, -15, 0, 0, 127, -45, 0, 0, 127, -75, 0, 0, 127,
+				105, 0, 0, 127, -105, 0, 0, 127, 75, 0, 0, 127, 45, 0, 0, 127,
+				15, 0, 0, 127, -15, 0, 0, 127, -45, 0, 0, 127, -75, 0, 0, 127,
+			} },
+		{ L"BC5", DXGI_FORMAT_BC5_UNORM,
+			{ 0xD9, 0x07, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x07, 0xD9, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+			{
+				217, 7, 0, 255, 7, 217, 0, 255, 187, 49, 0, 255, 157, 91, 0, 255,
+				127, 133, 0, 255, 97, 175, 0, 255, 67, 0, 0, 255, 37, 255, 0, 255,
+				217, 7, 0, 255, 7, 217, 0, 255, 187, 49, 0, 255, 157, 91, 0, 255,
+				127, 133, 0, 255, 97, 175, 0, 255, 67, 0, 0, 255, 37, 255, 0, 255,
+			} },
+		{ L"BC5 SNORM, six values, -1 and 1", DXGI_FORMAT_BC5_SNORM,
+			{ 0x69, 0x97, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x97, 0x69, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+			{
+				105, -105, 0, 127, -105, 105, 0, 127, 75, -63, 0, 127, 45, -21, 0, 127,
+				15, 21, 0, 127, -15, 63, 0, 127, -45, -127, 0, 127, -75, 127, 0, 127,
+				105, -105, 0, 127, -105, 105, 0, 127, 75, -63, 0, 127, 45, -21, 0, 127,
+				15, 21, 0, 127, -15, 63, 0, 127, -45, -127, 0, 127, -75, 127, 0, 127,
+			} },
+		{ L"BC6H UF16, mode 11", DXGI_FORMAT_BC6H_UF16,
+			{ 0x03, 0x00, 0x32, 0xFE, 0xFF, 0x9F, 0x3E, 0x00, 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE },
+			{
+				0, 3115, 31743, 15360, 1984, 3890, 29759, 15360, 4464, 4859, 27279, 15360, 6448, 5634, 25295, 15360,
+				8432, 6409, 23311, 15360, 10416, 7184, 21327, 15360, 12896, 8153, 18847, 15360, 14880, 8928, 16863, 15360,
+				16863, 9703, 14880, 15360, 18847, 10478, 12896, 15360, 21327, 11446, 10416, 15360, 23311, 12221, 8432, 15360,
+				25295, 12996, 6448, 15360, 27279, 13771, 4464, 15360, 29759, 14740, 1984, 15360, 31743, 15515, 0, 15360,
+			} },
+		{ L"BC6H SF16, mode 11", DXGI_FORMAT_BC6H_SF16,
+			{ 0x23, 0x40, 0xCE, 0x59, 0xFA, 0x0F, 0x00, 0x6A, 0x11, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE },
+			{
+				64511, 38999, 18631, 15360, 60543, 38609, 16302, 15360, 55583, 38122, 13391, 15360, 51615, 37732, 11062, 15360,
+				47648, 37343, 8733, 15360, 43680, 36953, 6404, 15360, 38720, 36467, 3493, 15360, 34752, 36078, 1164, 15360,
+				1984, 35688, 33932, 15360, 5952, 35299, 36261, 15360, 10912, 34812, 39172, 15360, 14880, 34422, 41501, 15360,
+				18847, 34033, 43830, 15360, 22815, 33643, 46159, 15360, 27775, 33157, 49070, 15360, 31743, 0, 51399, 15360,
+			} },
+		{ L"BC7, mode 6", DXGI_FORMAT_BC7_UNORM,
+			{ 0x40, 0x08, 0xFC, 0x0F, 0x00, 0x06, 0xFF, 0xFF, 0x11, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE },
+			{
+				33, 255, 129, 255, 45, 239, 129, 255, 60, 219, 129, 255, 72, 203, 129, 255,
+				84, 188, 130, 255, 96, 172, 130, 255, 111, 152, 130, 255, 123, 136, 130, 255,
+				135, 120, 130, 255, 147, 104, 130, 255, 162, 84, 130, 255, 174, 68, 130, 255,
+				186, 53, 131, 255, 198, 37, 131, 255, 213, 17, 131, 255, 225, 1, 131, 255,
+			} },
+		{ L"BC7, mode 1, partition 0", DXGI_FORMAT_BC7_UNORM,
+			{ 0x02, 0xC0, 0xAF, 0xC8, 0x14, 0xFA, 0x03, 0x3F, 0xE0, 0x7D, 0x92, 0x4C, 0x63, 0xFD, 0xBB, 0x1C },
+			{
+				0, 80, 253, 255, 36, 91, 217, 255, 65, 219, 123, 255, 110, 148, 124, 255,
+				71, 103, 182, 255, 107, 114, 146, 255, 135, 109, 124, 255, 158, 73, 125, 255,
+				217, 150, 36, 255, 253, 161, 0, 255, 203, 2, 126, 255, 180, 38, 125, 255,
+				182, 138, 71, 255, 146, 127, 107, 255, 110, 148, 124, 255, 42, 255, 122, 255,
+			} },
+	};
+
+	bool IsSnorm(const DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_BC4_SNORM || format == DXGI_FORMAT_BC5_SNORM;
+	}
+
+	bool IsBC6H(const DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_BC6H_UF16 || format == DXGI_FORMAT_BC6H_SF16;
+	}
+
+	// Decodes one known-answer block and prints the first pixel that differs. The SNORM
+	// formats and BC6H are decoded to RGBA16F, which keeps their values as they are.
+	bool CheckKnownAnswer(const BC_KNOWN_ANSWER& answer)
+	{
+		const bool half = IsSnorm(answer.format) || IsBC6H(answer.format);
+		D3D11_SUBRESOURCE_DATA source = {};
+		source.pSysMem = answer.block;
+		source.SysMemPitch = sizeof(answer.block);
+		uint8_t rgba8[64];
+		uint16_t rgba16f[64];
+		const HRESULT hr = half ? DecodeBCSurface(answer.format, 4, 4, source, BC_DECODE_RGBA16F, rgba16f, 4 * 8)
+		                        : DecodeBCSurface(answer.format, 4, 4, source, BC_DECODE_RGBA8, rgba8, 4 * 4);
+		if (FAILED(hr))
+		{
+			wprintf(L"  %-36s DecodeBCSurface failed (0x%08X)\n", answer.name, static_cast<unsigned int>(hr));
+			return false;
+		}
+
+		for (int i = 0; i < 64; ++i)
+		{
+			int decoded;
+			if (IsBC6H(answer.format))
+				decoded = rgba16f[i];
+			else if (half)
+				decoded = static_cast<int>(floorf(DirectX::PackedVector::XMConvertHalfToFloat(rgba16f[i]) * 127.0f + 0.5f));
+			else
+				decoded = rgba8[i];
+			if (decoded != answer.expected[i])
+			{
+				wprintf(L"  %-36s pixel %d channel %d is %d, expected %d\n", answer.name, i / 4, i % 4, decoded, answer.expected[i]);
+				return false;
+			}
+		}
+		wprintf(L"  %-36s ok\n", answer.name);
+		return true;
+	}
+
+	int BCDecode(int argc, wchar_t* argv[])
+	{
+		const size_t size = argc > 0 ? std::max<size_t>(_wtoi(argv[0]) / 4 * 4, 4) : 1024;
+
+		wprintf(L"known answers\n");
+		bool ok = true;
+		for (const BC_KNOWN_ANSWER& answer : s_bcKnownAnswers)
+			ok = CheckKnownAnswer(answer) && ok;
+
+		// Throughput on random blocks, which cover every BC6H and BC7 mode and partition; the
+		// reserved BC6H and BC7 modes among them decode to black as they would on the GPU
+		const struct
+		{
+			const wchar_t* name;
+			DXGI_FORMAT format;
+			size_t blockBytes;
+		} formats[] =
+		{
+			{ L"BC1", DXGI_FORMAT_BC1_UNORM, 8 }, { L"BC2", DXGI_FORMAT_BC2_UNORM, 16 }, { L"BC3", DXGI_FORMAT_BC3_UNORM, 16 },
+			{ L"BC4", DXGI_FORMAT_BC4_UNORM, 8 }, { L"BC5", DXGI_FORMAT_BC5_UNORM, 16 }, { L"BC6H UF16", DXGI_FORMAT_BC6H_UF16, 16 },
+			{ L"BC7", DXGI_FORMAT_BC7_UNORM, 16 },
+		};
+		std::vector<uint8_t> blocks(size / 4 * size / 4 * 16);
+		uint32_t seed = 1;
+		for (uint8_t& byte : blocks)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			byte = static_cast<uint8_t>(seed >> 24);
+		}
+		std::vector<uint8_t> decoded(size * size * 8);
+		const double megapixels = static_cast<double>(size * size) / 1e6;
+
+		wprintf(L"%zux%zu, one thread\n", size, size);
+		for (const auto& format : formats)
+		{
+			D3D11_SUBRESOURCE_DATA source = {};
+			source.pSysMem = blocks.data();
+			source.SysMemPitch = static_cast<UINT>(size / 4 * format.blockBytes);
+			const BC_DECODE_TARGET target = IsBC6H(format.format) ? BC_DECODE_RGBA16F : BC_DECODE_RGBA8;
+			const size_t pitch = size * (target == BC_DECODE_RGBA8 ? 4 : 8);
+			const double ms = TimeBest([&] { DecodeBCSurface(format.format, size, size, source, target, decoded.data(), pitch); });
+			wprintf(L"  %-10s to %-7s %8.2f ms %8.1f MPixels/s\n", format.name, target == BC_DECODE_RGBA8 ? L"RGBA8" : L"RGBA16F",
+			        ms, megapixels / ms * 1000.0);
+		}
+		return ok ? 0 : 1;
+	}
+
+	// Stands in for ID3D11Device when checking TextureCache. Its "DDS images" are just
+	// buffers: a texture takes as many bytes as the image, and one starting with 0 fails to
+	// create. It counts the views alive, so the check can see the cache releases each one.
+	class CountedView
+	{
+	public:
+		explicit CountedView(size_t& alive) : m_alive(alive), m_references(1) { ++m_alive; }
+
+		ULONG AddRef() { return ++m_references; }
+		ULONG Release()
+		{
+			const ULONG references = --m_references;
+			if (!references)
+			{
+				--m_alive;
+				delete this;
+			}
+			return references;
+		}
+
+	private:
+		size_t& m_alive;
+		ULONG m_references;
+	};
+
+	class CountingDevice
+	{
+	public:
+		size_t alive = 0;
+		size_t created = 0;
+	};
+
+	HRESULT CreateCachedTexture(CountingDevice* const device, const uint8_t* const ddsData, const size_t ddsDataSize, size_t,
+	                            CountedView** const textureView, size_t* const gpuBytes)
+	{
+		if (!ddsDataSize || !ddsData[0])
+			return E_FAIL;
+
+		*textureView = new CountedView(device->alive);
+		*gpuBytes = ddsDataSize;
+		++device->created;
+		return S_OK;
+	}
+
+	typedef BasicTextureCache<CountingDevice, CountedView> CountingTextureCache;
+
+	bool SameStats(const CountingTextureCache::Stats& stats, const uint64_t hits, const uint64_t contentHits, const uint64_t misses,
+	               const uint64_t evictions, const size_t entries, const size_t gpuBytes)
+	{
+		return stats.hits == hits && stats.contentHits == contentHits && stats.misses == misses && stats.evictions == evictions &&
+		       stats.entries == entries && stats.gpuBytes == gpuBytes;
+	}
+
+	int TextureCacheCheck(int argc, wchar_t* argv[])
+	{
+		const size_t operations = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 1) : 100000;
+		const size_t KB = 1024;
+		bool ok = true;
+
+		// The cases one at a time: hits by path whatever its case, a new path to the same data,
+		// another maxsize, a failed create, and evictions by insert and by SetBudget
+		CountingDevice device;
+		{
+			const std::vector<uint8_t> quarter(256 * KB, 1);
+			const std::vector<uint8_t> half(512 * KB, 1);
+			const std::vector<uint8_t> broken(256 * KB, 0);
+			CountingTextureCache cache(1024 * KB);
+			CountedView* view = nullptr;
+			const auto insert = [&](const wchar_t* fileName, const std::vector<uint8_t>& data, uint64_t hash)
+			{
+				const HRESULT hr = cache.Insert(&device, fileName, 0, data.data(), data.size(), hash, &view);
+				if (SUCCEEDED(hr))
+					view->Release();
+				return SUCCEEDED(hr);
+			};
+			const auto find = [&](const wchar_t* fileName, size_t maxsize)
+			{
+				if (!cache.Find(fileName, maxsize, &view))
+					return false;
+				view->Release();
+				return true;
+			};
+			bool steps = insert(L"a.dds", quarter, 1) && SameStats(cache.GetStats(), 0, 0, 1, 0, 1, 256 * KB);
+			steps = find(L"a.dds", 0) && find(L"A.DDS", 0) && !find(L"a.dds", 1) && !find(L"b.dds", 0) &&
+			        SameStats(cache.GetStats(), 2, 0, 1, 0, 1, 256 * KB) && steps;
+			steps = insert(L"b.dds", quarter, 1) && find(L"b.dds", 0) && SameStats(cache.GetStats(), 3, 1, 1, 0, 1, 256 * KB) && steps;
+			steps = insert(L"c.dds", quarter, 2) && insert(L"d.dds", quarter, 3) && SameStats(cache.GetStats(), 3, 1, 3, 0, 3, 768 * KB) && steps;
+
+			// a was used last, so e pushes c out: four textures and the bookkeeping pass 1 MB
+			steps = find(L"a.dds", 0) && insert(L"e.dds", quarter, 4) && SameStats(cache.GetStats(), 4, 1, 4, 1, 3, 768 * KB) && steps;
+			steps = !find(L"c.dds", 0) && find(L"b.dds", 0) && steps;
+			steps = !insert(L"f.dds", broken, 5) && SameStats(cache.GetStats(), 5, 1, 4, 1, 3, 768 * KB) && steps;
+
+			// Down to the most recently used, then one texture larger than the budget on its own
+			cache.SetBudget(300 * KB);
+			steps = SameStats(cache.GetStats(), 5, 1, 4, 3, 1, 256 * KB) && find(L"b.dds", 0) && find(L"a.dds", 0) && steps;
+			steps = insert(L"g.dds", half, 6) && SameStats(cache.GetStats(), 7, 1, 5, 4, 1, 512 * KB) && find(L"g.dds", 0) && steps;
+			steps = device.alive == 1 && steps;
+			cache.Clear();
+			const CountingTextureCache::Stats cleared = cache.GetStats();
+			steps = SameStats(cleared, 8, 1, 5, 4, 0, 0) && cleared.cpuBytes == 0 && device.alive == 0 && steps;
+			wprintf(L"  edge cases%s\n", steps ? L"" : L" FAILED");
+			ok = steps;
+		}
+
+		// Random finds and inserts over 256 files against a model of the cache: an LRU list
+		// of textures, each with the files that resolve to it, and the counters it should
+		// have. Every four files share their data, so new paths to cached data hit by
+		// content. Names are all as long, so every entry and every path costs the same
+		// bookkeeping, measured first on a cache of its own.
+		{
+			const size_t fileCount = 256;
+			const size_t contentCount = 64;
+			std::vector<std::vector<uint8_t>> contents(contentCount);
+			std::vector<std::wstring> names(fileCount);
+			uint32_t seed = 1;
+			const auto next = [&seed]
+			{
+				seed = seed * 1664525u + 1013904223u;
+				return seed >> 8;
+			};
+			for (std::vector<uint8_t>& content : contents)
+				content.assign((1 + next() % 64) * KB, 1);
+			for (size_t file = 0; file < fileCount; ++file)
+				names[file] = L"textures/tex" + std::to_wstring(1000 + file) + L".dds";
+
+			size_t entryBytes = 0;
+			size_t pathBytes = 0;
+			CountedView* view = nullptr;
+			{
+				CountingTextureCache measure(SIZE_MAX);
+				measure.Insert(&device, names[0].c_str(), 0, contents[0].data(), contents[0].size(), 0, &view);
+				view->Release();
+				const size_t one = measure.GetStats().cpuBytes;
+				measure.Insert(&device, names[1].c_str(), 0, contents[0].data(), contents[0].size(), 0, &view);
+				view->Release();
+				pathBytes = measure.GetStats().cpuBytes - one;
+				entryBytes = one - pathBytes;
+			}
+
+			struct MODEL_ENTRY
+			{
+				size_t content;
+				std::vector<size_t> files;
+			};
+			const size_t budget = 1024 * KB;
+			CountingTextureCache cache(budget);
+			std::vector<MODEL_ENTRY> lru;   // most recently used first
+			uint64_t hits = 0, contentHits = 0, misses = 0, evictions = 0;
+			size_t gpuBytes = 0;
+			size_t cpuBytes = 0;
+			const auto entryCost = [&](const MODEL_ENTRY& entry) { return entryBytes + entry.files.size() * pathBytes; };
+
+			bool model = true;
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t operation = 0; operation < operations && model; ++operation)
+			{
+				const size_t file = next() % fileCount;
+				const size_t content = file % contentCount;
+				const wchar_t* const fileName = names[file].c_str();
+				const auto byFile = std::find_if(lru.begin(), lru.end(), [file](const MODEL_ENTRY& entry)
+				{
+					return std::find(entry.files.begin(), entry.files.end(), file) != entry.files.end();
+				});
+				const auto byContent = std::find_if(lru.begin(), lru.end(), [content](const MODEL_ENTRY& entry) { return entry.content == content; });
+
+				MODEL_ENTRY touched;
+				if (cache.Find(fileName, 0, &view))
+				{
+					view->Release();
+					model = byFile != lru.end();
+					if (!model)
+						break;
+					touched = *byFile;
+					lru.erase(byFile);
+					++hits;
+				}
+				else
+				{
+					model = byFile == lru.end() && SUCCEEDED(cache.Insert(&device, fileName, 0, contents[content].data(),
+					                                                      contents[content].size(), content, &view));
+					if (!model)
+						break;
+					view->Release();
+					if (byContent != lru.end())
+					{
+						touched = *byContent;
+						lru.erase(byContent);
+						++contentHits;
+					}
+					else
+					{
+						touched.content = content;
+						gpuBytes += contents[content].size();
+						cpuBytes += entryBytes;
+						++misses;
+					}
+					touched.files.push_back(file);
+					cpuBytes += pathBytes;
+				}
+				lru.insert(lru.begin(), touched);
+
+				while (gpuBytes + cpuBytes > budget && lru.size() > 1)
+				{
+					gpuBytes -= contents[lru.back().content].size();
+					cpuBytes -= entryCost(lru.back());
+					lru.pop_back();
+					++evictions;
+				}
+
+				const CountingTextureCache::Stats stats = cache.GetStats();
+				model = SameStats(stats, hits, contentHits, misses, evictions, lru.size(), gpuBytes) && stats.cpuBytes == cpuBytes &&
+				        stats.gpuBytes + stats.cpuBytes <= budget && device.alive == lru.size();
+			}
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			const CountingTextureCache::Stats stats = cache.GetStats();
+			wprintf(L"  %zu random finds over %zu files of %zu textures in a %zu KB budget: %llu hits, %llu by content, %llu misses, "
+			        L"%llu evictions, %zu resident (%zu KB), %.2f us each%s\n", operations, fileCount, contentCount, budget / KB, stats.hits,
+			        stats.contentHits, stats.misses, stats.evictions, stats.entries, (stats.gpuBytes + stats.cpuBytes) / KB,
+			        ms * 1000.0 / operations, model ? L"" : L" DIFFERS FROM THE MODEL");
+			cache.Clear();
+			ok = model && device.alive == 0 && ok;
+		}
+		return ok ? 0 : 1;
+	}
+
+	// Stands in for DeviceTextureSink when checking TextureLoadQueue: it creates nothing,
+	// and checks that each image it is given is the file the check wrote, with its mips.
+	// Files whose names say so it already holds, or refuses to create.
+	class NullTextureSink : public TextureSink
+	{
+	public:
+		NullTextureSink(const size_t size, const size_t levels) : m_size(size), m_levels(levels) {}
+
+		bool Find(const wchar_t* const fileName, size_t, ID3D11ShaderResourceView** const textureView) override
+		{
+			if (!wcsstr(fileName, L"held"))
+				return false;
+			*textureView = nullptr;
+			++found;
+			return true;
+		}
+
+		bool WantsContentHash() const override { return false; }
+
+		HRESULT Create(const wchar_t* const fileName, size_t, const uint8_t* const ddsData, const size_t ddsDataSize, uint64_t,
+		               ID3D11ShaderResourceView** const textureView) override
+		{
+			++created;
+			*textureView = nullptr;
+			if (wcsstr(fileName, L"refused"))
+				return E_NOTIMPL;
+
+			// Every texel of the top level holds the number in the file's name
+			const size_t topBytes = m_size * m_size * 4;
+			const DDS_HEADER* const header = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+			const uint32_t number = static_cast<uint32_t>(wcstoul(wcspbrk(fileName, L"0123456789"), nullptr, 10));
+			bool same = ddsDataSize == sizeof(uint32_t) + sizeof(DDS_HEADER) + MipChainSize(DXGI_FORMAT_R8G8B8A8_UNORM, m_size, m_size, 1) &&
+			            header->mipMapCount == m_levels;
+			for (size_t offset = 0; offset < topBytes && same; offset += 4)
+				same = memcmp(ddsData + sizeof(uint32_t) + sizeof(DDS_HEADER) + offset, &number, 4) == 0;
+			wrong += same ? 0 : 1;
+			return S_OK;
+		}
+
+		size_t found = 0;
+		size_t created = 0;
+		size_t wrong = 0;
+
+	private:
+		const size_t m_size;
+		const size_t m_levels;
+	};
+
+	int LoadQueueCheck(int argc, wchar_t* argv[])
+	{
+		const size_t fileCount = argc > 0 ? std::max<size_t>(_wtoi(argv[0]), 16) : 256;
+		const size_t size = 64;
+		const size_t maxReady = 4;
+
+		// One file in sixteen is missing, one is not a DDS file, one the sink refuses and one
+		// it already holds; the rest are 64x64 RGBA8 images without mips
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_PITCH;
+		header.height = static_cast<uint32_t>(size);
+		header.width = static_cast<uint32_t>(size);
+		header.pitchOrLinearSize = static_cast<uint32_t>(size * 4);
+		header.mipMapCount = 1;
+		header.ddspf = DDS_PIXELFORMAT{ sizeof(DDS_PIXELFORMAT), DDS_RGB | DDS_ALPHAPIXELS, 0, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 };
+		header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+		enum FILE_KIND { FILE_GOOD, FILE_MISSING, FILE_CORRUPT, FILE_REFUSED, FILE_HELD };
+		std::vector<std::wstring> names(fileCount);
+		std::vector<FILE_KIND> kinds(fileCount);
+		size_t counts[5] = {};
+		for (size_t i = 0; i < fileCount; ++i)
+		{
+			static const FILE_KIND special[] = { FILE_MISSING, FILE_CORRUPT, FILE_REFUSED, FILE_HELD };
+			kinds[i] = i % 16 < 4 ? special[i % 16] : FILE_GOOD;
+			++counts[kinds[i]];
+			static const wchar_t* const prefixes[] = { L"loadqueue", L"loadqueue_missing", L"loadqueue", L"loadqueue_refused", L"loadqueue_held" };
+			names[i] = prefixes[kinds[i]] + std::to_wstring(i) + L".dds";
+			if (kinds[i] == FILE_MISSING || kinds[i] == FILE_HELD)
+				continue;
+
+			std::vector<uint8_t> data(sizeof(uint32_t) + sizeof(DDS_HEADER) + size * size * 4);
+			const uint32_t magic = kinds[i] == FILE_CORRUPT ? 0 : DDS_MAGIC;
+			memcpy(data.data(), &magic, sizeof(uint32_t));
+			memcpy(data.data() + sizeof(uint32_t), &header, sizeof(DDS_HEADER));
+			const uint32_t number = static_cast<uint32_t>(i);
+			for (size_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER); offset < data.size(); offset += 4)
+				memcpy(data.data() + offset, &number, 4);
+			if (FAILED(WriteWholeFile(names[i].c_str(), data.data(), data.size())))
+			{
+				wprintf(L"%s: cannot write\n", names[i].c_str());
+				return 1;
+			}
+		}
+
+		ThreadPool pool(4);
+		NullTextureSink sink(size, MipLevelCount(size, size));
+		std::vector<ID3D11ShaderResourceView*> views(fileCount);
+		std::vector<std::future<HRESULT>> results(fileCount);
+		bool bounded = true;
+		bool resolved = true;
+		HRESULT flushed = S_OK;
+		double ms = 0.0;
+		{
+			TextureLoadQueue queue(pool, sink, maxReady);
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < fileCount; ++i)
+				results[i] = queue.Submit(names[i].c_str(), &views[i]);
+
+			// Without Pump the readers fill the ready queue and then wait on it, every one of
+			// them once the pool's threads are all taken: the queue stays at maxReady and
+			// nothing else finishes, good or bad
+			for (int poll = 0; poll < 2000 && queue.Ready() < maxReady; ++poll)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			const size_t stalled = queue.Pending();
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			bounded = queue.Ready() == maxReady && queue.Pending() == stalled && stalled > pool.ThreadCount() && sink.created == 0;
+
+			size_t pumped = 0;
+			while (queue.Pending() > 0)
+			{
+				bounded = queue.Ready() <= maxReady && bounded;
+				pumped += queue.Pump();
+				std::this_thread::yield();
+			}
+			flushed = queue.Flush();
+			ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			bounded = pumped == counts[FILE_GOOD] && bounded;
+		}
+
+		size_t failed = 0;
+		for (size_t i = 0; i < fileCount; ++i)
+		{
+			if (results[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				resolved = false;
+				continue;
+			}
+			const HRESULT hr = results[i].get();
+			failed += FAILED(hr) ? 1 : 0;
+			const bool expected = kinds[i] == FILE_GOOD || kinds[i] == FILE_HELD ? SUCCEEDED(hr) : kinds[i] == FILE_REFUSED ? hr == E_NOTIMPL : FAILED(hr);
+			resolved = expected && resolved;
+			DeleteFileW(names[i].c_str());
+		}
+
+		const bool delivered = sink.wrong == 0 && sink.found == counts[FILE_HELD] && sink.created == counts[FILE_GOOD] + counts[FILE_REFUSED] &&
+		                       failed == counts[FILE_MISSING] + counts[FILE_CORRUPT] + counts[FILE_REFUSED] && FAILED(flushed);
+		wprintf(L"%zu files through a queue of %zu on %u threads: %zu created, %zu already held, %zu failed, %.1f ms%s%s%s\n", fileCount,
+		        maxReady, pool.ThreadCount(), sink.created, sink.found, failed, ms, bounded ? L"" : L", READY QUEUE NOT BOUNDED",
+		        resolved ? L"" : L", WRONG RESULTS", delivered ? L"" : L", WRONG IMAGES");
+		return bounded && resolved && delivered ? 0 : 1;
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc >= 2 && _wcsicmp(argv[1], L"encode") == 0)
+		return Encode(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"mipbench") == 0)
+		return MipBench(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"pack") == 0)
+		return Pack(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"openbench") == 0)
+		return OpenBench(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"compress") == 0)
+		return Compress(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"lzbench") == 0)
+		return LZBench(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"meshbench") == 0)
+		return MeshBench(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"meshopt") == 0)
+		return MeshOpt(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"quantize") == 0)
+		return Quantize(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"simplify") == 0)
+		return Simplify(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"meshlets") == 0)
+		return Meshlets(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"tangents") == 0)
+		return Tangents(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"arenas") == 0)
+		return Arenas(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"objbench") == 0)
+		return ObjBench(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"scenebench") == 0)
+		return SceneBench(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"transforms") == 0)
+		return Transforms(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"statecache") == 0)
+		return StateCacheCheck(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"drawsort") == 0)
+		return DrawSort(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"ring") == 0)
+		return Ring(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"bcdecode") == 0)
+		return BCDecode(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"texcache") == 0)
+		return TextureCacheCheck(argc - 2, argv + 2);
+
+	if (argc >= 2 && _wcsicmp(argv[1], L"loadqueue") == 0)
+		return LoadQueueCheck(argc - 2, argv + 2);
+
+	wprintf(L"%s", s_usage);
+	return 1;
+}
@@ -0,0 +1,121 @@
+#include "AssetArchive.h"
+#include "Hash.h"
+#include <algorithm>
+#include <wctype.h>
+
+HRESULT AssetArchive::Open(const wchar_t* const fileName)
+{
+	Close();
+
+	HRESULT hr = m_file.Open(fileName);
+	if (FAILED(hr))
+		return hr;
+
+	const uint8_t* const data = m_file.Data();
+	const uint64_t size = m_file.Size();
+
+	const ASSET_ARCHIVE_HEADER* const header = reinterpret_cast<const ASSET_ARCHIVE_HEADER*>(data);
+	if (size < sizeof(ASSET_ARCHIVE_HEADER) || header->magic != ASSET_ARCHIVE_MAGIC)
+		hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	else if (header->version != ASSET_ARCHIVE_VERSION)
+		hr = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	else if (header->tocOffset > size || header->entryCount > (size - header->tocOffset) / sizeof(ASSET_ARCHIVE_ENTRY) ||
+	         header->namesOffset > size || header->namesSize > size - header->namesOffset || (header->namesOffset & 1))
+		hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+	if (FAILED(hr))
+	{
+		Close();
+		return hr;
+	}
+
+	m_entries = reinterpret_cast<const ASSET_ARCHIVE_ENTRY*>(data + header->tocOffset);
+	m_names = reinterpret_cast<const uint16_t*>(data + header->namesOffset);
+	m_entryCount = header->entryCount;
+
+	// Everything Find hands out has to lie inside the mapping
+	const uint64_t nameChars = header->namesSize / sizeof(uint16_t);
+	for (size_t i = 0; i < m_entryCount; ++i)
+	{
+		const ASSET_ARCHIVE_ENTRY& entry = m_entries[i];
+		if (entry.offset > size || entry.storedSize > size - entry.offset || uint64_t(entry.nameOffset) + entry.nameLength > nameChars ||
+		    (i > 0 && m_entries[i - 1].nameHash > entry.nameHash))
+		{
+			Close();
+			return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+		}
+	}
+
+	return S_OK;
+}
+
+void AssetArchive::Close()
+{
+	m_file.Close();
+	m_entries = nullptr;
+	m_names = nullptr;
+	m_entryCount = 0;
+}
+
+std::wstring AssetArchive::NormalizeName(const wchar_t* const name)
+{
+	std::wstring normalized(name ? name : L"");
+	for (wchar_t& c : normalized)
+		c = c == L'\\' ? L'/' : static_cast<wchar_t>(towlower(c));
+
+	size_t start = 0;
+	while (normalized.compare(start, 2, L"./") == 0)
+		start += 2;
+	return normalized.substr(start);
+}
+
+uint64_t AssetArchive::HashName(const std::wstring& normalizedName)
+{
+	// Hashed as UTF-16 whatever the size of wchar_t, to match the name table
+	std::u16string units(normalizedName.begin(), normalizedName.end());
+	return HashBytes(units.data(), units.size() * sizeof(char16_t));
+}
+
+const ASSET_ARCHIVE_ENTRY* AssetArchive::FindEntry(const wchar_t* const name) const
+{
+	if (!name || !m_entries)
+		return nullptr;
+
+	const std::wstring normalized = NormalizeName(name);
+	const uint64_t hash = HashName(normalized);
+
+	const ASSET_ARCHIVE_ENTRY* const end = m_entries + m_entryCount;
+	auto entry = std::lower_bound(m_entries, end, hash, [](const ASSET_ARCHIVE_ENTRY& e, const uint64_t h) { return e.nameHash < h; });
+
+	// Colliding hashes sit next to each other; the stored name settles it
+	for (; entry != end && entry->nameHash == hash; ++entry)
+	{
+		if (entry->nameLength == normalized.size() &&
+		    std::equal(normalized.begin(), normalized.end(), m_names + entry->nameOffset,
+		               [](const wchar_t a, const uint16_t b) { return static_cast<uint16_t>(a) == b; }))
+		{
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+HRESULT AssetArchive::Find(const wchar_t* const name, const uint8_t** const data, size_t* const size) const
+{
+	if (!name || !data || !size)
+		return E_INVALIDARG;
+
+	*data = nullptr;
+	*size = 0;
+
+	const ASSET_ARCHIVE_ENTRY* const entry = FindEntry(name);
+	if (!entry)
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+	if (entry->compression != ASSET_COMPRESSION_NONE)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	*data = m_file.Data() + entry->offset;
+	*size = static_cast<size_t>(entry->storedSize);
+	return S_OK;
+}
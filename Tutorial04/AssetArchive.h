@@ -0,0 +1,90 @@
+#pragma once
+#include <windows.h>
+#include <stdint.h>
+#include <string>
+
+#include "MappedFile.h"
+
+//--------------------------------------------------------------------------------------
+// On-disk layout of an asset archive, written by "AssetTool pack":
+//
+//   ASSET_ARCHIVE_HEADER
+//   ASSET_ARCHIVE_ENTRY[entryCount]   sorted by nameHash
+//   name table                        UTF-16 names, normalized, not terminated
+//   payloads                          each starting on an ASSET_ARCHIVE_ALIGNMENT boundary
+//
+// All offsets are from the start of the file. Payloads are aligned so that pointers into a
+// mapping of the archive can be handed to the loaders, and to D3D, without copying.
+//--------------------------------------------------------------------------------------
+const uint32_t ASSET_ARCHIVE_MAGIC = 0x31435241; // "ARC1"
+const uint32_t ASSET_ARCHIVE_VERSION = 1;
+const size_t ASSET_ARCHIVE_ALIGNMENT = 4096;
+
+enum ASSET_COMPRESSION
+{
+	ASSET_COMPRESSION_NONE = 0,
+};
+
+#pragma pack(push,1)
+struct ASSET_ARCHIVE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t reserved;
+	uint64_t tocOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;      // bytes
+};
+
+struct ASSET_ARCHIVE_ENTRY
+{
+	uint64_t nameHash;       // AssetArchive::HashName of the normalized name
+	uint64_t offset;
+	uint64_t storedSize;     // bytes in the archive
+	uint64_t size;           // bytes once decompressed
+	uint32_t nameOffset;     // in characters from the start of the name table
+	uint16_t nameLength;     // in characters
+	uint8_t compression;     // ASSET_COMPRESSION
+	uint8_t reserved;
+};
+#pragma pack(pop)
+
+//--------------------------------------------------------------------------------------
+// Read-only view of an asset archive. The whole file is mapped once and lookups hash the
+// name and binary search the table of contents, so finding an asset touches no more than
+// a few pages and reading it costs whatever page faults its payload takes.
+//--------------------------------------------------------------------------------------
+class AssetArchive
+{
+public:
+	AssetArchive() = default;
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	// Maps the archive and checks that its header and table of contents are consistent
+	HRESULT Open(const wchar_t* fileName);
+	void Close();
+
+	bool IsOpen() const { return m_file.IsOpen(); }
+	size_t EntryCount() const { return m_entryCount; }
+
+	// Points 'data' into the mapping, which stays valid until the archive is closed. Fails
+	// with ERROR_FILE_NOT_FOUND for names not in the archive and ERROR_NOT_SUPPORTED for
+	// entries stored with a compression this build cannot read in place.
+	HRESULT Find(const wchar_t* name, const uint8_t** data, size_t* size) const;
+
+	// Names are matched ignoring case and with '\' and '/' treated alike, so paths written
+	// either way on the command line and in code find the same entry
+	static std::wstring NormalizeName(const wchar_t* name);
+	static uint64_t HashName(const std::wstring& normalizedName);
+
+private:
+	const ASSET_ARCHIVE_ENTRY* FindEntry(const wchar_t* name) const;
+
+	MappedFile m_file;
+	const ASSET_ARCHIVE_ENTRY* m_entries = nullptr;
+	const uint16_t* m_names = nullptr;
+	size_t m_entryCount = 0;
+};
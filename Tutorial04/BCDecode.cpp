@@ -0,0 +1,1025 @@
+#include "BCDecode.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <string.h>
+
+// Palette lookups are done with PSHUFB when the CPU has SSSE3, which every x64 part this
+// runs on does; the scalar path is kept for other targets and as the reference
+#if defined(_M_IX86) || defined(_M_X64)
+#define BC_DECODE_SSSE3
+#include <intrin.h>
+#include <tmmintrin.h>
+#endif
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	enum BLOCK_FORMAT
+	{
+		BLOCK_UNKNOWN,
+		BLOCK_BC1,
+		BLOCK_BC2,
+		BLOCK_BC3,
+		BLOCK_BC4_UNORM,
+		BLOCK_BC4_SNORM,
+		BLOCK_BC5_UNORM,
+		BLOCK_BC5_SNORM,
+		BLOCK_BC6H_UF16,
+		BLOCK_BC6H_SF16,
+		BLOCK_BC7,
+	};
+
+	BLOCK_FORMAT GetBlockFormat(const DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return BLOCK_BC1;
+
+		case DXGI_FORMAT_BC2_TYPELESS:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			return BLOCK_BC2;
+
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return BLOCK_BC3;
+
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+			return BLOCK_BC4_UNORM;
+
+		case DXGI_FORMAT_BC4_SNORM:
+			return BLOCK_BC4_SNORM;
+
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+			return BLOCK_BC5_UNORM;
+
+		case DXGI_FORMAT_BC5_SNORM:
+			return BLOCK_BC5_SNORM;
+
+		case DXGI_FORMAT_BC6H_TYPELESS:
+		case DXGI_FORMAT_BC6H_UF16:
+			return BLOCK_BC6H_UF16;
+
+		case DXGI_FORMAT_BC6H_SF16:
+			return BLOCK_BC6H_SF16;
+
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return BLOCK_BC7;
+
+		default:
+			return BLOCK_UNKNOWN;
+		}
+	}
+
+#pragma region Tables
+	// BC7 (and BC6H, first 32 entries) two-subset partitions, one bit per pixel
+	const uint16_t s_partitions2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+		0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+		0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+		0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+		0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+	};
+
+	// BC7 three-subset partitions, one subset index per pixel
+	const uint8_t s_partitions3[64][16] =
+	{
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+		{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+		{ 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 },
+		{ 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+		{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+		{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 },
+		{ 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 },
+		{ 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 },
+		{ 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+		{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 },
+		{ 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 },
+		{ 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+		{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 },
+		{ 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 },
+		{ 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 },
+		{ 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 },
+		{ 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+		{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 },
+		{ 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+	};
+
+	// Anchor pixels (whose index is stored with one bit less) of the second subset of a
+	// two-subset partition, and of the second and third subsets of a three-subset one
+	const uint8_t s_anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,
+		 2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,
+		 2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2,
+		15, 15, 15, 15, 15,  2,  2, 15,
+	};
+
+	const uint8_t s_anchors3[2][64] =
+	{
+		{
+			 3,  3, 15, 15,  8,  3, 15, 15,
+			 8,  8,  6,  6,  6,  5,  3,  3,
+			 3,  3,  8, 15,  3,  3,  6, 10,
+			 5,  8,  8,  6,  8,  5, 15, 15,
+			 8, 15,  3,  5,  6, 10,  8, 15,
+			15,  3, 15,  5, 15, 15, 15, 15,
+			 3, 15,  5,  5,  5,  8,  5, 10,
+			 5, 10,  8, 13, 15, 12,  3,  3,
+		},
+		{
+			15,  8,  8,  3, 15, 15,  3,  8,
+			15, 15, 15, 15, 15, 15, 15,  8,
+			15,  8, 15,  3, 15,  8, 15,  8,
+			 3, 15,  6, 10, 15, 15, 10,  8,
+			15,  3, 15, 10, 10,  8,  9, 10,
+			 6, 15,  8, 15,  3,  6,  6,  8,
+			15,  3, 15, 15, 15, 15, 15, 15,
+			15, 15, 15, 15,  3, 15, 15,  8,
+		},
+	};
+
+	// Interpolation weights out of 64 for 2, 3 and 4 bit indices
+	const uint8_t s_weights2[4] = { 0, 21, 43, 64 };
+	const uint8_t s_weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const uint8_t s_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	const uint8_t* GetWeights(const unsigned int indexBits)
+	{
+		return indexBits == 2 ? s_weights2 : indexBits == 3 ? s_weights3 : s_weights4;
+	}
+
+	struct BC7_MODE
+	{
+		uint8_t subsets;
+		uint8_t partitionBits;
+		uint8_t rotationBits;
+		uint8_t indexSelectionBits;
+		uint8_t colorBits;
+		uint8_t alphaBits;
+		uint8_t endpointPBits;
+		uint8_t sharedPBits;
+		uint8_t indexBits;
+		uint8_t index2Bits;
+	};
+
+	const BC7_MODE s_bc7Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+	};
+
+	struct BC6H_MODE
+	{
+		uint8_t regions;
+		bool transformed;
+		uint8_t endpointBits;
+		uint8_t deltaBits[3];
+	};
+
+	const BC6H_MODE s_bc6hModes[14] =
+	{
+		{ 2, true, 10, { 5, 5, 5 } },
+		{ 2, true, 7, { 6, 6, 6 } },
+		{ 2, true, 11, { 5, 4, 4 } },
+		{ 2, true, 11, { 4, 5, 4 } },
+		{ 2, true, 11, { 4, 4, 5 } },
+		{ 2, true, 9, { 5, 5, 5 } },
+		{ 2, true, 8, { 6, 5, 5 } },
+		{ 2, true, 8, { 5, 6, 5 } },
+		{ 2, true, 8, { 5, 5, 6 } },
+		{ 2, false, 6, { 6, 6, 6 } },
+		{ 1, false, 10, { 10, 10, 10 } },
+		{ 1, true, 11, { 9, 9, 9 } },
+		{ 1, true, 12, { 8, 8, 8 } },
+		{ 1, true, 16, { 4, 4, 4 } },
+	};
+
+	// Endpoint fields in BC6H headers, numbered endpoint * 3 + channel
+	enum BC6H_FIELD : uint8_t { R0, G0, B0, R1, G1, B1, R2, G2, B2, R3, G3, B3, END };
+
+	// A run of header bits holding bits 'first' to 'last' of one field, in that order;
+	// first > last marks the bit-reversed runs of modes 13 and 14
+	struct BC6H_RUN
+	{
+		BC6H_FIELD field;
+		uint8_t first;
+		uint8_t last;
+	};
+
+	// Header layouts following the mode bits, as listed in the BC6H format specification
+	const BC6H_RUN s_bc6hLayouts[14][24] =
+	{
+		{ { G2, 4, 4 }, { B2, 4, 4 }, { B3, 4, 4 }, { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 4 }, { G3, 4, 4 },
+		  { G2, 0, 3 }, { G1, 0, 4 }, { B3, 0, 0 }, { G3, 0, 3 }, { B1, 0, 4 }, { B3, 1, 1 }, { B2, 0, 3 }, { R2, 0, 4 },
+		  { B3, 2, 2 }, { R3, 0, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { G2, 5, 5 }, { G3, 4, 4 }, { G3, 5, 5 }, { R0, 0, 6 }, { B3, 0, 0 }, { B3, 1, 1 }, { B2, 4, 4 }, { G0, 0, 6 },
+		  { B2, 5, 5 }, { B3, 2, 2 }, { G2, 4, 4 }, { B0, 0, 6 }, { B3, 3, 3 }, { B3, 5, 5 }, { B3, 4, 4 }, { R1, 0, 5 },
+		  { G2, 0, 3 }, { G1, 0, 5 }, { G3, 0, 3 }, { B1, 0, 5 }, { B2, 0, 3 }, { R2, 0, 5 }, { R3, 0, 5 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 4 }, { R0, 10, 10 }, { G2, 0, 3 }, { G1, 0, 3 }, { G0, 10, 10 },
+		  { B3, 0, 0 }, { G3, 0, 3 }, { B1, 0, 3 }, { B0, 10, 10 }, { B3, 1, 1 }, { B2, 0, 3 }, { R2, 0, 4 }, { B3, 2, 2 },
+		  { R3, 0, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 3 }, { R0, 10, 10 }, { G3, 4, 4 }, { G2, 0, 3 }, { G1, 0, 4 },
+		  { G0, 10, 10 }, { G3, 0, 3 }, { B1, 0, 3 }, { B0, 10, 10 }, { B3, 1, 1 }, { B2, 0, 3 }, { R2, 0, 3 }, { B3, 0, 0 },
+		  { B3, 2, 2 }, { R3, 0, 3 }, { G2, 4, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 3 }, { R0, 10, 10 }, { B2, 4, 4 }, { G2, 0, 3 }, { G1, 0, 3 },
+		  { G0, 10, 10 }, { B3, 0, 0 }, { G3, 0, 3 }, { B1, 0, 4 }, { B0, 10, 10 }, { B2, 0, 3 }, { R2, 0, 3 }, { B3, 1, 1 },
+		  { B3, 2, 2 }, { R3, 0, 3 }, { B3, 4, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { R0, 0, 8 }, { B2, 4, 4 }, { G0, 0, 8 }, { G2, 4, 4 }, { B0, 0, 8 }, { B3, 4, 4 }, { R1, 0, 4 }, { G3, 4, 4 },
+		  { G2, 0, 3 }, { G1, 0, 4 }, { B3, 0, 0 }, { G3, 0, 3 }, { B1, 0, 4 }, { B3, 1, 1 }, { B2, 0, 3 }, { R2, 0, 4 },
+		  { B3, 2, 2 }, { R3, 0, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { R0, 0, 7 }, { G3, 4, 4 }, { B2, 4, 4 }, { G0, 0, 7 }, { B3, 2, 2 }, { G2, 4, 4 }, { B0, 0, 7 }, { B3, 3, 3 },
+		  { B3, 4, 4 }, { R1, 0, 5 }, { G2, 0, 3 }, { G1, 0, 4 }, { B3, 0, 0 }, { G3, 0, 3 }, { B1, 0, 4 }, { B3, 1, 1 },
+		  { B2, 0, 3 }, { R2, 0, 5 }, { R3, 0, 5 }, { END, 0, 0 } },
+		{ { R0, 0, 7 }, { B3, 0, 0 }, { B2, 4, 4 }, { G0, 0, 7 }, { G2, 5, 5 }, { G2, 4, 4 }, { B0, 0, 7 }, { G3, 5, 5 },
+		  { B3, 4, 4 }, { R1, 0, 4 }, { G3, 4, 4 }, { G2, 0, 3 }, { G1, 0, 5 }, { G3, 0, 3 }, { B1, 0, 4 }, { B3, 1, 1 },
+		  { B2, 0, 3 }, { R2, 0, 4 }, { B3, 2, 2 }, { R3, 0, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { R0, 0, 7 }, { B3, 1, 1 }, { B2, 4, 4 }, { G0, 0, 7 }, { B2, 5, 5 }, { G2, 4, 4 }, { B0, 0, 7 }, { B3, 5, 5 },
+		  { B3, 4, 4 }, { R1, 0, 4 }, { G3, 4, 4 }, { G2, 0, 3 }, { G1, 0, 4 }, { B3, 0, 0 }, { G3, 0, 3 }, { B1, 0, 5 },
+		  { B2, 0, 3 }, { R2, 0, 4 }, { B3, 2, 2 }, { R3, 0, 4 }, { B3, 3, 3 }, { END, 0, 0 } },
+		{ { R0, 0, 5 }, { G3, 4, 4 }, { B3, 0, 0 }, { B3, 1, 1 }, { B2, 4, 4 }, { G0, 0, 5 }, { G2, 5, 5 }, { B2, 5, 5 },
+		  { B3, 2, 2 }, { G2, 4, 4 }, { B0, 0, 5 }, { G3, 5, 5 }, { B3, 3, 3 }, { B3, 5, 5 }, { B3, 4, 4 }, { R1, 0, 5 },
+		  { G2, 0, 3 }, { G1, 0, 5 }, { G3, 0, 3 }, { B1, 0, 5 }, { B2, 0, 3 }, { R2, 0, 5 }, { R3, 0, 5 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 9 }, { G1, 0, 9 }, { B1, 0, 9 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 8 }, { R0, 10, 10 }, { G1, 0, 8 }, { G0, 10, 10 }, { B1, 0, 8 },
+		  { B0, 10, 10 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 7 }, { R0, 11, 10 }, { G1, 0, 7 }, { G0, 11, 10 }, { B1, 0, 7 },
+		  { B0, 11, 10 }, { END, 0, 0 } },
+		{ { R0, 0, 9 }, { G0, 0, 9 }, { B0, 0, 9 }, { R1, 0, 3 }, { R0, 15, 10 }, { G1, 0, 3 }, { G0, 15, 10 }, { B1, 0, 3 },
+		  { B0, 15, 10 }, { END, 0, 0 } },
+	};
+
+	// Tables built once on first use
+	struct DecodeTables
+	{
+		uint16_t unormToHalf[256];
+		uint16_t snormToHalf[256];
+		uint8_t snormToUnorm[256];
+#ifdef BC_DECODE_SSSE3
+		__m128i colorRowShuffle[256];   // four 2-bit palette indices -> byte gather of four RGBA8 texels
+		__m128i channelSpread[4][4];    // [channel][row] -> moves a row of channel values into place
+		__m128i channelKeep[4];         // [channel] -> clears that channel of four RGBA8 texels
+		bool hasSSSE3;
+#endif
+
+		DecodeTables()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const int snorm = std::max(static_cast<int>(static_cast<int8_t>(i)), -127);
+				unormToHalf[i] = XMConvertFloatToHalf(static_cast<float>(i) / 255.0f);
+				snormToHalf[i] = XMConvertFloatToHalf(static_cast<float>(snorm) / 127.0f);
+				snormToUnorm[i] = static_cast<uint8_t>((snorm + 127) * 255 / 254);
+			}
+
+#ifdef BC_DECODE_SSSE3
+			for (int bits = 0; bits < 256; ++bits)
+			{
+				alignas(16) uint8_t shuffle[16];
+				for (int pixel = 0; pixel < 4; ++pixel)
+				{
+					const int index = (bits >> (pixel * 2)) & 3;
+					for (int channel = 0; channel < 4; ++channel)
+						shuffle[pixel * 4 + channel] = static_cast<uint8_t>(index * 4 + channel);
+				}
+				colorRowShuffle[bits] = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle));
+			}
+
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				alignas(16) uint8_t keep[16];
+				for (int i = 0; i < 16; ++i)
+					keep[i] = (i & 3) == channel ? 0x00 : 0xFF;
+				channelKeep[channel] = _mm_load_si128(reinterpret_cast<const __m128i*>(keep));
+
+				for (int row = 0; row < 4; ++row)
+				{
+					alignas(16) uint8_t spread[16];
+					for (int i = 0; i < 16; ++i)
+						spread[i] = (i & 3) == channel ? static_cast<uint8_t>(row * 4 + (i >> 2)) : 0x80;
+					channelSpread[channel][row] = _mm_load_si128(reinterpret_cast<const __m128i*>(spread));
+				}
+			}
+
+			int cpuInfo[4] = {};
+			__cpuid(cpuInfo, 1);
+			hasSSSE3 = (cpuInfo[2] & (1 << 9)) != 0;
+#endif
+		}
+	};
+
+	const DecodeTables& GetTables()
+	{
+		static const DecodeTables tables;
+		return tables;
+	}
+#pragma endregion
+
+	// Reads a 128-bit block from the least significant bit up
+	class BitReader
+	{
+	public:
+		explicit BitReader(const uint8_t* const block)
+		{
+			memcpy(&m_low, block, sizeof(m_low));
+			memcpy(&m_high, block + 8, sizeof(m_high));
+		}
+
+		uint32_t Read(const unsigned int count)
+		{
+			if (count == 0)
+				return 0;
+
+			uint64_t bits;
+			if (m_position >= 64)
+				bits = m_high >> (m_position - 64);
+			else if (m_position + count <= 64)
+				bits = m_low >> m_position;
+			else
+				bits = (m_low >> m_position) | (m_high << (64 - m_position));
+
+			m_position += count;
+			return static_cast<uint32_t>(bits & ((uint64_t(1) << count) - 1));
+		}
+
+		void Skip(const unsigned int count) { m_position += count; }
+
+	private:
+		uint64_t m_low = 0;
+		uint64_t m_high = 0;
+		unsigned int m_position = 0;
+	};
+
+	inline uint8_t Interpolate(const int a, const int b, const int weight)
+	{
+		return static_cast<uint8_t>((a * (64 - weight) + b * weight + 32) >> 6);
+	}
+
+	inline int SignExtend(const int value, const unsigned int bits)
+	{
+		const int shift = 32 - static_cast<int>(bits);
+		return static_cast<int>(static_cast<uint32_t>(value) << shift) >> shift;
+	}
+
+#pragma region BC1-BC5
+	// Four RGBA8 colors of a BC1-style color block. BC2 and BC3 always use the four color
+	// mode; BC1 switches to three colors and transparent black when color0 <= color1.
+	void BuildColorPalette(const uint8_t* const block, const bool allowThreeColor, uint8_t palette[16])
+	{
+		const unsigned int c0 = block[0] | (block[1] << 8);
+		const unsigned int c1 = block[2] | (block[3] << 8);
+
+		int rgb0[3], rgb1[3];
+		Expand565(c0, rgb0);
+		Expand565(c1, rgb1);
+		const int r0 = rgb0[0], g0 = rgb0[1], b0 = rgb0[2];
+		const int r1 = rgb1[0], g1 = rgb1[1], b1 = rgb1[2];
+
+		palette[0] = static_cast<uint8_t>(r0); palette[1] = static_cast<uint8_t>(g0); palette[2] = static_cast<uint8_t>(b0); palette[3] = 255;
+		palette[4] = static_cast<uint8_t>(r1); palette[5] = static_cast<uint8_t>(g1); palette[6] = static_cast<uint8_t>(b1); palette[7] = 255;
+
+		if (c0 > c1 || !allowThreeColor)
+		{
+			palette[8] = static_cast<uint8_t>((2 * r0 + r1 + 1) / 3);
+			palette[9] = static_cast<uint8_t>((2 * g0 + g1 + 1) / 3);
+			palette[10] = static_cast<uint8_t>((2 * b0 + b1 + 1) / 3);
+			palette[11] = 255;
+			palette[12] = static_cast<uint8_t>((r0 + 2 * r1 + 1) / 3);
+			palette[13] = static_cast<uint8_t>((g0 + 2 * g1 + 1) / 3);
+			palette[14] = static_cast<uint8_t>((b0 + 2 * b1 + 1) / 3);
+			palette[15] = 255;
+		}
+		else
+		{
+			palette[8] = static_cast<uint8_t>((r0 + r1 + 1) / 2);
+			palette[9] = static_cast<uint8_t>((g0 + g1 + 1) / 2);
+			palette[10] = static_cast<uint8_t>((b0 + b1 + 1) / 2);
+			palette[11] = 255;
+			palette[12] = palette[13] = palette[14] = palette[15] = 0;
+		}
+	}
+
+	void DecodeColorBlock(const uint8_t* const block, const bool allowThreeColor, uint8_t out[64])
+	{
+		alignas(16) uint8_t palette[16];
+		BuildColorPalette(block, allowThreeColor, palette);
+
+#ifdef BC_DECODE_SSSE3
+		const DecodeTables& tables = GetTables();
+		if (tables.hasSSSE3)
+		{
+			// Each index byte covers one row, so a row is a single byte shuffle of the palette
+			const __m128i colors = _mm_load_si128(reinterpret_cast<const __m128i*>(palette));
+			for (int row = 0; row < 4; ++row)
+				_mm_store_si128(reinterpret_cast<__m128i*>(out + row * 16), _mm_shuffle_epi8(colors, tables.colorRowShuffle[block[4 + row]]));
+			return;
+		}
+#endif
+
+		const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+		for (int i = 0; i < 16; ++i)
+			memcpy(out + i * 4, palette + ((indices >> (i * 2)) & 3) * 4, 4);
+	}
+
+	// BC3 alpha / BC4 / BC5 channel block: two 8-bit endpoints and sixteen 3-bit indices.
+	// With signedValues the endpoints are SNORM and the result is in two's complement.
+	void DecodeChannelBlock(const uint8_t* const block, const bool signedValues, uint8_t out[16])
+	{
+		alignas(16) uint8_t palette[16] = {};
+		if (signedValues)
+		{
+			const int a0 = std::max(static_cast<int>(static_cast<int8_t>(block[0])), -127);
+			const int a1 = std::max(static_cast<int>(static_cast<int8_t>(block[1])), -127);
+			palette[0] = static_cast<uint8_t>(a0);
+			palette[1] = static_cast<uint8_t>(a1);
+			if (a0 > a1)
+			{
+				for (int i = 1; i < 7; ++i)
+				{
+					const int sum = (7 - i) * a0 + i * a1;
+					palette[i + 1] = static_cast<uint8_t>((sum >= 0 ? sum + 3 : sum - 3) / 7);
+				}
+			}
+			else
+			{
+				for (int i = 1; i < 5; ++i)
+				{
+					const int sum = (5 - i) * a0 + i * a1;
+					palette[i + 1] = static_cast<uint8_t>((sum >= 0 ? sum + 2 : sum - 2) / 5);
+				}
+				palette[6] = static_cast<uint8_t>(-127);
+				palette[7] = 127;
+			}
+		}
+		else
+		{
+			const int a0 = block[0];
+			const int a1 = block[1];
+			palette[0] = static_cast<uint8_t>(a0);
+			palette[1] = static_cast<uint8_t>(a1);
+			if (a0 > a1)
+			{
+				for (int i = 1; i < 7; ++i)
+					palette[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1 + 3) / 7);
+			}
+			else
+			{
+				for (int i = 1; i < 5; ++i)
+					palette[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1 + 2) / 5);
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		uint64_t indices = 0;
+		memcpy(&indices, block + 2, 6);
+
+		alignas(16) uint8_t index[16];
+		for (int i = 0; i < 16; ++i)
+			index[i] = static_cast<uint8_t>((indices >> (i * 3)) & 7);
+
+#ifdef BC_DECODE_SSSE3
+		if (GetTables().hasSSSE3)
+		{
+			const __m128i values = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(palette)),
+			                                        _mm_load_si128(reinterpret_cast<const __m128i*>(index)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), values);
+			return;
+		}
+#endif
+
+		for (int i = 0; i < 16; ++i)
+			out[i] = palette[index[i]];
+	}
+
+	// Writes sixteen channel values into one channel of a decoded RGBA8 block
+	void InsertChannel(const uint8_t values[16], const int channel, uint8_t out[64])
+	{
+#ifdef BC_DECODE_SSSE3
+		const DecodeTables& tables = GetTables();
+		if (tables.hasSSSE3)
+		{
+			// Spread the four values of each row to every fourth byte and merge them over the channel
+			const __m128i all = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+			for (int row = 0; row < 4; ++row)
+			{
+				__m128i* const dest = reinterpret_cast<__m128i*>(out + row * 16);
+				const __m128i spread = _mm_shuffle_epi8(all, tables.channelSpread[channel][row]);
+				_mm_store_si128(dest, _mm_or_si128(_mm_and_si128(_mm_load_si128(dest), tables.channelKeep[channel]), spread));
+			}
+			return;
+		}
+#endif
+
+		for (int i = 0; i < 16; ++i)
+			out[i * 4 + channel] = values[i];
+	}
+
+	void DecodeBC1(const uint8_t* const block, uint8_t out[64])
+	{
+		DecodeColorBlock(block, true, out);
+	}
+
+	void DecodeBC2(const uint8_t* const block, uint8_t out[64])
+	{
+		DecodeColorBlock(block + 8, false, out);
+
+		alignas(16) uint8_t alpha[16];
+		for (int i = 0; i < 16; ++i)
+			alpha[i] = static_cast<uint8_t>(((block[i >> 1] >> ((i & 1) * 4)) & 0xF) * 17);
+		InsertChannel(alpha, 3, out);
+	}
+
+	void DecodeBC3(const uint8_t* const block, uint8_t out[64])
+	{
+		DecodeColorBlock(block + 8, false, out);
+
+		alignas(16) uint8_t alpha[16];
+		DecodeChannelBlock(block, false, alpha);
+		InsertChannel(alpha, 3, out);
+	}
+
+	// BC4 and BC5 decode to (R, 0, 0, 1) and (R, G, 0, 1)
+	void DecodeBC4(const uint8_t* const block, const bool signedValues, uint8_t out[64])
+	{
+		static const uint8_t s_opaqueBlack[64] =
+		{
+			0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255,
+			0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255,
+			0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255,
+			0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255,
+		};
+		memcpy(out, s_opaqueBlack, sizeof(s_opaqueBlack));
+
+		alignas(16) uint8_t red[16];
+		DecodeChannelBlock(block, signedValues, red);
+		InsertChannel(red, 0, out);
+	}
+
+	void DecodeBC5(const uint8_t* const block, const bool signedValues, uint8_t out[64])
+	{
+		DecodeBC4(block, signedValues, out);
+
+		alignas(16) uint8_t green[16];
+		DecodeChannelBlock(block + 8, signedValues, green);
+		InsertChannel(green, 1, out);
+	}
+#pragma endregion
+
+#pragma region BC6H
+	int UnquantizeBC6H(const int value, const unsigned int bits, const bool signedValues)
+	{
+		if (!signedValues)
+		{
+			if (bits >= 15 || value == 0)
+				return value;
+			if (value == (1 << bits) - 1)
+				return 0xFFFF;
+			return ((value << 16) + 0x8000) >> bits;
+		}
+
+		if (bits >= 16)
+			return value;
+
+		const bool negative = value < 0;
+		const int magnitude = negative ? -value : value;
+		int result;
+		if (magnitude == 0)
+			result = 0;
+		else if (magnitude >= (1 << (bits - 1)) - 1)
+			result = 0x7FFF;
+		else
+			result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+
+		return negative ? -result : result;
+	}
+
+	uint16_t FinishBC6H(const int value, const bool signedValues)
+	{
+		if (!signedValues)
+			return static_cast<uint16_t>((value * 31) >> 6);
+
+		// Scale to the half range and move the sign out of two's complement
+		return value < 0 ? static_cast<uint16_t>(0x8000 | (((-value) * 31) >> 5)) : static_cast<uint16_t>((value * 31) >> 5);
+	}
+
+	void DecodeBC6H(const uint8_t* const block, const bool signedValues, uint16_t out[64])
+	{
+		BitReader bits(block);
+
+		int mode = -1;
+		const uint32_t modeBits = bits.Read(2);
+		if (modeBits < 2)
+		{
+			mode = static_cast<int>(modeBits);
+		}
+		else
+		{
+			switch (modeBits | (bits.Read(3) << 2))
+			{
+			case 0x02: mode = 2; break;
+			case 0x06: mode = 3; break;
+			case 0x0A: mode = 4; break;
+			case 0x0E: mode = 5; break;
+			case 0x12: mode = 6; break;
+			case 0x16: mode = 7; break;
+			case 0x1A: mode = 8; break;
+			case 0x1E: mode = 9; break;
+			case 0x03: mode = 10; break;
+			case 0x07: mode = 11; break;
+			case 0x0B: mode = 12; break;
+			case 0x0F: mode = 13; break;
+			default: break;
+			}
+		}
+
+		// Reserved modes decode to opaque black
+		if (mode < 0)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				out[i * 4 + 0] = out[i * 4 + 1] = out[i * 4 + 2] = 0;
+				out[i * 4 + 3] = 0x3C00;
+			}
+			return;
+		}
+
+		const BC6H_MODE& info = s_bc6hModes[mode];
+
+		int endpoints[4][3] = {};
+		for (const BC6H_RUN* run = s_bc6hLayouts[mode]; run->field != END; ++run)
+		{
+			int& value = endpoints[run->field / 3][run->field % 3];
+			if (run->first <= run->last)
+			{
+				value |= static_cast<int>(bits.Read(run->last - run->first + 1)) << run->first;
+			}
+			else
+			{
+				for (int bit = run->first; bit >= run->last; --bit)
+					value |= static_cast<int>(bits.Read(1)) << bit;
+			}
+		}
+
+		const unsigned int partition = info.regions == 2 ? bits.Read(5) : 0;
+		const int endpointCount = info.regions * 2;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			if (signedValues)
+				endpoints[0][c] = SignExtend(endpoints[0][c], info.endpointBits);
+
+			for (int e = 1; e < endpointCount; ++e)
+			{
+				if (info.transformed)
+				{
+					// The other endpoints are stored as deltas from the first
+					const int delta = SignExtend(endpoints[e][c], info.deltaBits[c]);
+					endpoints[e][c] = (endpoints[0][c] + delta) & ((1 << info.endpointBits) - 1);
+				}
+				if (signedValues)
+					endpoints[e][c] = SignExtend(endpoints[e][c], info.endpointBits);
+			}
+
+			for (int e = 0; e < endpointCount; ++e)
+				endpoints[e][c] = UnquantizeBC6H(endpoints[e][c], info.endpointBits, signedValues);
+		}
+
+		const unsigned int indexBits = info.regions == 2 ? 3 : 4;
+		const uint8_t* const weights = GetWeights(indexBits);
+		const unsigned int anchor = info.regions == 2 ? s_anchors2[partition] : 0;
+		const uint16_t subsets = info.regions == 2 ? s_partitions2[partition] : 0;
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			const unsigned int index = bits.Read(i == 0 || i == anchor ? indexBits - 1 : indexBits);
+			const int subset = (subsets >> i) & 1;
+			const int* const e0 = endpoints[subset * 2];
+			const int* const e1 = endpoints[subset * 2 + 1];
+			const int w = weights[index];
+
+			for (int c = 0; c < 3; ++c)
+				out[i * 4 + c] = FinishBC6H((e0[c] * (64 - w) + e1[c] * w + 32) >> 6, signedValues);
+			out[i * 4 + 3] = 0x3C00;
+		}
+	}
+#pragma endregion
+
+#pragma region BC7
+	inline uint8_t UnquantizeBC7(const unsigned int value, const unsigned int bits)
+	{
+		const unsigned int expanded = value << (8 - bits);
+		return static_cast<uint8_t>(expanded | (expanded >> bits));
+	}
+
+	void DecodeBC7(const uint8_t* const block, uint8_t out[64])
+	{
+		unsigned int mode = 0;
+		while (mode < 8 && !(block[0] & (1u << mode)))
+			++mode;
+
+		// Reserved mode decodes to transparent black
+		if (mode == 8)
+		{
+			memset(out, 0, 64);
+			return;
+		}
+
+		const BC7_MODE& info = s_bc7Modes[mode];
+		BitReader bits(block);
+		bits.Skip(mode + 1);
+
+		const unsigned int partition = bits.Read(info.partitionBits);
+		const unsigned int rotation = bits.Read(info.rotationBits);
+		const unsigned int indexSelection = bits.Read(info.indexSelectionBits);
+
+		const unsigned int endpointCount = info.subsets * 2u;
+		unsigned int endpoints[6][4] = {};
+		for (unsigned int c = 0; c < 3; ++c)
+			for (unsigned int e = 0; e < endpointCount; ++e)
+				endpoints[e][c] = bits.Read(info.colorBits);
+		if (info.alphaBits)
+		{
+			for (unsigned int e = 0; e < endpointCount; ++e)
+				endpoints[e][3] = bits.Read(info.alphaBits);
+		}
+
+		unsigned int colorBits = info.colorBits;
+		unsigned int alphaBits = info.alphaBits;
+		if (info.endpointPBits || info.sharedPBits)
+		{
+			for (unsigned int e = 0; e < endpointCount; ++e)
+			{
+				// Shared p-bits come one per subset, and apply to both of its endpoints
+				if (info.sharedPBits && (e & 1))
+					continue;
+
+				const unsigned int pBit = bits.Read(1);
+				for (unsigned int target = e; target < e + (info.sharedPBits ? 2u : 1u); ++target)
+				{
+					for (unsigned int c = 0; c < 4; ++c)
+						endpoints[target][c] = (endpoints[target][c] << 1) | pBit;
+				}
+			}
+			++colorBits;
+			if (alphaBits)
+				++alphaBits;
+		}
+
+		uint8_t colors[6][4];
+		for (unsigned int e = 0; e < endpointCount; ++e)
+		{
+			for (unsigned int c = 0; c < 3; ++c)
+				colors[e][c] = UnquantizeBC7(endpoints[e][c], colorBits);
+			colors[e][3] = alphaBits ? UnquantizeBC7(endpoints[e][3], alphaBits) : 255;
+		}
+
+		unsigned int anchor1 = 16;
+		unsigned int anchor2 = 16;
+		if (info.subsets == 2)
+		{
+			anchor1 = s_anchors2[partition];
+		}
+		else if (info.subsets == 3)
+		{
+			anchor1 = s_anchors3[0][partition];
+			anchor2 = s_anchors3[1][partition];
+		}
+
+		uint8_t indices[16];
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			const bool anchor = i == 0 || i == anchor1 || i == anchor2;
+			indices[i] = static_cast<uint8_t>(bits.Read(anchor ? info.indexBits - 1u : info.indexBits));
+		}
+
+		uint8_t indices2[16] = {};
+		if (info.index2Bits)
+		{
+			for (unsigned int i = 0; i < 16; ++i)
+				indices2[i] = static_cast<uint8_t>(bits.Read(i == 0 ? info.index2Bits - 1u : info.index2Bits));
+		}
+
+		// Modes 4 and 5 carry a second index set; the index selection bit decides which
+		// one drives color and which one drives alpha
+		const uint8_t* const colorIndices = info.index2Bits && indexSelection ? indices2 : indices;
+		const uint8_t* const alphaIndices = info.index2Bits && !indexSelection ? indices2 : indices;
+		const uint8_t* const colorWeights = GetWeights(colorIndices == indices ? info.indexBits : info.index2Bits);
+		const uint8_t* const alphaWeights = GetWeights(alphaIndices == indices ? info.indexBits : info.index2Bits);
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			unsigned int subset = 0;
+			if (info.subsets == 2)
+				subset = (s_partitions2[partition] >> i) & 1;
+			else if (info.subsets == 3)
+				subset = s_partitions3[partition][i];
+
+			const uint8_t* const e0 = colors[subset * 2];
+			const uint8_t* const e1 = colors[subset * 2 + 1];
+			uint8_t* const pixel = out + i * 4;
+
+			const int colorWeight = colorWeights[colorIndices[i]];
+			for (int c = 0; c < 3; ++c)
+				pixel[c] = Interpolate(e0[c], e1[c], colorWeight);
+			pixel[3] = Interpolate(e0[3], e1[3], alphaWeights[alphaIndices[i]]);
+
+			if (rotation)
+				std::swap(pixel[3], pixel[rotation - 1]);
+		}
+	}
+#pragma endregion
+
+	bool IsSigned(const BLOCK_FORMAT blockFormat)
+	{
+		return blockFormat == BLOCK_BC4_SNORM || blockFormat == BLOCK_BC5_SNORM || blockFormat == BLOCK_BC6H_SF16;
+	}
+
+	// Copies the visible part of a decoded RGBA8 block to the destination surface.
+	// signedChannels has a bit set for each channel that holds SNORM values.
+	void WriteBlock(const uint8_t block[64], const unsigned int signedChannels, const BC_DECODE_TARGET target,
+	                uint8_t* const dest, const size_t destRowPitch, const size_t columns, const size_t rows)
+	{
+		const DecodeTables& tables = GetTables();
+		for (size_t y = 0; y < rows; ++y)
+		{
+			const uint8_t* const source = block + y * 16;
+			uint8_t* const row = dest + y * destRowPitch;
+
+			if (target == BC_DECODE_RGBA8)
+			{
+				if (!signedChannels)
+				{
+					memcpy(row, source, columns * 4);
+					continue;
+				}
+
+				for (size_t i = 0; i < columns * 4; ++i)
+					row[i] = (signedChannels >> (i & 3)) & 1 ? tables.snormToUnorm[source[i]] : source[i];
+			}
+			else
+			{
+				uint16_t* const halfRow = reinterpret_cast<uint16_t*>(row);
+				for (size_t i = 0; i < columns * 4; ++i)
+					halfRow[i] = (signedChannels >> (i & 3)) & 1 ? tables.snormToHalf[source[i]] : tables.unormToHalf[source[i]];
+			}
+		}
+	}
+
+	void WriteBlock(const uint16_t block[64], const BC_DECODE_TARGET target,
+	                uint8_t* const dest, const size_t destRowPitch, const size_t columns, const size_t rows)
+	{
+		for (size_t y = 0; y < rows; ++y)
+		{
+			const uint16_t* const source = block + y * 16;
+			uint8_t* const row = dest + y * destRowPitch;
+
+			if (target == BC_DECODE_RGBA16F)
+			{
+				memcpy(row, source, columns * 8);
+				continue;
+			}
+
+			for (size_t i = 0; i < columns * 4; ++i)
+			{
+				const float value = std::min(std::max(XMConvertHalfToFloat(source[i]), 0.0f), 1.0f);
+				row[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+bool IsBCFormat(const DXGI_FORMAT format)
+{
+	return GetBlockFormat(format) != BLOCK_UNKNOWN;
+}
+
+HRESULT DecodeBCSurface(const DXGI_FORMAT format, const size_t width, const size_t height, const D3D11_SUBRESOURCE_DATA& source,
+                        const BC_DECODE_TARGET target, void* const dest, const size_t destRowPitch)
+{
+	const BLOCK_FORMAT blockFormat = GetBlockFormat(format);
+	if (blockFormat == BLOCK_UNKNOWN)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	if (!source.pSysMem || !dest || width == 0 || height == 0)
+		return E_INVALIDARG;
+
+	const size_t bytesPerPixel = target == BC_DECODE_RGBA8 ? 4 : 8;
+	const size_t blockBytes = blockFormat == BLOCK_BC1 || blockFormat == BLOCK_BC4_UNORM || blockFormat == BLOCK_BC4_SNORM ? 8 : 16;
+	const size_t blocksWide = (width + 3) / 4;
+	const size_t blocksHigh = (height + 3) / 4;
+	if (destRowPitch < width * bytesPerPixel || source.SysMemPitch < blocksWide * blockBytes)
+		return E_INVALIDARG;
+
+	const bool signedValues = IsSigned(blockFormat);
+	const unsigned int signedChannels = blockFormat == BLOCK_BC4_SNORM ? 0x1 : blockFormat == BLOCK_BC5_SNORM ? 0x3 : 0;
+
+	alignas(16) uint8_t rgba[64];
+	alignas(16) uint16_t half[64];
+
+	for (size_t by = 0; by < blocksHigh; ++by)
+	{
+		const uint8_t* block = static_cast<const uint8_t*>(source.pSysMem) + by * source.SysMemPitch;
+		uint8_t* const destRow = static_cast<uint8_t*>(dest) + by * 4 * destRowPitch;
+		const size_t rows = std::min<size_t>(4, height - by * 4);
+
+		for (size_t bx = 0; bx < blocksWide; ++bx, block += blockBytes)
+		{
+			uint8_t* const destBlock = destRow + bx * 4 * bytesPerPixel;
+			const size_t columns = std::min<size_t>(4, width - bx * 4);
+
+			switch (blockFormat)
+			{
+			case BLOCK_BC1: DecodeBC1(block, rgba); break;
+			case BLOCK_BC2: DecodeBC2(block, rgba); break;
+			case BLOCK_BC3: DecodeBC3(block, rgba); break;
+			case BLOCK_BC4_UNORM:
+			case BLOCK_BC4_SNORM: DecodeBC4(block, signedValues, rgba); break;
+			case BLOCK_BC5_UNORM:
+			case BLOCK_BC5_SNORM: DecodeBC5(block, signedValues, rgba); break;
+			case BLOCK_BC7: DecodeBC7(block, rgba); break;
+
+			case BLOCK_BC6H_UF16:
+			case BLOCK_BC6H_SF16:
+				DecodeBC6H(block, signedValues, half);
+				WriteBlock(half, target, destBlock, destRowPitch, columns, rows);
+				continue;
+
+			default:
+				return E_UNEXPECTED;
+			}
+
+			WriteBlock(rgba, signedChannels, target, destBlock, destRowPitch, columns, rows);
+		}
+	}
+
+	return S_OK;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------
+// CPU decoder for the block-compressed formats BitsPerPixel and GetSurfaceInfo know about
+// (BC1-BC7). Used wherever a compressed surface has to be looked at on the CPU:
+// thumbnails, software fallback rendering and checking encoder output.
+//--------------------------------------------------------------------------------------
+enum BC_DECODE_TARGET
+{
+	BC_DECODE_RGBA8,    // DXGI_FORMAT_R8G8B8A8_UNORM, 4 bytes per pixel
+	BC_DECODE_RGBA16F,  // DXGI_FORMAT_R16G16B16A16_FLOAT, 8 bytes per pixel
+};
+
+bool IsBCFormat(DXGI_FORMAT format);
+
+// The 8-bit channels of a BC1-style 5:6:5 endpoint, with the top bits replicated into the
+// low ones as the reference decoder and the hardware expand them. Shared with the encoder
+// so that it scores its endpoints against the colours a decoder will produce.
+inline void Expand565(const unsigned int color, int rgb[3])
+{
+	const unsigned int r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+	rgb[0] = static_cast<int>((r << 3) | (r >> 2));
+	rgb[1] = static_cast<int>((g << 2) | (g >> 4));
+	rgb[2] = static_cast<int>((b << 3) | (b >> 2));
+}
+
+// Expands one subresource laid out the way FillInitData describes it: pSysMem points at
+// the first block and SysMemPitch is the size of one row of blocks. sRGB data is passed
+// through unconverted. For RGBA8 the SNORM channels of BC4/BC5 are remapped to [0,1] and
+// BC6H is clamped to [0,1]; RGBA16F keeps both as they are.
+HRESULT DecodeBCSurface(DXGI_FORMAT format, size_t width, size_t height, const D3D11_SUBRESOURCE_DATA& source,
+                        BC_DECODE_TARGET target, void* dest, size_t destRowPitch);
@@ -0,0 +1,778 @@
+#include "BCEncode.h"
+#include "BCDecode.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	const int s_bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	inline float Clamp255(const float value)
+	{
+		return std::min(std::max(value, 0.0f), 255.0f);
+	}
+
+	inline float Square(const float value)
+	{
+		return value * value;
+	}
+
+	// Direction of largest spread through the points, by power iteration on the covariance.
+	// The fast path instead orients the bounding box diagonal by each channel's covariance
+	// with the widest channel, which is cheaper and good enough for smooth blocks.
+	void FindAxis(const float (*points)[4], const int count, const int channels, const BC_ENCODE_QUALITY quality,
+	              float mean[4], float axis[4])
+	{
+		float low[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+		float high[4] = {};
+		for (int c = 0; c < 4; ++c)
+			mean[c] = axis[c] = 0.0f;
+
+		for (int i = 0; i < count; ++i)
+		{
+			for (int c = 0; c < channels; ++c)
+			{
+				mean[c] += points[i][c];
+				low[c] = std::min(low[c], points[i][c]);
+				high[c] = std::max(high[c], points[i][c]);
+			}
+		}
+		for (int c = 0; c < channels; ++c)
+			mean[c] /= static_cast<float>(count);
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < count; ++i)
+		{
+			for (int a = 0; a < channels; ++a)
+			{
+				const float da = points[i][a] - mean[a];
+				for (int b = a; b < channels; ++b)
+					covariance[a][b] += da * (points[i][b] - mean[b]);
+			}
+		}
+		for (int a = 0; a < channels; ++a)
+			for (int b = 0; b < a; ++b)
+				covariance[a][b] = covariance[b][a];
+
+		if (quality == BC_ENCODE_FAST)
+		{
+			int widest = 0;
+			for (int c = 1; c < channels; ++c)
+			{
+				if (high[c] - low[c] > high[widest] - low[widest])
+					widest = c;
+			}
+			for (int c = 0; c < channels; ++c)
+				axis[c] = covariance[widest][c] < 0.0f ? low[c] - high[c] : high[c] - low[c];
+			return;
+		}
+
+		// Start from the widest diagonal so blocks with a clear gradient converge at once
+		for (int c = 0; c < channels; ++c)
+			axis[c] = high[c] - low[c];
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			for (int a = 0; a < channels; ++a)
+				for (int b = 0; b < channels; ++b)
+					next[a] += covariance[a][b] * axis[b];
+
+			float length = 0.0f;
+			for (int c = 0; c < channels; ++c)
+				length = std::max(length, fabsf(next[c]));
+			if (length < 1e-6f)
+				break;
+
+			for (int c = 0; c < channels; ++c)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	// Endpoints at the extremes of the points projected onto the axis
+	void FitEndpoints(const float (*points)[4], const int count, const int channels, const float mean[4], const float axis[4],
+	                  float start[4], float end[4])
+	{
+		float axisLength = 0.0f;
+		for (int c = 0; c < channels; ++c)
+			axisLength += axis[c] * axis[c];
+
+		if (axisLength < 1e-6f)
+		{
+			for (int c = 0; c < 4; ++c)
+				start[c] = end[c] = mean[c];
+			return;
+		}
+
+		float minT = 1e30f;
+		float maxT = -1e30f;
+		for (int i = 0; i < count; ++i)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channels; ++c)
+				t += (points[i][c] - mean[c]) * axis[c];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		for (int c = 0; c < 4; ++c)
+		{
+			start[c] = Clamp255(mean[c] + axis[c] * minT / axisLength);
+			end[c] = Clamp255(mean[c] + axis[c] * maxT / axisLength);
+		}
+	}
+
+	// Least-squares endpoints for fixed per-point weights: each point is modelled as
+	// (1 - w) * start + w * end. Returns false when the system is singular.
+	bool SolveEndpoints(const float (*points)[4], const float* weights, const int count, const int channels,
+	                    float start[4], float end[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+		for (int i = 0; i < count; ++i)
+		{
+			if (weights[i] < 0.0f)
+				continue;   // point does not take part (BC1 transparent texel)
+
+			const float b = weights[i];
+			const float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < channels; ++c)
+			{
+				ax[c] += a * points[i][c];
+				bx[c] += b * points[i][c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		const float inverse = 1.0f / determinant;
+		for (int c = 0; c < channels; ++c)
+		{
+			start[c] = Clamp255((ax[c] * bb - bx[c] * ab) * inverse);
+			end[c] = Clamp255((bx[c] * aa - ax[c] * ab) * inverse);
+		}
+		return true;
+	}
+
+	int RefinementPasses(const BC_ENCODE_QUALITY quality)
+	{
+		return quality == BC_ENCODE_FAST ? 0 : quality == BC_ENCODE_NORMAL ? 1 : 3;
+	}
+
+#pragma region BC1 color block
+	struct ColorBlock
+	{
+		uint16_t color0;
+		uint16_t color1;
+		uint32_t indices;
+		float error;
+	};
+
+	uint16_t Pack565(const float color[4])
+	{
+		const int r = static_cast<int>(Clamp255(color[0]) * 31.0f / 255.0f + 0.5f);
+		const int g = static_cast<int>(Clamp255(color[1]) * 63.0f / 255.0f + 0.5f);
+		const int b = static_cast<int>(Clamp255(color[2]) * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	// Same palette as DecodeBCSurface builds, from the same endpoint expansion
+	void BuildColorPalette(const uint16_t c0, const uint16_t c1, const bool fourColor, int palette[4][3])
+	{
+		int e[2][3];
+		Expand565(c0, e[0]);
+		Expand565(c1, e[1]);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[0][c] = e[0][c];
+			palette[1][c] = e[1][c];
+			if (fourColor)
+			{
+				palette[2][c] = (2 * e[0][c] + e[1][c] + 1) / 3;
+				palette[3][c] = (e[0][c] + 2 * e[1][c] + 1) / 3;
+			}
+			else
+			{
+				palette[2][c] = (e[0][c] + e[1][c] + 1) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	// Picks the closest palette entry for every texel; transparent texels get index 3
+	void FitColorIndices(const float (*points)[4], const bool* transparent, const bool fourColor, ColorBlock& block)
+	{
+		int palette[4][3];
+		BuildColorPalette(block.color0, block.color1, fourColor, palette);
+
+		const int choices = fourColor ? 4 : 3;
+		block.indices = 0;
+		block.error = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (transparent[i])
+			{
+				block.indices |= 3u << (i * 2);
+				continue;
+			}
+
+			int best = 0;
+			float bestError = 1e30f;
+			for (int k = 0; k < choices; ++k)
+			{
+				const float error = Square(points[i][0] - palette[k][0]) + Square(points[i][1] - palette[k][1]) + Square(points[i][2] - palette[k][2]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = k;
+				}
+			}
+			block.indices |= static_cast<uint32_t>(best) << (i * 2);
+			block.error += bestError;
+		}
+	}
+
+	// Puts the endpoints in the order the decoder reads as the wanted mode: color0 > color1
+	// for four colors, color0 <= color1 for three
+	void OrderColorEndpoints(const bool fourColor, ColorBlock& block)
+	{
+		if (fourColor ? block.color0 >= block.color1 : block.color0 <= block.color1)
+		{
+			// Equal endpoints decode as three colors, where index 0 still gives color0
+			if (fourColor && block.color0 == block.color1)
+				block.indices = 0;
+			return;
+		}
+
+		std::swap(block.color0, block.color1);
+		for (int i = 0; i < 16; ++i)
+		{
+			const uint32_t index = (block.indices >> (i * 2)) & 3;
+			uint32_t swapped = index;
+			if (index < 2)
+				swapped = index ^ 1;
+			else if (fourColor)
+				swapped = index ^ 1;   // 2 <-> 3
+			block.indices = (block.indices & ~(3u << (i * 2))) | (swapped << (i * 2));
+		}
+	}
+
+	ColorBlock EncodeColorMode(const float (*points)[4], const bool* transparent, const bool fourColor, const BC_ENCODE_QUALITY quality)
+	{
+		float opaque[16][4];
+		int opaqueCount = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (!transparent[i])
+				memcpy(opaque[opaqueCount++], points[i], sizeof(opaque[0]));
+		}
+
+		float mean[4], axis[4], start[4], end[4];
+		FindAxis(opaque, opaqueCount, 3, quality, mean, axis);
+		FitEndpoints(opaque, opaqueCount, 3, mean, axis, start, end);
+
+		ColorBlock best;
+		best.color0 = Pack565(end);
+		best.color1 = Pack565(start);
+		FitColorIndices(points, transparent, fourColor, best);
+
+		for (int pass = 0; pass < RefinementPasses(quality); ++pass)
+		{
+			float weights[16];
+			for (int i = 0; i < 16; ++i)
+			{
+				const uint32_t index = (best.indices >> (i * 2)) & 3;
+				if (transparent[i])
+					weights[i] = -1.0f;
+				else if (index < 2)
+					weights[i] = static_cast<float>(index);
+				else
+					weights[i] = fourColor ? (index == 2 ? 1.0f / 3.0f : 2.0f / 3.0f) : 0.5f;
+			}
+
+			// Endpoint 0 is color0 here, so it takes the (1 - w) side
+			if (!SolveEndpoints(points, weights, 16, 3, start, end))
+				break;
+
+			ColorBlock candidate;
+			candidate.color0 = Pack565(start);
+			candidate.color1 = Pack565(end);
+			FitColorIndices(points, transparent, fourColor, candidate);
+			if (candidate.error >= best.error)
+				break;
+			best = candidate;
+		}
+
+		OrderColorEndpoints(fourColor, best);
+		return best;
+	}
+
+	// BC1 color half. punchThrough lets texels with alpha < 128 become transparent black
+	// (BC1 only); allowThreeColor tries the three color mode for opaque blocks as well.
+	void EncodeColorBlock(const uint8_t rgba[64], const bool punchThrough, const bool allowThreeColor,
+	                      const BC_ENCODE_QUALITY quality, uint8_t out[8])
+	{
+		float points[16][4];
+		bool transparent[16];
+		int transparentCount = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				points[i][c] = rgba[i * 4 + c];
+			transparent[i] = punchThrough && rgba[i * 4 + 3] < 128;
+			transparentCount += transparent[i] ? 1 : 0;
+		}
+
+		ColorBlock block;
+		if (transparentCount == 16)
+		{
+			block.color0 = block.color1 = 0;
+			block.indices = 0xFFFFFFFF;
+		}
+		else if (transparentCount > 0)
+		{
+			block = EncodeColorMode(points, transparent, false, quality);
+		}
+		else
+		{
+			block = EncodeColorMode(points, transparent, true, quality);
+			if (allowThreeColor && quality == BC_ENCODE_BEST)
+			{
+				const ColorBlock threeColor = EncodeColorMode(points, transparent, false, quality);
+				if (threeColor.error < block.error)
+					block = threeColor;
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(block.color0);
+		out[1] = static_cast<uint8_t>(block.color0 >> 8);
+		out[2] = static_cast<uint8_t>(block.color1);
+		out[3] = static_cast<uint8_t>(block.color1 >> 8);
+		memcpy(out + 4, &block.indices, 4);
+	}
+#pragma endregion
+
+#pragma region BC4 channel block
+	struct ChannelBlock
+	{
+		int value0;
+		int value1;
+		uint8_t indices[16];
+		int error;
+	};
+
+	// Same palette as DecodeBCSurface builds
+	void BuildChannelPalette(const int a0, const int a1, int palette[8])
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int i = 1; i < 7; ++i)
+				palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void FitChannelIndices(const uint8_t values[16], ChannelBlock& block)
+	{
+		int palette[8];
+		BuildChannelPalette(block.value0, block.value1, palette);
+
+		block.error = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			int bestError = 1 << 30;
+			for (int k = 0; k < 8; ++k)
+			{
+				const int error = (values[i] - palette[k]) * (values[i] - palette[k]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = k;
+				}
+			}
+			block.indices[i] = static_cast<uint8_t>(best);
+			block.error += bestError;
+		}
+	}
+
+	void EncodeChannelBlock(const uint8_t values[16], const BC_ENCODE_QUALITY quality, uint8_t out[8])
+	{
+		int low = 255;
+		int high = 0;
+		int innerLow = 255;
+		int innerHigh = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			low = std::min<int>(low, values[i]);
+			high = std::max<int>(high, values[i]);
+			if (values[i] != 0 && values[i] != 255)
+			{
+				innerLow = std::min<int>(innerLow, values[i]);
+				innerHigh = std::max<int>(innerHigh, values[i]);
+			}
+		}
+
+		// Eight interpolated values between the extremes
+		ChannelBlock best;
+		best.value0 = high;
+		best.value1 = low;
+		FitChannelIndices(values, best);
+
+		if (quality == BC_ENCODE_BEST && best.error > 0 && high > low)
+		{
+			for (int pass = 0; pass < RefinementPasses(quality); ++pass)
+			{
+				float points[16][4] = {};
+				float weights[16];
+				for (int i = 0; i < 16; ++i)
+				{
+					points[i][0] = values[i];
+					const int index = best.indices[i];
+					weights[i] = index < 2 ? static_cast<float>(index) : static_cast<float>(index - 1) / 7.0f;
+				}
+
+				float start[4], end[4];
+				if (!SolveEndpoints(points, weights, 16, 1, start, end))
+					break;
+
+				ChannelBlock candidate;
+				candidate.value0 = static_cast<int>(start[0] + 0.5f);
+				candidate.value1 = static_cast<int>(end[0] + 0.5f);
+				if (candidate.value0 <= candidate.value1)
+					break;
+
+				FitChannelIndices(values, candidate);
+				if (candidate.error >= best.error)
+					break;
+				best = candidate;
+			}
+		}
+
+		// Six interpolated values plus exact 0 and 255, for blocks that touch either end
+		if (quality != BC_ENCODE_FAST && best.error > 0 && innerLow <= innerHigh)
+		{
+			ChannelBlock candidate;
+			candidate.value0 = innerLow;
+			candidate.value1 = innerHigh;
+			FitChannelIndices(values, candidate);
+			if (candidate.error < best.error)
+				best = candidate;
+		}
+
+		out[0] = static_cast<uint8_t>(best.value0);
+		out[1] = static_cast<uint8_t>(best.value1);
+
+		uint64_t indices = 0;
+		for (int i = 0; i < 16; ++i)
+			indices |= static_cast<uint64_t>(best.indices[i]) << (i * 3);
+		memcpy(out + 2, &indices, 6);
+	}
+#pragma endregion
+
+#pragma region BC7 mode 6
+	struct BC7Block
+	{
+		int endpoints[2][4];    // 8-bit values, bit 0 being the endpoint's p-bit
+		uint8_t indices[16];
+		float error;
+	};
+
+	// Quantizes an endpoint to seven bits plus a p-bit shared by all four channels
+	void QuantizeEndpoint(const float value[4], const int pBit, int quantized[4])
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			const int q = std::min(std::max(static_cast<int>((value[c] - pBit) * 0.5f + 0.5f), 0), 127);
+			quantized[c] = (q << 1) | pBit;
+		}
+	}
+
+	float EndpointError(const float value[4], const int quantized[4])
+	{
+		float error = 0.0f;
+		for (int c = 0; c < 4; ++c)
+			error += Square(value[c] - quantized[c]);
+		return error;
+	}
+
+	void FitBC7Indices(const float (*points)[4], BC7Block& block)
+	{
+		int palette[16][4];
+		for (int k = 0; k < 16; ++k)
+		{
+			for (int c = 0; c < 4; ++c)
+				palette[k][c] = (block.endpoints[0][c] * (64 - s_bc7Weights4[k]) + block.endpoints[1][c] * s_bc7Weights4[k] + 32) >> 6;
+		}
+
+		block.error = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			float bestError = 1e30f;
+			for (int k = 0; k < 16; ++k)
+			{
+				float error = 0.0f;
+				for (int c = 0; c < 4; ++c)
+					error += Square(points[i][c] - palette[k][c]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = k;
+				}
+			}
+			block.indices[i] = static_cast<uint8_t>(best);
+			block.error += bestError;
+		}
+	}
+
+	// Quantizes both endpoints and fits indices. The best preset tries all four p-bit
+	// pairs; the others take the p-bit that keeps each endpoint closest. An opaque block
+	// always takes p-bit 1, the only one that stores alpha 255; left to the colour
+	// channels the p-bit could leave every texel at 254.
+	BC7Block QuantizeBC7(const float (*points)[4], const float start[4], const float end[4], const bool opaque,
+	                     const BC_ENCODE_QUALITY quality)
+	{
+		BC7Block best;
+		best.error = 1e30f;
+
+		if (opaque)
+		{
+			QuantizeEndpoint(start, 1, best.endpoints[0]);
+			QuantizeEndpoint(end, 1, best.endpoints[1]);
+			best.endpoints[0][3] = best.endpoints[1][3] = 255;
+			FitBC7Indices(points, best);
+			return best;
+		}
+
+		if (quality == BC_ENCODE_BEST)
+		{
+			for (int pBits = 0; pBits < 4; ++pBits)
+			{
+				BC7Block candidate;
+				QuantizeEndpoint(start, pBits & 1, candidate.endpoints[0]);
+				QuantizeEndpoint(end, pBits >> 1, candidate.endpoints[1]);
+				FitBC7Indices(points, candidate);
+				if (candidate.error < best.error)
+					best = candidate;
+			}
+			return best;
+		}
+
+		const float* const values[2] = { start, end };
+		for (int e = 0; e < 2; ++e)
+		{
+			int zero[4], one[4];
+			QuantizeEndpoint(values[e], 0, zero);
+			QuantizeEndpoint(values[e], 1, one);
+			memcpy(best.endpoints[e], EndpointError(values[e], zero) <= EndpointError(values[e], one) ? zero : one, sizeof(zero));
+		}
+		FitBC7Indices(points, best);
+		return best;
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* const out) : m_out(out) { memset(m_out, 0, 16); }
+
+		void Write(const uint32_t value, const unsigned int count)
+		{
+			for (unsigned int bit = 0; bit < count; ++bit, ++m_position)
+			{
+				if ((value >> bit) & 1)
+					m_out[m_position >> 3] |= static_cast<uint8_t>(1u << (m_position & 7));
+			}
+		}
+
+	private:
+		uint8_t* m_out;
+		unsigned int m_position = 0;
+	};
+
+	void EncodeBC7Block(const uint8_t rgba[64], const BC_ENCODE_QUALITY quality, uint8_t out[16])
+	{
+		float points[16][4];
+		for (int i = 0; i < 16; ++i)
+			for (int c = 0; c < 4; ++c)
+				points[i][c] = rgba[i * 4 + c];
+
+		bool opaque = true;
+		for (int i = 0; i < 16; ++i)
+			opaque = opaque && rgba[i * 4 + 3] == 255;
+
+		float mean[4], axis[4], start[4], end[4];
+		FindAxis(points, 16, 4, quality, mean, axis);
+		FitEndpoints(points, 16, 4, mean, axis, start, end);
+
+		BC7Block best = QuantizeBC7(points, start, end, opaque, quality);
+		for (int pass = 0; pass < RefinementPasses(quality) && best.error > 0.0f; ++pass)
+		{
+			float weights[16];
+			for (int i = 0; i < 16; ++i)
+				weights[i] = s_bc7Weights4[best.indices[i]] / 64.0f;
+
+			if (!SolveEndpoints(points, weights, 16, 4, start, end))
+				break;
+
+			const BC7Block candidate = QuantizeBC7(points, start, end, opaque, quality);
+			if (candidate.error >= best.error)
+				break;
+			best = candidate;
+		}
+
+		// The anchor texel's index is stored without its top bit
+		if (best.indices[0] >= 8)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			for (int i = 0; i < 16; ++i)
+				best.indices[i] = static_cast<uint8_t>(15 - best.indices[i]);
+		}
+
+		BitWriter bits(out);
+		bits.Write(1u << 6, 7);
+		for (int c = 0; c < 4; ++c)
+		{
+			bits.Write(static_cast<uint32_t>(best.endpoints[0][c] >> 1), 7);
+			bits.Write(static_cast<uint32_t>(best.endpoints[1][c] >> 1), 7);
+		}
+		bits.Write(static_cast<uint32_t>(best.endpoints[0][0] & 1), 1);
+		bits.Write(static_cast<uint32_t>(best.endpoints[1][0] & 1), 1);
+		for (int i = 0; i < 16; ++i)
+			bits.Write(best.indices[i], i == 0 ? 3 : 4);
+	}
+#pragma endregion
+
+	enum ENCODE_FORMAT
+	{
+		ENCODE_UNKNOWN,
+		ENCODE_BC1,
+		ENCODE_BC3,
+		ENCODE_BC5,
+		ENCODE_BC7,
+	};
+
+	ENCODE_FORMAT GetEncodeFormat(const DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return ENCODE_BC1;
+
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return ENCODE_BC3;
+
+		case DXGI_FORMAT_BC5_UNORM:
+			return ENCODE_BC5;
+
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return ENCODE_BC7;
+
+		default:
+			return ENCODE_UNKNOWN;
+		}
+	}
+
+	void EncodeBlock(const ENCODE_FORMAT format, const uint8_t rgba[64], const BC_ENCODE_QUALITY quality, uint8_t* const out)
+	{
+		uint8_t channel[16];
+		switch (format)
+		{
+		case ENCODE_BC1:
+			EncodeColorBlock(rgba, true, true, quality, out);
+			break;
+
+		case ENCODE_BC3:
+			for (int i = 0; i < 16; ++i)
+				channel[i] = rgba[i * 4 + 3];
+			EncodeChannelBlock(channel, quality, out);
+			EncodeColorBlock(rgba, false, false, quality, out + 8);
+			break;
+
+		case ENCODE_BC5:
+			for (int c = 0; c < 2; ++c)
+			{
+				for (int i = 0; i < 16; ++i)
+					channel[i] = rgba[i * 4 + c];
+				EncodeChannelBlock(channel, quality, out + c * 8);
+			}
+			break;
+
+		case ENCODE_BC7:
+			EncodeBC7Block(rgba, quality, out);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+bool IsBCEncodeFormat(const DXGI_FORMAT format)
+{
+	return GetEncodeFormat(format) != ENCODE_UNKNOWN;
+}
+
+HRESULT EncodeBCSurface(const DXGI_FORMAT format, const size_t width, const size_t height, const uint8_t* const rgba, const size_t rowPitch,
+                        const BC_ENCODE_QUALITY quality, uint8_t* const dest, const size_t destRowPitch, ThreadPool* const pool)
+{
+	const ENCODE_FORMAT encodeFormat = GetEncodeFormat(format);
+	if (encodeFormat == ENCODE_UNKNOWN)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	if (!rgba || !dest || width == 0 || height == 0 || rowPitch < width * 4)
+		return E_INVALIDARG;
+
+	const size_t blockBytes = encodeFormat == ENCODE_BC1 ? 8 : 16;
+	const size_t blocksWide = (width + 3) / 4;
+	const size_t blocksHigh = (height + 3) / 4;
+	if (destRowPitch < blocksWide * blockBytes)
+		return E_INVALIDARG;
+
+	const auto encodeBlocks = [&](const size_t begin, const size_t end)
+	{
+		uint8_t texels[64];
+		for (size_t blockIndex = begin; blockIndex < end; ++blockIndex)
+		{
+			const size_t bx = blockIndex % blocksWide;
+			const size_t by = blockIndex / blocksWide;
+
+			for (size_t y = 0; y < 4; ++y)
+			{
+				const uint8_t* const row = rgba + std::min(by * 4 + y, height - 1) * rowPitch;
+				for (size_t x = 0; x < 4; ++x)
+					memcpy(texels + (y * 4 + x) * 4, row + std::min(bx * 4 + x, width - 1) * 4, 4);
+			}
+
+			EncodeBlock(encodeFormat, texels, quality, dest + by * destRowPitch + bx * blockBytes);
+		}
+	};
+
+	const size_t blockCount = blocksWide * blocksHigh;
+	if (pool)
+		pool->ParallelFor(blockCount, 64, encodeBlocks);
+	else
+		encodeBlocks(0, blockCount);
+
+	return S_OK;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// CPU encoder for the block-compressed formats the loader consumes: BC1 (with 1-bit
+// alpha), BC3, BC5 (red and green of the source) and BC7 (mode 6 only). It is meant for
+// cooking assets offline; the output is checked with DecodeBCSurface.
+//--------------------------------------------------------------------------------------
+enum BC_ENCODE_QUALITY
+{
+	BC_ENCODE_FAST,    // endpoints from the bounding box, no refinement
+	BC_ENCODE_NORMAL,  // endpoints along the principal axis, one least-squares refinement
+	BC_ENCODE_BEST,    // more refinement passes, and every alternative block mode is tried
+};
+
+bool IsBCEncodeFormat(DXGI_FORMAT format);
+
+// Compresses an RGBA8 image into a subresource laid out the way FillInitData expects:
+// destRowPitch bytes per row of blocks. Edge blocks repeat the last row and column. When
+// a pool is given the blocks are spread over it.
+HRESULT EncodeBCSurface(DXGI_FORMAT format, size_t width, size_t height, const uint8_t* rgba, size_t rowPitch,
+                        BC_ENCODE_QUALITY quality, uint8_t* dest, size_t destRowPitch, ThreadPool* pool = nullptr);
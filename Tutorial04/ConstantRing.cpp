@@ -0,0 +1,80 @@
+#include "ConstantRing.h"
+#include <string.h>
+
+ConstantRing::ConstantRing()
+	: m_buffer(nullptr), m_ring(0, CONSTANT_SLOT_BYTES), m_slotBytes(0), m_offsets(false)
+{
+}
+
+ConstantRing::~ConstantRing()
+{
+	Release();
+}
+
+HRESULT ConstantRing::Create(ID3D11Device* const device, const UINT ringBytes, const UINT writeBytes, const bool offsets)
+{
+	if (!device || !writeBytes || writeBytes > D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16)
+		return E_INVALIDARG;
+	Release();
+
+	// Slots are whole multiples of sixteen constants, which is all an offset can address;
+	// without offsets the one slot only has to be a multiple of a constant
+	const UINT slotBytes = offsets ? (writeBytes + CONSTANT_SLOT_BYTES - 1) / CONSTANT_SLOT_BYTES * CONSTANT_SLOT_BYTES
+	                               : (writeBytes + 15) / 16 * 16;
+	const UINT capacity = offsets ? ringBytes / slotBytes * slotBytes : slotBytes;
+	if (!capacity)
+		return E_INVALIDARG;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = capacity;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	const HRESULT hr = device->CreateBuffer(&desc, nullptr, &m_buffer);
+	if (FAILED(hr))
+		return hr;
+
+	// Every allocation is a whole slot, so aligning to what an offset can address already
+	// packs them back to back; RingAllocator needs a power of two, which slotBytes need not be
+	m_ring = RingAllocator(capacity, offsets ? CONSTANT_SLOT_BYTES : 16);
+	m_slotBytes = slotBytes;
+	m_offsets = offsets;
+	return S_OK;
+}
+
+void ConstantRing::Release()
+{
+	if (m_buffer)
+		m_buffer->Release();
+	m_buffer = nullptr;
+	m_ring.Reset();
+}
+
+HRESULT ConstantRing::Write(ID3D11DeviceContext* const context, const void* const data, const UINT size, UINT* const firstConstant,
+                            UINT* const constantCount)
+{
+	if (!m_buffer)
+		return E_FAIL;
+	if (!context || !data || !size || size > m_slotBytes || !firstConstant || !constantCount)
+		return E_INVALIDARG;
+
+	bool wrapped = false;
+	const uint32_t offset = m_ring.Allocate(m_slotBytes, &wrapped);
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	const HRESULT hr = context->Map(m_buffer, 0, wrapped ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped);
+	if (FAILED(hr))
+	{
+		// The next write cannot trust what is in the buffer
+		m_ring.Reset();
+		return hr;
+	}
+	memcpy(static_cast<uint8_t*>(mapped.pData) + offset, data, size);
+	context->Unmap(m_buffer, 0);
+
+	*firstConstant = offset / 16;
+	*constantCount = m_slotBytes / 16;
+	++m_stats.writes;
+	m_stats.bytesWritten += size;
+	m_stats.discards += wrapped ? 1 : 0;
+	return S_OK;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+
+#include "RingAllocator.h"
+
+//--------------------------------------------------------------------------------------
+// Constants that change every draw, all written into one large D3D11_USAGE_DYNAMIC
+// constant buffer instead of rewriting one small buffer per draw. Write copies only the
+// bytes it is given, with MAP_WRITE_NO_OVERWRITE while the ring moves forward and
+// MAP_WRITE_DISCARD when it wraps. Each write's slot is a multiple of CONSTANT_SLOT_BYTES
+// long, since offsets are counted in sixteen constants, and is bound with
+// *SetConstantBuffers1 at the constants Write returns.
+//
+// That takes a D3D 11.1 context and a driver that can both map dynamic constant buffers
+// with NO_OVERWRITE and bind them at offsets. Created without offsets, the buffer holds
+// one write, every Write discards it, and it is bound once like any other.
+//
+// Not thread-safe: use it from the thread that owns the device.
+//--------------------------------------------------------------------------------------
+class ConstantRing
+{
+public:
+	static const UINT CONSTANT_SLOT_BYTES = 256;
+
+	struct Stats
+	{
+		uint64_t writes;
+		uint64_t bytesWritten;   // copied by Write, not counting the rest of each slot
+		uint64_t discards;
+	};
+
+	ConstantRing();
+	~ConstantRing();
+
+	ConstantRing(const ConstantRing&) = delete;
+	ConstantRing& operator=(const ConstantRing&) = delete;
+
+	// ringBytes is the buffer's size with offsets, and writeBytes the most one Write copies
+	HRESULT Create(ID3D11Device* device, UINT ringBytes, UINT writeBytes, bool offsets);
+	void Release();
+
+	// Copies 'size' bytes into the buffer. firstConstant and constantCount are where they
+	// landed, for *SetConstantBuffers1; without offsets they are always 0 and the slot size.
+	HRESULT Write(ID3D11DeviceContext* context, const void* data, UINT size, UINT* firstConstant, UINT* constantCount);
+
+	ID3D11Buffer* Buffer() const { return m_buffer; }
+	bool Offsets() const { return m_offsets; }
+
+	Stats GetStats() const { return m_stats; }
+
+private:
+	ID3D11Buffer* m_buffer;
+	RingAllocator m_ring;
+	UINT m_slotBytes;
+	bool m_offsets;
+	Stats m_stats = {};
+};
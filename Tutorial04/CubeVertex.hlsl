@@ -1,53 +1,57 @@
-//MAIN CUBE VERTEX
-cbuffer ConstantBuffer : register(b0)
-{
-	matrix World;
-	matrix View;
-	matrix Projection;
-	float4 lightPos;
-	float4 lightCol;
-	float4 lightAmb;
-	float4 lightDiff;
-	float4 Eye;
-}
-
-struct VS_INPUT {
-	float4 Pos : POSITION;
-	float3 Normal : NORMAL;
-	float2 TexCoord : TEXCOORD;
-	float3 Tangent : TANGENT;
-	float3 Binormal : BINORMAL;
-};
-
-struct VS_OUTPUT
-{
-	float4 Pos : SV_POSITION;
-	float4 WorldPos : POSITION;
-	float3 Normal : NORMAL;
-	float2 TexCoord : TEXCOORD;
-	float3 Tangent : TANGENT;
-	float3 Binormal : BINORMAL;
-	float3 viewDir: POSITION1;
-};
-
-VS_OUTPUT main(VS_INPUT input)
-{
-	VS_OUTPUT output = (VS_OUTPUT)0;
-
-	//Apply Perspective to vertices
-	output.Pos = mul(input.Pos, World);
-	output.WorldPos = output.Pos;
-	output.Pos = mul(output.Pos, View);
-	output.Pos = mul(output.Pos, Projection);
-
-	//Normalise
-	output.Normal = mul(input.Normal, (float3x3)World);
-	output.Normal = normalize(output.Normal);
-
-	output.TexCoord = input.TexCoord;
-	output.Tangent = input.Tangent;
-	output.Binormal = input.Binormal;
-	output.viewDir = input.Pos.xyz;
-
-	return output;
+//MAIN CUBE VERTEX
+cbuffer FrameConstants : register(b0)
+{
+	matrix View;
+	matrix Projection;
+	float4 lightPos;
+	float4 lightCol;
+	float4 lightAmb;
+	float4 lightDiff;
+	float4 Eye;
+}
+
+cbuffer ObjectConstants : register(b2)
+{
+	matrix World;
+}
+
+struct VS_INPUT {
+	float4 Pos : POSITION;
+	float3 Normal : NORMAL;
+	float2 TexCoord : TEXCOORD;
+	float3 Tangent : TANGENT;
+	float3 Binormal : BINORMAL;
+};
+
+struct VS_OUTPUT
+{
+	float4 Pos : SV_POSITION;
+	float4 WorldPos : POSITION;
+	float3 Normal : NORMAL;
+	float2 TexCoord : TEXCOORD;
+	float3 Tangent : TANGENT;
+	float3 Binormal : BINORMAL;
+	float3 viewDir: POSITION1;
+};
+
+VS_OUTPUT main(VS_INPUT input)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	//Apply Perspective to vertices
+	output.Pos = mul(input.Pos, World);
+	output.WorldPos = output.Pos;
+	output.Pos = mul(output.Pos, View);
+	output.Pos = mul(output.Pos, Projection);
+
+	//Normalise
+	output.Normal = mul(input.Normal, (float3x3)World);
+	output.Normal = normalize(output.Normal);
+
+	output.TexCoord = input.TexCoord;
+	output.Tangent = input.Tangent;
+	output.Binormal = input.Binormal;
+	output.viewDir = input.Pos.xyz;
+
+	return output;
 }
\ No newline at end of file
@@ -1,156 +1,219 @@
-//--------------------------------------------------------------------------------------
-// File: DDSTextureLoader.h
-//
-// Functions for loading a DDS texture and creating a Direct3D 11 runtime resource for it
-//
-// Note these functions are useful as a light-weight runtime loader for DDS files. For
-// a full-featured DDS file reader, writer, and texture processing pipeline see
-// the 'Texconv' sample and the 'DirectXTex' library.
-//
-// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
-// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
-// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
-// PARTICULAR PURPOSE.
-//
-// Copyright (c) Microsoft Corporation. All rights reserved.
-//
-// http://go.microsoft.com/fwlink/?LinkId=248926
-// http://go.microsoft.com/fwlink/?LinkId=248929
-//--------------------------------------------------------------------------------------
-
-#ifdef _MSC_VER
-#pragma once
-#endif
-
-#if defined(_XBOX_ONE) && defined(_TITLE)
-#include <d3d11_x.h>
-#define DCOMMON_H_INCLUDED
-#define NO_D3D11_DEBUG_NAME
-#else
-#include <d3d11_1.h>
-#endif
-
-#pragma warning(push)
-#pragma warning(disable : 4005)
-#include <stdint.h>
-#pragma warning(pop)
-
-#if defined(_MSC_VER) && (_MSC_VER<1610) && !defined(_In_reads_)
-#define _In_reads_(exp)
-#define _Out_writes_(exp)
-#define _In_reads_bytes_(exp)
-#define _In_reads_opt_(exp)
-#define _Outptr_opt_
-#endif
-
-#ifndef _Use_decl_annotations_
-#define _Use_decl_annotations_
-#endif
-
-namespace DirectX
-{
-    enum DDS_ALPHA_MODE
-    {
-        DDS_ALPHA_MODE_UNKNOWN       = 0,
-        DDS_ALPHA_MODE_STRAIGHT      = 1,
-        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
-        DDS_ALPHA_MODE_OPAQUE        = 3,
-        DDS_ALPHA_MODE_CUSTOM        = 4,
-    };
-
-    // Standard version
-    HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
-                                        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
-                                        _In_ size_t ddsDataSize,
-                                        _Outptr_opt_ ID3D11Resource** texture,
-                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                        _In_ size_t maxsize = 0,
-                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                      );
-
-    HRESULT CreateDDSTextureFromFile( _In_ ID3D11Device* d3dDevice,
-                                      _In_z_ const wchar_t* szFileName,
-                                      _Outptr_opt_ ID3D11Resource** texture,
-                                      _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                      _In_ size_t maxsize = 0,
-                                      _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                    );
-
-    // Standard version with optional auto-gen mipmap support
-    HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
-                                        _In_opt_ ID3D11DeviceContext* d3dContext,
-                                        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
-                                        _In_ size_t ddsDataSize,
-                                        _Outptr_opt_ ID3D11Resource** texture,
-                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                        _In_ size_t maxsize = 0,
-                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                      );
-
-    HRESULT CreateDDSTextureFromFile( _In_ ID3D11Device* d3dDevice,
-                                      _In_opt_ ID3D11DeviceContext* d3dContext,
-                                      _In_z_ const wchar_t* szFileName,
-                                      _Outptr_opt_ ID3D11Resource** texture,
-                                      _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                      _In_ size_t maxsize = 0,
-                                      _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                    );
-
-    // Extended version
-    HRESULT CreateDDSTextureFromMemoryEx( _In_ ID3D11Device* d3dDevice,
-                                          _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
-                                          _In_ size_t ddsDataSize,
-                                          _In_ size_t maxsize,
-                                          _In_ D3D11_USAGE usage,
-                                          _In_ unsigned int bindFlags,
-                                          _In_ unsigned int cpuAccessFlags,
-                                          _In_ unsigned int miscFlags,
-                                          _In_ bool forceSRGB,
-                                          _Outptr_opt_ ID3D11Resource** texture,
-                                          _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                          _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                      );
-
-    HRESULT CreateDDSTextureFromFileEx( _In_ ID3D11Device* d3dDevice,
-                                        _In_z_ const wchar_t* szFileName,
-                                        _In_ size_t maxsize,
-                                        _In_ D3D11_USAGE usage,
-                                        _In_ unsigned int bindFlags,
-                                        _In_ unsigned int cpuAccessFlags,
-                                        _In_ unsigned int miscFlags,
-                                        _In_ bool forceSRGB,
-                                        _Outptr_opt_ ID3D11Resource** texture,
-                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                    );
-
-    // Extended version with optional auto-gen mipmap support
-    HRESULT CreateDDSTextureFromMemoryEx( _In_ ID3D11Device* d3dDevice,
-                                          _In_opt_ ID3D11DeviceContext* d3dContext,
-                                          _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
-                                          _In_ size_t ddsDataSize,
-                                          _In_ size_t maxsize,
-                                          _In_ D3D11_USAGE usage,
-                                          _In_ unsigned int bindFlags,
-                                          _In_ unsigned int cpuAccessFlags,
-                                          _In_ unsigned int miscFlags,
-                                          _In_ bool forceSRGB,
-                                          _Outptr_opt_ ID3D11Resource** texture,
-                                          _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                          _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                      );
-
-    HRESULT CreateDDSTextureFromFileEx( _In_ ID3D11Device* d3dDevice,
-                                        _In_opt_ ID3D11DeviceContext* d3dContext,
-                                        _In_z_ const wchar_t* szFileName,
-                                        _In_ size_t maxsize,
-                                        _In_ D3D11_USAGE usage,
-                                        _In_ unsigned int bindFlags,
-                                        _In_ unsigned int cpuAccessFlags,
-                                        _In_ unsigned int miscFlags,
-                                        _In_ bool forceSRGB,
-                                        _Outptr_opt_ ID3D11Resource** texture,
-                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
-                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
-                                    );
+//--------------------------------------------------------------------------------------
+// File: DDSTextureLoader.h
+//
+// Functions for loading a DDS texture and creating a Direct3D 11 runtime resource for it
+//
+// Note these functions are useful as a light-weight runtime loader for DDS files. For
+// a full-featured DDS file reader, writer, and texture processing pipeline see
+// the 'Texconv' sample and the 'DirectXTex' library.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#define DCOMMON_H_INCLUDED
+#define NO_D3D11_DEBUG_NAME
+#else
+#include <d3d11_1.h>
+#endif
+
+#pragma warning(push)
+#pragma warning(disable : 4005)
+#include <stdint.h>
+#pragma warning(pop)
+
+#include <memory>
+
+#include "MipGenerator.h"
+
+#if defined(_MSC_VER) && (_MSC_VER<1610) && !defined(_In_reads_)
+#define _In_reads_(exp)
+#define _Out_writes_(exp)
+#define _In_reads_bytes_(exp)
+#define _In_reads_opt_(exp)
+#define _Outptr_opt_
+#endif
+
+#ifndef _Use_decl_annotations_
+#define _Use_decl_annotations_
+#endif
+
+namespace DirectX
+{
+    enum DDS_ALPHA_MODE
+    {
+        DDS_ALPHA_MODE_UNKNOWN       = 0,
+        DDS_ALPHA_MODE_STRAIGHT      = 1,
+        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+        DDS_ALPHA_MODE_OPAQUE        = 3,
+        DDS_ALPHA_MODE_CUSTOM        = 4,
+    };
+
+    // Standard version
+    HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
+                                        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                        _In_ size_t ddsDataSize,
+                                        _Outptr_opt_ ID3D11Resource** texture,
+                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                        _In_ size_t maxsize = 0,
+                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                      );
+
+    HRESULT CreateDDSTextureFromFile( _In_ ID3D11Device* d3dDevice,
+                                      _In_z_ const wchar_t* szFileName,
+                                      _Outptr_opt_ ID3D11Resource** texture,
+                                      _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                      _In_ size_t maxsize = 0,
+                                      _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                    );
+
+    // Standard version with optional auto-gen mipmap support
+    HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
+                                        _In_opt_ ID3D11DeviceContext* d3dContext,
+                                        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                        _In_ size_t ddsDataSize,
+                                        _Outptr_opt_ ID3D11Resource** texture,
+                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                        _In_ size_t maxsize = 0,
+                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                      );
+
+    HRESULT CreateDDSTextureFromFile( _In_ ID3D11Device* d3dDevice,
+                                      _In_opt_ ID3D11DeviceContext* d3dContext,
+                                      _In_z_ const wchar_t* szFileName,
+                                      _Outptr_opt_ ID3D11Resource** texture,
+                                      _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                      _In_ size_t maxsize = 0,
+                                      _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                    );
+
+    // Extended version
+    HRESULT CreateDDSTextureFromMemoryEx( _In_ ID3D11Device* d3dDevice,
+                                          _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                          _In_ size_t ddsDataSize,
+                                          _In_ size_t maxsize,
+                                          _In_ D3D11_USAGE usage,
+                                          _In_ unsigned int bindFlags,
+                                          _In_ unsigned int cpuAccessFlags,
+                                          _In_ unsigned int miscFlags,
+                                          _In_ bool forceSRGB,
+                                          _Outptr_opt_ ID3D11Resource** texture,
+                                          _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                          _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                      );
+
+    HRESULT CreateDDSTextureFromFileEx( _In_ ID3D11Device* d3dDevice,
+                                        _In_z_ const wchar_t* szFileName,
+                                        _In_ size_t maxsize,
+                                        _In_ D3D11_USAGE usage,
+                                        _In_ unsigned int bindFlags,
+                                        _In_ unsigned int cpuAccessFlags,
+                                        _In_ unsigned int miscFlags,
+                                        _In_ bool forceSRGB,
+                                        _Outptr_opt_ ID3D11Resource** texture,
+                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                    );
+
+    // Extended version with optional auto-gen mipmap support
+    HRESULT CreateDDSTextureFromMemoryEx( _In_ ID3D11Device* d3dDevice,
+                                          _In_opt_ ID3D11DeviceContext* d3dContext,
+                                          _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                          _In_ size_t ddsDataSize,
+                                          _In_ size_t maxsize,
+                                          _In_ D3D11_USAGE usage,
+                                          _In_ unsigned int bindFlags,
+                                          _In_ unsigned int cpuAccessFlags,
+                                          _In_ unsigned int miscFlags,
+                                          _In_ bool forceSRGB,
+                                          _Outptr_opt_ ID3D11Resource** texture,
+                                          _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                          _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                      );
+
+    HRESULT CreateDDSTextureFromFileEx( _In_ ID3D11Device* d3dDevice,
+                                        _In_opt_ ID3D11DeviceContext* d3dContext,
+                                        _In_z_ const wchar_t* szFileName,
+                                        _In_ size_t maxsize,
+                                        _In_ D3D11_USAGE usage,
+                                        _In_ unsigned int bindFlags,
+                                        _In_ unsigned int cpuAccessFlags,
+                                        _In_ unsigned int miscFlags,
+                                        _In_ bool forceSRGB,
+                                        _Outptr_opt_ ID3D11Resource** texture,
+                                        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+                                        _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                    );
+
+    // Reads a DDS file into memory and validates its header without touching the device,
+    // so it can run on a worker thread. With a non-zero maxsize only the mips that fit are
+    // read. The buffer can then be handed to CreateDDSTextureFromMemoryEx. Files written
+    // LZ-chunked by "AssetTool compress" come back as the plain DDS image, decoded on the
+    // pool when one is given.
+    HRESULT LoadDDSDataFromFile( _In_z_ const wchar_t* szFileName,
+                                 _In_ size_t maxsize,
+                                 std::unique_ptr<uint8_t[]>& ddsData,
+                                 _Out_ size_t* ddsDataSize,
+                                 _In_opt_ ThreadPool* pool = nullptr
+                               );
+
+    // Shape of the texture in a DDS file, read from its header alone
+    struct DDS_TEXTURE_INFO
+    {
+        D3D11_RESOURCE_DIMENSION resDim;
+        size_t width;
+        size_t height;
+        size_t depth;
+        size_t mipCount;
+        size_t arraySize;       // six per cube
+        DXGI_FORMAT format;
+        bool isCubeMap;
+    };
+
+    HRESULT GetDDSTextureInfo( _In_z_ const wchar_t* szFileName,
+                               _Out_ DDS_TEXTURE_INFO* info
+                             );
+
+    // Reads one mip level of every array slice of a 2D DDS texture and nothing else, for
+    // streaming finer levels into a texture created from the mip tail. The slices are
+    // stored back to back, 'slicePitch' bytes apart, ready for UpdateSubresource.
+    HRESULT LoadDDSMipFromFile( _In_z_ const wchar_t* szFileName,
+                                _In_ size_t mipLevel,
+                                std::unique_ptr<uint8_t[]>& mipData,
+                                _Out_ size_t* rowPitch,
+                                _Out_ size_t* slicePitch,
+                                _In_opt_ ThreadPool* pool = nullptr
+                              );
+
+    // Bytes of video memory the texture in a DDS image takes once created with 'maxsize',
+    // summed from GetSurfaceInfo over the mips and array slices that are kept
+    HRESULT GetDDSTextureMemorySize( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                     _In_ size_t ddsDataSize,
+                                     _In_ size_t maxsize,
+                                     _Out_ size_t* textureBytes
+                                   );
+
+    // Replaces a DDS image that has a single mip with one carrying the full chain, built on
+    // the CPU. Meant for textures created without a context to GenerateMips on. Returns
+    // S_FALSE and leaves the data alone when the texture already has mips or is not a 2D
+    // texture in a format IsMipGenFormat accepts.
+    HRESULT GenerateDDSMipChain( std::unique_ptr<uint8_t[]>& ddsData,
+                                 _Inout_ size_t* ddsDataSize,
+                                 _In_ MIP_FILTER filter,
+                                 _In_ bool forceSRGB,
+                                 _In_opt_ ThreadPool* pool
+                               );
 }
\ No newline at end of file
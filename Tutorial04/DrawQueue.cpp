@@ -0,0 +1,97 @@
+#include "DrawQueue.h"
+#include <string.h>
+
+namespace
+{
+	// Six passes of eleven bits; each pass's histogram still fits in the L1 cache
+	const unsigned RADIX_BITS = 11;
+	const size_t RADIX = size_t(1) << RADIX_BITS;
+	const unsigned DIGITS = (64 + RADIX_BITS - 1) / RADIX_BITS;
+
+	// Below this many packets clearing and summing the histograms costs more than an
+	// insertion sort, which keeps equal keys in order as well
+	const size_t INSERTION_SORT_COUNT = 64;
+
+	uint64_t Field(const uint32_t value, const unsigned bits)
+	{
+		return value & ((uint64_t(1) << bits) - 1);
+	}
+}
+
+uint64_t MakeDrawKey(const uint32_t layer, const bool blended, const uint32_t shader, const uint32_t material, const uint32_t mesh,
+                     const float depth)
+{
+	// Non-negative floats order as their bits do; the top ones are the exponent and the
+	// leading mantissa bits
+	uint32_t depthBits = 0;
+	if (depth > 0.0f)
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+	depthBits >>= 31 - DRAW_KEY_DEPTH_BITS;
+
+	uint64_t key = Field(layer, DRAW_KEY_LAYER_BITS);
+	key = key << 1 | (blended ? 1 : 0);
+	if (blended)
+		key = key << DRAW_KEY_DEPTH_BITS | Field(~depthBits, DRAW_KEY_DEPTH_BITS);
+	key = key << DRAW_KEY_SHADER_BITS | Field(shader, DRAW_KEY_SHADER_BITS);
+	key = key << DRAW_KEY_MATERIAL_BITS | Field(material, DRAW_KEY_MATERIAL_BITS);
+	key = key << DRAW_KEY_MESH_BITS | Field(mesh, DRAW_KEY_MESH_BITS);
+	if (!blended)
+		key = key << DRAW_KEY_DEPTH_BITS | Field(depthBits, DRAW_KEY_DEPTH_BITS);
+	return key;
+}
+
+void DrawQueue::Reserve(const size_t count)
+{
+	m_packets.reserve(count);
+	m_scratch.reserve(count);
+}
+
+void DrawQueue::Sort()
+{
+	const size_t count = m_packets.size();
+	if (count < INSERTION_SORT_COUNT)
+	{
+		for (size_t i = 1; i < count; ++i)
+		{
+			const DRAW_PACKET packet = m_packets[i];
+			size_t j = i;
+			for (; j > 0 && m_packets[j - 1].key > packet.key; --j)
+				m_packets[j] = m_packets[j - 1];
+			m_packets[j] = packet;
+		}
+		return;
+	}
+	m_scratch.resize(count);
+
+	// Every digit's histogram in one pass over the keys
+	uint32_t histograms[DIGITS][RADIX] = {};
+	for (const DRAW_PACKET& packet : m_packets)
+	{
+		uint64_t key = packet.key;
+		for (unsigned digit = 0; digit < DIGITS; ++digit, key >>= RADIX_BITS)
+			++histograms[digit][key & (RADIX - 1)];
+	}
+
+	for (unsigned digit = 0; digit < DIGITS; ++digit)
+	{
+		// A digit all the keys share would leave the order as it is
+		const unsigned shift = digit * RADIX_BITS;
+		uint32_t* const offsets = histograms[digit];
+		if (offsets[(m_packets[0].key >> shift) & (RADIX - 1)] == count)
+			continue;
+
+		uint32_t total = 0;
+		for (size_t bucket = 0; bucket < RADIX; ++bucket)
+		{
+			const uint32_t bucketCount = offsets[bucket];
+			offsets[bucket] = total;
+			total += bucketCount;
+		}
+
+		const DRAW_PACKET* const from = m_packets.data();
+		DRAW_PACKET* const to = m_scratch.data();
+		for (size_t i = 0; i < count; ++i)
+			to[offsets[(from[i].key >> shift) & (RADIX - 1)]++] = from[i];
+		m_packets.swap(m_scratch);
+	}
+}
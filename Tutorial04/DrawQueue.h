@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// A draw as the queue sorts it: the key orders it, and the payload tells the caller which
+// draw it was, such as the index of the entity. Packed to twelve bytes, since each pass of
+// the sort moves every packet.
+//--------------------------------------------------------------------------------------
+#pragma pack(push,4)
+struct DRAW_PACKET
+{
+	uint64_t key;
+	uint32_t payload;
+};
+#pragma pack(pop)
+
+// Fields of a draw key, most significant first. Opaque draws sort by layer, then shader,
+// material, mesh and depth, nearest first; blended ones by layer, then depth, farthest
+// first, then the rest. Fields wider than their bits keep only the low ones, which only
+// costs state changes, never correctness.
+const unsigned DRAW_KEY_LAYER_BITS = 4;
+const unsigned DRAW_KEY_SHADER_BITS = 10;
+const unsigned DRAW_KEY_MATERIAL_BITS = 12;
+const unsigned DRAW_KEY_MESH_BITS = 10;
+const unsigned DRAW_KEY_DEPTH_BITS = 27;
+
+// Lower layers draw first, and in each layer the opaque draws before the blended ones.
+// depth is the view-space distance; negative ones count as 0.
+uint64_t MakeDrawKey(uint32_t layer, bool blended, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+
+//--------------------------------------------------------------------------------------
+// The draws of a frame, pushed in any order and sorted by key. Sort is a least-significant
+// digit radix sort, eleven bits per pass, that skips the digits every key has the same, so
+// it is linear in the packets and keeps draws with equal keys in the order they were pushed.
+// Clear keeps the memory for the next frame.
+//--------------------------------------------------------------------------------------
+class DrawQueue
+{
+public:
+	DrawQueue() = default;
+
+	DrawQueue(const DrawQueue&) = delete;
+	DrawQueue& operator=(const DrawQueue&) = delete;
+
+	void Clear() { m_packets.clear(); }
+	void Reserve(size_t count);
+
+	void Push(const uint64_t key, const uint32_t payload) { m_packets.push_back(DRAW_PACKET{ key, payload }); }
+
+	void Sort();
+
+	size_t Count() const { return m_packets.size(); }
+	const DRAW_PACKET* Packets() const { return m_packets.data(); }
+
+private:
+	std::vector<DRAW_PACKET> m_packets;
+	std::vector<DRAW_PACKET> m_scratch;
+};
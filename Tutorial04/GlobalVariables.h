@@ -1,62 +1,128 @@
-#pragma once
-
-#pragma region Global Variables
-
-HINSTANCE                 g_hInst = nullptr;
-HWND                      g_hWnd = nullptr;
-D3D_DRIVER_TYPE           g_driverType = D3D_DRIVER_TYPE_NULL;
-D3D_FEATURE_LEVEL         g_featureLevel = D3D_FEATURE_LEVEL_11_0;
-ID3D11Device*             g_pd3dDevice = nullptr;
-ID3D11Device1*            g_pd3dDevice1 = nullptr;
-ID3D11DeviceContext*      g_pImmediateContext = nullptr;
-ID3D11DeviceContext1*     g_pImmediateContext1 = nullptr;
-IDXGISwapChain*           g_pSwapChain = nullptr;
-IDXGISwapChain1*          g_pSwapChain1 = nullptr;
-ID3D11RenderTargetView*   g_pRenderTargetView = nullptr;
-ID3D11Texture2D*		  g_pDepthStencil = nullptr;
-ID3D11DepthStencilView*   g_pDepthStencilView = nullptr;
-ID3D11VertexShader*       g_pSphereVertex = nullptr;
-ID3D11VertexShader*       g_pSphereVertex2 = nullptr;
-ID3D11VertexShader*       g_pCubeVertex = nullptr;
-ID3D11VertexShader*       g_pCubeVertex2 = nullptr;
-ID3D11VertexShader*       g_pDisplacementVertex = nullptr;
-ID3D11PixelShader*        g_pLightingPixel = nullptr;
-ID3D11PixelShader*        g_pCubemapPixel = nullptr;
-ID3D11PixelShader*		  g_pTransparentPixel = nullptr;
-ID3D11PixelShader*		  g_pBumpPixel = nullptr;
-ID3D11PixelShader*		  g_pDisplacementPixel = nullptr;
-ID3D11PixelShader*		  g_pInkPixel = nullptr;
-ID3D11InputLayout*        g_pVertexLayout = nullptr;
-ID3D11Buffer*             g_pVertexBuffer = nullptr;
-ID3D11Buffer*             g_pVertexBuffer2 = nullptr;
-ID3D11Buffer*             g_pIndexBuffer = nullptr;
-ID3D11Buffer*             g_pIndexBuffer2 = nullptr;
-ID3D11Buffer*             g_pConstantBuffer = nullptr;
-ID3D11ShaderResourceView* g_pBoxTextureRV = nullptr;
-ID3D11SamplerState*       g_pBoxSampler = nullptr;
-ID3D11ShaderResourceView* g_pStonesNormalRV = nullptr;
-ID3D11SamplerState*       g_pStonesNormalSampler = nullptr;
-ID3D11ShaderResourceView* g_pStonesTextureRV = nullptr;
-ID3D11SamplerState*       g_pStonesSampler = nullptr;
-ID3D11ShaderResourceView* g_pTileTexRV = nullptr;
-ID3D11SamplerState*       g_pTileSampler = nullptr;
-ID3D11ShaderResourceView* g_pDispMapRV = nullptr;
-ID3D11SamplerState*       g_pDispMapSampler = nullptr;
-ID3D11DepthStencilState*  g_pDepthStencilStateBox = nullptr;
-ID3D11DepthStencilState*  g_pDepthStencilStateObjects = nullptr;
-ID3D11RasterizerState*    g_pRasterStateBox = nullptr;
-ID3D11RasterizerState*    g_pRasterStateObjects = nullptr;
-ID3D11BlendState*	      g_pBlendDesc = nullptr;
-ID3D11BlendState*         g_pNoBlendDesc = nullptr;
-
-XMMATRIX				  g_World;
-XMMATRIX				  g_View;
-XMMATRIX				  g_Projection;
-Lighting                  g_light;
-XMVECTOR				  g_Eye;
-XMVECTOR				  g_Eye2;
-XMVECTOR				  g_At;
-XMVECTOR				  g_Up;
-XMVECTOR				  g_Up2;
-size_t nIndices;
+#pragma once
+
+#pragma region Global Variables
+
+HINSTANCE                 g_hInst = nullptr;
+HWND                      g_hWnd = nullptr;
+D3D_DRIVER_TYPE           g_driverType = D3D_DRIVER_TYPE_NULL;
+D3D_FEATURE_LEVEL         g_featureLevel = D3D_FEATURE_LEVEL_11_0;
+ID3D11Device*             g_pd3dDevice = nullptr;
+ID3D11Device1*            g_pd3dDevice1 = nullptr;
+ID3D11DeviceContext*      g_pImmediateContext = nullptr;
+ID3D11DeviceContext1*     g_pImmediateContext1 = nullptr;
+IDXGISwapChain*           g_pSwapChain = nullptr;
+IDXGISwapChain1*          g_pSwapChain1 = nullptr;
+ID3D11RenderTargetView*   g_pRenderTargetView = nullptr;
+ID3D11Texture2D*		  g_pDepthStencil = nullptr;
+ID3D11DepthStencilView*   g_pDepthStencilView = nullptr;
+ID3D11VertexShader*       g_pSphereVertex = nullptr;
+ID3D11VertexShader*       g_pSphereVertex2 = nullptr;
+ID3D11VertexShader*       g_pSphereCompactVertex = nullptr;
+ID3D11VertexShader*       g_pCubeVertex = nullptr;
+ID3D11VertexShader*       g_pCubeVertex2 = nullptr;
+ID3D11VertexShader*       g_pDisplacementVertex = nullptr;
+ID3D11PixelShader*        g_pLightingPixel = nullptr;
+ID3D11PixelShader*        g_pCubemapPixel = nullptr;
+ID3D11PixelShader*		  g_pTransparentPixel = nullptr;
+ID3D11PixelShader*		  g_pBumpPixel = nullptr;
+ID3D11PixelShader*		  g_pDisplacementPixel = nullptr;
+ID3D11PixelShader*		  g_pInkPixel = nullptr;
+ID3D11InputLayout*        g_pVertexLayout = nullptr;
+ID3D11InputLayout*        g_pCompactVertexLayout = nullptr;
+ID3D11Buffer*             g_pFrameConstants = nullptr;
+ID3D11Buffer*             g_pQuantizationBuffer = nullptr;
+ID3D11ShaderResourceView* g_pBoxTextureRV = nullptr;
+ID3D11SamplerState*       g_pBoxSampler = nullptr;
+ID3D11ShaderResourceView* g_pStonesNormalRV = nullptr;
+ID3D11SamplerState*       g_pStonesNormalSampler = nullptr;
+ID3D11ShaderResourceView* g_pStonesTextureRV = nullptr;
+ID3D11SamplerState*       g_pStonesSampler = nullptr;
+ID3D11ShaderResourceView* g_pTileTexRV = nullptr;
+ID3D11SamplerState*       g_pTileSampler = nullptr;
+ID3D11ShaderResourceView* g_pDispMapRV = nullptr;
+ID3D11SamplerState*       g_pDispMapSampler = nullptr;
+ID3D11DepthStencilState*  g_pDepthStencilStateBox = nullptr;
+ID3D11DepthStencilState*  g_pDepthStencilStateObjects = nullptr;
+ID3D11RasterizerState*    g_pRasterStateBox = nullptr;
+ID3D11RasterizerState*    g_pRasterStateObjects = nullptr;
+ID3D11BlendState*	      g_pBlendDesc = nullptr;
+ID3D11BlendState*         g_pNoBlendDesc = nullptr;
+ThreadPool*               g_pThreadPool = nullptr;
+AssetArchive*             g_pAssetArchive = nullptr;
+TextureCache*             g_pTextureCache = nullptr;
+MeshRegistry*             g_pMeshRegistry = nullptr;
+StateCache*               g_pStateCache = nullptr;
+DrawQueue*                g_pDrawQueue = nullptr;
+ConstantRing*             g_pObjectConstants = nullptr;
+MESH_HANDLE               g_cubeMesh = {};
+MESH_HANDLE               g_sphereMesh = {};
+TextureResidency*         g_pTextureResidency = nullptr;
+TextureResidency::Handle  g_stonesTexture = 0;
+TextureResidency::Handle  g_stonesNormal = 0;
+
+XMMATRIX				  g_World;
+XMMATRIX				  g_View;
+XMMATRIX				  g_Projection;
+Lighting                  g_light;
+XMVECTOR				  g_Eye;
+XMVECTOR				  g_Eye2;
+XMVECTOR				  g_At;
+XMVECTOR				  g_Up;
+XMVECTOR				  g_Up2;
+size_t nIndices;
+DXGI_FORMAT               g_sphereIndexFormat = DXGI_FORMAT_R16_UINT;
+float                     g_viewportHeight = 1.0f;
+
+// How far Sphere.obj spans from its origin before the world scale is applied, measured
+// from its vertices once it is loaded; 0 until then, which keeps every sphere at LOD 0
+float                     g_sphereModelRadius = 0.0f;
+
+// Levels of detail of Sphere.obj, ranges of g_sphereMesh's indices, picked per sphere
+// from its size on screen
+const size_t              SPHERE_MAX_LODS = 4;
+const float               SPHERE_MAX_LOD_ERROR = 0.05f;   // of the sphere's extent
+MESH_CACHE_LOD            g_sphereLods[SPHERE_MAX_LODS] = {};
+size_t                    g_sphereLodCount = 0;
+
+// Every level's meshlets, and the index ranges of those left after culling, which
+// DrawSphereLod refills for each sphere it draws
+std::vector<MESH_CACHE_MESHLET> g_sphereMeshlets;
+std::vector<MESHLET_DRAW_RANGE> g_sphereDrawRanges;
+
+// Set by -compactvertices on the command line: the spheres are uploaded as CompactVertex
+// and drawn with SphereCompactVertex.hlsl instead of from SimpleVertex
+bool                      g_compactSphereVertices = false;
+
+// What a scene material's names resolved to when Scene.txt was loaded. The sampler and
+// textures are kept as the globals holding them, since residency replaces a streamed
+// texture's view as more of it is read; nullptr leaves that slot as it was.
+struct SCENE_MATERIAL_BINDING
+{
+	ID3D11VertexShader*              vertexShader;
+	ID3D11VertexShader*              debugVertexShader;   // drawn with while F6 is held
+	ID3D11InputLayout*               inputLayout;
+	ID3D11Buffer*                    vertexConstants1;    // the quantization buffer for spheres
+	ID3D11PixelShader*               pixelShader;
+	ID3D11SamplerState* const*       sampler;
+	ID3D11ShaderResourceView* const* textures[SCENE_MATERIAL_TEXTURES];
+	const TextureResidency::Handle*  residency[SCENE_MATERIAL_TEXTURES];   // for streamed textures
+	ID3D11DepthStencilState*         depthState;
+	ID3D11RasterizerState*           rasterState;
+	ID3D11BlendState*                blendState;
+	uint32_t                         layer;               // 0 for background materials, drawn first
+	uint32_t                         shader;              // the pixel shader's name, which the draws are grouped by
+	bool                             blended;
+};
+
+struct SCENE_MESH_BINDING
+{
+	const MESH_HANDLE*               mesh;
+	bool                             lods;     // drawn through DrawSphereLod
+	float                            radius;   // from the model's origin, before scaling
+};
+
+// The scene Render draws, and its meshes and materials by index
+SceneStore*               g_pScene = nullptr;
+std::vector<SCENE_MATERIAL_BINDING> g_sceneMaterials;
+std::vector<SCENE_MESH_BINDING> g_sceneMeshes;
 #pragma endregion
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "Hash.h"
+#include <string.h>
+
+namespace
+{
+	const uint64_t PRIME1 = 11400714785074694791ULL;
+	const uint64_t PRIME2 = 14029467366897019727ULL;
+	const uint64_t PRIME3 = 1609587929392839161ULL;
+	const uint64_t PRIME4 = 9650029242287828579ULL;
+	const uint64_t PRIME5 = 2870177450012600261ULL;
+
+	inline uint64_t RotateLeft(const uint64_t value, const int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	inline uint64_t Read64(const uint8_t* p)
+	{
+		uint64_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Round(uint64_t accumulator, const uint64_t input)
+	{
+		accumulator += input * PRIME2;
+		accumulator = RotateLeft(accumulator, 31);
+		return accumulator * PRIME1;
+	}
+
+	inline uint64_t MergeRound(uint64_t accumulator, const uint64_t value)
+	{
+		accumulator ^= Round(0, value);
+		return accumulator * PRIME1 + PRIME4;
+	}
+}
+
+uint64_t HashBytes(const void* const data, const size_t size, const uint64_t seed)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	const uint8_t* const end = p + size;
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		// Four independent lanes over 32-byte stripes
+		uint64_t v1 = seed + PRIME1 + PRIME2;
+		uint64_t v2 = seed + PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME1;
+		const uint8_t* const limit = end - 32;
+		do
+		{
+			v1 = Round(v1, Read64(p));
+			v2 = Round(v2, Read64(p + 8));
+			v3 = Round(v3, Read64(p + 16));
+			v4 = Round(v4, Read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		hash = MergeRound(hash, v1);
+		hash = MergeRound(hash, v2);
+		hash = MergeRound(hash, v3);
+		hash = MergeRound(hash, v4);
+	}
+	else
+	{
+		hash = seed + PRIME5;
+	}
+
+	hash += static_cast<uint64_t>(size);
+
+	for (; p + 8 <= end; p += 8)
+		hash = RotateLeft(hash ^ Round(0, Read64(p)), 27) * PRIME1 + PRIME4;
+
+	if (p + 4 <= end)
+	{
+		hash = RotateLeft(hash ^ (static_cast<uint64_t>(Read32(p)) * PRIME1), 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+
+	for (; p < end; ++p)
+		hash = RotateLeft(hash ^ (*p * PRIME5), 11) * PRIME1;
+
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------
+// 64-bit non-cryptographic hash of a byte range (the XXH64 algorithm). Used to recognise
+// identical asset data loaded under different names; fast enough to run over whole files
+// on the reader threads.
+//--------------------------------------------------------------------------------------
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
@@ -0,0 +1,544 @@
+#include "LZCodec.h"
+#include "ThreadPool.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+	const size_t MIN_MATCH = 4;
+	const size_t MAX_OFFSET = 65535;
+
+	// The last match has to start this far from the end and the block always ends with at
+	// least LAST_LITERALS literals, which leaves the decoder room for its wide copies
+	const size_t MATCH_LIMIT = 12;
+	const size_t LAST_LITERALS = 5;
+
+	const unsigned int HASH_BITS = 14;
+	const unsigned int HIGH_HASH_BITS = 16;
+	const unsigned int HIGH_MAX_ATTEMPTS = 64;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Hash4(const uint32_t value, const unsigned int bits)
+	{
+		return (value * 2654435761u) >> (32 - bits);
+	}
+
+	inline size_t MatchLength(const uint8_t* a, const uint8_t* b, const uint8_t* const limit)
+	{
+		const uint8_t* const start = b;
+		while (b < limit && *a == *b)
+		{
+			++a;
+			++b;
+		}
+		return static_cast<size_t>(b - start);
+	}
+
+	class BlockWriter
+	{
+	public:
+		BlockWriter(uint8_t* dest, const size_t capacity) : m_out(dest), m_end(dest + capacity), m_begin(dest) {}
+
+		// Literals [literals, literals + literalCount), then a match unless matchLength is 0
+		bool Sequence(const uint8_t* literals, const size_t literalCount, const size_t offset, const size_t matchLength)
+		{
+			// token, both length extensions, the literals and the offset
+			const size_t worst = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+			if (static_cast<size_t>(m_end - m_out) < worst)
+				return false;
+
+			uint8_t* const token = m_out++;
+			*token = static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4);
+			WriteLength(literalCount);
+			if (literalCount)
+				memcpy(m_out, literals, literalCount);
+			m_out += literalCount;
+
+			if (matchLength)
+			{
+				*m_out++ = static_cast<uint8_t>(offset);
+				*m_out++ = static_cast<uint8_t>(offset >> 8);
+				*token |= static_cast<uint8_t>(std::min<size_t>(matchLength - MIN_MATCH, 15));
+				WriteLength(matchLength - MIN_MATCH);
+			}
+			return true;
+		}
+
+		size_t Size() const { return static_cast<size_t>(m_out - m_begin); }
+
+	private:
+		void WriteLength(size_t length)
+		{
+			if (length < 15)
+				return;
+			for (length -= 15; length >= 255; length -= 255)
+				*m_out++ = 255;
+			*m_out++ = static_cast<uint8_t>(length);
+		}
+
+		uint8_t* m_out;
+		uint8_t* const m_end;
+		uint8_t* const m_begin;
+	};
+
+	size_t CompressFast(const uint8_t* const source, const size_t sourceSize, uint8_t* const dest, const size_t destCapacity)
+	{
+		BlockWriter writer(dest, destCapacity);
+		const uint8_t* const end = source + sourceSize;
+		const uint8_t* anchor = source;
+
+		if (sourceSize > MATCH_LIMIT)
+		{
+			std::unique_ptr<uint32_t[]> table(new (std::nothrow) uint32_t[size_t(1) << HASH_BITS]);
+			if (!table)
+				return 0;
+			memset(table.get(), 0xFF, sizeof(uint32_t) << HASH_BITS);
+
+			const uint8_t* const matchLimit = end - MATCH_LIMIT;
+			const uint8_t* const lengthLimit = end - LAST_LITERALS;
+			const uint8_t* p = source;
+			unsigned int misses = 0;
+			while (p < matchLimit)
+			{
+				const uint32_t value = Read32(p);
+				uint32_t& slot = table[Hash4(value, HASH_BITS)];
+				const uint32_t candidate = slot;
+				slot = static_cast<uint32_t>(p - source);
+
+				if (candidate == UINT32_MAX || static_cast<size_t>(p - source) - candidate > MAX_OFFSET || Read32(source + candidate) != value)
+				{
+					// Step further the longer nothing matches, so incompressible data goes quickly
+					p += 1 + (misses++ >> 5);
+					continue;
+				}
+				misses = 0;
+
+				const uint8_t* match = source + candidate;
+				while (p > anchor && match > source && p[-1] == match[-1])
+				{
+					--p;
+					--match;
+				}
+
+				const size_t length = MIN_MATCH + MatchLength(match + MIN_MATCH, p + MIN_MATCH, lengthLimit);
+				if (!writer.Sequence(anchor, static_cast<size_t>(p - anchor), static_cast<size_t>(p - match), length))
+					return 0;
+
+				p += length;
+				anchor = p;
+				if (p - 2 >= source && p < matchLimit)
+					table[Hash4(Read32(p - 2), HASH_BITS)] = static_cast<uint32_t>(p - 2 - source);
+			}
+		}
+
+		if (!writer.Sequence(anchor, static_cast<size_t>(end - anchor), 0, 0))
+			return 0;
+		return writer.Size();
+	}
+
+	class MatchFinder
+	{
+	public:
+		explicit MatchFinder(const uint8_t* source)
+			: m_source(source)
+			, m_head(new (std::nothrow) uint32_t[size_t(1) << HIGH_HASH_BITS])
+			, m_chain(new (std::nothrow) uint16_t[MAX_OFFSET + 1])
+			, m_next(0)
+		{
+			if (m_head)
+				memset(m_head.get(), 0xFF, sizeof(uint32_t) << HIGH_HASH_BITS);
+		}
+
+		bool IsValid() const { return m_head && m_chain; }
+
+		// Inserts every position up to 'position'
+		void InsertUpTo(const size_t position)
+		{
+			for (; m_next < position; ++m_next)
+			{
+				uint32_t& head = m_head[Hash4(Read32(m_source + m_next), HIGH_HASH_BITS)];
+				const size_t delta = head == UINT32_MAX ? 0 : m_next - head;
+				m_chain[m_next & MAX_OFFSET] = static_cast<uint16_t>(delta > MAX_OFFSET ? 0 : delta);
+				head = static_cast<uint32_t>(m_next);
+			}
+		}
+
+		// Longest match for 'position' within the window, 0 when there is none
+		size_t Find(const size_t position, const size_t lengthLimit, size_t* const offset)
+		{
+			InsertUpTo(position);
+
+			const uint8_t* const p = m_source + position;
+			const uint8_t* const limit = m_source + lengthLimit;
+			size_t best = 0;
+			uint32_t candidate = m_head[Hash4(Read32(p), HIGH_HASH_BITS)];
+			for (unsigned int attempt = 0; attempt < HIGH_MAX_ATTEMPTS && candidate != UINT32_MAX; ++attempt)
+			{
+				const size_t distance = position - candidate;
+				if (distance == 0 || distance > MAX_OFFSET)
+					break;
+
+				const uint8_t* const match = m_source + candidate;
+				if (match[best] == p[best] && Read32(match) == Read32(p))
+				{
+					const size_t length = MIN_MATCH + MatchLength(match + MIN_MATCH, p + MIN_MATCH, limit);
+					if (length > best)
+					{
+						best = length;
+						*offset = distance;
+						if (p + length >= limit)
+							break;
+					}
+				}
+
+				const uint16_t delta = m_chain[candidate & MAX_OFFSET];
+				if (delta == 0 || delta > candidate)
+					break;
+				candidate -= delta;
+			}
+			return best >= MIN_MATCH ? best : 0;
+		}
+
+	private:
+		const uint8_t* const m_source;
+		std::unique_ptr<uint32_t[]> m_head;
+		std::unique_ptr<uint16_t[]> m_chain;   // distance to the previous position with the same hash
+		size_t m_next;
+	};
+
+	size_t CompressHigh(const uint8_t* const source, const size_t sourceSize, uint8_t* const dest, const size_t destCapacity)
+	{
+		BlockWriter writer(dest, destCapacity);
+		size_t anchor = 0;
+
+		if (sourceSize > MATCH_LIMIT)
+		{
+			MatchFinder finder(source);
+			if (!finder.IsValid())
+				return 0;
+
+			const size_t matchLimit = sourceSize - MATCH_LIMIT;
+			const size_t lengthLimit = sourceSize - LAST_LITERALS;
+			size_t position = 0;
+			while (position < matchLimit)
+			{
+				size_t offset = 0;
+				size_t length = finder.Find(position, lengthLimit, &offset);
+				if (!length)
+				{
+					++position;
+					continue;
+				}
+
+				// Lazy evaluation: take the next position's match instead when it is longer
+				while (position + 1 < matchLimit)
+				{
+					size_t nextOffset = 0;
+					const size_t nextLength = finder.Find(position + 1, lengthLimit, &nextOffset);
+					if (nextLength <= length)
+						break;
+					++position;
+					length = nextLength;
+					offset = nextOffset;
+				}
+
+				if (!writer.Sequence(source + anchor, position - anchor, offset, length))
+					return 0;
+
+				position += length;
+				anchor = position;
+			}
+		}
+
+		if (!writer.Sequence(source + anchor, sourceSize - anchor, 0, 0))
+			return 0;
+		return writer.Size();
+	}
+
+	inline bool ReadLength(const uint8_t*& in, const uint8_t* const end, size_t& length)
+	{
+		if (length != 15)
+			return true;
+
+		uint8_t extra;
+		do
+		{
+			if (in >= end)
+				return false;
+			extra = *in++;
+			length += extra;
+		} while (extra == 255);
+		return true;
+	}
+
+	// Whether a chunked header fits the stream it came with: the chunk count matches the raw
+	// size, the size table fits, and the raw size is no more than the stored bytes can decode
+	// to. Each length byte adds at most 255 bytes to a match, so no block expands 255 times.
+	bool ValidChunkedHeader(const LZ_CHUNKED_HEADER& header, const size_t streamSize)
+	{
+		if (streamSize < sizeof(header) || header.magic != LZ_CHUNKED_MAGIC || header.chunkSize == 0)
+			return false;
+
+		const uint64_t chunkCount = header.rawSize / header.chunkSize + (header.rawSize % header.chunkSize ? 1 : 0);
+		if (header.chunkCount != chunkCount || header.chunkCount > (streamSize - sizeof(header)) / sizeof(uint32_t))
+			return false;
+
+		const uint64_t storedBytes = streamSize - sizeof(header) - uint64_t(header.chunkCount) * sizeof(uint32_t);
+		return header.rawSize <= storedBytes * 255;
+	}
+}
+
+size_t LZCompressBound(const size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+size_t LZCompressBlock(const uint8_t* const source, const size_t sourceSize, uint8_t* const dest, const size_t destCapacity, const LZ_LEVEL level)
+{
+	if ((!source && sourceSize) || !dest)
+		return 0;
+
+	return level == LZ_LEVEL_HIGH ? CompressHigh(source, sourceSize, dest, destCapacity) : CompressFast(source, sourceSize, dest, destCapacity);
+}
+
+bool LZDecompressBlock(const uint8_t* const source, const size_t sourceSize, uint8_t* const dest, const size_t destSize)
+{
+	if (!source || (!dest && destSize))
+		return false;
+
+	const uint8_t* in = source;
+	const uint8_t* const inEnd = source + sourceSize;
+	uint8_t* out = dest;
+	uint8_t* const outEnd = dest + destSize;
+
+	for (;;)
+	{
+		if (in >= inEnd)
+			return false;
+
+		const uint8_t token = *in++;
+
+		size_t literals = token >> 4;
+		if (!ReadLength(in, inEnd, literals))
+			return false;
+
+		if (literals > static_cast<size_t>(inEnd - in) || literals > static_cast<size_t>(outEnd - out))
+			return false;
+
+		// Far enough from both ends, whole 16-byte copies are safe and cheaper than memcpy
+		// with a variable length
+		if (literals <= 16 && inEnd - in >= 16 && outEnd - out >= 16)
+			memcpy(out, in, 16);
+		else
+			memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// Only the last sequence ends without a match
+		if (in == inEnd)
+			return out == outEnd;
+
+		if (inEnd - in < 2)
+			return false;
+		const size_t offset = in[0] | (size_t(in[1]) << 8);
+		in += 2;
+
+		size_t length = token & 15;
+		if (!ReadLength(in, inEnd, length))
+			return false;
+		length += MIN_MATCH;
+
+		if (offset == 0 || offset > static_cast<size_t>(out - dest) || length > static_cast<size_t>(outEnd - out))
+			return false;
+
+		const uint8_t* match = out - offset;
+		if (offset >= 16 && outEnd - out >= static_cast<ptrdiff_t>(length + 16))
+		{
+			// Non-overlapping: copy in 16-byte steps, overrunning into space written later
+			for (size_t copied = 0; copied < length; copied += 16)
+				memcpy(out + copied, match + copied, 16);
+			out += length;
+		}
+		else
+		{
+			// Overlapping matches repeat the last 'offset' bytes, so go one byte at a time
+			for (size_t i = 0; i < length; ++i)
+				out[i] = match[i];
+			out += length;
+		}
+	}
+}
+
+bool IsLZChunked(const uint8_t* const data, const size_t size)
+{
+	return data && size >= sizeof(LZ_CHUNKED_HEADER) && Read32(data) == LZ_CHUNKED_MAGIC;
+}
+
+size_t LZChunkRawSize(const LZ_CHUNKED_HEADER& header, const size_t firstChunk, const size_t count)
+{
+	const uint64_t begin = uint64_t(firstChunk) * header.chunkSize;
+	const uint64_t end = std::min<uint64_t>(uint64_t(firstChunk + count) * header.chunkSize, header.rawSize);
+	return end > begin ? static_cast<size_t>(end - begin) : 0;
+}
+
+bool LZDecompressChunk(const LZ_CHUNKED_HEADER& header, const size_t chunk, const uint8_t* const stored, const size_t storedSize, uint8_t* const dest)
+{
+	const size_t rawSize = LZChunkRawSize(header, chunk, 1);
+	if (storedSize == rawSize)
+	{
+		memcpy(dest, stored, rawSize);
+		return true;
+	}
+	return LZDecompressBlock(stored, storedSize, dest, rawSize);
+}
+
+HRESULT LZCompressChunked(const uint8_t* const data, const size_t size, size_t chunkSize, const LZ_LEVEL level, std::vector<uint8_t>& stream,
+                          ThreadPool* const pool)
+{
+	if (!data && size)
+		return E_INVALIDARG;
+
+	chunkSize = std::max<size_t>(chunkSize, 1024);
+	const size_t chunkCount = (size + chunkSize - 1) / chunkSize;
+	if (chunkSize > UINT32_MAX || chunkCount > UINT32_MAX)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	LZ_CHUNKED_HEADER header = {};
+	header.magic = LZ_CHUNKED_MAGIC;
+	header.chunkSize = static_cast<uint32_t>(chunkSize);
+	header.rawSize = size;
+	header.chunkCount = static_cast<uint32_t>(chunkCount);
+
+	// Every chunk compresses into its own slot, then the slots are packed together
+	const size_t slotSize = LZCompressBound(chunkSize);
+	std::vector<uint8_t> slots(chunkCount * slotSize);
+	std::vector<uint32_t> storedSizes(chunkCount);
+	const auto compress = [&](const size_t begin, const size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; ++chunk)
+		{
+			const uint8_t* const raw = data + chunk * chunkSize;
+			const size_t rawSize = LZChunkRawSize(header, chunk, 1);
+			uint8_t* const slot = slots.data() + chunk * slotSize;
+
+			// Anything that does not come out smaller is stored, which also keeps the stored
+			// size of a compressed chunk from ever equalling its raw size
+			const size_t packed = LZCompressBlock(raw, rawSize, slot, rawSize - 1, level);
+			if (packed)
+			{
+				storedSizes[chunk] = static_cast<uint32_t>(packed);
+			}
+			else
+			{
+				memcpy(slot, raw, rawSize);
+				storedSizes[chunk] = static_cast<uint32_t>(rawSize);
+			}
+		}
+	};
+
+	if (pool)
+		pool->ParallelFor(chunkCount, 1, compress);
+	else
+		compress(0, chunkCount);
+
+	size_t total = sizeof(LZ_CHUNKED_HEADER) + chunkCount * sizeof(uint32_t);
+	for (const uint32_t stored : storedSizes)
+		total += stored;
+
+	stream.resize(total);
+	uint8_t* out = stream.data();
+	memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+	if (chunkCount)
+		memcpy(out, storedSizes.data(), chunkCount * sizeof(uint32_t));
+	out += chunkCount * sizeof(uint32_t);
+	for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		memcpy(out, slots.data() + chunk * slotSize, storedSizes[chunk]);
+		out += storedSizes[chunk];
+	}
+	return S_OK;
+}
+
+HRESULT LZDecompressChunked(const uint8_t* const stream, const size_t streamSize, uint8_t* const dest, const size_t destSize, ThreadPool* const pool)
+{
+	if (!IsLZChunked(stream, streamSize) || !dest)
+		return E_INVALIDARG;
+
+	LZ_CHUNKED_HEADER header;
+	memcpy(&header, stream, sizeof(header));
+	if (!ValidChunkedHeader(header, streamSize) || header.rawSize != destSize)
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+	// Chunk offsets from the size table, checked against the stream before any decoding
+	const uint8_t* const table = stream + sizeof(header);
+	std::vector<size_t> offsets(header.chunkCount + 1);
+	offsets[0] = sizeof(header) + header.chunkCount * sizeof(uint32_t);
+	for (size_t chunk = 0; chunk < header.chunkCount; ++chunk)
+	{
+		const uint32_t stored = Read32(table + chunk * sizeof(uint32_t));
+		if (stored > streamSize - offsets[chunk] || stored > LZChunkRawSize(header, chunk, 1))
+			return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+		offsets[chunk + 1] = offsets[chunk] + stored;
+	}
+
+	std::atomic<bool> failed(false);
+	const auto decompress = [&](const size_t begin, const size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; ++chunk)
+		{
+			if (!LZDecompressChunk(header, chunk, stream + offsets[chunk], offsets[chunk + 1] - offsets[chunk], dest + chunk * header.chunkSize))
+				failed = true;
+		}
+	};
+
+	if (pool && header.chunkCount > 1)
+		pool->ParallelFor(header.chunkCount, 1, decompress);
+	else
+		decompress(0, header.chunkCount);
+
+	return failed ? HRESULT_FROM_WIN32(ERROR_INVALID_DATA) : S_OK;
+}
+
+HRESULT LZDecompressChunked(const uint8_t* const stream, const size_t streamSize, std::unique_ptr<uint8_t[]>& dest, size_t* const destSize,
+                            ThreadPool* const pool)
+{
+	if (!destSize)
+		return E_POINTER;
+	*destSize = 0;
+
+	if (!IsLZChunked(stream, streamSize))
+		return E_INVALIDARG;
+
+	// The header is checked before its raw size is allocated, so a corrupt one cannot ask
+	// for more than the stream could decode to
+	LZ_CHUNKED_HEADER header;
+	memcpy(&header, stream, sizeof(header));
+	if (!ValidChunkedHeader(header, streamSize))
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	if (header.rawSize > SIZE_MAX)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	const size_t rawSize = static_cast<size_t>(header.rawSize);
+	dest.reset(new (std::nothrow) uint8_t[rawSize ? rawSize : 1]);
+	if (!dest)
+		return E_OUTOFMEMORY;
+
+	const HRESULT hr = LZDecompressChunked(stream, streamSize, dest.get(), rawSize, pool);
+	if (FAILED(hr))
+	{
+		dest.reset();
+		return hr;
+	}
+
+	*destSize = rawSize;
+	return S_OK;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <windows.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// Byte-oriented LZ77 codec in the style of LZ4: a block is a run of sequences, each a
+// token byte (literal count in the high nibble, match length - 4 in the low one, 15
+// meaning more length bytes follow), the literals, then a 16-bit match offset. The last
+// sequence has literals only. There is no entropy stage, so decoding is a loop of copies
+// that runs well above disk speed.
+//--------------------------------------------------------------------------------------
+enum LZ_LEVEL
+{
+	LZ_LEVEL_FAST,      // greedy, one hash probe per position
+	LZ_LEVEL_HIGH,      // hash chains with lazy matching; slower to pack, same decode speed
+};
+
+// Largest compressed size a block of 'size' bytes can take
+size_t LZCompressBound(size_t size);
+
+// Returns the compressed size, or 0 when it would not fit in destCapacity. Blocks are
+// self-contained and offsets are 16-bit, so blocks over 64 KB only find nearer matches.
+size_t LZCompressBlock(const uint8_t* source, size_t sourceSize, uint8_t* dest, size_t destCapacity, LZ_LEVEL level);
+
+// Decodes a whole block, which has to expand to exactly destSize bytes. Malformed input
+// fails rather than reading or writing outside either buffer.
+bool LZDecompressBlock(const uint8_t* source, size_t sourceSize, uint8_t* dest, size_t destSize);
+
+//--------------------------------------------------------------------------------------
+// Chunked stream: an LZ_CHUNKED_HEADER, one uint32_t stored size per chunk, then the
+// chunks back to back. Each chunk is an independent block of 'chunkSize' bytes (the last
+// may be shorter), so chunks decode in parallel and any byte range can be read without
+// decoding what comes before it. A chunk stored at its raw size did not compress and is
+// kept as it is.
+//--------------------------------------------------------------------------------------
+const uint32_t LZ_CHUNKED_MAGIC = 0x31435A4C; // "LZC1"
+const size_t LZ_DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+#pragma pack(push,1)
+struct LZ_CHUNKED_HEADER
+{
+	uint32_t magic;
+	uint32_t chunkSize;
+	uint64_t rawSize;
+	uint32_t chunkCount;
+	uint32_t reserved;
+};
+#pragma pack(pop)
+
+bool IsLZChunked(const uint8_t* data, size_t size);
+
+HRESULT LZCompressChunked(const uint8_t* data, size_t size, size_t chunkSize, LZ_LEVEL level, std::vector<uint8_t>& stream,
+                          ThreadPool* pool = nullptr);
+
+// Raw size of the chunks in [firstChunk, firstChunk + count)
+size_t LZChunkRawSize(const LZ_CHUNKED_HEADER& header, size_t firstChunk, size_t count);
+
+// Decodes one chunk given its stored bytes; dest takes LZChunkRawSize(header, chunk, 1)
+bool LZDecompressChunk(const LZ_CHUNKED_HEADER& header, size_t chunk, const uint8_t* stored, size_t storedSize, uint8_t* dest);
+
+// Decodes a whole stream into destSize (= header.rawSize) bytes, spreading the chunks over
+// the pool when there is one
+HRESULT LZDecompressChunked(const uint8_t* stream, size_t streamSize, uint8_t* dest, size_t destSize, ThreadPool* pool = nullptr);
+
+// Same, into a new buffer sized from the stream header
+HRESULT LZDecompressChunked(const uint8_t* stream, size_t streamSize, std::unique_ptr<uint8_t[]>& dest, size_t* destSize,
+                            ThreadPool* pool = nullptr);
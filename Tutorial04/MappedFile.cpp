@@ -0,0 +1,206 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+
+HRESULT MappedFile::Open(const wchar_t* const fileName)
+{
+	Close();
+
+	if (!fileName)
+		return E_INVALIDARG;
+
+	m_hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_hFile, &fileSize))
+	{
+		const HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hr;
+	}
+
+	// Empty files cannot be mapped, and the view has to fit in the address space
+	if (fileSize.QuadPart <= 0 || static_cast<ULONGLONG>(fileSize.QuadPart) > static_cast<ULONGLONG>(SIZE_MAX))
+	{
+		Close();
+		return E_FAIL;
+	}
+
+	m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_hMapping)
+	{
+		const HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hr;
+	}
+
+	m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		const HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hr;
+	}
+
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	return S_OK;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+
+	m_pData = nullptr;
+	m_hMapping = nullptr;
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_size = 0;
+}
+
+HRESULT WriteWholeFile(const wchar_t* const fileName, const void* const data, const size_t size)
+{
+	if (!fileName || (!data && size))
+		return E_INVALIDARG;
+
+	HANDLE hFile = CreateFileW(fileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	// WriteFile takes a DWORD, and may succeed having written less than it was given; the
+	// last error is not set then, so a short write is reported as the end of the handle
+	HRESULT hr = S_OK;
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t left = size; left > 0 && SUCCEEDED(hr);)
+	{
+		const DWORD chunk = static_cast<DWORD>(left < 0x40000000 ? left : 0x40000000);
+		DWORD written = 0;
+		if (!WriteFile(hFile, bytes, chunk, &written, nullptr))
+			hr = HRESULT_FROM_WIN32(GetLastError());
+		else if (written < chunk)
+			hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+		bytes += written;
+		left -= written;
+	}
+	CloseHandle(hFile);
+
+	// A partial file is no use to whoever reads it next
+	if (FAILED(hr))
+		DeleteFileW(fileName);
+	return hr;
+}
+
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+namespace
+{
+	// errno in the Win32 facility, the way HRESULT_FROM_WIN32 wraps GetLastError; ENOENT
+	// comes out as ERROR_FILE_NOT_FOUND does
+	HRESULT HResultFromErrno(const int error)
+	{
+		return error > 0 ? static_cast<HRESULT>(0x80070000u | (static_cast<unsigned int>(error) & 0xFFFF)) : E_FAIL;
+	}
+
+	// Paths are wide on Windows; here they go to open() in the locale's multibyte encoding
+	bool NarrowPath(const wchar_t* const fileName, std::string& name)
+	{
+		const size_t nameLength = wcstombs(nullptr, fileName, 0);
+		if (nameLength == static_cast<size_t>(-1))
+			return false;
+		name.assign(nameLength, '\0');
+		wcstombs(&name[0], fileName, nameLength + 1);
+		return true;
+	}
+}
+
+HRESULT MappedFile::Open(const wchar_t* const fileName)
+{
+	Close();
+
+	if (!fileName)
+		return E_INVALIDARG;
+
+	std::string name;
+	if (!NarrowPath(fileName, name))
+		return E_INVALIDARG;
+
+	const int file = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+		return HResultFromErrno(errno);
+
+	struct stat status = {};
+	if (fstat(file, &status) != 0)
+	{
+		const HRESULT hr = HResultFromErrno(errno);
+		close(file);
+		return hr;
+	}
+
+	// Empty files cannot be mapped, and the view has to fit in the address space
+	if (!S_ISREG(status.st_mode) || status.st_size <= 0 || static_cast<unsigned long long>(status.st_size) > static_cast<unsigned long long>(SIZE_MAX))
+	{
+		close(file);
+		return E_FAIL;
+	}
+
+	// The mapping holds its own reference to the file, so the descriptor is not kept
+	const size_t size = static_cast<size_t>(status.st_size);
+	void* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	const int error = errno;
+	close(file);
+	if (data == MAP_FAILED)
+		return HResultFromErrno(error);
+
+	madvise(data, size, MADV_SEQUENTIAL);
+	m_pData = static_cast<const uint8_t*>(data);
+	m_size = size;
+	return S_OK;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData) munmap(const_cast<uint8_t*>(m_pData), m_size);
+
+	m_pData = nullptr;
+	m_size = 0;
+}
+
+HRESULT WriteWholeFile(const wchar_t* const fileName, const void* const data, const size_t size)
+{
+	std::string name;
+	if (!fileName || (!data && size) || !NarrowPath(fileName, name))
+		return E_INVALIDARG;
+
+	const int file = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (file < 0)
+		return HResultFromErrno(errno);
+
+	HRESULT hr = S_OK;
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t left = size; left > 0 && hr == S_OK;)
+	{
+		const ssize_t written = write(file, bytes, left);
+		if (written < 0 && errno == EINTR)
+			continue;
+		hr = written < 0 ? HResultFromErrno(errno) : written == 0 ? E_FAIL : S_OK;
+		bytes += written > 0 ? written : 0;
+		left -= written > 0 ? static_cast<size_t>(written) : 0;
+	}
+
+	if (close(file) != 0 && hr == S_OK)
+		hr = HResultFromErrno(errno);
+	if (hr != S_OK)
+		unlink(name.c_str());
+	return hr;
+}
+#endif
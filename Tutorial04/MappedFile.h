@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stddef.h>
+
+// The few HRESULTs Open returns, for builds without the Windows headers
+#ifndef _HRESULT_DEFINED
+#define _HRESULT_DEFINED
+typedef int32_t HRESULT;
+#endif
+#ifndef S_OK
+#define S_OK ((HRESULT)0L)
+#endif
+#ifndef E_FAIL
+#define E_FAIL ((HRESULT)0x80004005L)
+#endif
+#ifndef E_INVALIDARG
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#endif
+#endif
+
+//--------------------------------------------------------------------------------------
+// Read-only memory mapping of a whole file. Pointers returned by Data() stay valid until
+// the file is closed, so they can be handed straight to D3D11_SUBRESOURCE_DATA without
+// copying the contents into a heap buffer first. On Windows it is a file mapping; other
+// platforms open, fstat and mmap the file instead.
+//--------------------------------------------------------------------------------------
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	HRESULT Open(const wchar_t* fileName);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const uint8_t* Data() const { return m_pData; }
+	size_t Size() const { return m_size; }
+
+private:
+#ifdef _WIN32
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	HANDLE m_hMapping = nullptr;
+#endif
+	const uint8_t* m_pData = nullptr;
+	size_t m_size = 0;
+};
+
+// Writes 'size' bytes as the whole of a new file, or fails and leaves no file behind: a
+// short write fails rather than leaving a truncated file that looks written
+HRESULT WriteWholeFile(const wchar_t* fileName, const void* data, size_t size);
@@ -0,0 +1,214 @@
+#include "MeshCache.h"
+#include "MeshConvert.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	size_t Align(const size_t offset)
+	{
+		return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(MESH_CACHE_ALIGNMENT - 1);
+	}
+
+	bool ValidRange(const uint32_t offset, const uint32_t count, const size_t total)
+	{
+		return offset <= total && count <= total - offset;
+	}
+
+	// Every level and meshlet covers whole triangles of the index list, and every level's
+	// meshlets lie within the table
+	bool ValidRanges(const MESH_CACHE_LOD* const lods, const size_t lodCount, const MESH_CACHE_MESHLET* const meshlets,
+	                 const size_t meshletCount, const size_t indexCount)
+	{
+		for (size_t i = 0; i < lodCount; ++i)
+		{
+			if (!ValidRange(lods[i].indexOffset, lods[i].indexCount, indexCount) || lods[i].indexOffset % 3 != 0 ||
+			    lods[i].indexCount % 3 != 0 || !ValidRange(lods[i].meshletOffset, lods[i].meshletCount, meshletCount))
+				return false;
+		}
+		for (size_t i = 0; i < meshletCount; ++i)
+		{
+			if (!ValidRange(meshlets[i].indexOffset, meshlets[i].indexCount, indexCount) || meshlets[i].indexOffset % 3 != 0 ||
+			    meshlets[i].indexCount % 3 != 0)
+				return false;
+		}
+		return true;
+	}
+}
+
+HRESULT CookedMesh::Open(const wchar_t* const fileName, const uint64_t sourceHash)
+{
+	Close();
+
+	HRESULT hr = m_file.Open(fileName);
+	if (FAILED(hr))
+		return hr;
+
+	const uint8_t* const data = m_file.Data();
+	const uint64_t size = m_file.Size();
+
+	const MESH_CACHE_HEADER* const header = reinterpret_cast<const MESH_CACHE_HEADER*>(data);
+	if (size < sizeof(MESH_CACHE_HEADER) || header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION ||
+	    header->vertexStride != sizeof(SimpleVertex) || (header->indexStride != sizeof(uint16_t) && header->indexStride != sizeof(uint32_t)) ||
+	    header->sourceHash != sourceHash ||
+	    (header->vertexOffset | header->indexOffset) & (MESH_CACHE_ALIGNMENT - 1) ||
+	    header->vertexOffset > size || uint64_t(header->vertexCount) * sizeof(SimpleVertex) > size - header->vertexOffset ||
+	    header->indexOffset > size || uint64_t(header->indexCount) * header->indexStride > size - header->indexOffset ||
+	    header->indexCount % 3 != 0 || !header->lodCount || header->lodCount > MESH_CACHE_MAX_LODS ||
+	    header->meshletCount > header->indexCount / 3 ||
+	    sizeof(MESH_CACHE_HEADER) + header->lodCount * sizeof(MESH_CACHE_LOD) + uint64_t(header->meshletCount) * sizeof(MESH_CACHE_MESHLET) >
+	    header->vertexOffset)
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	// Indices outside the vertex blob would read past it on the GPU
+	const uint8_t* const indices = data + header->indexOffset;
+	uint32_t maxIndex = 0;
+	for (size_t i = 0; i < header->indexCount; ++i)
+	{
+		const uint32_t index = header->indexStride == sizeof(uint16_t)
+			? reinterpret_cast<const uint16_t*>(indices)[i] : reinterpret_cast<const uint32_t*>(indices)[i];
+		maxIndex = std::max(maxIndex, index);
+	}
+	if (header->indexCount && maxIndex >= header->vertexCount)
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	const MESH_CACHE_LOD* const lods = reinterpret_cast<const MESH_CACHE_LOD*>(data + sizeof(MESH_CACHE_HEADER));
+	const MESH_CACHE_MESHLET* const meshlets = reinterpret_cast<const MESH_CACHE_MESHLET*>(lods + header->lodCount);
+	if (!ValidRanges(lods, header->lodCount, meshlets, header->meshletCount, header->indexCount))
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	m_header = header;
+	m_lods = lods;
+	m_meshlets = meshlets;
+	m_vertices = reinterpret_cast<const SimpleVertex*>(data + header->vertexOffset);
+	m_indices = indices;
+	return S_OK;
+}
+
+void CookedMesh::Close()
+{
+	m_file.Close();
+	m_header = nullptr;
+	m_lods = nullptr;
+	m_meshlets = nullptr;
+	m_vertices = nullptr;
+	m_indices = nullptr;
+}
+
+DXGI_FORMAT CookedMesh::IndexFormat() const
+{
+	return m_header && m_header->indexStride == sizeof(uint32_t) ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+}
+
+std::wstring CookedMesh::CachePath(const wchar_t* const sourceName)
+{
+	return std::wstring(sourceName ? sourceName : L"") + L".mesh";
+}
+
+HRESULT WriteCookedMesh(const wchar_t* const fileName, const uint64_t sourceHash, const SimpleVertex* const vertices, const size_t vertexCount,
+                        const uint32_t* const indices, const size_t indexCount, const MESH_CACHE_LOD* lods, size_t lodCount,
+                        const MESH_CACHE_MESHLET* const meshlets, const size_t meshletCount)
+{
+	if (!fileName || (!vertices && vertexCount) || (!indices && indexCount) || (!lods && lodCount) || lodCount > MESH_CACHE_MAX_LODS ||
+	    (!meshlets && meshletCount) || meshletCount > indexCount / 3)
+		return E_INVALIDARG;
+
+	if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX || indexCount % 3 != 0)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	MESH_CACHE_LOD wholeMesh = {};
+	if (!lodCount)
+	{
+		wholeMesh.indexCount = static_cast<uint32_t>(indexCount);
+		lods = &wholeMesh;
+		lodCount = 1;
+	}
+	if (!ValidRanges(lods, lodCount, meshlets, meshletCount, indexCount))
+		return E_INVALIDARG;
+
+	MESH_CACHE_HEADER header = {};
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.vertexStride = sizeof(SimpleVertex);
+	header.indexStride = static_cast<uint32_t>(IndexStride(IndexFormatFor(vertexCount)));
+	header.vertexCount = static_cast<uint32_t>(vertexCount);
+	header.indexCount = static_cast<uint32_t>(indexCount);
+	header.lodCount = static_cast<uint32_t>(lodCount);
+	header.meshletCount = static_cast<uint32_t>(meshletCount);
+	header.vertexOffset = Align(sizeof(MESH_CACHE_HEADER) + lodCount * sizeof(MESH_CACHE_LOD) + meshletCount * sizeof(MESH_CACHE_MESHLET));
+	header.indexOffset = Align(static_cast<size_t>(header.vertexOffset) + vertexCount * sizeof(SimpleVertex));
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		header.boundsMin[axis] = vertexCount ? FLT_MAX : 0.0f;
+		header.boundsMax[axis] = vertexCount ? -FLT_MAX : 0.0f;
+	}
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const float position[3] = { vertices[i].Pos.x, vertices[i].Pos.y, vertices[i].Pos.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			header.boundsMin[axis] = std::min(header.boundsMin[axis], position[axis]);
+			header.boundsMax[axis] = std::max(header.boundsMax[axis], position[axis]);
+		}
+	}
+	header.radius = MeshRadius(vertices, vertexCount);
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		if (indices[i] >= vertexCount)
+			return E_INVALIDARG;
+	}
+
+	std::vector<uint8_t> data(static_cast<size_t>(header.indexOffset) + indexCount * header.indexStride, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), lods, lodCount * sizeof(MESH_CACHE_LOD));
+	if (meshletCount)
+		memcpy(data.data() + sizeof(header) + lodCount * sizeof(MESH_CACHE_LOD), meshlets, meshletCount * sizeof(MESH_CACHE_MESHLET));
+	if (vertexCount)
+		memcpy(data.data() + header.vertexOffset, vertices, vertexCount * sizeof(SimpleVertex));
+	if (header.indexStride == sizeof(uint16_t))
+		NarrowIndices(indices, indexCount, reinterpret_cast<uint16_t*>(data.data() + header.indexOffset));
+	else if (indexCount)
+		memcpy(data.data() + header.indexOffset, indices, indexCount * sizeof(uint32_t));
+
+	// A partial file would only fail its size check, and none is left behind
+	return WriteWholeFile(fileName, data.data(), data.size());
+}
+
+float MeshRadius(const SimpleVertex* const vertices, const size_t vertexCount)
+{
+	float radiusSquared = 0.0f;
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const XMFLOAT3& position = vertices[i].Pos;
+		radiusSquared = std::max(radiusSquared, position.x * position.x + position.y * position.y + position.z * position.z);
+	}
+	return sqrtf(radiusSquared);
+}
+
+size_t SelectMeshLod(const MESH_CACHE_LOD* const lods, const size_t lodCount, const float modelRadius, const float screenPixels,
+                     const float maxPixelError)
+{
+	if (!lods || modelRadius <= 0.0f)
+		return 0;
+
+	const float pixelsPerUnit = screenPixels / (2.0f * modelRadius);
+	size_t lod = 0;
+	while (lod + 1 < lodCount && lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
+		++lod;
+	return lod;
+}
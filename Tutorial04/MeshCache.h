@@ -0,0 +1,128 @@
+#pragma once
+#include <windows.h>
+#include <dxgiformat.h>
+#include <stdint.h>
+#include <string>
+
+#include "MappedFile.h"
+#include "SimpleVertex.h"
+
+//--------------------------------------------------------------------------------------
+// On-disk layout of a cooked mesh, written the first time a model is imported and kept
+// next to its source as "<source>.mesh":
+//
+//   MESH_CACHE_HEADER
+//   lods        MESH_CACHE_LOD[lodCount], finest first
+//   meshlets    MESH_CACHE_MESHLET[meshletCount], each level's together
+//   vertices    SimpleVertex[vertexCount], starting on a MESH_CACHE_ALIGNMENT boundary
+//   indices     indexStride bytes each, triangle list, likewise aligned
+//
+// sourceHash ties the file to the bytes it was cooked from, so an edited source, or one
+// imported with other flags, is cooked again rather than loaded stale. Indices are 16-bit
+// whenever the vertex count allows and 32-bit otherwise. Both are stored in the order
+// MeshOptimize leaves them, so cooking bumps the version when those passes change. Every
+// level of detail is a range of the one index list over the same vertices, and is split
+// into meshlets (see MeshCluster.h) that are ranges of it in turn.
+//--------------------------------------------------------------------------------------
+const uint32_t MESH_CACHE_MAGIC = 0x3148534D; // "MSH1"
+const uint32_t MESH_CACHE_VERSION = 4;   // 2: triangles and vertices in optimized order, 3: levels of detail, 4: meshlets
+const size_t MESH_CACHE_ALIGNMENT = 16;
+const size_t MESH_CACHE_MAX_LODS = 8;
+
+#pragma pack(push,1)
+struct MESH_CACHE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t vertexStride;   // sizeof(SimpleVertex) when cooked
+	uint32_t indexStride;    // 2 or 4
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	float boundsMin[3];
+	float boundsMax[3];
+	float radius;            // furthest vertex from the origin
+	uint32_t lodCount;
+	uint32_t meshletCount;
+};
+
+struct MESH_CACHE_LOD
+{
+	uint32_t indexOffset;    // in indices, from the start of the index list
+	uint32_t indexCount;
+	float error;             // furthest from the full mesh, in model units
+	uint32_t meshletOffset;  // in meshlets, from the start of the meshlet table
+	uint32_t meshletCount;   // 0 when the level is drawn whole
+};
+
+// A run of triangles that can be culled as one. The sphere bounds its vertices and the
+// cone its triangle normals: every normal is within acos(sqrt(1 - coneCutoff^2)) of
+// coneAxis, and coneCutoff is 1 when they spread too far to ever be backfacing together.
+struct MESH_CACHE_MESHLET
+{
+	uint32_t indexOffset;    // in indices, from the start of the index list
+	uint32_t indexCount;
+	float center[3];
+	float radius;
+	float coneAxis[3];       // of cross(p1 - p0, p2 - p0), the way the triangles are wound
+	float coneCutoff;
+};
+#pragma pack(pop)
+
+//--------------------------------------------------------------------------------------
+// Read-only view of a cooked mesh. The file is mapped, so the vertex and index pointers
+// go straight to CreateBuffer and loading costs a header check and the page faults.
+//--------------------------------------------------------------------------------------
+class CookedMesh
+{
+public:
+	CookedMesh() = default;
+
+	CookedMesh(const CookedMesh&) = delete;
+	CookedMesh& operator=(const CookedMesh&) = delete;
+
+	// Fails with ERROR_FILE_NOT_FOUND when there is no cooked file, and ERROR_INVALID_DATA
+	// when it is damaged, from another version or cooked from other source bytes
+	HRESULT Open(const wchar_t* fileName, uint64_t sourceHash);
+	void Close();
+
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	const SimpleVertex* Vertices() const { return m_vertices; }
+	size_t VertexCount() const { return m_header ? m_header->vertexCount : 0; }
+	const void* Indices() const { return m_indices; }
+	size_t IndexCount() const { return m_header ? m_header->indexCount : 0; }
+	const MESH_CACHE_LOD* Lods() const { return m_lods; }
+	size_t LodCount() const { return m_header ? m_header->lodCount : 0; }
+	const MESH_CACHE_MESHLET* Meshlets() const { return m_meshlets; }
+	size_t MeshletCount() const { return m_header ? m_header->meshletCount : 0; }
+	DXGI_FORMAT IndexFormat() const;
+	const MESH_CACHE_HEADER* Header() const { return m_header; }
+
+	// The cooked file kept for a source file
+	static std::wstring CachePath(const wchar_t* sourceName);
+
+private:
+	MappedFile m_file;
+	const MESH_CACHE_HEADER* m_header = nullptr;
+	const MESH_CACHE_LOD* m_lods = nullptr;
+	const MESH_CACHE_MESHLET* m_meshlets = nullptr;
+	const SimpleVertex* m_vertices = nullptr;
+	const void* m_indices = nullptr;
+};
+
+// Distance of the furthest vertex from the origin, as the cooked header stores it
+float MeshRadius(const SimpleVertex* vertices, size_t vertexCount);
+
+// Writes a cooked mesh, computing its bounds from the vertices and storing the indices in
+// the narrowest format that addresses them. Without 'lods' the mesh has one level, all of
+// the indices, drawn whole; the meshlets are those the levels refer to.
+HRESULT WriteCookedMesh(const wchar_t* fileName, uint64_t sourceHash, const SimpleVertex* vertices, size_t vertexCount,
+                        const uint32_t* indices, size_t indexCount, const MESH_CACHE_LOD* lods = nullptr, size_t lodCount = 0,
+                        const MESH_CACHE_MESHLET* meshlets = nullptr, size_t meshletCount = 0);
+
+// The coarsest level whose error, seen at 'screenPixels' across a mesh of 'modelRadius',
+// stays within maxPixelError pixels
+size_t SelectMeshLod(const MESH_CACHE_LOD* lods, size_t lodCount, float modelRadius, float screenPixels, float maxPixelError = 1.0f);
@@ -0,0 +1,295 @@
+#include "MeshCluster.h"
+#include "MeshOptimize.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+	const size_t NO_TRIANGLE = ~size_t(0);
+
+	// Normals spread wider than about 84 degrees from their axis could face any camera
+	const float MIN_CONE_COSINE = 0.1f;
+
+	XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	XMFLOAT3 UnitNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		const XMFLOAT3 n = Cross(Subtract(p1, p0), Subtract(p2, p0));
+		const float length = sqrtf(Dot(n, n));
+		return length > 0.0f ? XMFLOAT3(n.x / length, n.y / length, n.z / length) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	// Sphere around the centre of the vertices' box, and the cone around the mean of the
+	// triangle normals
+	MESH_CACHE_MESHLET ComputeBounds(const size_t indexOffset, const size_t indexCount,
+	                                 const std::vector<uint32_t>& meshletVertices, const SimpleVertex* const vertices,
+	                                 const std::vector<XMFLOAT3>& normals, const size_t firstTriangle)
+	{
+		MESH_CACHE_MESHLET meshlet = {};
+		meshlet.indexOffset = static_cast<uint32_t>(indexOffset);
+		meshlet.indexCount = static_cast<uint32_t>(indexCount);
+
+		XMFLOAT3 lower(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 upper(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (const uint32_t v : meshletVertices)
+		{
+			const XMFLOAT3& p = vertices[v].Pos;
+			lower = XMFLOAT3(std::min(lower.x, p.x), std::min(lower.y, p.y), std::min(lower.z, p.z));
+			upper = XMFLOAT3(std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z));
+		}
+		const XMFLOAT3 center((lower.x + upper.x) * 0.5f, (lower.y + upper.y) * 0.5f, (lower.z + upper.z) * 0.5f);
+		float radiusSquared = 0.0f;
+		for (const uint32_t v : meshletVertices)
+		{
+			const XMFLOAT3 offset = Subtract(vertices[v].Pos, center);
+			radiusSquared = std::max(radiusSquared, Dot(offset, offset));
+		}
+		meshlet.center[0] = center.x;
+		meshlet.center[1] = center.y;
+		meshlet.center[2] = center.z;
+		meshlet.radius = sqrtf(radiusSquared);
+
+		const size_t triangleCount = indexCount / 3;
+		XMFLOAT3 axis(0.0f, 0.0f, 0.0f);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const XMFLOAT3& n = normals[firstTriangle + t];
+			axis = XMFLOAT3(axis.x + n.x, axis.y + n.y, axis.z + n.z);
+		}
+		const float axisLength = sqrtf(Dot(axis, axis));
+
+		float minCosine = axisLength > 0.0f ? 1.0f : -1.0f;
+		if (axisLength > 0.0f)
+		{
+			axis = XMFLOAT3(axis.x / axisLength, axis.y / axisLength, axis.z / axisLength);
+			for (size_t t = 0; t < triangleCount; ++t)
+			{
+				const XMFLOAT3& n = normals[firstTriangle + t];
+				if (Dot(n, n) > 0.0f)
+					minCosine = std::min(minCosine, Dot(n, axis));
+			}
+		}
+		meshlet.coneAxis[0] = axis.x;
+		meshlet.coneAxis[1] = axis.y;
+		meshlet.coneAxis[2] = axis.z;
+		meshlet.coneCutoff = minCosine > MIN_CONE_COSINE ? sqrtf(1.0f - minCosine * minCosine) : 1.0f;
+		return meshlet;
+	}
+}
+
+size_t BuildMeshlets(uint32_t* const indices, const size_t indexOffset, const size_t indexCount, const SimpleVertex* const vertices,
+                     const size_t vertexCount, std::vector<MESH_CACHE_MESHLET>& meshlets)
+{
+	if (!indices || !vertices || indexCount < 3)
+		return 0;
+
+	uint32_t* const triangles = indices + indexOffset;
+	const size_t triangleCount = indexCount / 3;
+
+	// The triangles around each vertex, and each triangle's facing
+	std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		++firstTriangle[triangles[i] + 1];
+	for (size_t v = 0; v < vertexCount; ++v)
+		firstTriangle[v + 1] += firstTriangle[v];
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			vertexTriangles[fill[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<XMFLOAT3> normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t)
+		normals[t] = UnitNormal(vertices[triangles[t * 3]].Pos, vertices[triangles[t * 3 + 1]].Pos, vertices[triangles[t * 3 + 2]].Pos);
+
+	// stamp[v] is the number of the meshlet v was last added to, so membership needs no
+	// clearing between meshlets
+	std::vector<uint32_t> stamp(vertexCount, 0);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	std::vector<XMFLOAT3> outputNormals;
+	outputNormals.reserve(triangleCount);
+	std::vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(MESHLET_MAX_VERTICES);
+	std::vector<uint32_t> localIndices;
+
+	const size_t firstMeshlet = meshlets.size();
+	uint32_t meshletNumber = 0;
+	size_t seed = 0;
+	for (;;)
+	{
+		// Seeding in the order given keeps the meshlets close to what OptimizeOverdraw sorted
+		while (seed < triangleCount && emitted[seed])
+			++seed;
+		if (seed == triangleCount)
+			break;
+
+		++meshletNumber;
+		meshletVertices.clear();
+		const size_t begin = output.size();
+		XMFLOAT3 normalSum(0.0f, 0.0f, 0.0f);
+		size_t triangle = seed;
+		for (;;)
+		{
+			emitted[triangle] = 1;
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t v = triangles[triangle * 3 + corner];
+				output.push_back(v);
+				if (stamp[v] != meshletNumber)
+				{
+					stamp[v] = meshletNumber;
+					meshletVertices.push_back(v);
+				}
+			}
+			outputNormals.push_back(normals[triangle]);
+			normalSum = XMFLOAT3(normalSum.x + normals[triangle].x, normalSum.y + normals[triangle].y, normalSum.z + normals[triangle].z);
+			if ((output.size() - begin) / 3 == MESHLET_MAX_TRIANGLES)
+				break;
+
+			// The neighbour adding the fewest vertices, then the one facing most like the
+			// meshlet so far
+			size_t best = NO_TRIANGLE;
+			size_t bestNew = 4;
+			float bestFacing = -FLT_MAX;
+			for (const uint32_t v : meshletVertices)
+			{
+				for (uint32_t i = firstTriangle[v]; i < firstTriangle[v + 1]; ++i)
+				{
+					const uint32_t candidate = vertexTriangles[i];
+					if (emitted[candidate])
+						continue;
+
+					size_t added = 0;
+					for (int corner = 0; corner < 3; ++corner)
+						added += stamp[triangles[candidate * 3 + corner]] != meshletNumber;
+					if (meshletVertices.size() + added > MESHLET_MAX_VERTICES || added > bestNew)
+						continue;
+
+					const float facing = Dot(normals[candidate], normalSum);
+					if (added < bestNew || facing > bestFacing)
+					{
+						best = candidate;
+						bestNew = added;
+						bestFacing = facing;
+					}
+				}
+			}
+			if (best == NO_TRIANGLE)
+				break;
+			triangle = best;
+		}
+
+		// Growing by fewest new vertices does not follow the post-transform cache, so the
+		// meshlet is reordered for it on its own, numbering its vertices from 0 to keep
+		// that cheap
+		localIndices.resize(output.size() - begin);
+		for (size_t i = 0; i < localIndices.size(); ++i)
+			localIndices[i] = static_cast<uint32_t>(std::find(meshletVertices.begin(), meshletVertices.end(), output[begin + i]) - meshletVertices.begin());
+		OptimizeVertexCache(localIndices.data(), localIndices.size(), meshletVertices.size());
+		for (size_t i = 0; i < localIndices.size(); ++i)
+			output[begin + i] = meshletVertices[localIndices[i]];
+
+		meshlets.push_back(ComputeBounds(indexOffset + begin, output.size() - begin, meshletVertices, vertices, outputNormals, begin / 3));
+	}
+
+	memcpy(triangles, output.data(), output.size() * sizeof(uint32_t));
+	return meshlets.size() - firstMeshlet;
+}
+
+size_t CullMeshlets(const MESH_CACHE_MESHLET* const meshlets, const size_t meshletCount, FXMMATRIX world, CXMMATRIX view,
+                    CXMMATRIX projection, const D3D11_CULL_MODE cullMode, const BOOL frontCounterClockwise,
+                    MESHLET_DRAW_RANGE* const ranges, MESHLET_CULL_STATS* const stats)
+{
+	MESHLET_CULL_STATS counts = {};
+	size_t rangeCount = 0;
+	if (meshlets && ranges)
+	{
+		const XMMATRIX worldView = XMMatrixMultiply(world, view);
+		const XMMATRIX worldViewProjection = XMMatrixMultiply(worldView, projection);
+
+		// The side planes of the frustum, in model space, from the columns of the clip
+		// transform. Depth is not clipped, so there are no near and far planes.
+		const XMMATRIX columns = XMMatrixTranspose(worldViewProjection);
+		const XMVECTOR planes[4] =
+		{
+			XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[0])),
+			XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[0])),
+			XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[1])),
+			XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[1])),
+		};
+
+		// A triangle is clockwise on screen when it faces the camera, under a transform
+		// that does not mirror; facing is the sign of dot(normal, position - camera) that
+		// the rasterizer throws away
+		XMVECTOR determinant;
+		const XMMATRIX modelFromView = XMMatrixInverse(&determinant, worldView);
+		XMFLOAT3 camera;
+		XMStoreFloat3(&camera, modelFromView.r[3]);
+		float facing = cullMode == D3D11_CULL_BACK ? 1.0f : cullMode == D3D11_CULL_FRONT ? -1.0f : 0.0f;
+		if (frontCounterClockwise)
+			facing = -facing;
+		if (XMVectorGetX(XMMatrixDeterminant(worldViewProjection)) < 0.0f)
+			facing = -facing;
+
+		for (size_t i = 0; i < meshletCount; ++i)
+		{
+			const MESH_CACHE_MESHLET& meshlet = meshlets[i];
+			const XMFLOAT3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+
+			bool outside = false;
+			for (const XMVECTOR& plane : planes)
+				outside = outside || XMVectorGetX(XMPlaneDotCoord(plane, XMLoadFloat3(&center))) < -meshlet.radius;
+			if (outside)
+			{
+				++counts.frustumCulled;
+				continue;
+			}
+
+			// Every normal in the cone faces away from every point of the sphere
+			if (facing != 0.0f && meshlet.coneCutoff < 1.0f)
+			{
+				const XMFLOAT3 toCenter = Subtract(center, camera);
+				const XMFLOAT3 axis(meshlet.coneAxis[0] * facing, meshlet.coneAxis[1] * facing, meshlet.coneAxis[2] * facing);
+				if (Dot(toCenter, axis) >= meshlet.coneCutoff * sqrtf(Dot(toCenter, toCenter)) + meshlet.radius)
+				{
+					++counts.backfaceCulled;
+					continue;
+				}
+			}
+
+			counts.trianglesDrawn += meshlet.indexCount / 3;
+			if (rangeCount && ranges[rangeCount - 1].indexOffset + ranges[rangeCount - 1].indexCount == meshlet.indexOffset)
+			{
+				ranges[rangeCount - 1].indexCount += meshlet.indexCount;
+			}
+			else
+			{
+				ranges[rangeCount].indexOffset = meshlet.indexOffset;
+				ranges[rangeCount].indexCount = meshlet.indexCount;
+				++rangeCount;
+			}
+		}
+	}
+
+	if (stats)
+		*stats = counts;
+	return rangeCount;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "MeshCache.h"
+#include "SimpleVertex.h"
+
+//--------------------------------------------------------------------------------------
+// Meshlets: a triangle list cut into runs small enough to cull as one before drawing.
+// D3D11 has no mesh shaders, so a meshlet is a contiguous range of the index list and
+// culling turns the meshlets that survive into the fewest DrawIndexed ranges.
+//
+// A meshlet is grown from a seed triangle by adding the neighbour that brings in the
+// fewest new vertices, which keeps it compact on the surface and its normals close, so
+// its cone is narrow enough to reject whole when it faces away from the camera.
+//--------------------------------------------------------------------------------------
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+// Reorders the triangles of indices[indexOffset, indexOffset + indexCount) in place into
+// meshlets and appends one entry per meshlet, with offsets into the whole index list.
+// Returns how many were appended.
+size_t BuildMeshlets(uint32_t* indices, size_t indexOffset, size_t indexCount, const SimpleVertex* vertices, size_t vertexCount,
+                     std::vector<MESH_CACHE_MESHLET>& meshlets);
+
+struct MESHLET_DRAW_RANGE
+{
+	UINT indexOffset;
+	UINT indexCount;
+};
+
+struct MESHLET_CULL_STATS
+{
+	size_t frustumCulled;    // meshlets wholly outside a side of the view frustum
+	size_t backfaceCulled;   // meshlets whose triangles all face the way the rasterizer culls
+	size_t trianglesDrawn;
+};
+
+// Writes a range to 'ranges' for each run of consecutive meshlets that survive, so it needs
+// room for meshletCount of them, and returns how many it wrote. Culling happens in model
+// space, so 'world' must not shear or scale unevenly. cullMode and frontCounterClockwise
+// are those of the rasterizer state the ranges are drawn with; D3D11_CULL_NONE only
+// culls against the frustum.
+size_t CullMeshlets(const MESH_CACHE_MESHLET* meshlets, size_t meshletCount, FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                    D3D11_CULL_MODE cullMode, BOOL frontCounterClockwise, MESHLET_DRAW_RANGE* ranges,
+                    MESHLET_CULL_STATS* stats = nullptr);
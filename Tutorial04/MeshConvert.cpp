@@ -0,0 +1,117 @@
+#include "MeshConvert.h"
+#include "ThreadPool.h"
+#include <string.h>
+
+// Each attribute is moved with one unaligned four-float load and store, so the fourth lane
+// of every store lands on the start of the next attribute and is overwritten by it
+#if defined(_M_IX86) || defined(_M_X64)
+#define MESH_CONVERT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Vertices per pool task; below two of these the pool is not worth waking
+	const size_t VERTEX_GRAIN = 32 * 1024;
+
+	// Missing streams read this with a stride of zero
+	const float s_zeros[4] = {};
+
+	struct StreamCursor
+	{
+		const float* data;
+		size_t stride;   // floats per vertex, 0 for a missing stream
+
+		StreamCursor(const float* stream) : data(stream ? stream : s_zeros), stride(stream ? 3 : 0) {}
+		const float* At(const size_t vertex) const { return data + vertex * stride; }
+	};
+
+	static_assert(sizeof(SimpleVertex) == 14 * sizeof(float), "SimpleVertex is expected to be 14 tightly packed floats");
+
+	void ConvertOne(const StreamCursor (&streams)[5], const size_t vertex, float* out)
+	{
+		memcpy(out + 0, streams[0].At(vertex), 3 * sizeof(float));
+		memcpy(out + 3, streams[1].At(vertex), 3 * sizeof(float));
+		memcpy(out + 6, streams[2].At(vertex), 2 * sizeof(float));
+		memcpy(out + 8, streams[3].At(vertex), 3 * sizeof(float));
+		memcpy(out + 11, streams[4].At(vertex), 3 * sizeof(float));
+	}
+
+	void ConvertRange(const StreamCursor (&streams)[5], const size_t begin, const size_t end, SimpleVertex* const vertices)
+	{
+		if (begin >= end)
+			return;
+
+		float* out = reinterpret_cast<float*>(vertices + begin);
+		size_t vertex = begin;
+
+#ifdef MESH_CONVERT_SSE2
+		// A four-float load reads one float past the vertex and the last store writes one
+		// past it, so the final vertex of the range, and of each stream, goes the scalar way
+		const size_t simdEnd = end - 1;
+		for (; vertex < simdEnd; ++vertex, out += 14)
+		{
+			const __m128 position = _mm_loadu_ps(streams[0].At(vertex));
+			const __m128 normal = _mm_loadu_ps(streams[1].At(vertex));
+			const __m128 texCoord = _mm_loadu_ps(streams[2].At(vertex));
+			const __m128 tangent = _mm_loadu_ps(streams[3].At(vertex));
+			const __m128 bitangent = _mm_loadu_ps(streams[4].At(vertex));
+
+			_mm_storeu_ps(out + 0, position);
+			_mm_storeu_ps(out + 3, normal);
+			_mm_storel_pi(reinterpret_cast<__m64*>(out + 6), texCoord);
+			_mm_storeu_ps(out + 8, tangent);
+			_mm_storeu_ps(out + 11, bitangent);   // spills onto the next vertex's position
+		}
+#endif
+
+		for (; vertex < end; ++vertex, out += 14)
+			ConvertOne(streams, vertex, out);
+	}
+}
+
+void InterleaveVertices(const MESH_STREAMS& streams, const size_t vertexCount, SimpleVertex* const vertices, ThreadPool* const pool)
+{
+	if (!streams.positions || !vertices || !vertexCount)
+		return;
+
+	const StreamCursor cursors[5] =
+	{
+		StreamCursor(streams.positions),
+		StreamCursor(streams.normals),
+		StreamCursor(streams.texCoords),
+		StreamCursor(streams.tangents),
+		StreamCursor(streams.bitangents),
+	};
+
+	// Ranges end on a scalar vertex, so no store spills into a range another thread owns
+	if (pool && vertexCount >= 2 * VERTEX_GRAIN)
+		pool->ParallelFor(vertexCount, VERTEX_GRAIN, [&](const size_t begin, const size_t end) { ConvertRange(cursors, begin, end, vertices); });
+	else
+		ConvertRange(cursors, 0, vertexCount, vertices);
+}
+
+DXGI_FORMAT IndexFormatFor(const size_t vertexCount)
+{
+	return vertexCount <= 0x10000 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+void NarrowIndices(const uint32_t* const source, const size_t indexCount, uint16_t* const dest)
+{
+	size_t i = 0;
+
+#ifdef MESH_CONVERT_SSE2
+	// SSE2 only packs with signed saturation, so bias into the signed range and back
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+	for (; i + 8 <= indexCount; i += 8)
+	{
+		const __m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), bias32);
+		const __m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4)), bias32);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_xor_si128(_mm_packs_epi32(low, high), bias16));
+	}
+#endif
+
+	for (; i < indexCount; ++i)
+		dest[i] = static_cast<uint16_t>(source[i]);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <dxgiformat.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SimpleVertex.h"
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// Attribute streams of a mesh as an importer holds them: one array per attribute, three
+// floats per vertex (Assimp's aiVector3D, whose z is ignored for texture coordinates).
+// Any stream but positions may be null and comes out as zeros.
+//--------------------------------------------------------------------------------------
+struct MESH_STREAMS
+{
+	const float* positions;
+	const float* normals;
+	const float* texCoords;
+	const float* tangents;
+	const float* bitangents;
+};
+
+// Interleaves the streams into SimpleVertex, four floats at a time. Large meshes are split
+// over the pool.
+void InterleaveVertices(const MESH_STREAMS& streams, size_t vertexCount, SimpleVertex* vertices, ThreadPool* pool = nullptr);
+
+// Narrowest index format that can address 'vertexCount' vertices: R16_UINT up to 65536
+DXGI_FORMAT IndexFormatFor(size_t vertexCount);
+
+inline size_t IndexStride(const DXGI_FORMAT format) { return format == DXGI_FORMAT_R32_UINT ? 4 : 2; }
+
+// Copies 32-bit indices into 16-bit ones; every index has to be below 65536
+void NarrowIndices(const uint32_t* source, size_t indexCount, uint16_t* dest);
@@ -0,0 +1,393 @@
+#include "MeshOptimize.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	// Forsyth's constants, from "Linear-Speed Vertex Cache Optimisation"
+	const size_t FORSYTH_CACHE_SIZE = 32;
+	const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+	const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+	const size_t FORSYTH_MAX_VALENCE = 64;
+
+	struct ForsythTables
+	{
+		float cache[FORSYTH_CACHE_SIZE];
+		float valence[FORSYTH_MAX_VALENCE];
+
+		ForsythTables()
+		{
+			for (size_t i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+			{
+				// The last triangle's vertices score the same whatever their order, so no
+				// triangle is favoured for matching the previous one's winding
+				cache[i] = i < 3 ? FORSYTH_LAST_TRI_SCORE
+				                 : powf(1.0f - float(i - 3) / float(FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+			}
+
+			// Vertices with few triangles left are boosted, so they are finished off
+			// rather than left to be transformed again later
+			valence[0] = 0.0f;
+			for (size_t i = 1; i < FORSYTH_MAX_VALENCE; ++i)
+				valence[i] = FORSYTH_VALENCE_BOOST_SCALE * powf(float(i), -FORSYTH_VALENCE_BOOST_POWER);
+		}
+
+		float Score(const int cachePosition, const uint32_t activeTriangles) const
+		{
+			if (!activeTriangles)
+				return -1.0f;
+
+			const float cacheScore = cachePosition < 0 ? 0.0f : cache[cachePosition];
+			return cacheScore + valence[std::min<size_t>(activeTriangles, FORSYTH_MAX_VALENCE - 1)];
+		}
+	};
+
+	const ForsythTables& GetForsythTables()
+	{
+		static const ForsythTables tables;
+		return tables;
+	}
+
+	// A vertex is in the FIFO while fewer than 'cacheSize' misses have happened since its own
+	class FifoCache
+	{
+	public:
+		FifoCache(const size_t vertexCount, const size_t cacheSize)
+			: m_timestamps(vertexCount, 0), m_time(cacheSize + 1), m_cacheSize(cacheSize) {}
+
+		unsigned int Misses(const uint32_t* const triangle)
+		{
+			unsigned int count = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				if (m_time - m_timestamps[triangle[k]] > m_cacheSize)
+				{
+					m_timestamps[triangle[k]] = m_time++;
+					++count;
+				}
+			}
+			return count;
+		}
+
+		void Flush() { m_time += m_cacheSize + 1; }
+
+	private:
+		std::vector<size_t> m_timestamps;
+		size_t m_time;
+		const size_t m_cacheSize;
+	};
+
+	// Cache misses per triangle over the whole list
+	void SimulateFifo(const uint32_t* indices, const size_t triangleCount, const size_t vertexCount, const size_t cacheSize,
+	                  std::vector<uint8_t>& misses)
+	{
+		FifoCache cache(vertexCount, cacheSize);
+		misses.resize(triangleCount);
+		for (size_t t = 0; t < triangleCount; ++t)
+			misses[t] = static_cast<uint8_t>(cache.Misses(indices + t * 3));
+	}
+
+	struct Cluster
+	{
+		size_t begin;       // triangle
+		size_t end;
+		float sortKey;
+	};
+}
+
+VERTEX_CACHE_STATS AnalyzeVertexCache(const uint32_t* const indices, const size_t indexCount, const size_t vertexCount, const size_t cacheSize)
+{
+	VERTEX_CACHE_STATS stats = {};
+	const size_t triangleCount = indexCount / 3;
+	if (!indices || !triangleCount || !vertexCount || !cacheSize)
+		return stats;
+
+	std::vector<uint8_t> misses;
+	SimulateFifo(indices, triangleCount, vertexCount, cacheSize, misses);
+
+	size_t transformed = 0;
+	for (const uint8_t count : misses)
+		transformed += count;
+
+	std::vector<bool> used(vertexCount, false);
+	size_t referenced = 0;
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		if (!used[indices[i]])
+		{
+			used[indices[i]] = true;
+			++referenced;
+		}
+	}
+
+	stats.acmr = float(transformed) / float(triangleCount);
+	stats.atvr = float(transformed) / float(referenced);
+	return stats;
+}
+
+void OptimizeVertexCache(uint32_t* const indices, const size_t indexCount, const size_t vertexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (!indices || triangleCount < 2 || !vertexCount)
+		return;
+
+	const ForsythTables& tables = GetForsythTables();
+
+	// Triangles around each vertex, as offsets into one shared list. activeTriangles[v]
+	// counts the ones not yet emitted, which are kept at the front of v's range.
+	std::vector<uint32_t> activeTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		++activeTriangles[indices[i]];
+
+	std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+		firstTriangle[v + 1] = firstTriangle[v] + activeTriangles[v];
+
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	{
+		std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			for (size_t k = 0; k < 3; ++k)
+				vertexTriangles[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = tables.Score(-1, activeTriangles[v]);
+
+	std::vector<bool> emitted(triangleCount, false);
+	size_t best = 0;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		const float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = t;
+		}
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+
+	// One slot past the cache for the vertices pushed out by the newest triangle
+	uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+	size_t cacheCount = 0;
+	size_t scanStart = 0;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		// Nothing in the cache leads anywhere: carry on from the first triangle left
+		if (best == SIZE_MAX)
+		{
+			while (emitted[scanStart])
+				++scanStart;
+			best = scanStart;
+		}
+
+		const uint32_t* const triangle = indices + best * 3;
+		output.insert(output.end(), triangle, triangle + 3);
+		emitted[best] = true;
+
+		// Take the triangle out of its vertices' active lists
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const uint32_t v = triangle[k];
+			uint32_t* const list = vertexTriangles.data() + firstTriangle[v];
+			const uint32_t count = activeTriangles[v];
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (list[i] == best)
+				{
+					std::swap(list[i], list[count - 1]);
+					break;
+				}
+			}
+			--activeTriangles[v];
+		}
+
+		// The triangle's vertices go to the front of the LRU cache
+		uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+		size_t newCount = 0;
+		for (size_t k = 0; k < 3; ++k)
+			newCache[newCount++] = triangle[k];
+		for (size_t i = 0; i < cacheCount; ++i)
+		{
+			const uint32_t v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				newCache[newCount++] = v;
+		}
+
+		for (size_t i = 0; i < newCount; ++i)
+		{
+			const uint32_t v = newCache[i];
+			cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+			vertexScore[v] = tables.Score(cachePosition[v], activeTriangles[v]);
+		}
+
+		// Rescore the triangles around everything that moved and pick the best of them
+		best = SIZE_MAX;
+		bestScore = 0.0f;
+		for (size_t i = 0; i < newCount; ++i)
+		{
+			const uint32_t v = newCache[i];
+			const uint32_t* const list = vertexTriangles.data() + firstTriangle[v];
+			for (uint32_t j = 0; j < activeTriangles[v]; ++j)
+			{
+				const uint32_t t = list[j];
+				const float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+	}
+
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void OptimizeOverdraw(uint32_t* const indices, const size_t indexCount, const SimpleVertex* const vertices, const size_t vertexCount,
+                      const float threshold)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (!indices || !vertices || triangleCount < 2 || !vertexCount)
+		return;
+
+	// Hard boundaries: triangles that miss on all three vertices start over anyway
+	std::vector<uint8_t> misses;
+	SimulateFifo(indices, triangleCount, vertexCount, VERTEX_CACHE_ANALYSIS_SIZE, misses);
+
+	std::vector<size_t> hardBoundaries;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		if (t == 0 || misses[t] == 3)
+			hardBoundaries.push_back(t);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	// Soft boundaries: within each hard cluster, cut wherever the run so far, starting from
+	// a cold cache as it will once reordered, already does as well as the whole cluster
+	std::vector<Cluster> clusters;
+	FifoCache cache(vertexCount, VERTEX_CACHE_ANALYSIS_SIZE);
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+	{
+		const size_t begin = hardBoundaries[h];
+		const size_t end = hardBoundaries[h + 1];
+
+		cache.Flush();
+		size_t clusterMisses = 0;
+		for (size_t t = begin; t < end; ++t)
+			clusterMisses += cache.Misses(indices + t * 3);
+		const float target = threshold * float(clusterMisses) / float(end - begin);
+
+		cache.Flush();
+		size_t start = begin;
+		size_t runMisses = 0;
+		for (size_t t = begin; t < end; ++t)
+		{
+			runMisses += cache.Misses(indices + t * 3);
+			if (t + 1 < end && float(runMisses) / float(t + 1 - start) <= target)
+			{
+				clusters.push_back({ start, t + 1, 0.0f });
+				start = t + 1;
+				runMisses = 0;
+				cache.Flush();
+			}
+		}
+		clusters.push_back({ start, end, 0.0f });
+	}
+
+	if (clusters.size() < 2)
+		return;
+
+	float meshCentroid[3] = {};
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		meshCentroid[0] += vertices[v].Pos.x;
+		meshCentroid[1] += vertices[v].Pos.y;
+		meshCentroid[2] += vertices[v].Pos.z;
+	}
+	for (float& c : meshCentroid)
+		c /= float(vertexCount);
+
+	// Clusters facing away from the centre are drawn first: they are the likeliest to
+	// cover the rest. Centroid and normal are weighted by triangle area.
+	for (Cluster& cluster : clusters)
+	{
+		float centroid[3] = {};
+		float normal[3] = {};
+		float area = 0.0f;
+		for (size_t t = cluster.begin; t < cluster.end; ++t)
+		{
+			const XMFLOAT3& p0 = vertices[indices[t * 3]].Pos;
+			const XMFLOAT3& p1 = vertices[indices[t * 3 + 1]].Pos;
+			const XMFLOAT3& p2 = vertices[indices[t * 3 + 2]].Pos;
+
+			const float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+			const float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+			const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float weight = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			centroid[0] += (p0.x + p1.x + p2.x) * weight;
+			centroid[1] += (p0.y + p1.y + p2.y) * weight;
+			centroid[2] += (p0.z + p1.z + p2.z) * weight;
+			for (int axis = 0; axis < 3; ++axis)
+				normal[axis] += n[axis];
+			area += weight;
+		}
+
+		const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (area <= 0.0f || normalLength <= 0.0f)
+			continue;
+
+		float key = 0.0f;
+		for (int axis = 0; axis < 3; ++axis)
+			key += (centroid[axis] / (3.0f * area) - meshCentroid[axis]) * normal[axis] / normalLength;
+		cluster.sortKey = key;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	for (const Cluster& cluster : clusters)
+		output.insert(output.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t OptimizeVertexFetch(SimpleVertex* const vertices, const size_t vertexCount, uint32_t* const indices, const size_t indexCount)
+{
+	if (!vertices || !indices || !vertexCount)
+		return vertexCount;
+
+	std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+	std::vector<SimpleVertex> reordered;
+	reordered.reserve(vertexCount);
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& newIndex = remap[indices[i]];
+		if (newIndex == UINT32_MAX)
+		{
+			newIndex = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[indices[i]]);
+		}
+		indices[i] = newIndex;
+	}
+
+	memcpy(vertices, reordered.data(), reordered.size() * sizeof(SimpleVertex));
+	return reordered.size();
+}
@@ -0,0 +1,140 @@
+#include "MeshRegistry.h"
+
+MeshRegistry::MeshRegistry(const UINT arenaBytes)
+	: m_arenaBytes(arenaBytes)
+{
+}
+
+MeshRegistry::~MeshRegistry()
+{
+	Clear();
+}
+
+HRESULT MeshRegistry::Allocate(ID3D11Device* const device, std::vector<Arena>& arenas, const UINT bindFlags, const UINT stride,
+                               const DXGI_FORMAT format, const UINT count, UINT* const arenaIndex, UINT* const offset)
+{
+	for (size_t i = 0; i < arenas.size(); ++i)
+	{
+		if (arenas[i].stride != stride || arenas[i].format != format)
+			continue;
+		const uint32_t found = arenas[i].allocator.Allocate(count);
+		if (found != OffsetAllocator::INVALID_OFFSET)
+		{
+			*arenaIndex = static_cast<UINT>(i);
+			*offset = found;
+			return S_OK;
+		}
+	}
+
+	// None has room, so add one that holds at least this mesh
+	const UINT defaultCapacity = m_arenaBytes / stride;
+	const UINT capacity = count > defaultCapacity ? count : defaultCapacity;
+	if (capacity > UINT32_MAX / stride)
+		return E_OUTOFMEMORY;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = capacity * stride;
+	desc.BindFlags = bindFlags;
+	ID3D11Buffer* buffer = nullptr;
+	const HRESULT hr = device->CreateBuffer(&desc, nullptr, &buffer);
+	if (FAILED(hr))
+		return hr;
+
+	arenas.push_back(Arena{ buffer, stride, format, OffsetAllocator(capacity) });
+	m_stats.arenaBytes += desc.ByteWidth;
+	*arenaIndex = static_cast<UINT>(arenas.size() - 1);
+	*offset = arenas.back().allocator.Allocate(count);
+	return S_OK;
+}
+
+HRESULT MeshRegistry::Add(ID3D11Device* const device, ID3D11DeviceContext* const context, const void* const vertices,
+                          const UINT vertexStride, const UINT vertexCount, const void* const indices, const DXGI_FORMAT indexFormat,
+                          const UINT indexCount, MESH_HANDLE* const handle)
+{
+	if (!device || !context || !vertices || !vertexStride || !vertexCount || !indices || !indexCount || !handle)
+		return E_INVALIDARG;
+	if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT)
+		return E_INVALIDARG;
+
+	const UINT indexStride = indexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2;
+	UINT vertexArena = 0;
+	UINT vertexOffset = 0;
+	HRESULT hr = Allocate(device, m_vertexArenas, D3D11_BIND_VERTEX_BUFFER, vertexStride, DXGI_FORMAT_UNKNOWN, vertexCount,
+	                      &vertexArena, &vertexOffset);
+	if (FAILED(hr))
+		return hr;
+
+	UINT indexArena = 0;
+	UINT indexOffset = 0;
+	hr = Allocate(device, m_indexArenas, D3D11_BIND_INDEX_BUFFER, indexStride, indexFormat, indexCount, &indexArena, &indexOffset);
+	if (FAILED(hr))
+	{
+		m_vertexArenas[vertexArena].allocator.Free(vertexOffset, vertexCount);
+		return hr;
+	}
+
+	// Buffers are one-dimensional, so only left and right of the box count
+	D3D11_BOX box = { vertexOffset * vertexStride, 0, 0, (vertexOffset + vertexCount) * vertexStride, 1, 1 };
+	context->UpdateSubresource(m_vertexArenas[vertexArena].buffer, 0, &box, vertices, 0, 0);
+	box.left = indexOffset * indexStride;
+	box.right = (indexOffset + indexCount) * indexStride;
+	context->UpdateSubresource(m_indexArenas[indexArena].buffer, 0, &box, indices, 0, 0);
+
+	handle->vertexArena = vertexArena;
+	handle->indexArena = indexArena;
+	handle->baseVertex = static_cast<INT>(vertexOffset);
+	handle->firstIndex = indexOffset;
+	handle->vertexCount = vertexCount;
+	handle->indexCount = indexCount;
+	m_stats.usedBytes += size_t(vertexCount) * vertexStride + size_t(indexCount) * indexStride;
+	return S_OK;
+}
+
+void MeshRegistry::Remove(const MESH_HANDLE& handle)
+{
+	if (handle.vertexArena >= m_vertexArenas.size() || handle.indexArena >= m_indexArenas.size())
+		return;
+
+	Arena& vertexArena = m_vertexArenas[handle.vertexArena];
+	Arena& indexArena = m_indexArenas[handle.indexArena];
+	vertexArena.allocator.Free(static_cast<uint32_t>(handle.baseVertex), handle.vertexCount);
+	indexArena.allocator.Free(handle.firstIndex, handle.indexCount);
+	m_stats.usedBytes -= size_t(handle.vertexCount) * vertexArena.stride + size_t(handle.indexCount) * indexArena.stride;
+}
+
+void MeshRegistry::Bind(StateCache& cache, const MESH_HANDLE& handle)
+{
+	const Arena& vertexArena = m_vertexArenas[handle.vertexArena];
+	const UINT offset = 0;
+	cache.IASetVertexBuffers(0, 1, &vertexArena.buffer, &vertexArena.stride, &offset);
+
+	const Arena& indexArena = m_indexArenas[handle.indexArena];
+	cache.IASetIndexBuffer(indexArena.buffer, indexArena.format, 0);
+}
+
+void MeshRegistry::Draw(StateCache& cache, const MESH_HANDLE& handle, const UINT indexCount, const UINT indexOffset)
+{
+	Bind(cache, handle);
+	cache.Get()->DrawIndexed(indexCount, handle.firstIndex + indexOffset, handle.baseVertex);
+}
+
+void MeshRegistry::Clear()
+{
+	for (Arena& arena : m_vertexArenas)
+		arena.buffer->Release();
+	for (Arena& arena : m_indexArenas)
+		arena.buffer->Release();
+	m_vertexArenas.clear();
+	m_indexArenas.clear();
+	m_stats.arenaBytes = 0;
+	m_stats.usedBytes = 0;
+}
+
+MeshRegistry::Stats MeshRegistry::GetStats() const
+{
+	Stats stats = m_stats;
+	stats.vertexArenas = m_vertexArenas.size();
+	stats.indexArenas = m_indexArenas.size();
+	return stats;
+}
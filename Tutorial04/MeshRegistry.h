@@ -0,0 +1,86 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+#include <vector>
+
+#include "OffsetAllocator.h"
+#include "StateCache.h"
+
+//--------------------------------------------------------------------------------------
+// Where a mesh lives in the registry's arenas. Index values are relative to the mesh's
+// own vertices; DrawIndexed adds baseVertex to them.
+//--------------------------------------------------------------------------------------
+struct MESH_HANDLE
+{
+	UINT vertexArena;
+	UINT indexArena;
+	INT baseVertex;
+	UINT firstIndex;
+	UINT vertexCount;
+	UINT indexCount;
+};
+
+//--------------------------------------------------------------------------------------
+// Suballocates every mesh from a few large vertex and index buffers instead of giving each
+// its own. Meshes with the same vertex stride share a vertex arena and those with the same
+// index format an index arena, so consecutive draws of different meshes usually need no
+// IASetVertexBuffers or IASetIndexBuffer at all: Bind goes through the StateCache, which
+// drops the calls for arenas that are bound already. When a mesh does not fit in the
+// arenas there are, another one is created, at least as large as the mesh.
+//
+// The arenas are D3D11_USAGE_DEFAULT and meshes are written in with UpdateSubresource.
+// Not thread-safe: use it from the thread that owns the device.
+//--------------------------------------------------------------------------------------
+class MeshRegistry
+{
+public:
+	struct Stats
+	{
+		size_t vertexArenas;
+		size_t indexArenas;
+		size_t arenaBytes;      // created, used or not
+		size_t usedBytes;
+	};
+
+	// arenaBytes is the size each arena is created with, unless a mesh needs more
+	explicit MeshRegistry(UINT arenaBytes);
+	~MeshRegistry();
+
+	MeshRegistry(const MeshRegistry&) = delete;
+	MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+	// Copies a mesh into the arenas; indexFormat is DXGI_FORMAT_R16_UINT or R32_UINT
+	HRESULT Add(ID3D11Device* device, ID3D11DeviceContext* context, const void* vertices, UINT vertexStride, UINT vertexCount,
+	            const void* indices, DXGI_FORMAT indexFormat, UINT indexCount, MESH_HANDLE* handle);
+
+	// Returns the mesh's ranges to their arenas; the handle must not be drawn again
+	void Remove(const MESH_HANDLE& handle);
+
+	// Sets the arenas holding the mesh as the vertex buffer in slot 0 and the index buffer
+	void Bind(StateCache& cache, const MESH_HANDLE& handle);
+
+	// Bind, then DrawIndexed over indices [indexOffset, indexOffset + indexCount) of the mesh
+	void Draw(StateCache& cache, const MESH_HANDLE& handle, UINT indexCount, UINT indexOffset);
+	void Draw(StateCache& cache, const MESH_HANDLE& handle) { Draw(cache, handle, handle.indexCount, 0); }
+
+	void Clear();
+
+	Stats GetStats() const;
+
+private:
+	struct Arena
+	{
+		ID3D11Buffer* buffer;
+		UINT stride;            // vertex stride, or the index size
+		DXGI_FORMAT format;     // DXGI_FORMAT_UNKNOWN for vertex arenas
+		OffsetAllocator allocator;
+	};
+
+	HRESULT Allocate(ID3D11Device* device, std::vector<Arena>& arenas, UINT bindFlags, UINT stride, DXGI_FORMAT format, UINT count,
+	                 UINT* arenaIndex, UINT* offset);
+
+	std::vector<Arena> m_vertexArenas;
+	std::vector<Arena> m_indexArenas;
+	UINT m_arenaBytes;
+	Stats m_stats = {};
+};
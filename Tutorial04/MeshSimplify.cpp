@@ -0,0 +1,530 @@
+#include "MeshSimplify.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+	const uint32_t NO_VERTEX = ~0u;
+	const uint32_t MANY_VERTICES = ~1u;
+
+	enum VertexKind : uint8_t
+	{
+		KIND_MANIFOLD,   // closed all round; collapses onto any neighbour
+		KIND_BORDER,     // on one open border; collapses along it
+		KIND_SEAM,       // one of two wedges on a seam; collapses along it, with its wedge
+		KIND_LOCKED,     // anything else: corners, seam ends, borders meeting seams
+	};
+
+	// Open edges are held to their line by a plane through them, across their triangle,
+	// weighted this many times their squared length
+	const double BOUNDARY_WEIGHT = 10.0;
+
+	// A collapse is refused if it turns a triangle by more than about 75 degrees
+	const float FLIP_COSINE = 0.25f;
+
+	// Plane distances summed over the triangles around a corner, weighted by their area
+	struct Quadric
+	{
+		double a00, a11, a22, a10, a20, a21;
+		double b0, b1, b2;
+		double c;
+		double weight;
+
+		void AddPlane(const double (&n)[3], const double d, const double w)
+		{
+			a00 += w * n[0] * n[0];
+			a11 += w * n[1] * n[1];
+			a22 += w * n[2] * n[2];
+			a10 += w * n[1] * n[0];
+			a20 += w * n[2] * n[0];
+			a21 += w * n[2] * n[1];
+			b0 += w * n[0] * d;
+			b1 += w * n[1] * d;
+			b2 += w * n[2] * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a00 += other.a00;
+			a11 += other.a11;
+			a22 += other.a22;
+			a10 += other.a10;
+			a20 += other.a20;
+			a21 += other.a21;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// Mean squared distance of 'p' from the planes
+		double Error(const XMFLOAT3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double rx = a00 * x + a10 * y + a20 * z;
+			const double ry = a10 * x + a11 * y + a21 * z;
+			const double rz = a20 * x + a21 * y + a22 * z;
+			const double error = rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0.0 ? fabs(error) / weight : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	XMFLOAT3 TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		return Cross(Subtract(p1, p0), Subtract(p2, p0));
+	}
+
+	float LargestExtent(const uint32_t* const indices, const size_t indexCount, const SimpleVertex* const vertices)
+	{
+		XMFLOAT3 lower(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 upper(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			const XMFLOAT3& p = vertices[indices[i]].Pos;
+			lower = XMFLOAT3(std::min(lower.x, p.x), std::min(lower.y, p.y), std::min(lower.z, p.z));
+			upper = XMFLOAT3(std::max(upper.x, p.x), std::max(upper.y, p.y), std::max(upper.z, p.z));
+		}
+		return indexCount ? std::max(std::max(upper.x - lower.x, upper.y - lower.y), upper.z - lower.z) : 0.0f;
+	}
+
+	// remap[v] is the first vertex at v's position; wedges link every vertex at a position
+	// into a ring
+	void BuildPositionRemap(const SimpleVertex* const vertices, const size_t vertexCount,
+	                        std::vector<uint32_t>& remap, std::vector<uint32_t>& wedges)
+	{
+		std::vector<uint32_t> order(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+			order[i] = static_cast<uint32_t>(i);
+
+		const auto less = [&](const uint32_t a, const uint32_t b)
+		{
+			const XMFLOAT3& pa = vertices[a].Pos;
+			const XMFLOAT3& pb = vertices[b].Pos;
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			if (pa.z != pb.z) return pa.z < pb.z;
+			return a < b;
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		remap.resize(vertexCount);
+		wedges.resize(vertexCount);
+		for (size_t begin = 0; begin < vertexCount;)
+		{
+			size_t end = begin + 1;
+			const XMFLOAT3& p = vertices[order[begin]].Pos;
+			while (end < vertexCount && vertices[order[end]].Pos.x == p.x && vertices[order[end]].Pos.y == p.y &&
+			       vertices[order[end]].Pos.z == p.z)
+				++end;
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				remap[order[i]] = order[begin];
+				wedges[order[i]] = order[i + 1 < end ? i + 1 : begin];
+			}
+			begin = end;
+		}
+	}
+
+	// The triangles around each vertex
+	struct Adjacency
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		void Build(const std::vector<uint32_t>& indices, const size_t vertexCount)
+		{
+			offsets.assign(vertexCount + 1, 0);
+			for (const uint32_t index : indices)
+				++offsets[index + 1];
+			for (size_t v = 0; v < vertexCount; ++v)
+				offsets[v + 1] += offsets[v];
+
+			triangles.resize(indices.size());
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i)
+				triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// Whether a triangle runs the edge from -> to
+		bool HasEdge(const std::vector<uint32_t>& indices, const uint32_t from, const uint32_t to) const
+		{
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; ++a)
+			{
+				const uint32_t* const corners = &indices[triangles[a] * 3];
+				for (int k = 0; k < 3; ++k)
+				{
+					if (corners[k] == from && corners[(k + 1) % 3] == to)
+						return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	// Marks each vertex with its single open edge out and in, or NO_VERTEX or MANY_VERTICES.
+	// An edge is open when no triangle runs it the other way.
+	void FindOpenEdges(const std::vector<uint32_t>& indices, const Adjacency& adjacency, const size_t vertexCount,
+	                   std::vector<uint32_t>& openOut, std::vector<uint32_t>& openIn)
+	{
+		openOut.assign(vertexCount, NO_VERTEX);
+		openIn.assign(vertexCount, NO_VERTEX);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				const uint32_t from = indices[i + k];
+				const uint32_t to = indices[i + (k + 1) % 3];
+				if (adjacency.HasEdge(indices, to, from))
+					continue;
+
+				openOut[from] = openOut[from] == NO_VERTEX || openOut[from] == to ? to : MANY_VERTICES;
+				openIn[to] = openIn[to] == NO_VERTEX || openIn[to] == from ? from : MANY_VERTICES;
+			}
+		}
+	}
+
+	bool IsSingle(const uint32_t vertex)
+	{
+		return vertex != NO_VERTEX && vertex != MANY_VERTICES;
+	}
+
+	// The wedge of v still referenced, other than v itself, when there is exactly one
+	uint32_t OtherWedge(const uint32_t v, const std::vector<uint32_t>& wedges, const std::vector<uint8_t>& referenced, size_t* wedgeCount)
+	{
+		uint32_t other = NO_VERTEX;
+		size_t count = 1;
+		for (uint32_t w = wedges[v]; w != v; w = wedges[w])
+		{
+			if (referenced[w])
+			{
+				other = w;
+				++count;
+			}
+		}
+		*wedgeCount = count;
+		return count == 2 ? other : NO_VERTEX;
+	}
+
+	void ClassifyVertices(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap, const std::vector<uint32_t>& wedges,
+	                      const std::vector<uint32_t>& openOut, const std::vector<uint32_t>& openIn,
+	                      std::vector<uint8_t>& referenced, std::vector<uint8_t>& kinds)
+	{
+		const size_t vertexCount = remap.size();
+		referenced.assign(vertexCount, 0);
+		for (const uint32_t index : indices)
+			referenced[index] = 1;
+
+		kinds.assign(vertexCount, KIND_LOCKED);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			if (!referenced[v])
+				continue;
+
+			size_t wedgeCount = 0;
+			const uint32_t other = OtherWedge(v, wedges, referenced, &wedgeCount);
+			if (wedgeCount == 1)
+			{
+				if (openOut[v] == NO_VERTEX && openIn[v] == NO_VERTEX)
+					kinds[v] = KIND_MANIFOLD;
+				else if (IsSingle(openOut[v]) && IsSingle(openIn[v]))
+					kinds[v] = KIND_BORDER;
+			}
+			else if (wedgeCount == 2)
+			{
+				// The two sides of a seam run opposite ways between the same positions;
+				// anything else is a border crossing the seam or the seam's end
+				if (IsSingle(openOut[v]) && IsSingle(openIn[v]) && IsSingle(openOut[other]) && IsSingle(openIn[other]) &&
+				    remap[openOut[v]] == remap[openIn[other]] && remap[openIn[v]] == remap[openOut[other]])
+					kinds[v] = KIND_SEAM;
+			}
+		}
+	}
+
+	bool CanCollapse(const uint32_t from, const uint32_t to, const std::vector<uint32_t>& remap, const std::vector<uint8_t>& kinds,
+	                 const std::vector<uint32_t>& openOut, const std::vector<uint32_t>& openIn)
+	{
+		if (remap[from] == remap[to])
+			return false;
+
+		switch (kinds[from])
+		{
+		case KIND_MANIFOLD:
+			return true;
+		case KIND_BORDER:
+			return (kinds[to] == KIND_BORDER || kinds[to] == KIND_LOCKED) && (openOut[from] == to || openIn[from] == to);
+		case KIND_SEAM:
+			return (kinds[to] == KIND_SEAM || kinds[to] == KIND_LOCKED) && (openOut[from] == to || openIn[from] == to);
+		default:
+			return false;
+		}
+	}
+
+	// Whether moving 'from' onto 'to' turns over a triangle that survives the collapse;
+	// counts into 'removed' those that do not
+	bool FlipsTriangle(const uint32_t from, const uint32_t to, const std::vector<uint32_t>& indices,
+	                   const Adjacency& adjacency,
+	                   const std::vector<uint32_t>& collapseRemap, const SimpleVertex* const vertices, size_t* removed)
+	{
+		for (uint32_t a = adjacency.offsets[from]; a < adjacency.offsets[from + 1]; ++a)
+		{
+			const size_t triangle = adjacency.triangles[a];
+			uint32_t corners[3];
+			bool degenerate = false;
+			for (int k = 0; k < 3; ++k)
+			{
+				corners[k] = collapseRemap[indices[triangle * 3 + k]];
+				degenerate |= corners[k] == to;
+			}
+			if (degenerate)
+			{
+				++*removed;
+				continue;
+			}
+
+			XMFLOAT3 before[3];
+			XMFLOAT3 after[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				before[k] = vertices[corners[k]].Pos;
+				after[k] = corners[k] == from ? vertices[to].Pos : before[k];
+			}
+			const XMFLOAT3 normalBefore = TriangleNormal(before[0], before[1], before[2]);
+			const XMFLOAT3 normalAfter = TriangleNormal(after[0], after[1], after[2]);
+			if (Dot(normalBefore, normalAfter) < FLIP_COSINE * sqrtf(Dot(normalBefore, normalBefore) * Dot(normalAfter, normalAfter)))
+				return true;
+		}
+		return false;
+	}
+}
+
+size_t SimplifyMesh(uint32_t* const destination, const uint32_t* const indices, const size_t indexCount, const SimpleVertex* const vertices,
+                    const size_t vertexCount, const size_t targetIndexCount, const float targetError, float* const resultError)
+{
+	if (resultError)
+		*resultError = 0.0f;
+	if (!destination || !indices || !vertices || indexCount % 3 != 0)
+		return 0;
+
+	std::vector<uint32_t> current(indices, indices + indexCount);
+	const float extent = LargestExtent(indices, indexCount, vertices);
+
+	std::vector<uint32_t> remap, wedges;
+	BuildPositionRemap(vertices, vertexCount, remap, wedges);
+
+	Adjacency adjacency;
+	std::vector<uint32_t> openOut, openIn;
+	std::vector<uint8_t> referenced, kinds;
+	adjacency.Build(current, vertexCount);
+	FindOpenEdges(current, adjacency, vertexCount, openOut, openIn);
+	ClassifyVertices(current, remap, wedges, openOut, openIn, referenced, kinds);
+
+	// One quadric per position, so the wedges of a corner share it
+	std::vector<Quadric> quadrics(vertexCount, Quadric());
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		const XMFLOAT3& p0 = vertices[current[i]].Pos;
+		const XMFLOAT3 normal = TriangleNormal(p0, vertices[current[i + 1]].Pos, vertices[current[i + 2]].Pos);
+		const float length = sqrtf(Dot(normal, normal));
+		if (length <= 0.0f)
+			continue;
+
+		const double n[3] = { normal.x / length, normal.y / length, normal.z / length };
+		const double d = -(n[0] * p0.x + n[1] * p0.y + n[2] * p0.z);
+		for (int k = 0; k < 3; ++k)
+			quadrics[remap[current[i + k]]].AddPlane(n, d, 0.5 * length);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const uint32_t from = current[i + k];
+			const uint32_t to = current[i + (k + 1) % 3];
+			if (adjacency.HasEdge(current, to, from))
+				continue;
+
+			const XMFLOAT3 edge = Subtract(vertices[to].Pos, vertices[from].Pos);
+			const XMFLOAT3 across = Cross(edge, normal);
+			const float acrossLength = sqrtf(Dot(across, across));
+			if (acrossLength <= 0.0f)
+				continue;
+
+			const double m[3] = { across.x / acrossLength, across.y / acrossLength, across.z / acrossLength };
+			const double e = -(m[0] * vertices[from].Pos.x + m[1] * vertices[from].Pos.y + m[2] * vertices[from].Pos.z);
+			const double w = BOUNDARY_WEIGHT * Dot(edge, edge);
+			quadrics[remap[from]].AddPlane(m, e, w);
+			quadrics[remap[to]].AddPlane(m, e, w);
+		}
+	}
+
+	const double errorLimit = double(targetError) * extent * double(targetError) * extent;
+	const size_t targetTriangles = targetIndexCount / 3;
+	double largestCost = 0.0;
+
+	std::vector<uint32_t> collapseRemap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	std::vector<Collapse> candidates;
+
+	while (current.size() / 3 > targetTriangles)
+	{
+		// The cheaper allowed direction of every edge within the error limit, cheapest first.
+		// An edge shared by two triangles is taken from the one that runs it upwards.
+		candidates.clear();
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				const uint32_t a = current[i + k];
+				const uint32_t b = current[i + (k + 1) % 3];
+				if (a > b && adjacency.HasEdge(current, b, a))
+					continue;
+
+				const bool ab = CanCollapse(a, b, remap, kinds, openOut, openIn);
+				const bool ba = CanCollapse(b, a, remap, kinds, openOut, openIn);
+				const double costAB = ab ? quadrics[remap[a]].Error(vertices[b].Pos) : DBL_MAX;
+				const double costBA = ba ? quadrics[remap[b]].Error(vertices[a].Pos) : DBL_MAX;
+				if ((ab || ba) && std::min(costAB, costBA) <= errorLimit)
+					candidates.push_back(costAB <= costBA ? Collapse{ a, b, costAB } : Collapse{ b, a, costBA });
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			collapseRemap[v] = v;
+		std::fill(touched.begin(), touched.end(), 0);
+
+		// Each corner moves at most once a pass, so the costs stay true to the quadrics
+		const size_t triangleCount = current.size() / 3;
+		size_t removed = 0;
+		size_t collapses = 0;
+		double passCost = 0.0;
+		for (const Collapse& candidate : candidates)
+		{
+			if (triangleCount - removed <= targetTriangles)
+				break;
+
+			const uint32_t from = candidate.from;
+			const uint32_t to = candidate.to;
+			if (touched[remap[from]] || touched[remap[to]])
+				continue;
+
+			// A seam corner takes its other wedge to the matching wedge across the edge
+			uint32_t wedgeFrom = NO_VERTEX;
+			uint32_t wedgeTo = NO_VERTEX;
+			if (kinds[from] == KIND_SEAM)
+			{
+				size_t wedgeCount = 0;
+				wedgeFrom = OtherWedge(from, wedges, referenced, &wedgeCount);
+				wedgeTo = openOut[from] == to ? openIn[wedgeFrom] : openOut[wedgeFrom];
+				if (!IsSingle(wedgeTo) || remap[wedgeTo] != remap[to])
+					continue;
+			}
+
+			size_t collapseRemoved = 0;
+			if (FlipsTriangle(from, to, current, adjacency, collapseRemap, vertices, &collapseRemoved) ||
+			    (wedgeFrom != NO_VERTEX && FlipsTriangle(wedgeFrom, wedgeTo, current, adjacency, collapseRemap, vertices, &collapseRemoved)))
+				continue;
+
+			collapseRemap[from] = to;
+			if (wedgeFrom != NO_VERTEX)
+				collapseRemap[wedgeFrom] = wedgeTo;
+
+			quadrics[remap[to]].Add(quadrics[remap[from]]);
+			touched[remap[from]] = 1;
+			touched[remap[to]] = 1;
+			passCost = std::max(passCost, candidate.cost);
+			removed += collapseRemoved;
+			++collapses;
+		}
+
+		// Once the cheap collapses are spent, each pass only frees the next one along a
+		// chain; the few triangles left to gain are not worth a pass apiece. What the pass
+		// merged is dropped with it, its cost included, so the error matches the result.
+		if (!collapses || removed < triangleCount / 1000)
+			break;
+		largestCost = std::max(largestCost, passCost);
+
+		// Apply the pass and drop the triangles it closed up
+		size_t write = 0;
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			const uint32_t a = collapseRemap[current[i]];
+			const uint32_t b = collapseRemap[current[i + 1]];
+			const uint32_t c = collapseRemap[current[i + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+			current[write++] = a;
+			current[write++] = b;
+			current[write++] = c;
+		}
+		current.resize(write);
+
+		adjacency.Build(current, vertexCount);
+		FindOpenEdges(current, adjacency, vertexCount, openOut, openIn);
+		ClassifyVertices(current, remap, wedges, openOut, openIn, referenced, kinds);
+	}
+
+	if (resultError)
+		*resultError = extent > 0.0f ? static_cast<float>(sqrt(largestCost)) / extent : 0.0f;
+	if (!current.empty())
+		memcpy(destination, current.data(), current.size() * sizeof(uint32_t));
+	return current.size();
+}
+
+size_t BuildLodChain(const uint32_t* const indices, const size_t indexCount, const SimpleVertex* const vertices, const size_t vertexCount,
+                     const size_t maxLods, const float maxError, std::vector<uint32_t>& lodIndices, MESH_CACHE_LOD* const lods)
+{
+	lodIndices.assign(indices, indices + indexCount);
+	if (!maxLods || !lods)
+		return 0;
+
+	lods[0] = MESH_CACHE_LOD();
+	lods[0].indexCount = static_cast<uint32_t>(indexCount);
+
+	const float extent = LargestExtent(indices, indexCount, vertices);
+	std::vector<uint32_t> simplified(indexCount);
+	size_t lodCount = 1;
+	size_t previousCount = indexCount;
+	while (lodCount < maxLods)
+	{
+		float error = 0.0f;
+		const size_t target = previousCount / 6 * 3;
+		const size_t count = SimplifyMesh(simplified.data(), indices, indexCount, vertices, vertexCount, target, maxError, &error);
+		if (!count || count > previousCount / 4 * 3)
+			break;
+
+		MESH_CACHE_LOD& lod = lods[lodCount++];
+		lod = MESH_CACHE_LOD();
+		lod.indexOffset = static_cast<uint32_t>(lodIndices.size());
+		lod.indexCount = static_cast<uint32_t>(count);
+		lod.error = std::max(error * extent, lods[lodCount - 2].error);   // SelectMeshLod expects it never to shrink
+		lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.begin() + count);
+		previousCount = count;
+	}
+	return lodCount;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "MeshCache.h"
+#include "SimpleVertex.h"
+
+//--------------------------------------------------------------------------------------
+// Quadric edge-collapse simplification of a triangle list. Vertices are never moved or
+// added: each collapse merges one vertex into a neighbour, so every level of detail
+// indexes the vertex buffer of the full mesh.
+//
+// Vertices that share a position are wedges of one corner, split by a UV or normal seam.
+// A corner on a seam only slides along the seam, taking its wedges with it, and one on an
+// open border only slides along the border; corners where seams or borders meet never
+// move. Errors are distances from the original surface as a fraction of the largest
+// extent of the mesh bounds.
+//--------------------------------------------------------------------------------------
+
+// Writes at most indexCount indices to 'destination', which may be 'indices'. Collapses
+// stop once the triangles are down to targetIndexCount / 3 or the next collapse would
+// exceed targetError. Returns the index count written; resultError, if given, receives
+// the largest error of a collapse made.
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const SimpleVertex* vertices,
+                    size_t vertexCount, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+// Builds up to maxLods levels into 'lodIndices': level 0 is the indices as given and each
+// further level aims at half the triangles of the one before, simplified from level 0.
+// Stops at the first level that would exceed maxError or remove less than a quarter of
+// the triangles. Each entry of 'lods' gets its range of lodIndices and its error in model
+// units. Returns how many levels were built.
+size_t BuildLodChain(const uint32_t* indices, size_t indexCount, const SimpleVertex* vertices, size_t vertexCount,
+                     size_t maxLods, float maxError, std::vector<uint32_t>& lodIndices, MESH_CACHE_LOD* lods);
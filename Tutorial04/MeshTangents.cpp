@@ -0,0 +1,144 @@
+#include "MeshTangents.h"
+#include "ThreadPool.h"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	// Triangles per block below which the pool is not worth waking; vertices per task
+	// when the partials are added up
+	const size_t TRIANGLE_GRAIN = 64 * 1024;
+	const size_t VERTEX_GRAIN = 32 * 1024;
+
+	// Sums for vertices [first, first + sums.size()): tangent in xyz, and in w the corner
+	// angles of the triangles around it, negative for those whose UVs are mirrored
+	struct TangentPartial
+	{
+		size_t first = 0;
+		std::vector<XMFLOAT4> sums;
+	};
+
+	// 'v' with its component along the unit normal 'n' taken out
+	XMVECTOR Project(FXMVECTOR v, FXMVECTOR n)
+	{
+		return XMVectorNegativeMultiplySubtract(n, XMVector3Dot(n, v), v);
+	}
+
+	void AccumulateTriangle(const uint32_t* const triangle, const SimpleVertex* const vertices, TangentPartial& partial)
+	{
+		const SimpleVertex* const corners[3] = { &vertices[triangle[0]], &vertices[triangle[1]], &vertices[triangle[2]] };
+		const XMVECTOR positions[3] =
+		{
+			XMLoadFloat3(&corners[0]->Pos),
+			XMLoadFloat3(&corners[1]->Pos),
+			XMLoadFloat3(&corners[2]->Pos),
+		};
+
+		const float s1 = corners[1]->TexCoord.x - corners[0]->TexCoord.x;
+		const float t1 = corners[1]->TexCoord.y - corners[0]->TexCoord.y;
+		const float s2 = corners[2]->TexCoord.x - corners[0]->TexCoord.x;
+		const float t2 = corners[2]->TexCoord.y - corners[0]->TexCoord.y;
+		const float area = s1 * t2 - s2 * t1;
+		if (area == 0.0f)
+			return;
+
+		// dP/du and dP/dv, up to a positive scale
+		const float scale = area > 0.0f ? 1.0f : -1.0f;
+		const XMVECTOR e1 = XMVectorSubtract(positions[1], positions[0]);
+		const XMVECTOR e2 = XMVectorSubtract(positions[2], positions[0]);
+		const XMVECTOR tangent = XMVector3Normalize(XMVectorScale(XMVectorSubtract(XMVectorScale(e1, t2), XMVectorScale(e2, t1)), scale));
+		const XMVECTOR bitangent = XMVectorScale(XMVectorSubtract(XMVectorScale(e2, s1), XMVectorScale(e1, s2)), scale);
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			const XMVECTOR normal = XMLoadFloat3(&corners[corner]->Normal);
+			const XMVECTOR toNext = XMVector3Normalize(Project(XMVectorSubtract(positions[(corner + 1) % 3], positions[corner]), normal));
+			const XMVECTOR toPrevious = XMVector3Normalize(Project(XMVectorSubtract(positions[(corner + 2) % 3], positions[corner]), normal));
+			const float angle = acosf(std::min(std::max(XMVectorGetX(XMVector3Dot(toNext, toPrevious)), -1.0f), 1.0f));
+
+			// Mirrored where v runs against cross(normal, tangent), whichever way the triangle winds
+			const XMVECTOR projected = XMVector3Normalize(Project(tangent, normal));
+			const float orientation = XMVectorGetX(XMVector3Dot(XMVector3Cross(normal, projected), bitangent)) < 0.0f ? -1.0f : 1.0f;
+			const XMVECTOR weighted = XMVectorSetW(XMVectorScale(projected, angle), orientation * angle);
+			XMFLOAT4& sum = partial.sums[triangle[corner] - partial.first];
+			XMStoreFloat4(&sum, XMVectorAdd(XMLoadFloat4(&sum), weighted));
+		}
+	}
+
+	void AccumulateBlock(const uint32_t* const indices, const size_t begin, const size_t end, const SimpleVertex* const vertices,
+	                     TangentPartial& partial)
+	{
+		if (begin >= end)
+			return;
+
+		const auto range = std::minmax_element(indices + begin * 3, indices + end * 3);
+		partial.first = *range.first;
+		partial.sums.assign(*range.second - *range.first + 1, XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+		for (size_t t = begin; t < end; ++t)
+			AccumulateTriangle(indices + t * 3, vertices, partial);
+	}
+
+	void FinishVertex(const XMFLOAT4& sum, SimpleVertex& vertex)
+	{
+		const XMVECTOR normal = XMLoadFloat3(&vertex.Normal);
+		XMVECTOR tangent = XMVector3Normalize(Project(XMLoadFloat4(&sum), normal));
+		if (XMVectorGetX(XMVector3LengthSq(tangent)) == 0.0f)
+		{
+			// Any direction across the normal, from the axis least along it
+			const XMVECTOR axis = fabsf(vertex.Normal.x) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			tangent = XMVector3Normalize(Project(axis, normal));
+		}
+
+		XMStoreFloat3(&vertex.Tangent, tangent);
+		XMStoreFloat3(&vertex.BiNormal, XMVectorScale(XMVector3Cross(normal, tangent), sum.w < 0.0f ? -1.0f : 1.0f));
+	}
+}
+
+void GenerateTangents(const uint32_t* const indices, const size_t indexCount, SimpleVertex* const vertices, const size_t vertexCount,
+                      ThreadPool* const pool)
+{
+	if (!indices || !vertices || !vertexCount)
+		return;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		if (indices[i] >= vertexCount)
+			return;
+	}
+
+	const size_t triangleCount = indexCount / 3;
+	const size_t blockCount = pool ? std::max<size_t>(std::min<size_t>(pool->ThreadCount() + 1, triangleCount / TRIANGLE_GRAIN), 1) : 1;
+	std::vector<TangentPartial> partials(blockCount);
+	const auto accumulate = [&](const size_t begin, const size_t end)
+	{
+		for (size_t block = begin; block < end; ++block)
+			AccumulateBlock(indices, triangleCount * block / blockCount, triangleCount * (block + 1) / blockCount, vertices, partials[block]);
+	};
+
+	// Every vertex's sum is read by the one task that finishes it
+	const auto finish = [&](const size_t begin, const size_t end)
+	{
+		std::vector<XMFLOAT4> sums(end - begin, XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+		for (const TangentPartial& partial : partials)
+		{
+			const size_t first = std::max(begin, partial.first);
+			const size_t last = std::min(end, partial.first + partial.sums.size());
+			for (size_t v = first; v < last; ++v)
+				XMStoreFloat4(&sums[v - begin], XMVectorAdd(XMLoadFloat4(&sums[v - begin]), XMLoadFloat4(&partial.sums[v - partial.first])));
+		}
+		for (size_t v = begin; v < end; ++v)
+			FinishVertex(sums[v - begin], vertices[v]);
+	};
+
+	if (blockCount > 1)
+	{
+		pool->ParallelFor(blockCount, 1, accumulate);
+		pool->ParallelFor(vertexCount, VERTEX_GRAIN, finish);
+	}
+	else
+	{
+		accumulate(0, 1);
+		finish(0, vertexCount);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SimpleVertex.h"
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// Tangent space for normal mapping, built the way MikkTSpace builds it so maps baked
+// against that convention shade without seams:
+//
+//   each triangle's direction of increasing u is projected into the plane of each corner's
+//   normal and summed at the corner's vertex, weighted by the angle the triangle makes
+//   there; the sum is made orthogonal to the normal, and the bitangent is
+//   cross(normal, tangent), negated where the UVs are mirrored
+//
+// MikkTSpace splits a vertex whose triangles disagree on mirroring; here the vertex takes
+// the side that covers the larger angle, as the index buffer cannot split it. Triangles
+// with no UV area add nothing, and vertices left without a tangent get any direction
+// perpendicular to their normal.
+//--------------------------------------------------------------------------------------
+
+// Overwrites Tangent and BiNormal of every vertex from Pos, Normal and TexCoord. Large
+// meshes are split over the pool into blocks of triangles, each summing into its own
+// partial over the vertex range it touches, so no two threads write the same sum; the
+// partials are then added per vertex. Where vertices come in about the order the
+// triangles use them, as OBJ and OptimizeVertexFetch leave them, those ranges barely
+// overlap.
+void GenerateTangents(const uint32_t* indices, size_t indexCount, SimpleVertex* vertices, size_t vertexCount,
+                      ThreadPool* pool = nullptr);
@@ -0,0 +1,577 @@
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <new>
+#include <string.h>
+#include <vector>
+
+// Filtering works on one RGBA float4 per texel, which maps onto a single SSE register;
+// the RGBA8 conversions and the box filter of an RGBA8 top level work on several texels
+// per register instead. The scalar path is kept for other targets and as the reference.
+#if defined(_M_IX86) || defined(_M_X64)
+#define MIP_GEN_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	enum PIXEL_LAYOUT
+	{
+		LAYOUT_UNKNOWN,
+		LAYOUT_RGBA8,
+		LAYOUT_RGBA8_SRGB,
+		LAYOUT_RGBA16F,
+		LAYOUT_R32F,
+	};
+
+	PIXEL_LAYOUT GetLayout(const DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			return LAYOUT_RGBA8;
+
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			return LAYOUT_RGBA8_SRGB;
+
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			return LAYOUT_RGBA16F;
+
+		case DXGI_FORMAT_R32_FLOAT:
+			return LAYOUT_R32F;
+
+		default:
+			return LAYOUT_UNKNOWN;
+		}
+	}
+
+	size_t BytesPerPixel(const PIXEL_LAYOUT layout)
+	{
+		return layout == LAYOUT_RGBA16F ? 8 : 4;
+	}
+
+	const int KAISER_TAPS = 8;
+	const int LINEAR_TO_SRGB_ENTRIES = 4096;
+
+	double BesselI0(const double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x * 0.5 / k) * (x * 0.5 / k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	// Tables built once on first use
+	struct MipTables
+	{
+		float srgbToLinear[256];
+		uint8_t linearToSRGB[LINEAR_TO_SRGB_ENTRIES];   // indexed by sqrt(linear), which puts the entries where the curve is steep
+		float kaiser[KAISER_TAPS];                      // source texels 2x-3 .. 2x+4 for destination texel x
+
+		MipTables()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const double c = i / 255.0;
+				srgbToLinear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+			}
+
+			for (int i = 0; i < LINEAR_TO_SRGB_ENTRIES; ++i)
+			{
+				const double root = static_cast<double>(i) / (LINEAR_TO_SRGB_ENTRIES - 1);
+				const double linear = root * root;
+				const double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow(linear, 1.0 / 2.4) - 0.055;
+				linearToSRGB[i] = static_cast<uint8_t>(std::min(c * 255.0 + 0.5, 255.0));
+			}
+
+			// Windowed sinc at half the source rate, centred between texels 2x and 2x+1
+			const double pi = 3.14159265358979323846;
+			const double alpha = 4.0;
+			const double radius = 4.0;
+			double sum = 0.0;
+			double weights[KAISER_TAPS];
+			for (int t = 0; t < KAISER_TAPS; ++t)
+			{
+				const double distance = t - 3.5;
+				const double x = distance * 0.5;
+				const double sinc = sin(pi * x) / (pi * x);
+				const double ratio = distance / radius;
+				weights[t] = sinc * BesselI0(alpha * sqrt(1.0 - ratio * ratio)) / BesselI0(alpha);
+				sum += weights[t];
+			}
+			for (int t = 0; t < KAISER_TAPS; ++t)
+				kaiser[t] = static_cast<float>(weights[t] / sum);
+		}
+	};
+
+	const MipTables& GetTables()
+	{
+		static const MipTables tables;
+		return tables;
+	}
+
+#ifdef MIP_GEN_SSE2
+	typedef __m128 Pixel;
+
+	inline Pixel LoadPixel(const float* p) { return _mm_loadu_ps(p); }
+	inline void StorePixel(float* p, const Pixel value) { _mm_storeu_ps(p, value); }
+	inline Pixel ZeroPixel() { return _mm_setzero_ps(); }
+	inline Pixel AddPixels(const Pixel a, const Pixel b) { return _mm_add_ps(a, b); }
+	inline Pixel ScalePixel(const Pixel a, const float scale) { return _mm_mul_ps(a, _mm_set1_ps(scale)); }
+#else
+	struct Pixel
+	{
+		float c[4];
+	};
+
+	inline Pixel LoadPixel(const float* p) { Pixel value; memcpy(value.c, p, sizeof(value.c)); return value; }
+	inline void StorePixel(float* p, const Pixel& value) { memcpy(p, value.c, sizeof(value.c)); }
+	inline Pixel ZeroPixel() { return Pixel{}; }
+
+	inline Pixel AddPixels(const Pixel& a, const Pixel& b)
+	{
+		Pixel sum;
+		for (int i = 0; i < 4; ++i)
+			sum.c[i] = a.c[i] + b.c[i];
+		return sum;
+	}
+
+	inline Pixel ScalePixel(const Pixel& a, const float scale)
+	{
+		Pixel scaled;
+		for (int i = 0; i < 4; ++i)
+			scaled.c[i] = a.c[i] * scale;
+		return scaled;
+	}
+#endif
+
+	void ToFloatRow(const PIXEL_LAYOUT layout, const bool srgb, const uint8_t* source, const size_t width, float* dest)
+	{
+		const MipTables& tables = GetTables();
+		switch (layout)
+		{
+		case LAYOUT_RGBA8:
+		case LAYOUT_RGBA8_SRGB:
+			if (srgb)
+			{
+				for (size_t x = 0; x < width; ++x, source += 4, dest += 4)
+				{
+					dest[0] = tables.srgbToLinear[source[0]];
+					dest[1] = tables.srgbToLinear[source[1]];
+					dest[2] = tables.srgbToLinear[source[2]];
+					dest[3] = source[3] * (1.0f / 255.0f);
+				}
+				break;
+			}
+#ifdef MIP_GEN_SSE2
+		{
+			// Four texels per load, widened to 16 and then 32 bits per channel
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+			size_t x = 0;
+			for (; x + 4 <= width; x += 4, source += 16, dest += 16)
+			{
+				const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+				const __m128i low = _mm_unpacklo_epi8(texels, zero);
+				const __m128i high = _mm_unpackhi_epi8(texels, zero);
+				_mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+				_mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+				_mm_storeu_ps(dest + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+				_mm_storeu_ps(dest + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+			}
+			for (size_t i = 0; i < (width - x) * 4; ++i)
+				dest[i] = source[i] * (1.0f / 255.0f);
+		}
+#else
+			for (size_t i = 0; i < width * 4; ++i)
+				dest[i] = source[i] * (1.0f / 255.0f);
+#endif
+			break;
+
+		case LAYOUT_RGBA16F:
+		{
+			const HALF* halves = reinterpret_cast<const HALF*>(source);
+			for (size_t i = 0; i < width * 4; ++i)
+				dest[i] = XMConvertHalfToFloat(halves[i]);
+			break;
+		}
+
+		case LAYOUT_R32F:
+		{
+			const float* values = reinterpret_cast<const float*>(source);
+			for (size_t x = 0; x < width; ++x, dest += 4)
+			{
+				dest[0] = values[x];
+				dest[1] = dest[2] = dest[3] = 0.0f;
+			}
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	void FromFloatRow(const PIXEL_LAYOUT layout, const bool srgb, const float* source, size_t width, uint8_t* dest)
+	{
+		const MipTables& tables = GetTables();
+		switch (layout)
+		{
+		case LAYOUT_RGBA8:
+		case LAYOUT_RGBA8_SRGB:
+#ifdef MIP_GEN_SSE2
+			if (!srgb)
+			{
+				// Four texels per store: round all sixteen channels, then narrow to bytes
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 scale = _mm_set1_ps(255.0f);
+				const __m128 half = _mm_set1_ps(0.5f);
+				const auto toUnorm = [&](const float* const texel)
+				{
+					const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texel), zero), one);
+					return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+				};
+				for (; width >= 4; width -= 4, source += 16, dest += 16)
+				{
+					const __m128i low = _mm_packs_epi32(toUnorm(source), toUnorm(source + 4));
+					const __m128i high = _mm_packs_epi32(toUnorm(source + 8), toUnorm(source + 12));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_packus_epi16(low, high));
+				}
+			}
+			for (size_t x = 0; x < width; ++x, source += 4, dest += 4)
+			{
+				const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+				const __m128i unorm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+				if (srgb)
+				{
+					alignas(16) int32_t index[4];
+					const __m128 root = _mm_sqrt_ps(value);
+					_mm_store_si128(reinterpret_cast<__m128i*>(index),
+					                _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(root, _mm_set1_ps(LINEAR_TO_SRGB_ENTRIES - 1.0f)), _mm_set1_ps(0.5f))));
+					dest[0] = tables.linearToSRGB[index[0]];
+					dest[1] = tables.linearToSRGB[index[1]];
+					dest[2] = tables.linearToSRGB[index[2]];
+					dest[3] = static_cast<uint8_t>(_mm_cvtsi128_si32(_mm_srli_si128(unorm, 12)));
+				}
+				else
+				{
+					const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(unorm, unorm), unorm);
+					const uint32_t texel = static_cast<uint32_t>(_mm_cvtsi128_si32(packed));
+					memcpy(dest, &texel, 4);
+				}
+			}
+#else
+			for (size_t x = 0; x < width; ++x, source += 4, dest += 4)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					const float value = std::min(std::max(source[c], 0.0f), 1.0f);
+					if (srgb && c < 3)
+						dest[c] = tables.linearToSRGB[static_cast<int>(sqrtf(value) * (LINEAR_TO_SRGB_ENTRIES - 1.0f) + 0.5f)];
+					else
+						dest[c] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+				}
+			}
+#endif
+			break;
+
+		case LAYOUT_RGBA16F:
+		{
+			HALF* halves = reinterpret_cast<HALF*>(dest);
+			for (size_t i = 0; i < width * 4; ++i)
+				halves[i] = XMConvertFloatToHalf(source[i]);
+			break;
+		}
+
+		case LAYOUT_R32F:
+		{
+			float* values = reinterpret_cast<float*>(dest);
+			for (size_t x = 0; x < width; ++x)
+				values[x] = source[x * 4];
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	// One level of one slice. The top level is only ever read through 'bytes', a row at a
+	// time, so a full resolution float copy of it never exists; lower levels are kept in
+	// float so rounding does not build up down the chain.
+	struct Level
+	{
+		size_t width;
+		size_t height;
+		uint8_t* bytes;
+		size_t rowPitch;
+		float* texels;   // null for the top level
+
+		const float* Row(const size_t y, const PIXEL_LAYOUT layout, const bool srgb, float* scratch) const
+		{
+			if (texels)
+				return texels + y * width * 4;
+
+			ToFloatRow(layout, srgb, bytes + y * rowPitch, width, scratch);
+			return scratch;
+		}
+	};
+
+	void BoxRow(const float* row0, const float* row1, const size_t sourceWidth, float* dest, const size_t destWidth)
+	{
+		for (size_t x = 0; x < destWidth; ++x)
+		{
+			const size_t x0 = std::min(x * 2, sourceWidth - 1) * 4;
+			const size_t x1 = std::min(x * 2 + 1, sourceWidth - 1) * 4;
+			const Pixel sum = AddPixels(AddPixels(LoadPixel(row0 + x0), LoadPixel(row0 + x1)), AddPixels(LoadPixel(row1 + x0), LoadPixel(row1 + x1)));
+			StorePixel(dest + x * 4, ScalePixel(sum, 0.25f));
+		}
+	}
+
+#ifdef MIP_GEN_SSE2
+	// The box filter straight from two rows of a linear RGBA8 level, which skips converting
+	// the whole top level to float and back. Each 16-byte load holds four texels, whose
+	// channels are widened to 16 bits and summed over both rows and each pair of columns,
+	// two destination texels per load. The sums are exact, so the bytes are rounded from
+	// them directly and the float texels are the same sums scaled.
+	void BoxRowRGBA8(const uint8_t* row0, const uint8_t* row1, const size_t sourceWidth, float* dest, uint8_t* destBytes,
+	                 const size_t destWidth)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		const __m128 scale = _mm_set1_ps(1.0f / (4.0f * 255.0f));
+		size_t x = 0;
+		for (; x + 2 <= destWidth && x * 2 + 4 <= sourceWidth; x += 2)
+		{
+			const __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+			const __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+			const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+			const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+			const __m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+			_mm_storeu_ps(dest + x * 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(sums, zero)), scale));
+			_mm_storeu_ps(dest + x * 4 + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(sums, zero)), scale));
+			const __m128i rounded = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(destBytes + x * 4), _mm_packus_epi16(rounded, rounded));
+		}
+
+		for (; x < destWidth; ++x)
+		{
+			const size_t x0 = std::min(x * 2, sourceWidth - 1) * 4;
+			const size_t x1 = std::min(x * 2 + 1, sourceWidth - 1) * 4;
+			for (size_t c = 0; c < 4; ++c)
+			{
+				const unsigned int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+				dest[x * 4 + c] = sum * (1.0f / (4.0f * 255.0f));
+				destBytes[x * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+#endif
+
+	void KaiserRow(const float* row, const size_t sourceWidth, float* dest, const size_t destWidth)
+	{
+		const float* weights = GetTables().kaiser;
+		for (size_t x = 0; x < destWidth; ++x)
+		{
+			Pixel sum = ZeroPixel();
+			for (int t = 0; t < KAISER_TAPS; ++t)
+			{
+				const ptrdiff_t source = static_cast<ptrdiff_t>(x * 2) + t - 3;
+				const size_t clamped = static_cast<size_t>(std::min(std::max<ptrdiff_t>(source, 0), static_cast<ptrdiff_t>(sourceWidth) - 1));
+				sum = AddPixels(sum, ScalePixel(LoadPixel(row + clamped * 4), weights[t]));
+			}
+			StorePixel(dest + x * 4, sum);
+		}
+	}
+
+	void KaiserColumn(const float* columns, const size_t sourceHeight, const size_t width, const size_t y, float* dest)
+	{
+		const float* weights = GetTables().kaiser;
+		const float* rows[KAISER_TAPS];
+		for (int t = 0; t < KAISER_TAPS; ++t)
+		{
+			const ptrdiff_t source = static_cast<ptrdiff_t>(y * 2) + t - 3;
+			rows[t] = columns + std::min(std::max<ptrdiff_t>(source, 0), static_cast<ptrdiff_t>(sourceHeight) - 1) * width * 4;
+		}
+
+		for (size_t x = 0; x < width; ++x)
+		{
+			Pixel sum = ZeroPixel();
+			for (int t = 0; t < KAISER_TAPS; ++t)
+				sum = AddPixels(sum, ScalePixel(LoadPixel(rows[t] + x * 4), weights[t]));
+			StorePixel(dest + x * 4, sum);
+		}
+	}
+
+	// Runs body over 'rows' rows, a few thousand texels at a time per task
+	void ForEachRow(ThreadPool* const pool, const size_t rows, const size_t rowWidth, const std::function<void(size_t begin, size_t end)>& body)
+	{
+		if (pool)
+			pool->ParallelFor(rows, std::max<size_t>(1, 4096 / rowWidth), body);
+		else
+			body(0, rows);
+	}
+}
+
+bool IsMipGenFormat(const DXGI_FORMAT format)
+{
+	return GetLayout(format) != LAYOUT_UNKNOWN;
+}
+
+size_t MipLevelCount(size_t width, size_t height)
+{
+	size_t levels = 1;
+	while (width > 1 || height > 1)
+	{
+		width = std::max<size_t>(width / 2, 1);
+		height = std::max<size_t>(height / 2, 1);
+		++levels;
+	}
+	return levels;
+}
+
+size_t MipChainSize(const DXGI_FORMAT format, size_t width, size_t height, const size_t arraySize)
+{
+	const size_t bytesPerPixel = BytesPerPixel(GetLayout(format));
+	size_t sliceBytes = 0;
+	for (size_t level = MipLevelCount(width, height); level > 0; --level)
+	{
+		sliceBytes += width * height * bytesPerPixel;
+		width = std::max<size_t>(width / 2, 1);
+		height = std::max<size_t>(height / 2, 1);
+	}
+	return sliceBytes * arraySize;
+}
+
+HRESULT GenerateMipChain(const DXGI_FORMAT format, const size_t width, const size_t height, const size_t arraySize, const uint8_t* const source,
+                         const MIP_FILTER filter, const bool treatAsSRGB, uint8_t* const dest, ThreadPool* const pool)
+{
+	const PIXEL_LAYOUT layout = GetLayout(format);
+	if (layout == LAYOUT_UNKNOWN)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	if (!source || !dest || width == 0 || height == 0 || arraySize == 0)
+		return E_INVALIDARG;
+
+	const bool srgb = layout == LAYOUT_RGBA8_SRGB || (layout == LAYOUT_RGBA8 && treatAsSRGB);
+	const size_t bytesPerPixel = BytesPerPixel(layout);
+	const size_t levelCount = MipLevelCount(width, height);
+	const size_t sliceBytes = MipChainSize(format, width, height, 1);
+
+	std::vector<Level> levels(levelCount * arraySize);
+	size_t texelCount[2] = {};
+	for (size_t item = 0; item < arraySize; ++item)
+	{
+		size_t w = width;
+		size_t h = height;
+		uint8_t* bytes = dest + item * sliceBytes;
+		for (size_t level = 0; level < levelCount; ++level)
+		{
+			levels[item * levelCount + level] = Level{ w, h, bytes, w * bytesPerPixel, nullptr };
+			if (level > 0)
+				texelCount[level & 1] = std::max(texelCount[level & 1], w * h);
+			bytes += w * h * bytesPerPixel;
+			w = std::max<size_t>(w / 2, 1);
+			h = std::max<size_t>(h / 2, 1);
+		}
+
+		memcpy(levels[item * levelCount].bytes, source + item * width * height * bytesPerPixel, width * height * bytesPerPixel);
+	}
+
+	// Two float levels per slice are live at a time, odd ones in one buffer and even ones in
+	// the other; the Kaiser filter also keeps the horizontally filtered rows of the level it
+	// reads. Every texel is written before it is read, so none of these is cleared.
+	std::unique_ptr<float[]> texels[2];
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (!texelCount[i])
+			continue;
+		texels[i].reset(new (std::nothrow) float[texelCount[i] * arraySize * 4]);
+		if (!texels[i])
+			return E_OUTOFMEMORY;
+	}
+	std::unique_ptr<float[]> columns;
+	if (filter == MIP_FILTER_KAISER)
+	{
+		columns.reset(new (std::nothrow) float[std::max<size_t>(width / 2, 1) * height * arraySize * 4]);
+		if (!columns)
+			return E_OUTOFMEMORY;
+	}
+
+	for (size_t level = 1; level < levelCount; ++level)
+	{
+		const size_t sourceWidth = levels[level - 1].width;
+		const size_t sourceHeight = levels[level - 1].height;
+		const size_t destWidth = levels[level].width;
+		const size_t destHeight = levels[level].height;
+
+		float* const output = texels[level & 1].get();
+		for (size_t item = 0; item < arraySize; ++item)
+			levels[item * levelCount + level].texels = output + item * destWidth * destHeight * 4;
+
+		if (filter == MIP_FILTER_KAISER)
+		{
+			ForEachRow(pool, sourceHeight * arraySize, sourceWidth, [&](const size_t begin, const size_t end)
+			{
+				std::vector<float> scratch(sourceWidth * 4);
+				for (size_t row = begin; row < end; ++row)
+				{
+					const size_t item = row / sourceHeight;
+					const size_t y = row % sourceHeight;
+					const Level& from = levels[item * levelCount + level - 1];
+					KaiserRow(from.Row(y, layout, srgb, scratch.data()), sourceWidth, columns.get() + row * destWidth * 4, destWidth);
+				}
+			});
+		}
+
+		ForEachRow(pool, destHeight * arraySize, destWidth, [&](const size_t begin, const size_t end)
+		{
+			std::vector<float> scratch(sourceWidth * 8);
+			for (size_t row = begin; row < end; ++row)
+			{
+				const size_t item = row / destHeight;
+				const size_t y = row % destHeight;
+				const Level& from = levels[item * levelCount + level - 1];
+				const Level& to = levels[item * levelCount + level];
+				float* const destRow = to.texels + y * destWidth * 4;
+
+				if (filter == MIP_FILTER_KAISER)
+				{
+					KaiserColumn(columns.get() + item * sourceHeight * destWidth * 4, sourceHeight, destWidth, y, destRow);
+				}
+#ifdef MIP_GEN_SSE2
+				else if (!from.texels && layout == LAYOUT_RGBA8 && !srgb)
+				{
+					const uint8_t* const row0 = from.bytes + std::min(y * 2, sourceHeight - 1) * from.rowPitch;
+					const uint8_t* const row1 = from.bytes + std::min(y * 2 + 1, sourceHeight - 1) * from.rowPitch;
+					BoxRowRGBA8(row0, row1, sourceWidth, destRow, to.bytes + y * to.rowPitch, destWidth);
+					continue;
+				}
+#endif
+				else
+				{
+					const float* row0 = from.Row(std::min(y * 2, sourceHeight - 1), layout, srgb, scratch.data());
+					const float* row1 = from.Row(std::min(y * 2 + 1, sourceHeight - 1), layout, srgb, scratch.data() + sourceWidth * 4);
+					BoxRow(row0, row1, sourceWidth, destRow, destWidth);
+				}
+
+				FromFloatRow(layout, srgb, destRow, destWidth, to.bytes + y * to.rowPitch);
+			}
+		});
+	}
+
+	return S_OK;
+}
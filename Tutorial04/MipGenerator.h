@@ -0,0 +1,33 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// CPU mip chain generation for DDS files that ship without mips, so textures the device
+// cannot (or is not asked to) GenerateMips for still minify cleanly. Handles the plain
+// uncompressed formats: RGBA8/BGRA8 (UNORM and sRGB), RGBA16F and R32F. sRGB data is
+// filtered in linear space.
+//--------------------------------------------------------------------------------------
+enum MIP_FILTER
+{
+	MIP_FILTER_BOX,     // 2x2 average, cheapest
+	MIP_FILTER_KAISER,  // 8-tap Kaiser-windowed sinc, sharper and without the box's aliasing
+};
+
+bool IsMipGenFormat(DXGI_FORMAT format);
+
+// Levels in a full chain down to 1x1
+size_t MipLevelCount(size_t width, size_t height);
+
+// Bytes needed for the full chains of 'arraySize' slices
+size_t MipChainSize(DXGI_FORMAT format, size_t width, size_t height, size_t arraySize);
+
+// Builds the full chain for 'arraySize' 2D slices whose top levels are packed one after
+// another in 'source'. dest receives MipChainSize bytes in the order FillInitData reads
+// them: every level of slice 0, then every level of slice 1, and so on. treatAsSRGB also
+// filters UNORM data in linear space, for callers that load it with forceSRGB. Each level
+// is spread over the pool by rows of every slice.
+HRESULT GenerateMipChain(DXGI_FORMAT format, size_t width, size_t height, size_t arraySize, const uint8_t* source,
+                         MIP_FILTER filter, bool treatAsSRGB, uint8_t* dest, ThreadPool* pool = nullptr);
@@ -0,0 +1,446 @@
+#include "ObjReader.h"
+#include "ThreadPool.h"
+#include <math.h>
+#include <string.h>
+
+// Line ends are looked for sixteen bytes at a time
+#if defined(_M_IX86) || defined(_M_X64)
+#define OBJ_READER_SSE2
+#include <emmintrin.h>
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Text per chunk, and so per pool task; files under two of these are read on the
+	// calling thread in one piece. Vertices per task when they are filled in.
+	const size_t CHUNK_BYTES = 1024 * 1024;
+	const size_t VERTEX_GRAIN = 32 * 1024;
+
+	const int32_t NO_INDEX = INT32_MIN;
+	const uint32_t NO_ATTRIBUTE = UINT32_MAX;
+
+	enum ObjAttribute { OBJ_POSITION, OBJ_TEXCOORD, OBJ_NORMAL, OBJ_ATTRIBUTES };
+	const size_t s_components[OBJ_ATTRIBUTES] = { 3, 2, 3 };
+
+	// A face corner as it was written, made 0-based. Indices whose 'relative' bit is set were
+	// negative and count from the start of the chunk's own list, which is not known until
+	// every chunk before it has been read.
+	struct ObjCorner
+	{
+		int32_t index[OBJ_ATTRIBUTES];
+		uint32_t relative;
+	};
+
+	// A corner with its indices into the whole file's lists, NO_ATTRIBUTE where it has none
+	struct ObjKey
+	{
+		uint32_t index[OBJ_ATTRIBUTES];
+
+		bool operator==(const ObjKey& other) const
+		{
+			return index[0] == other.index[0] && index[1] == other.index[1] && index[2] == other.index[2];
+		}
+	};
+
+	struct ObjChunk
+	{
+		const char* begin;
+		const char* end;
+		std::vector<float> attributes[OBJ_ATTRIBUTES];
+		std::vector<ObjCorner> corners;   // three per triangle
+		size_t base[OBJ_ATTRIBUTES];      // where the lists start in the whole file's
+		size_t cornerBase;
+		bool failed;
+	};
+
+	// Exact in a double up to 1e22
+	const double s_powersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	bool IsDigit(const char c)
+	{
+		return static_cast<unsigned char>(c - '0') < 10;
+	}
+
+	bool IsBlank(const char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	const char* SkipBlanks(const char* p, const char* const end)
+	{
+		while (p < end && IsBlank(*p))
+			++p;
+		return p;
+	}
+
+	// The '\n' ending the line that 'p' is on, or 'end'
+	const char* FindLineEnd(const char* p, const char* const end)
+	{
+#ifdef OBJ_READER_SSE2
+		const __m128i newline = _mm_set1_epi8('\n');
+		for (; end - p >= 16; p += 16)
+		{
+			const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), newline));
+			unsigned long first;
+			if (_BitScanForward(&first, static_cast<unsigned long>(mask)))
+				return p + first;
+		}
+#endif
+		while (p < end && *p != '\n')
+			++p;
+		return p;
+	}
+
+	// Eight digits at once, as a 64-bit word of ASCII: checks all eight are digits, then
+	// combines them pairwise into two-, four- and eight-digit values
+	bool ReadEightDigits(const char* const p, uint32_t* const value)
+	{
+		uint64_t word;
+		memcpy(&word, p, sizeof(word));
+		if ((((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))) != 0x3333333333333333ull)
+			return false;
+
+		word = ((word & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+		word = ((word & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+		*value = static_cast<uint32_t>(((word & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+		return true;
+	}
+
+	// Adds a run of digits to the mantissa. Digits past what a uint64_t holds are dropped,
+	// moving the decimal exponent instead, as they cannot change a float.
+	const char* ReadDigits(const char* p, const char* const end, const bool fraction, uint64_t* const mantissa, int* const exponent,
+	                       bool* const any)
+	{
+		uint32_t eight;
+		while (end - p >= 8 && *mantissa < 10000000000ull && ReadEightDigits(p, &eight))
+		{
+			*mantissa = *mantissa * 100000000u + eight;
+			*exponent -= fraction ? 8 : 0;
+			*any = true;
+			p += 8;
+		}
+		for (; p < end && IsDigit(*p); ++p)
+		{
+			if (*mantissa < 1000000000000000000ull)
+			{
+				*mantissa = *mantissa * 10 + (*p - '0');
+				*exponent -= fraction ? 1 : 0;
+			}
+			else
+			{
+				*exponent += fraction ? 0 : 1;
+			}
+			*any = true;
+		}
+		return p;
+	}
+
+	const char* ReadFloat(const char* p, const char* const end, float* const value, bool* const failed)
+	{
+		p = SkipBlanks(p, end);
+		const bool negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+'))
+			++p;
+
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		bool any = false;
+		p = ReadDigits(p, end, false, &mantissa, &exponent, &any);
+		if (p < end && *p == '.')
+			p = ReadDigits(p + 1, end, true, &mantissa, &exponent, &any);
+		if (!any)
+		{
+			*failed = true;
+			return p;
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			const bool negativeExponent = p < end && *p == '-';
+			if (p < end && (*p == '-' || *p == '+'))
+				++p;
+			int written = 0;
+			for (; p < end && IsDigit(*p); ++p)
+				written = written < 10000 ? written * 10 + (*p - '0') : written;
+			exponent += negativeExponent ? -written : written;
+		}
+
+		// Both factors are exact for the common cases, so the double is correctly rounded
+		// and the float nearly always is
+		double result = static_cast<double>(mantissa);
+		if (exponent < 0)
+			result = exponent >= -22 ? result / s_powersOfTen[-exponent] : result / pow(10.0, -exponent);
+		else if (exponent > 0)
+			result = exponent <= 22 ? result * s_powersOfTen[exponent] : result * pow(10.0, exponent);
+		*value = static_cast<float>(negative ? -result : result);
+		return p;
+	}
+
+	const char* ReadIndex(const char* p, const char* const end, ObjChunk& chunk, const ObjAttribute attribute, ObjCorner& corner)
+	{
+		const bool negative = p < end && *p == '-';
+		if (negative)
+			++p;
+
+		const char* const digits = p;
+		int64_t value = 0;
+		for (; p < end && IsDigit(*p) && value <= INT32_MAX; ++p)
+			value = value * 10 + (*p - '0');
+		if (p == digits || value == 0 || value > INT32_MAX)
+		{
+			chunk.failed = true;
+			return p;
+		}
+
+		if (negative)
+		{
+			const int64_t listed = static_cast<int64_t>(chunk.attributes[attribute].size() / s_components[attribute]);
+			corner.index[attribute] = static_cast<int32_t>(listed - value);
+			corner.relative |= 1u << attribute;
+		}
+		else
+		{
+			corner.index[attribute] = static_cast<int32_t>(value - 1);
+		}
+		return p;
+	}
+
+	void ReadAttribute(const char* p, const char* const end, ObjChunk& chunk, const ObjAttribute attribute)
+	{
+		float values[3];
+		for (size_t i = 0; i < s_components[attribute]; ++i)
+			p = ReadFloat(p, end, &values[i], &chunk.failed);
+		chunk.attributes[attribute].insert(chunk.attributes[attribute].end(), values, values + s_components[attribute]);
+	}
+
+	void ReadFace(const char* p, const char* const end, ObjChunk& chunk)
+	{
+		ObjCorner first = {};
+		ObjCorner previous = {};
+		for (size_t count = 0; !chunk.failed; ++count)
+		{
+			p = SkipBlanks(p, end);
+			if (p == end || *p == '\r' || *p == '#')
+				break;
+
+			ObjCorner corner = { { NO_INDEX, NO_INDEX, NO_INDEX }, 0 };
+			p = ReadIndex(p, end, chunk, OBJ_POSITION, corner);
+			if (p < end && *p == '/')
+			{
+				++p;
+				if (p < end && *p != '/')
+					p = ReadIndex(p, end, chunk, OBJ_TEXCOORD, corner);
+				if (p < end && *p == '/')
+					p = ReadIndex(p + 1, end, chunk, OBJ_NORMAL, corner);
+			}
+			if (p < end && !IsBlank(*p) && *p != '\r')
+				chunk.failed = true;
+
+			// A fan around the first corner
+			if (count == 0)
+			{
+				first = corner;
+			}
+			else if (count >= 2)
+			{
+				chunk.corners.push_back(first);
+				chunk.corners.push_back(previous);
+				chunk.corners.push_back(corner);
+			}
+			previous = corner;
+		}
+	}
+
+	void ReadChunk(ObjChunk& chunk)
+	{
+		for (const char* line = chunk.begin; line < chunk.end && !chunk.failed;)
+		{
+			const char* const lineEnd = FindLineEnd(line, chunk.end);
+			const char* const p = SkipBlanks(line, lineEnd);
+			if (lineEnd - p >= 2 && IsBlank(p[1]))
+			{
+				if (p[0] == 'v')
+					ReadAttribute(p + 2, lineEnd, chunk, OBJ_POSITION);
+				else if (p[0] == 'f')
+					ReadFace(p + 2, lineEnd, chunk);
+			}
+			else if (lineEnd - p >= 3 && p[0] == 'v' && IsBlank(p[2]))
+			{
+				if (p[1] == 't')
+					ReadAttribute(p + 3, lineEnd, chunk, OBJ_TEXCOORD);
+				else if (p[1] == 'n')
+					ReadAttribute(p + 3, lineEnd, chunk, OBJ_NORMAL);
+			}
+			line = lineEnd + 1;
+		}
+	}
+
+	// Indices into the whole file's lists, checked against their lengths, and each chunk's
+	// attributes copied to where its lists start in them
+	void ResolveChunk(ObjChunk& chunk, const size_t* const totals, std::vector<float>* const attributes, ObjKey* const keys)
+	{
+		for (size_t attribute = 0; attribute < OBJ_ATTRIBUTES; ++attribute)
+		{
+			const std::vector<float>& source = chunk.attributes[attribute];
+			if (!source.empty())
+				memcpy(attributes[attribute].data() + chunk.base[attribute] * s_components[attribute], source.data(), source.size() * sizeof(float));
+		}
+
+		for (size_t i = 0; i < chunk.corners.size(); ++i)
+		{
+			const ObjCorner& corner = chunk.corners[i];
+			ObjKey& key = keys[chunk.cornerBase + i];
+			for (size_t attribute = 0; attribute < OBJ_ATTRIBUTES; ++attribute)
+			{
+				if (corner.index[attribute] == NO_INDEX)
+				{
+					key.index[attribute] = NO_ATTRIBUTE;
+					continue;
+				}
+
+				const int64_t index = corner.index[attribute] + ((corner.relative >> attribute) & 1 ? static_cast<int64_t>(chunk.base[attribute]) : 0);
+				if (index < 0 || index >= static_cast<int64_t>(totals[attribute]))
+				{
+					chunk.failed = true;
+					return;
+				}
+				key.index[attribute] = static_cast<uint32_t>(index);
+			}
+		}
+	}
+
+	size_t HashKey(const ObjKey& key, const int shift)
+	{
+		const uint64_t mixed = (key.index[0] * 0x9E3779B97F4A7C15ull) ^ (key.index[1] * 0xC2B2AE3D27D4EB4Full) ^ (key.index[2] * 0x165667B19E3779F9ull);
+		return static_cast<size_t>((mixed * 0x9E3779B97F4A7C15ull) >> shift);
+	}
+
+	void RunOver(ThreadPool* const pool, const size_t count, const size_t grain, const std::function<void(size_t begin, size_t end)>& body)
+	{
+		if (pool && count >= 2 * grain)
+			pool->ParallelFor(count, grain, body);
+		else
+			body(0, count);
+	}
+}
+
+HRESULT ReadObj(const uint8_t* const data, const size_t size, std::vector<SimpleVertex>& vertices, std::vector<uint32_t>& indices,
+                ThreadPool* const pool)
+{
+	vertices.clear();
+	indices.clear();
+	if (!data || !size)
+		return E_FAIL;
+
+	// Chunks end just past a line end, so no line is split between two
+	const char* const text = reinterpret_cast<const char*>(data);
+	const char* const textEnd = text + size;
+	const size_t chunkCount = pool && size >= 2 * CHUNK_BYTES ? size / CHUNK_BYTES : 1;
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* begin = text;
+	for (size_t c = 0; c < chunkCount; ++c)
+	{
+		const char* const split = c + 1 == chunkCount ? textEnd : text + size * (c + 1) / chunkCount;
+		const char* const end = split > begin ? FindLineEnd(split, textEnd) : begin;
+		chunks[c].begin = begin;
+		chunks[c].end = end < textEnd ? end + 1 : textEnd;
+		chunks[c].failed = false;
+		begin = chunks[c].end;
+	}
+
+	RunOver(pool, chunkCount, 1, [&](const size_t first, const size_t last)
+	{
+		for (size_t c = first; c < last; ++c)
+			ReadChunk(chunks[c]);
+	});
+
+	size_t totals[OBJ_ATTRIBUTES] = {};
+	size_t cornerCount = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		if (chunk.failed)
+			return E_FAIL;
+		for (size_t attribute = 0; attribute < OBJ_ATTRIBUTES; ++attribute)
+		{
+			chunk.base[attribute] = totals[attribute];
+			totals[attribute] += chunk.attributes[attribute].size() / s_components[attribute];
+		}
+		chunk.cornerBase = cornerCount;
+		cornerCount += chunk.corners.size();
+	}
+	if (!cornerCount || cornerCount > UINT32_MAX)
+		return E_FAIL;
+
+	std::vector<float> attributes[OBJ_ATTRIBUTES];
+	for (size_t attribute = 0; attribute < OBJ_ATTRIBUTES; ++attribute)
+		attributes[attribute].resize(totals[attribute] * s_components[attribute]);
+	std::vector<ObjKey> keys(cornerCount);
+	RunOver(pool, chunkCount, 1, [&](const size_t first, const size_t last)
+	{
+		for (size_t c = first; c < last; ++c)
+			ResolveChunk(chunks[c], totals, attributes, keys.data());
+	});
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (chunk.failed)
+			return E_FAIL;
+	}
+
+	// One vertex per distinct corner, numbered in the order they first appear. The table
+	// is at most half full, with linear probing.
+	int shift = 64;
+	size_t tableSize = 1;
+	for (; tableSize < cornerCount * 2; tableSize *= 2)
+		--shift;
+	std::vector<uint32_t> table(tableSize, NO_ATTRIBUTE);
+	std::vector<ObjKey> unique;
+	indices.resize(cornerCount);
+	for (size_t i = 0; i < cornerCount; ++i)
+	{
+		const ObjKey& key = keys[i];
+		for (size_t slot = HashKey(key, shift);; slot = (slot + 1) & (tableSize - 1))
+		{
+			if (table[slot] == NO_ATTRIBUTE)
+			{
+				table[slot] = static_cast<uint32_t>(unique.size());
+				unique.push_back(key);
+			}
+			else if (!(unique[table[slot]] == key))
+			{
+				continue;
+			}
+			indices[i] = table[slot];
+			break;
+		}
+	}
+
+	vertices.resize(unique.size());
+	RunOver(pool, unique.size(), VERTEX_GRAIN, [&](const size_t first, const size_t last)
+	{
+		for (size_t v = first; v < last; ++v)
+		{
+			SimpleVertex vertex = {};
+			const ObjKey& key = unique[v];
+			const float* const position = &attributes[OBJ_POSITION][key.index[OBJ_POSITION] * 3];
+			vertex.Pos = XMFLOAT3(position[0], position[1], position[2]);
+			if (key.index[OBJ_NORMAL] != NO_ATTRIBUTE)
+			{
+				const float* const normal = &attributes[OBJ_NORMAL][key.index[OBJ_NORMAL] * 3];
+				vertex.Normal = XMFLOAT3(normal[0], normal[1], normal[2]);
+			}
+			if (key.index[OBJ_TEXCOORD] != NO_ATTRIBUTE)
+			{
+				const float* const texCoord = &attributes[OBJ_TEXCOORD][key.index[OBJ_TEXCOORD] * 2];
+				vertex.TexCoord = XMFLOAT2(texCoord[0], texCoord[1]);
+			}
+			vertices[v] = vertex;
+		}
+	});
+	return S_OK;
+}
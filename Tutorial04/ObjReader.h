@@ -0,0 +1,37 @@
+#pragma once
+#include <windows.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "SimpleVertex.h"
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// Reads Wavefront OBJ meshes such as Sphere.obj without going through Assimp. Only the
+// geometry is read:
+//
+//   v x y z       position; a w or vertex colour after it is ignored
+//   vt u v        texture coordinate; a w is ignored, and v is not flipped
+//   vn x y z      normal
+//   f a b c ...   a corner is p, p/t, p//n or p/t/n, 1-based or negative (relative to the
+//                 end of the list so far); polygons are split into fans
+//
+// Every other statement (g, o, s, usemtl, mtllib, comments) is skipped, and all faces go
+// into one mesh. Corners with the same p/t/n triple share a vertex; attributes a face does
+// not give are zero, and tangents are left zero for GenerateTangents.
+//
+// The text is cut into chunks at line ends and large files are parsed over the pool, one
+// chunk per task, each into its own lists; the indices are then resolved against where
+// each chunk's lists start, and the corners merged through one hash table.
+//--------------------------------------------------------------------------------------
+
+// Goes into the key meshes are cooked under, so a change to what ReadObj returns recooks
+// them
+const uint32_t OBJ_READER_VERSION = 1;
+
+// E_FAIL when the file has no faces or a face uses an index that is out of range or not a
+// number
+HRESULT ReadObj(const uint8_t* data, size_t size, std::vector<SimpleVertex>& vertices, std::vector<uint32_t>& indices,
+                ThreadPool* pool = nullptr);
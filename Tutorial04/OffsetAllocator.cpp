@@ -0,0 +1,66 @@
+#include "OffsetAllocator.h"
+#include <iterator>
+
+OffsetAllocator::OffsetAllocator(const uint32_t capacity)
+	: m_capacity(capacity), m_freeSize(0)
+{
+	if (capacity)
+		Insert(0, capacity);
+}
+
+uint32_t OffsetAllocator::Allocate(const uint32_t size)
+{
+	if (!size)
+		return INVALID_OFFSET;
+
+	const SizeSet::iterator fit = m_bySize.lower_bound(std::make_pair(size, 0u));
+	if (fit == m_bySize.end())
+		return INVALID_OFFSET;
+
+	// The front of the range is taken and the rest stays free
+	const uint32_t offset = fit->second;
+	const uint32_t rangeSize = fit->first;
+	Erase(m_byOffset.find(offset));
+	if (rangeSize > size)
+		Insert(offset + size, rangeSize - size);
+	return offset;
+}
+
+void OffsetAllocator::Free(uint32_t offset, uint32_t size)
+{
+	if (!size || offset >= m_capacity || size > m_capacity - offset)
+		return;
+
+	// Absorb the free ranges ending where this one starts and starting where it ends
+	const OffsetMap::iterator next = m_byOffset.lower_bound(offset);
+	if (next != m_byOffset.begin())
+	{
+		const OffsetMap::iterator previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			Erase(previous);
+		}
+	}
+	if (next != m_byOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		Erase(next);
+	}
+	Insert(offset, size);
+}
+
+void OffsetAllocator::Insert(const uint32_t offset, const uint32_t size)
+{
+	m_byOffset.emplace(offset, size);
+	m_bySize.emplace(size, offset);
+	m_freeSize += size;
+}
+
+void OffsetAllocator::Erase(const OffsetMap::iterator range)
+{
+	m_bySize.erase(std::make_pair(range->second, range->first));
+	m_freeSize -= range->second;
+	m_byOffset.erase(range);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <utility>
+
+//--------------------------------------------------------------------------------------
+// Hands out ranges of [0, capacity) in whatever unit the caller counts in (vertices,
+// indices). Allocate takes the smallest free range that holds the request, so large holes
+// are kept for large meshes; Free merges the range with the free neighbours on both sides.
+// Both are O(log n) in the number of free ranges. Knows nothing of D3D, so the arenas'
+// bookkeeping can be exercised on its own (see AssetTool arenas).
+//--------------------------------------------------------------------------------------
+class OffsetAllocator
+{
+public:
+	static const uint32_t INVALID_OFFSET = UINT32_MAX;
+
+	explicit OffsetAllocator(uint32_t capacity);
+
+	// INVALID_OFFSET when no free range is large enough, or for a size of 0
+	uint32_t Allocate(uint32_t size);
+
+	// 'offset' and 'size' must be those of a range Allocate returned and not yet freed
+	void Free(uint32_t offset, uint32_t size);
+
+	uint32_t Capacity() const { return m_capacity; }
+	uint32_t FreeSize() const { return m_freeSize; }
+	uint32_t LargestFree() const { return m_bySize.empty() ? 0 : m_bySize.rbegin()->first; }
+	size_t FreeRangeCount() const { return m_byOffset.size(); }
+
+private:
+	typedef std::map<uint32_t, uint32_t> OffsetMap;            // offset -> size
+	typedef std::set<std::pair<uint32_t, uint32_t>> SizeSet;   // (size, offset), smallest first
+
+	void Insert(uint32_t offset, uint32_t size);
+	void Erase(OffsetMap::iterator range);
+
+	OffsetMap m_byOffset;
+	SizeSet m_bySize;
+	uint32_t m_capacity;
+	uint32_t m_freeSize;
+};
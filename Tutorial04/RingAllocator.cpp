@@ -0,0 +1,32 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(const uint32_t capacity, const uint32_t alignment)
+	: m_capacity(capacity), m_alignment(alignment), m_head(0), m_started(false), m_passes(0)
+{
+}
+
+uint32_t RingAllocator::Allocate(const uint32_t size, bool* const wrapped)
+{
+	*wrapped = false;
+	if (size == 0 || size > m_capacity)
+		return INVALID_OFFSET;
+
+	// Round the head up in 64 bits, as it may round past the end of a ring near 4 GB
+	const uint64_t aligned = (uint64_t(m_head) + m_alignment - 1) & ~uint64_t(m_alignment - 1);
+	uint32_t offset = static_cast<uint32_t>(aligned);
+	if (!m_started || aligned + size > m_capacity)
+	{
+		offset = 0;
+		m_started = true;
+		++m_passes;
+		*wrapped = true;
+	}
+	m_head = offset + size;
+	return offset;
+}
+
+void RingAllocator::Reset()
+{
+	m_head = 0;
+	m_started = false;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------
+// Hands out aligned ranges of [0, capacity) one after another, starting again from 0 when
+// the next one does not fit in what is left. Nothing is freed: a range stays valid until
+// the allocator wraps past it. That is how a D3D11_USAGE_DYNAMIC buffer is written, with
+// MAP_WRITE_NO_OVERWRITE while the ranges only move forward and MAP_WRITE_DISCARD on each
+// wrap, which gives the buffer fresh memory while the GPU still reads the old. Knows
+// nothing of D3D, so the wrapping can be exercised on its own (see AssetTool ring).
+//--------------------------------------------------------------------------------------
+class RingAllocator
+{
+public:
+	static const uint32_t INVALID_OFFSET = UINT32_MAX;
+
+	// 'alignment' is a power of two no larger than 'capacity'
+	RingAllocator(uint32_t capacity, uint32_t alignment);
+
+	// The offset of 'size' bytes, or INVALID_OFFSET for a size of 0 or one larger than the
+	// ring. 'wrapped' is set when the range starts a new pass over the ring, the first
+	// one included, and everything handed out before it may be overwritten.
+	uint32_t Allocate(uint32_t size, bool* wrapped);
+
+	// The next Allocate starts a new pass, as after a lost or recreated buffer
+	void Reset();
+
+	uint32_t Capacity() const { return m_capacity; }
+	uint32_t Alignment() const { return m_alignment; }
+	uint64_t Passes() const { return m_passes; }   // started so far, the first one included
+
+private:
+	uint32_t m_capacity;
+	uint32_t m_alignment;
+	uint32_t m_head;       // where the next range may start
+	bool m_started;        // whether this pass has handed out a range yet
+	uint64_t m_passes;
+};
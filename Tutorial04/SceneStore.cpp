@@ -0,0 +1,466 @@
+#include "SceneStore.h"
+#include "MappedFile.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	// Position, rotation, scale, parent, flags, mesh and material
+	const size_t ENTITY_BYTES = 3 * sizeof(float) + 4 * sizeof(float) + 3 * sizeof(float) + 2 * sizeof(uint32_t) + 2 * sizeof(uint16_t);
+
+	const float DEGREES_TO_RADIANS = XM_PI / 180.0f;
+
+	bool IsSpace(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// Splits a line into whitespace-separated tokens, stopping at a comment
+	size_t Tokenize(const char* line, const char* const end, const char** tokens, size_t* lengths, const size_t maxTokens)
+	{
+		size_t count = 0;
+		while (line < end)
+		{
+			while (line < end && IsSpace(*line))
+				++line;
+			if (line == end || *line == '#')
+				break;
+			const char* const start = line;
+			while (line < end && !IsSpace(*line))
+				++line;
+			if (count == maxTokens)
+				return maxTokens + 1;
+			tokens[count] = start;
+			lengths[count] = static_cast<size_t>(line - start);
+			++count;
+		}
+		return count;
+	}
+
+	bool Matches(const char* const token, const size_t length, const char* const word)
+	{
+		return strlen(word) == length && memcmp(token, word, length) == 0;
+	}
+
+	bool ParseFloat(const char* const token, const size_t length, float* const value)
+	{
+		char buffer[64];
+		if (length >= sizeof(buffer))
+			return false;
+		memcpy(buffer, token, length);
+		buffer[length] = '\0';
+		char* end = nullptr;
+		*value = strtof(buffer, &end);
+		return end == buffer + length;
+	}
+
+	bool ParseFloat3(const char* const* tokens, const size_t* lengths, XMFLOAT3* const value)
+	{
+		return ParseFloat(tokens[0], lengths[0], &value->x) && ParseFloat(tokens[1], lengths[1], &value->y) &&
+		       ParseFloat(tokens[2], lengths[2], &value->z);
+	}
+
+	// A name field: "-" is none, anything else must fit the name table
+	bool ParseName(SceneStore& scene, const char* const token, const size_t length, uint16_t* const index)
+	{
+		if (Matches(token, length, "-"))
+		{
+			*index = SCENE_NO_NAME;
+			return true;
+		}
+		*index = scene.AddName(token, length);
+		return *index != SCENE_NO_NAME;
+	}
+
+	bool ParseMaterial(SceneStore& scene, const char* const* tokens, const size_t* lengths, const size_t count)
+	{
+		if (count < 9 || count > 11)
+			return false;
+
+		SCENE_MATERIAL material = {};
+		if (!ParseName(scene, tokens[1], lengths[1], &material.name) || material.name == SCENE_NO_NAME ||
+		    !ParseName(scene, tokens[2], lengths[2], &material.vertexShader) ||
+		    !ParseName(scene, tokens[3], lengths[3], &material.pixelShader) ||
+		    !ParseName(scene, tokens[4], lengths[4], &material.sampler) ||
+		    !ParseName(scene, tokens[6], lengths[6], &material.depthState) ||
+		    !ParseName(scene, tokens[7], lengths[7], &material.rasterState) ||
+		    !ParseName(scene, tokens[8], lengths[8], &material.blendState))
+			return false;
+
+		// One texture, or two joined by '+'
+		const char* const textures = tokens[5];
+		const char* const plus = static_cast<const char*>(memchr(textures, '+', lengths[5]));
+		const size_t firstLength = plus ? static_cast<size_t>(plus - textures) : lengths[5];
+		material.textures[1] = SCENE_NO_NAME;
+		if (!ParseName(scene, textures, firstLength, &material.textures[0]) ||
+		    (plus && !ParseName(scene, plus + 1, lengths[5] - firstLength - 1, &material.textures[1])))
+			return false;
+
+		for (size_t i = 9; i < count; ++i)
+		{
+			uint32_t flag = 0;
+			if (Matches(tokens[i], lengths[i], "debugvs"))
+				flag = SCENE_MATERIAL_DEBUG_VS;
+			else if (Matches(tokens[i], lengths[i], "background"))
+				flag = SCENE_MATERIAL_BACKGROUND;
+			if (!flag || (material.flags & flag))
+				return false;
+			material.flags |= flag;
+		}
+		return scene.AddMaterial(material) != SCENE_NO_NAME;
+	}
+
+	bool ParseIndex(const char* const token, const size_t length, uint32_t* const value)
+	{
+		char buffer[16];
+		if (length >= sizeof(buffer) || token[0] < '0' || token[0] > '9')
+			return false;
+		memcpy(buffer, token, length);
+		buffer[length] = '\0';
+		char* end = nullptr;
+		const unsigned long parsed = strtoul(buffer, &end, 10);
+		*value = static_cast<uint32_t>(parsed);
+		return end == buffer + length && parsed < UINT32_MAX;
+	}
+
+	bool ParseEntity(SceneStore& scene, const char* const* tokens, const size_t* lengths, const size_t count)
+	{
+		if (count < 9 || lengths[1] >= SCENE_NAME_LENGTH || lengths[2] >= SCENE_NAME_LENGTH)
+			return false;
+
+		char name[SCENE_NAME_LENGTH];
+		memcpy(name, tokens[1], lengths[1]);
+		name[lengths[1]] = '\0';
+		const uint16_t mesh = scene.FindMesh(name);
+		memcpy(name, tokens[2], lengths[2]);
+		name[lengths[2]] = '\0';
+		const uint16_t material = scene.FindMaterial(name);
+
+		XMFLOAT3 position;
+		XMFLOAT3 scale;
+		if (!ParseFloat3(tokens + 3, lengths + 3, &position) || !ParseFloat3(tokens + 6, lengths + 6, &scale))
+			return false;
+
+		// Then whichever of the rotation, parent and flag are there, in that order
+		size_t next = 9;
+		XMFLOAT3 rotation(0.0f, 0.0f, 0.0f);
+		XMFLOAT3 degrees;
+		if (count >= next + 3 && ParseFloat3(tokens + next, lengths + next, &degrees))
+		{
+			rotation = XMFLOAT3(degrees.x * DEGREES_TO_RADIANS, degrees.y * DEGREES_TO_RADIANS, degrees.z * DEGREES_TO_RADIANS);
+			next += 3;
+		}
+		uint32_t parent = TransformSystem::NO_PARENT;
+		if (next + 2 <= count && Matches(tokens[next], lengths[next], "parent"))
+		{
+			if (!ParseIndex(tokens[next + 1], lengths[next + 1], &parent))
+				return false;
+			next += 2;
+		}
+		uint32_t flags = 0;
+		if (next < count && Matches(tokens[next], lengths[next], "scroll"))
+		{
+			flags |= SCENE_ENTITY_SCROLL;
+			++next;
+		}
+		return next == count &&
+		       scene.AddEntity(mesh, material, position, TransformSystem::RotationFromEuler(rotation), scale, flags, parent);
+	}
+
+	template <typename T>
+	void CopyOut(uint8_t*& out, const std::vector<T>& source)
+	{
+		if (!source.empty())
+			memcpy(out, source.data(), source.size() * sizeof(T));
+		out += source.size() * sizeof(T);
+	}
+
+	template <typename T>
+	void CopyIn(const uint8_t*& in, std::vector<T>& dest, const size_t count)
+	{
+		dest.resize(count);
+		if (count)
+			memcpy(dest.data(), in, count * sizeof(T));
+		in += count * sizeof(T);
+	}
+}
+
+void SceneStore::Clear()
+{
+	m_names.clear();
+	m_meshNames.clear();
+	m_materials.clear();
+	m_entityMeshes.clear();
+	m_entityMaterials.clear();
+	m_entityFlags.clear();
+	m_transforms.Clear();
+}
+
+void SceneStore::Reserve(const size_t entityCount)
+{
+	m_entityMeshes.reserve(entityCount);
+	m_entityMaterials.reserve(entityCount);
+	m_entityFlags.reserve(entityCount);
+	m_transforms.Reserve(entityCount);
+}
+
+uint16_t SceneStore::AddName(const char* const text, const size_t length)
+{
+	if (!text || !length || length >= SCENE_NAME_LENGTH || (length == 1 && text[0] == '-'))
+		return SCENE_NO_NAME;
+
+	for (size_t i = 0; i < m_names.size(); ++i)
+	{
+		if (strncmp(m_names[i].text, text, length) == 0 && m_names[i].text[length] == '\0')
+			return static_cast<uint16_t>(i);
+	}
+	if (m_names.size() >= SCENE_NO_NAME)
+		return SCENE_NO_NAME;
+
+	SCENE_NAME name = {};
+	memcpy(name.text, text, length);
+	m_names.push_back(name);
+	return static_cast<uint16_t>(m_names.size() - 1);
+}
+
+uint16_t SceneStore::AddName(const char* const text)
+{
+	return text ? AddName(text, strlen(text)) : SCENE_NO_NAME;
+}
+
+uint16_t SceneStore::FindName(const char* const text) const
+{
+	for (size_t i = 0; text && i < m_names.size(); ++i)
+	{
+		if (strcmp(m_names[i].text, text) == 0)
+			return static_cast<uint16_t>(i);
+	}
+	return SCENE_NO_NAME;
+}
+
+const char* SceneStore::Name(const uint16_t index) const
+{
+	return index < m_names.size() ? m_names[index].text : "";
+}
+
+uint16_t SceneStore::AddMesh(const char* const name)
+{
+	if (FindMesh(name) != SCENE_NO_NAME || m_meshNames.size() >= SCENE_NO_NAME)
+		return SCENE_NO_NAME;
+	const uint16_t nameIndex = AddName(name);
+	if (nameIndex == SCENE_NO_NAME)
+		return SCENE_NO_NAME;
+	m_meshNames.push_back(nameIndex);
+	return static_cast<uint16_t>(m_meshNames.size() - 1);
+}
+
+uint16_t SceneStore::AddMaterial(const SCENE_MATERIAL& material)
+{
+	if (material.name >= m_names.size() || FindMaterial(Name(material.name)) != SCENE_NO_NAME || m_materials.size() >= SCENE_NO_NAME)
+		return SCENE_NO_NAME;
+	m_materials.push_back(material);
+	return static_cast<uint16_t>(m_materials.size() - 1);
+}
+
+uint16_t SceneStore::FindMesh(const char* const name) const
+{
+	const uint16_t nameIndex = FindName(name);
+	for (size_t i = 0; nameIndex != SCENE_NO_NAME && i < m_meshNames.size(); ++i)
+	{
+		if (m_meshNames[i] == nameIndex)
+			return static_cast<uint16_t>(i);
+	}
+	return SCENE_NO_NAME;
+}
+
+uint16_t SceneStore::FindMaterial(const char* const name) const
+{
+	const uint16_t nameIndex = FindName(name);
+	for (size_t i = 0; nameIndex != SCENE_NO_NAME && i < m_materials.size(); ++i)
+	{
+		if (m_materials[i].name == nameIndex)
+			return static_cast<uint16_t>(i);
+	}
+	return SCENE_NO_NAME;
+}
+
+bool SceneStore::AddEntity(const uint16_t mesh, const uint16_t material, const XMFLOAT3& position, const XMFLOAT4& rotation,
+                           const XMFLOAT3& scale, const uint32_t flags, const uint32_t parent)
+{
+	if (mesh >= m_meshNames.size() || material >= m_materials.size() ||
+	    m_transforms.Add(position, rotation, scale, parent) == TransformSystem::NO_PARENT)
+		return false;
+	m_entityMeshes.push_back(mesh);
+	m_entityMaterials.push_back(material);
+	m_entityFlags.push_back(flags);
+	return true;
+}
+
+HRESULT SceneStore::Read(const uint8_t* const data, const size_t size, const uint64_t sourceHash)
+{
+	if (!data)
+		return E_INVALIDARG;
+
+	SCENE_FILE_HEADER header;
+	if (size < sizeof(header))
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != SCENE_FILE_MAGIC || header.version != SCENE_FILE_VERSION || header.sourceHash != sourceHash ||
+	    header.nameCount > SCENE_NO_NAME || header.meshCount > SCENE_NO_NAME || header.materialCount > SCENE_NO_NAME)
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+	const uint64_t expected = sizeof(header) + uint64_t(header.nameCount) * sizeof(SCENE_NAME) +
+	                          uint64_t(header.materialCount) * sizeof(SCENE_MATERIAL) + uint64_t(header.meshCount) * sizeof(uint16_t) +
+	                          uint64_t(header.entityCount) * ENTITY_BYTES;
+	if (expected != size)
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+	Clear();
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT4> rotations;
+	std::vector<XMFLOAT3> scales;
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> flags;
+	std::vector<uint16_t> meshes;
+	std::vector<uint16_t> materials;
+	const uint8_t* in = data + sizeof(header);
+	CopyIn(in, m_names, header.nameCount);
+	CopyIn(in, m_materials, header.materialCount);
+	CopyIn(in, positions, header.entityCount);
+	CopyIn(in, rotations, header.entityCount);
+	CopyIn(in, scales, header.entityCount);
+	CopyIn(in, parents, header.entityCount);
+	CopyIn(in, flags, header.entityCount);
+	CopyIn(in, m_meshNames, header.meshCount);
+	CopyIn(in, meshes, header.entityCount);
+	CopyIn(in, materials, header.entityCount);
+
+	// Every index has to land in its table, every name be terminated and every parent come
+	// before its child, which AddEntity checks
+	bool valid = true;
+	for (const SCENE_NAME& name : m_names)
+		valid &= name.text[SCENE_NAME_LENGTH - 1] == '\0';
+	for (const uint16_t name : m_meshNames)
+		valid &= name < m_names.size();
+	for (const SCENE_MATERIAL& material : m_materials)
+	{
+		const uint16_t fields[] = { material.vertexShader, material.pixelShader, material.sampler, material.textures[0],
+		                            material.textures[1], material.depthState, material.rasterState, material.blendState };
+		valid &= material.name < m_names.size();
+		for (const uint16_t field : fields)
+			valid &= field == SCENE_NO_NAME || field < m_names.size();
+	}
+	Reserve(header.entityCount);
+	for (size_t i = 0; valid && i < header.entityCount; ++i)
+		valid = AddEntity(meshes[i], materials[i], positions[i], rotations[i], scales[i], flags[i], parents[i]);
+	if (!valid)
+	{
+		Clear();
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+	return S_OK;
+}
+
+HRESULT SceneStore::Write(const wchar_t* const fileName, const uint64_t sourceHash) const
+{
+	if (!fileName)
+		return E_INVALIDARG;
+	if (EntityCount() > UINT32_MAX)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	SCENE_FILE_HEADER header = {};
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.sourceHash = sourceHash;
+	header.nameCount = static_cast<uint32_t>(m_names.size());
+	header.meshCount = static_cast<uint32_t>(m_meshNames.size());
+	header.materialCount = static_cast<uint32_t>(m_materials.size());
+	header.entityCount = static_cast<uint32_t>(EntityCount());
+
+	// The transforms keep their components apart, so gather them per field first
+	std::vector<XMFLOAT3> positions(EntityCount());
+	std::vector<XMFLOAT4> rotations(EntityCount());
+	std::vector<XMFLOAT3> scales(EntityCount());
+	std::vector<uint32_t> parents(EntityCount());
+	for (uint32_t i = 0; i < EntityCount(); ++i)
+	{
+		positions[i] = m_transforms.Position(i);
+		rotations[i] = m_transforms.Rotation(i);
+		scales[i] = m_transforms.Scale(i);
+		parents[i] = m_transforms.Parent(i);
+	}
+
+	std::vector<uint8_t> data(sizeof(header) + m_names.size() * sizeof(SCENE_NAME) + m_materials.size() * sizeof(SCENE_MATERIAL) +
+	                          m_meshNames.size() * sizeof(uint16_t) + EntityCount() * ENTITY_BYTES);
+	memcpy(data.data(), &header, sizeof(header));
+	uint8_t* out = data.data() + sizeof(header);
+	CopyOut(out, m_names);
+	CopyOut(out, m_materials);
+	CopyOut(out, positions);
+	CopyOut(out, rotations);
+	CopyOut(out, scales);
+	CopyOut(out, parents);
+	CopyOut(out, m_entityFlags);
+	CopyOut(out, m_meshNames);
+	CopyOut(out, m_entityMeshes);
+	CopyOut(out, m_entityMaterials);
+
+	return WriteWholeFile(fileName, data.data(), data.size());
+}
+
+std::wstring SceneStore::CachePath(const wchar_t* const sourceName)
+{
+	return std::wstring(sourceName ? sourceName : L"") + L".scene";
+}
+
+HRESULT ParseSceneText(const char* const text, const size_t size, SceneStore& scene, size_t* const errorLine)
+{
+	if (!text && size)
+		return E_INVALIDARG;
+
+	scene.Clear();
+	const size_t MAX_TOKENS = 16;
+	const char* tokens[MAX_TOKENS];
+	size_t lengths[MAX_TOKENS];
+
+	const char* line = text;
+	const char* const end = text + size;
+	for (size_t lineNumber = 1; line < end; ++lineNumber)
+	{
+		const char* newline = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+		const char* const lineEnd = newline ? newline : end;
+		const size_t count = Tokenize(line, lineEnd, tokens, lengths, MAX_TOKENS);
+		line = newline ? newline + 1 : end;
+		if (!count)
+			continue;
+
+		bool parsed = false;
+		if (count <= MAX_TOKENS && Matches(tokens[0], lengths[0], "mesh"))
+		{
+			char name[SCENE_NAME_LENGTH];
+			if (count == 2 && lengths[1] < SCENE_NAME_LENGTH)
+			{
+				memcpy(name, tokens[1], lengths[1]);
+				name[lengths[1]] = '\0';
+				parsed = scene.AddMesh(name) != SCENE_NO_NAME;
+			}
+		}
+		else if (count <= MAX_TOKENS && Matches(tokens[0], lengths[0], "material"))
+		{
+			parsed = ParseMaterial(scene, tokens, lengths, count);
+		}
+		else if (count <= MAX_TOKENS && Matches(tokens[0], lengths[0], "entity"))
+		{
+			parsed = ParseEntity(scene, tokens, lengths, count);
+		}
+
+		if (!parsed)
+		{
+			if (errorLine)
+				*errorLine = lineNumber;
+			scene.Clear();
+			return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+		}
+	}
+	return S_OK;
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <windows.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "SimpleVertex.h"
+#include "TransformSystem.h"
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// What Render draws: named meshes, materials and the entities that pair one of each with
+// a transform. The scene is written as text, Scene.txt:
+//
+//   # comment
+//   mesh <name>
+//   material <name> <vs> <ps> <sampler> <texture>[+<texture>] <depth> <raster> <blend> [debugvs] [background]
+//   entity <mesh> <material> <px py pz> <sx sy sz> [<rx ry rz>] [parent <entity>] [scroll]
+//
+// Names are up to SCENE_NAME_LENGTH - 1 characters and name what the program loaded: a
+// mesh or material field names a mesh, shader, sampler, texture or state object that
+// Main looks up when the scene is loaded, and "-" leaves that one as it was. Meshes and
+// materials are declared before the entities using them. Rotations are in degrees about
+// x, then y, then z, applied after the scale and before the translation. A parent is an
+// earlier entity, counted from 0 in the order they are listed, whose world matrix the
+// entity's transform is relative to.
+//
+// Render does not draw in the order listed: entities with a background material come
+// first, then the opaque ones grouped by shader and material, and the blended ones last,
+// farthest first.
+//
+// The text is cooked once into "<source>.scene", which holds the same tables and the
+// entities as arrays, each field on its own:
+//
+//   SCENE_FILE_HEADER
+//   names           SCENE_NAME[nameCount]
+//   materials       SCENE_MATERIAL[materialCount]
+//   positions       float[3][entityCount]
+//   rotations       float[4][entityCount], unit quaternions
+//   scales          float[3][entityCount]
+//   parents         uint32_t[entityCount], TransformSystem::NO_PARENT for none
+//   entity flags    uint32_t[entityCount]
+//   meshes          uint16_t[meshCount], the name of each
+//   entity meshes   uint16_t[entityCount], likewise entity materials
+//
+// sourceHash ties the cooked file to the text it came from, as for cooked meshes.
+//--------------------------------------------------------------------------------------
+const uint32_t SCENE_FILE_MAGIC = 0x314E4353; // "SCN1"
+const uint32_t SCENE_FILE_VERSION = 2;   // 2: quaternions and parents
+const size_t SCENE_NAME_LENGTH = 32;
+const size_t SCENE_MATERIAL_TEXTURES = 2;
+const uint16_t SCENE_NO_NAME = 0xFFFF;   // also the most names, meshes and materials a scene has
+
+// SCENE_MATERIAL::flags
+const uint32_t SCENE_MATERIAL_DEBUG_VS = 0x1;   // F6 swaps in the vertex shader's debug variant
+const uint32_t SCENE_MATERIAL_BACKGROUND = 0x2; // drawn before the rest, as a sky without depth is
+
+// Entity flags
+const uint32_t SCENE_ENTITY_SCROLL = 0x1;       // F with Shift moves it down over time
+
+#pragma pack(push,1)
+struct SCENE_FILE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t nameCount;
+	uint32_t meshCount;
+	uint32_t materialCount;
+	uint32_t entityCount;
+};
+
+struct SCENE_NAME
+{
+	char text[SCENE_NAME_LENGTH];   // zero-padded
+};
+
+// Every field but flags is an index into the name table, or SCENE_NO_NAME
+struct SCENE_MATERIAL
+{
+	uint16_t name;
+	uint16_t vertexShader;
+	uint16_t pixelShader;
+	uint16_t sampler;
+	uint16_t textures[SCENE_MATERIAL_TEXTURES];   // pixel shader slots 0 and 1
+	uint16_t depthState;
+	uint16_t rasterState;
+	uint16_t blendState;
+	uint16_t reserved;
+	uint32_t flags;
+};
+#pragma pack(pop)
+
+//--------------------------------------------------------------------------------------
+// The scene in memory, entities stored field by field so a pass over every entity reads
+// only the arrays it uses. Entities keep the order they were added in. Entity i's
+// transform is transform i of a TransformSystem, so UpdateWorlds only rebuilds the world
+// matrices of entities that moved.
+//--------------------------------------------------------------------------------------
+class SceneStore
+{
+public:
+	SceneStore() = default;
+
+	SceneStore(const SceneStore&) = delete;
+	SceneStore& operator=(const SceneStore&) = delete;
+
+	void Clear();
+	void Reserve(size_t entityCount);
+
+	// The index of a name, added if it is new; SCENE_NO_NAME for "-", a name that is too
+	// long or when the table is full
+	uint16_t AddName(const char* text, size_t length);
+	uint16_t AddName(const char* text);
+	uint16_t FindName(const char* text) const;
+	const char* Name(uint16_t index) const;   // "" for SCENE_NO_NAME
+
+	// Return the new mesh or material's index, or SCENE_NO_NAME when the name is taken or
+	// the table is full
+	uint16_t AddMesh(const char* name);
+	uint16_t AddMaterial(const SCENE_MATERIAL& material);
+	uint16_t FindMesh(const char* name) const;
+	uint16_t FindMaterial(const char* name) const;
+
+	// False when the mesh, material or parent does not exist
+	bool AddEntity(uint16_t mesh, uint16_t material, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale,
+	               uint32_t flags = 0, uint32_t parent = TransformSystem::NO_PARENT);
+
+	size_t NameCount() const { return m_names.size(); }
+	size_t MeshCount() const { return m_meshNames.size(); }
+	const char* MeshName(const size_t mesh) const { return Name(m_meshNames[mesh]); }
+	size_t MaterialCount() const { return m_materials.size(); }
+	const SCENE_MATERIAL& Material(const size_t material) const { return m_materials[material]; }
+
+	size_t EntityCount() const { return m_entityMeshes.size(); }
+	const uint16_t* EntityMeshes() const { return m_entityMeshes.data(); }
+	const uint16_t* EntityMaterials() const { return m_entityMaterials.data(); }
+	const uint32_t* EntityFlags() const { return m_entityFlags.data(); }
+
+	// Moving an entity is setting its transform; the world matrices follow on UpdateWorlds
+	TransformSystem& Transforms() { return m_transforms; }
+	const TransformSystem& Transforms() const { return m_transforms; }
+
+	// Returns how many world matrices changed
+	size_t UpdateWorlds(ThreadPool* pool = nullptr) { return m_transforms.Update(pool); }
+	const XMFLOAT4X4* Worlds() const { return m_transforms.Worlds(); }
+
+	// Cooked scene files
+	HRESULT Read(const uint8_t* data, size_t size, uint64_t sourceHash);
+	HRESULT Write(const wchar_t* fileName, uint64_t sourceHash) const;
+
+	// The cooked file kept for a scene's text
+	static std::wstring CachePath(const wchar_t* sourceName);
+
+private:
+	std::vector<SCENE_NAME> m_names;
+	std::vector<uint16_t> m_meshNames;
+	std::vector<SCENE_MATERIAL> m_materials;
+
+	std::vector<uint16_t> m_entityMeshes;
+	std::vector<uint16_t> m_entityMaterials;
+	std::vector<uint32_t> m_entityFlags;
+	TransformSystem m_transforms;
+};
+
+// Replaces the scene with the one in the text. Fails with ERROR_INVALID_DATA, and sets
+// errorLine to the 1-based line at fault, for a statement it cannot read or a name that
+// is not declared
+HRESULT ParseSceneText(const char* text, size_t size, SceneStore& scene, size_t* errorLine = nullptr);
@@ -1,15 +1,15 @@
-#pragma once
-#include <DirectXMath.h>
-
-using namespace DirectX;
-//--------------------------------------------------------------------------------------
-// Structures
-//--------------------------------------------------------------------------------------
-struct SimpleVertex
-{
-	XMFLOAT3 Pos;
-	XMFLOAT3 Normal;
-	XMFLOAT2 TexCoord;
-	XMFLOAT3 Tangent;
-	XMFLOAT3 BiNormal;
+#pragma once
+#include <DirectXMath.h>
+
+using namespace DirectX;
+//--------------------------------------------------------------------------------------
+// Structures
+//--------------------------------------------------------------------------------------
+struct SimpleVertex
+{
+	XMFLOAT3 Pos;
+	XMFLOAT3 Normal;
+	XMFLOAT2 TexCoord;
+	XMFLOAT3 Tangent;
+	XMFLOAT3 BiNormal;
 };
\ No newline at end of file
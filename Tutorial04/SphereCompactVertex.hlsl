@@ -0,0 +1,78 @@
+//SPHERE 1 VERTEX, FROM CompactVertex (see VertexQuantize.h)
+cbuffer FrameConstants : register(b0)
+{
+	matrix View;
+	matrix Projection;
+	float4 lightPos;
+	float4 lightCol;
+	float4 lightAmb;
+	float4 lightDiff;
+	float4 Eye;
+}
+
+cbuffer Quantization : register(b1)
+{
+	float4 PositionOffset;
+	float4 PositionScale;
+}
+
+cbuffer ObjectConstants : register(b2)
+{
+	matrix World;
+}
+
+struct VS_INPUT {
+	float4 Pos : POSITION;      // R16G16B16A16_UNORM, w is the bitangent sign
+	float2 Normal : NORMAL;     // R16G16_SNORM octahedral
+	float2 Tangent : TANGENT;   // R16G16_SNORM octahedral
+	float2 TexCoord : TEXCOORD; // R16G16_FLOAT
+};
+
+struct VS_OUTPUT
+{
+	float4 Pos : SV_POSITION;
+	float4 WorldPos : POSITION;
+	float3 Normal : NORMAL;
+	float2 TexCoord : TEXCOORD;
+	float3 Tangent : TANGENT;
+	float3 Binormal : BINORMAL;
+};
+
+float3 DecodePosition(float3 unorm)
+{
+	return PositionOffset.xyz + unorm * PositionScale.xyz;
+}
+
+// Unfolds the lower half of the octahedron back under the upper
+float3 DecodeOctahedral(float2 e)
+{
+	float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	float fold = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -fold : fold;
+	return normalize(n);
+}
+
+VS_OUTPUT main(VS_INPUT input)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	float3 normal = DecodeOctahedral(input.Normal);
+	float3 tangent = DecodeOctahedral(input.Tangent);
+	float bitangentSign = input.Pos.w * 2.0f - 1.0f;
+
+	//Apply Perspective to vertices
+	output.Pos = mul(float4(DecodePosition(input.Pos.xyz), 1.0f), World);
+	output.WorldPos = output.Pos;
+	output.Pos = mul(output.Pos, View);
+	output.Pos = mul(output.Pos, Projection);
+
+	//Normalise
+	output.Normal = mul(normal, (float3x3)World);
+	output.Normal = normalize(output.Normal);
+
+	output.TexCoord = input.TexCoord;
+	output.Tangent = tangent;
+	output.Binormal = normalize(cross(normal, tangent)) * bitangentSign;
+
+	return output;
+}
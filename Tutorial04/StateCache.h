@@ -0,0 +1,302 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------
+// Calls made through the cache since BeginFrame: those passed on to the context, and those
+// dropped because they would have set what was set already.
+//--------------------------------------------------------------------------------------
+struct STATE_CACHE_STATS
+{
+	uint32_t issued;
+	uint32_t filtered;
+};
+
+// Slots of each per-slot array the cache shadows: vertex buffers, and constant buffers,
+// shader resources and samplers per stage. Calls reaching past these are always issued.
+const UINT STATE_CACHE_SLOTS = 8;
+
+//--------------------------------------------------------------------------------------
+// Stands in for a device context when binding pipeline state: it remembers what each of
+// the calls below set and only passes a call on when it changes something. Draws and
+// everything else go to Get().
+//
+// The cache only knows what went through it. Whoever binds on the context directly, or
+// calls ClearState, calls Invalidate afterwards, so the next call of every kind is issued.
+// A bound object cannot be destroyed and another created at its address meanwhile, since
+// the context holds a reference to what it has bound.
+//
+// Context is ID3D11DeviceContext in the program, hence StateCache; anything with the same
+// methods will do, which is how AssetTool checks the cache against a context that records
+// what it is told.
+//--------------------------------------------------------------------------------------
+template <typename Context>
+class BasicStateCache
+{
+public:
+	explicit BasicStateCache(Context* const context) : m_context(context) { Invalidate(); }
+
+	BasicStateCache(const BasicStateCache&) = delete;
+	BasicStateCache& operator=(const BasicStateCache&) = delete;
+
+	Context* Get() const { return m_context; }
+
+	void Invalidate();
+
+	// Starts counting a new frame
+	void BeginFrame() { m_lastFrame = m_frame; m_frame = STATE_CACHE_STATS(); }
+	const STATE_CACHE_STATS& ThisFrame() const { return m_frame; }
+	const STATE_CACHE_STATS& LastFrame() const { return m_lastFrame; }
+
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset);
+
+	void VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount);
+	void VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+
+	void PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount);
+	void PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+	void PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views);
+	void PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers);
+
+	void RSSetState(ID3D11RasterizerState* state);
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef);
+	void OMSetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask);
+
+private:
+	// What a slot holds after Invalidate; no object lives there
+	template <typename T>
+	static T* Unknown() { return reinterpret_cast<T*>(UINTPTR_MAX); }
+
+	// Stores values into the shadowed slots; true when one of them changed or the range
+	// reaches past STATE_CACHE_SLOTS
+	template <typename T>
+	static bool SetSlots(T** shadow, UINT startSlot, UINT count, T* const* values);
+
+	// Counts the call, and says whether to issue it
+	bool Issue(const bool changed)
+	{
+		++(changed ? m_frame.issued : m_frame.filtered);
+		return changed;
+	}
+
+	Context* m_context;
+	STATE_CACHE_STATS m_frame = {};
+	STATE_CACHE_STATS m_lastFrame = {};
+
+	ID3D11InputLayout* m_inputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY m_topology;
+	ID3D11Buffer* m_vertexBuffers[STATE_CACHE_SLOTS];
+	UINT m_vertexStrides[STATE_CACHE_SLOTS];
+	UINT m_vertexOffsets[STATE_CACHE_SLOTS];
+	ID3D11Buffer* m_indexBuffer;
+	DXGI_FORMAT m_indexFormat;
+	UINT m_indexOffset;
+
+	ID3D11VertexShader* m_vertexShader;
+	ID3D11Buffer* m_vertexConstants[STATE_CACHE_SLOTS];
+
+	ID3D11PixelShader* m_pixelShader;
+	ID3D11Buffer* m_pixelConstants[STATE_CACHE_SLOTS];
+	ID3D11ShaderResourceView* m_pixelResources[STATE_CACHE_SLOTS];
+	ID3D11SamplerState* m_pixelSamplers[STATE_CACHE_SLOTS];
+
+	ID3D11RasterizerState* m_rasterState;
+	ID3D11DepthStencilState* m_depthState;
+	UINT m_stencilRef;
+	ID3D11BlendState* m_blendState;
+	FLOAT m_blendFactor[4];
+	UINT m_sampleMask;
+};
+
+typedef BasicStateCache<ID3D11DeviceContext> StateCache;
+
+template <typename Context>
+void BasicStateCache<Context>::Invalidate()
+{
+	m_inputLayout = Unknown<ID3D11InputLayout>();
+	m_topology = static_cast<D3D11_PRIMITIVE_TOPOLOGY>(-1);
+	for (UINT slot = 0; slot < STATE_CACHE_SLOTS; ++slot)
+	{
+		m_vertexBuffers[slot] = Unknown<ID3D11Buffer>();
+		m_vertexStrides[slot] = 0;
+		m_vertexOffsets[slot] = 0;
+		m_vertexConstants[slot] = Unknown<ID3D11Buffer>();
+		m_pixelConstants[slot] = Unknown<ID3D11Buffer>();
+		m_pixelResources[slot] = Unknown<ID3D11ShaderResourceView>();
+		m_pixelSamplers[slot] = Unknown<ID3D11SamplerState>();
+	}
+	m_indexBuffer = Unknown<ID3D11Buffer>();
+	m_indexFormat = DXGI_FORMAT_UNKNOWN;
+	m_indexOffset = 0;
+	m_vertexShader = Unknown<ID3D11VertexShader>();
+	m_pixelShader = Unknown<ID3D11PixelShader>();
+	m_rasterState = Unknown<ID3D11RasterizerState>();
+	m_depthState = Unknown<ID3D11DepthStencilState>();
+	m_stencilRef = 0;
+	m_blendState = Unknown<ID3D11BlendState>();
+	for (FLOAT& factor : m_blendFactor)
+		factor = 1.0f;
+	m_sampleMask = 0;
+}
+
+template <typename Context>
+template <typename T>
+bool BasicStateCache<Context>::SetSlots(T** const shadow, const UINT startSlot, const UINT count, T* const* const values)
+{
+	bool changed = startSlot + count > STATE_CACHE_SLOTS;
+	for (UINT i = 0; i < count && startSlot + i < STATE_CACHE_SLOTS; ++i)
+	{
+		if (shadow[startSlot + i] != values[i])
+		{
+			shadow[startSlot + i] = values[i];
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+template <typename Context>
+void BasicStateCache<Context>::IASetInputLayout(ID3D11InputLayout* const layout)
+{
+	if (Issue(layout != m_inputLayout))
+	{
+		m_inputLayout = layout;
+		m_context->IASetInputLayout(layout);
+	}
+}
+
+template <typename Context>
+void BasicStateCache<Context>::IASetPrimitiveTopology(const D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (Issue(topology != m_topology))
+	{
+		m_topology = topology;
+		m_context->IASetPrimitiveTopology(topology);
+	}
+}
+
+template <typename Context>
+void BasicStateCache<Context>::IASetVertexBuffers(const UINT startSlot, const UINT count, ID3D11Buffer* const* const buffers,
+                                                  const UINT* const strides, const UINT* const offsets)
+{
+	bool changed = startSlot + count > STATE_CACHE_SLOTS;
+	for (UINT i = 0; i < count && startSlot + i < STATE_CACHE_SLOTS; ++i)
+	{
+		const UINT slot = startSlot + i;
+		if (m_vertexBuffers[slot] != buffers[i] || m_vertexStrides[slot] != strides[i] || m_vertexOffsets[slot] != offsets[i])
+		{
+			m_vertexBuffers[slot] = buffers[i];
+			m_vertexStrides[slot] = strides[i];
+			m_vertexOffsets[slot] = offsets[i];
+			changed = true;
+		}
+	}
+	if (Issue(changed))
+		m_context->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+}
+
+template <typename Context>
+void BasicStateCache<Context>::IASetIndexBuffer(ID3D11Buffer* const buffer, const DXGI_FORMAT format, const UINT offset)
+{
+	if (Issue(buffer != m_indexBuffer || format != m_indexFormat || offset != m_indexOffset))
+	{
+		m_indexBuffer = buffer;
+		m_indexFormat = format;
+		m_indexOffset = offset;
+		m_context->IASetIndexBuffer(buffer, format, offset);
+	}
+}
+
+// Shaders with class instances are always set, and leave the shader unknown after them
+template <typename Context>
+void BasicStateCache<Context>::VSSetShader(ID3D11VertexShader* const shader, ID3D11ClassInstance* const* const instances,
+                                           const UINT instanceCount)
+{
+	if (Issue(shader != m_vertexShader || instanceCount))
+	{
+		m_vertexShader = instanceCount ? Unknown<ID3D11VertexShader>() : shader;
+		m_context->VSSetShader(shader, instances, instanceCount);
+	}
+}
+
+template <typename Context>
+void BasicStateCache<Context>::VSSetConstantBuffers(const UINT startSlot, const UINT count, ID3D11Buffer* const* const buffers)
+{
+	if (Issue(SetSlots(m_vertexConstants, startSlot, count, buffers)))
+		m_context->VSSetConstantBuffers(startSlot, count, buffers);
+}
+
+template <typename Context>
+void BasicStateCache<Context>::PSSetShader(ID3D11PixelShader* const shader, ID3D11ClassInstance* const* const instances,
+                                           const UINT instanceCount)
+{
+	if (Issue(shader != m_pixelShader || instanceCount))
+	{
+		m_pixelShader = instanceCount ? Unknown<ID3D11PixelShader>() : shader;
+		m_context->PSSetShader(shader, instances, instanceCount);
+	}
+}
+
+template <typename Context>
+void BasicStateCache<Context>::PSSetConstantBuffers(const UINT startSlot, const UINT count, ID3D11Buffer* const* const buffers)
+{
+	if (Issue(SetSlots(m_pixelConstants, startSlot, count, buffers)))
+		m_context->PSSetConstantBuffers(startSlot, count, buffers);
+}
+
+template <typename Context>
+void BasicStateCache<Context>::PSSetShaderResources(const UINT startSlot, const UINT count, ID3D11ShaderResourceView* const* const views)
+{
+	if (Issue(SetSlots(m_pixelResources, startSlot, count, views)))
+		m_context->PSSetShaderResources(startSlot, count, views);
+}
+
+template <typename Context>
+void BasicStateCache<Context>::PSSetSamplers(const UINT startSlot, const UINT count, ID3D11SamplerState* const* const samplers)
+{
+	if (Issue(SetSlots(m_pixelSamplers, startSlot, count, samplers)))
+		m_context->PSSetSamplers(startSlot, count, samplers);
+}
+
+template <typename Context>
+void BasicStateCache<Context>::RSSetState(ID3D11RasterizerState* const state)
+{
+	if (Issue(state != m_rasterState))
+	{
+		m_rasterState = state;
+		m_context->RSSetState(state);
+	}
+}
+
+template <typename Context>
+void BasicStateCache<Context>::OMSetDepthStencilState(ID3D11DepthStencilState* const state, const UINT stencilRef)
+{
+	if (Issue(state != m_depthState || stencilRef != m_stencilRef))
+	{
+		m_depthState = state;
+		m_stencilRef = stencilRef;
+		m_context->OMSetDepthStencilState(state, stencilRef);
+	}
+}
+
+// A null blend factor is taken as ones, as the context takes it
+template <typename Context>
+void BasicStateCache<Context>::OMSetBlendState(ID3D11BlendState* const state, const FLOAT blendFactor[4], const UINT sampleMask)
+{
+	static const FLOAT ones[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	const FLOAT* const factor = blendFactor ? blendFactor : ones;
+	bool changed = state != m_blendState || sampleMask != m_sampleMask;
+	for (int i = 0; i < 4; ++i)
+		changed = changed || factor[i] != m_blendFactor[i];
+	if (Issue(changed))
+	{
+		m_blendState = state;
+		m_sampleMask = sampleMask;
+		for (int i = 0; i < 4; ++i)
+			m_blendFactor[i] = factor[i];
+		m_context->OMSetBlendState(state, blendFactor, sampleMask);
+	}
+}
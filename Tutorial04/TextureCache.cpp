@@ -0,0 +1,46 @@
+#include "TextureCache.h"
+#include "DDSTextureLoader.h"
+#include "Hash.h"
+#include <wctype.h>
+
+using namespace DirectX;
+
+std::wstring TextureCachePathKey(const wchar_t* const fileName, const size_t maxsize)
+{
+	std::wstring key(fileName);
+	for (wchar_t& c : key)
+		c = static_cast<wchar_t>(towlower(c));
+	key += L'|';
+	key += std::to_wstring(maxsize);
+	return key;
+}
+
+FILETIME TextureCacheLastWrite(const wchar_t* const fileName)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data = {};
+	if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &data))
+		return FILETIME{};
+	return data.ftLastWriteTime;
+}
+
+HRESULT ReadTextureCacheData(const wchar_t* const fileName, const size_t maxsize, std::unique_ptr<uint8_t[]>& ddsData, size_t* const ddsDataSize,
+                             uint64_t* const contentHash)
+{
+	HRESULT hr = LoadDDSDataFromFile(fileName, maxsize, ddsData, ddsDataSize);
+	if (FAILED(hr))
+		return hr;
+
+	*contentHash = HashBytes(ddsData.get(), *ddsDataSize);
+	return GenerateDDSMipChain(ddsData, ddsDataSize, MIP_FILTER_KAISER, false, nullptr);
+}
+
+HRESULT CreateCachedTexture(ID3D11Device* const device, const uint8_t* const ddsData, const size_t ddsDataSize, const size_t maxsize,
+                            ID3D11ShaderResourceView** const textureView, size_t* const gpuBytes)
+{
+	HRESULT hr = GetDDSTextureMemorySize(ddsData, ddsDataSize, maxsize, gpuBytes);
+	if (FAILED(hr))
+		return hr;
+
+	return CreateDDSTextureFromMemoryEx(device, ddsData, ddsDataSize, maxsize, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
+	                                    nullptr, textureView);
+}
@@ -0,0 +1,296 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// What BasicTextureCache needs from outside: path keys, file times, reading a file the way
+// Get caches it, and creating a texture on a device.
+//--------------------------------------------------------------------------------------
+
+// Paths are case-insensitive, and the same file loaded with another maxsize is a different texture
+std::wstring TextureCachePathKey(const wchar_t* fileName, size_t maxsize);
+
+// FILETIME of the file's last write, or zero when it cannot be read
+FILETIME TextureCacheLastWrite(const wchar_t* fileName);
+
+// Reads a DDS file, hashes the image as read, then gives it a mip chain when it has none
+HRESULT ReadTextureCacheData(const wchar_t* fileName, size_t maxsize, std::unique_ptr<uint8_t[]>& ddsData, size_t* ddsDataSize,
+                             uint64_t* contentHash);
+
+// Creates the view for a DDS image and says how much texture memory it takes. The cache
+// calls this unqualified, so another Device type brings its own overload along.
+HRESULT CreateCachedTexture(ID3D11Device* device, const uint8_t* ddsData, size_t ddsDataSize, size_t maxsize,
+                            ID3D11ShaderResourceView** textureView, size_t* gpuBytes);
+
+//--------------------------------------------------------------------------------------
+// Keeps created textures so that asking for the same file again costs a lookup instead of
+// a read and an upload. Entries are found by path first. A file read under a new path is
+// matched by the hash of its contents, and identical data shares the existing view. Once
+// the cached bytes pass the budget the least recently used entries are released.
+// Not thread-safe: use it from the thread that owns the device.
+//
+// Device and View are ID3D11Device and ID3D11ShaderResourceView in the program, hence
+// TextureCache; AssetTool checks the bookkeeping with a device that only counts views.
+//--------------------------------------------------------------------------------------
+template <typename Device, typename View>
+class BasicTextureCache
+{
+public:
+	struct Stats
+	{
+		uint64_t hits;          // found by path
+		uint64_t contentHits;   // new path, but the same data was already cached
+		uint64_t misses;        // had to be created
+		uint64_t evictions;
+		size_t entries;
+		size_t gpuBytes;        // texture memory, as CreateCachedTexture reported it
+		size_t cpuBytes;        // the cache's own bookkeeping
+	};
+
+	explicit BasicTextureCache(const size_t budgetBytes) : m_budget(budgetBytes) {}
+	~BasicTextureCache() { Clear(); }
+
+	BasicTextureCache(const BasicTextureCache&) = delete;
+	BasicTextureCache& operator=(const BasicTextureCache&) = delete;
+
+	// Returns a new reference to the cached view when 'fileName' was cached with the same
+	// maxsize and has not been written to since
+	bool Find(const wchar_t* fileName, size_t maxsize, View** textureView);
+
+	// Caches a DDS image that has already been read. contentHash is HashBytes over the
+	// image as LoadDDSDataFromFile returned it, so readers can compute it off this thread.
+	// The view returned carries a reference of its own.
+	HRESULT Insert(Device* device, const wchar_t* fileName, size_t maxsize, const uint8_t* ddsData, size_t ddsDataSize,
+	               uint64_t contentHash, View** textureView);
+
+	// Find, or read, hash and Insert
+	HRESULT Get(Device* device, const wchar_t* fileName, View** textureView, size_t maxsize = 0);
+
+	// Evicts straight away when the cache is already over the new budget
+	void SetBudget(size_t budgetBytes);
+	size_t Budget() const { return m_budget; }
+
+	void Clear();
+
+	Stats GetStats() const;
+
+private:
+	struct Entry
+	{
+		View* textureView;
+		uint64_t contentKey;    // content hash mixed with maxsize
+		size_t gpuBytes;
+		size_t cpuBytes;
+		std::vector<std::wstring> paths;   // every path key that resolves to this entry
+	};
+
+	typedef std::list<Entry> EntryList;   // most recently used first
+	typedef typename EntryList::iterator EntryIterator;
+
+	struct PathEntry
+	{
+		EntryIterator entry;
+		FILETIME lastWrite;
+	};
+
+	static size_t PathBytes(const std::wstring& key) { return sizeof(PathEntry) + 2 * (key.size() + 1) * sizeof(wchar_t); }
+	void AddPath(const std::wstring& key, const wchar_t* fileName, EntryIterator entry);
+	void RemovePath(const std::wstring& key);
+	void Touch(EntryIterator entry) { m_entries.splice(m_entries.begin(), m_entries, entry); }
+	void Erase(EntryIterator entry);
+	void Evict();
+
+	EntryList m_entries;
+	std::unordered_map<std::wstring, PathEntry> m_paths;
+	std::unordered_map<uint64_t, EntryIterator> m_contents;
+	size_t m_budget;
+	Stats m_stats = {};
+};
+
+typedef BasicTextureCache<ID3D11Device, ID3D11ShaderResourceView> TextureCache;
+
+template <typename Device, typename View>
+void BasicTextureCache<Device, View>::AddPath(const std::wstring& key, const wchar_t* const fileName, const EntryIterator entry)
+{
+	RemovePath(key);
+
+	m_paths[key] = PathEntry{ entry, TextureCacheLastWrite(fileName) };
+	entry->paths.push_back(key);
+
+	entry->cpuBytes += PathBytes(key);
+	m_stats.cpuBytes += PathBytes(key);
+}
+
+template <typename Device, typename View>
+void BasicTextureCache<Device, View>::RemovePath(const std::wstring& key)
+{
+	const auto found = m_paths.find(key);
+	if (found == m_paths.end())
+		return;
+
+	Entry& entry = *found->second.entry;
+	for (auto path = entry.paths.begin(); path != entry.paths.end(); ++path)
+	{
+		if (*path == key)
+		{
+			entry.paths.erase(path);
+			break;
+		}
+	}
+
+	entry.cpuBytes -= PathBytes(key);
+	m_stats.cpuBytes -= PathBytes(key);
+	m_paths.erase(found);
+}
+
+template <typename Device, typename View>
+void BasicTextureCache<Device, View>::Erase(const EntryIterator entry)
+{
+	while (!entry->paths.empty())
+		RemovePath(entry->paths.back());
+
+	m_contents.erase(entry->contentKey);
+	m_stats.gpuBytes -= entry->gpuBytes;
+	m_stats.cpuBytes -= entry->cpuBytes;
+
+	// Views still held elsewhere keep the texture alive; the cache only drops its reference
+	entry->textureView->Release();
+	m_entries.erase(entry);
+}
+
+template <typename Device, typename View>
+void BasicTextureCache<Device, View>::Evict()
+{
+	// The most recently used entry stays even when it is over budget on its own
+	while (m_stats.gpuBytes + m_stats.cpuBytes > m_budget && m_entries.size() > 1)
+	{
+		Erase(std::prev(m_entries.end()));
+		++m_stats.evictions;
+	}
+}
+
+template <typename Device, typename View>
+bool BasicTextureCache<Device, View>::Find(const wchar_t* const fileName, const size_t maxsize, View** const textureView)
+{
+	if (!fileName || !textureView)
+		return false;
+
+	const std::wstring key = TextureCachePathKey(fileName, maxsize);
+	const auto found = m_paths.find(key);
+	if (found == m_paths.end())
+		return false;
+
+	// A file that changed on disk has to be read again; its old data may still be shared
+	// by other paths, so only this path is forgotten
+	const FILETIME lastWrite = TextureCacheLastWrite(fileName);
+	if (CompareFileTime(&lastWrite, &found->second.lastWrite) != 0)
+	{
+		RemovePath(key);
+		return false;
+	}
+
+	const EntryIterator entry = found->second.entry;
+	Touch(entry);
+	entry->textureView->AddRef();
+	*textureView = entry->textureView;
+	++m_stats.hits;
+	return true;
+}
+
+template <typename Device, typename View>
+HRESULT BasicTextureCache<Device, View>::Insert(Device* const device, const wchar_t* const fileName, const size_t maxsize,
+                                                const uint8_t* const ddsData, const size_t ddsDataSize, const uint64_t contentHash,
+                                                View** const textureView)
+{
+	if (!device || !fileName || !ddsData || !textureView)
+		return E_INVALIDARG;
+
+	*textureView = nullptr;
+	const std::wstring key = TextureCachePathKey(fileName, maxsize);
+
+	// Single-mip files get their chain after hashing, and maxsize then decides which mips
+	// are created, so equal data only means an equal texture at the same maxsize
+	const uint64_t contentKey = contentHash ^ (static_cast<uint64_t>(maxsize) * 0x9E3779B97F4A7C15ULL);
+
+	const auto sameContent = m_contents.find(contentKey);
+	if (sameContent != m_contents.end())
+	{
+		const EntryIterator entry = sameContent->second;
+		AddPath(key, fileName, entry);
+		Touch(entry);
+		entry->textureView->AddRef();
+		*textureView = entry->textureView;
+		++m_stats.contentHits;
+
+		// The new path's bookkeeping counts against the budget like a new texture would
+		Evict();
+		return S_OK;
+	}
+
+	View* view = nullptr;
+	size_t gpuBytes = 0;
+	const HRESULT hr = CreateCachedTexture(device, ddsData, ddsDataSize, maxsize, &view, &gpuBytes);
+	if (FAILED(hr))
+		return hr;
+
+	++m_stats.misses;
+	m_entries.push_front(Entry{ view, contentKey, gpuBytes, sizeof(Entry) + sizeof(EntryIterator), {} });
+	const EntryIterator entry = m_entries.begin();
+	m_contents[contentKey] = entry;
+	m_stats.gpuBytes += entry->gpuBytes;
+	m_stats.cpuBytes += entry->cpuBytes;
+	AddPath(key, fileName, entry);
+
+	view->AddRef();
+	*textureView = view;
+
+	Evict();
+	return S_OK;
+}
+
+template <typename Device, typename View>
+HRESULT BasicTextureCache<Device, View>::Get(Device* const device, const wchar_t* const fileName, View** const textureView, const size_t maxsize)
+{
+	if (!device || !fileName || !textureView)
+		return E_INVALIDARG;
+
+	if (Find(fileName, maxsize, textureView))
+		return S_OK;
+
+	std::unique_ptr<uint8_t[]> ddsData;
+	size_t ddsDataSize = 0;
+	uint64_t contentHash = 0;
+	const HRESULT hr = ReadTextureCacheData(fileName, maxsize, ddsData, &ddsDataSize, &contentHash);
+	if (FAILED(hr))
+		return hr;
+
+	return Insert(device, fileName, maxsize, ddsData.get(), ddsDataSize, contentHash, textureView);
+}
+
+template <typename Device, typename View>
+void BasicTextureCache<Device, View>::SetBudget(const size_t budgetBytes)
+{
+	m_budget = budgetBytes;
+	Evict();
+}
+
+template <typename Device, typename View>
+void BasicTextureCache<Device, View>::Clear()
+{
+	while (!m_entries.empty())
+		Erase(m_entries.begin());
+}
+
+template <typename Device, typename View>
+typename BasicTextureCache<Device, View>::Stats BasicTextureCache<Device, View>::GetStats() const
+{
+	Stats stats = m_stats;
+	stats.entries = m_entries.size();
+	return stats;
+}
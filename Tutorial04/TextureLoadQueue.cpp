@@ -0,0 +1,186 @@
+#include "TextureLoadQueue.h"
+#include "AssetArchive.h"
+#include "DDSTextureLoader.h"
+#include "Hash.h"
+#include "LZCodec.h"
+
+using namespace DirectX;
+
+bool DeviceTextureSink::Find(const wchar_t* const fileName, const size_t maxsize, ID3D11ShaderResourceView** const textureView)
+{
+	return m_cache && m_cache->Find(fileName, maxsize, textureView);
+}
+
+HRESULT DeviceTextureSink::Create(const wchar_t* const fileName, const size_t maxsize, const uint8_t* const ddsData, const size_t ddsDataSize,
+                                  const uint64_t contentHash, ID3D11ShaderResourceView** const textureView)
+{
+	if (m_cache)
+		return m_cache->Insert(m_device, fileName, maxsize, ddsData, ddsDataSize, contentHash, textureView);
+
+	return CreateDDSTextureFromMemoryEx(m_device, ddsData, ddsDataSize, maxsize, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
+	                                    nullptr, textureView);
+}
+
+TextureLoadQueue::TextureLoadQueue(ThreadPool& pool, TextureSink& sink, const size_t maxReady, const AssetArchive* const archive)
+	: m_pool(pool)
+	, m_sink(sink)
+	, m_archive(archive)
+	, m_maxReady(maxReady > 0 ? maxReady : 1)
+{
+}
+
+TextureLoadQueue::~TextureLoadQueue()
+{
+	// Readers still in flight touch this object, so wait for them; their data is dropped
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_closing = true;
+	m_readyChanged.notify_all();
+	m_readyChanged.wait(lock, [this] { return m_reading == 0; });
+
+	for (auto& request : m_ready)
+		Finish(*request, E_ABORT);
+	m_ready.clear();
+}
+
+std::future<HRESULT> TextureLoadQueue::Submit(const wchar_t* const fileName, ID3D11ShaderResourceView** const textureView, const size_t maxsize)
+{
+	auto request = std::make_shared<Request>();
+	auto future = request->result.get_future();
+
+	if (!fileName || !textureView)
+	{
+		request->result.set_value(E_INVALIDARG);
+		return future;
+	}
+
+	*textureView = nullptr;
+	if (m_sink.Find(fileName, maxsize, textureView))
+	{
+		request->result.set_value(S_OK);
+		return future;
+	}
+
+	request->fileName = fileName;
+	request->maxsize = maxsize;
+	request->textureView = textureView;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_pending;
+		++m_reading;
+	}
+
+	m_pool.Submit([this, request] { Read(request); });
+	return future;
+}
+
+void TextureLoadQueue::Read(const std::shared_ptr<Request>& request)
+{
+	// Packed textures already carry their mips, so nothing here has to copy them
+	const bool archived = m_archive && SUCCEEDED(m_archive->Find(request->fileName.c_str(), &request->archiveData, &request->ddsDataSize));
+
+	HRESULT hr = archived ? S_OK : LoadDDSDataFromFile(request->fileName.c_str(), request->maxsize, request->ddsData, &request->ddsDataSize, &m_pool);
+
+	// unless they were packed LZ-chunked, in which case they expand into a heap copy
+	if (archived && IsLZChunked(request->archiveData, request->ddsDataSize))
+	{
+		hr = LZDecompressChunked(request->archiveData, request->ddsDataSize, request->ddsData, &request->ddsDataSize, &m_pool);
+		request->archiveData = nullptr;
+	}
+
+	if (SUCCEEDED(hr) && m_sink.WantsContentHash())
+		request->contentHash = HashBytes(request->Data(), request->ddsDataSize);
+
+	// The device thread has no context to GenerateMips with, so files without mips get
+	// their chain here instead
+	if (SUCCEEDED(hr) && !archived)
+		hr = GenerateDDSMipChain(request->ddsData, &request->ddsDataSize, MIP_FILTER_KAISER, false, &m_pool);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (SUCCEEDED(hr))
+		m_readyChanged.wait(lock, [this] { return m_closing || m_ready.size() < m_maxReady; });
+
+	// Failed reads never reach the device thread
+	if (FAILED(hr))
+		Finish(*request, hr);
+	else if (m_closing)
+		Finish(*request, E_ABORT);
+	else
+		m_ready.push_back(request);
+
+	--m_reading;
+	m_readyChanged.notify_all();
+}
+
+void TextureLoadQueue::Finish(Request& request, const HRESULT hr)
+{
+	request.ddsData.reset();
+	request.archiveData = nullptr;
+	request.result.set_value(hr);
+
+	if (FAILED(hr) && SUCCEEDED(m_firstFailure))
+		m_firstFailure = hr;
+	--m_pending;
+}
+
+std::shared_ptr<TextureLoadQueue::Request> TextureLoadQueue::PopReady(const bool wait)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (wait)
+		m_readyChanged.wait(lock, [this] { return m_pending == 0 || !m_ready.empty(); });
+
+	if (m_ready.empty())
+		return nullptr;
+
+	auto request = m_ready.front();
+	m_ready.pop_front();
+
+	// A reader may be waiting for the slot that just freed up
+	m_readyChanged.notify_all();
+	return request;
+}
+
+HRESULT TextureLoadQueue::Create(Request& request)
+{
+	const HRESULT hr = m_sink.Create(request.fileName.c_str(), request.maxsize, request.Data(), request.ddsDataSize, request.contentHash,
+	                                 request.textureView);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Finish(request, hr);
+	return hr;
+}
+
+size_t TextureLoadQueue::Pump()
+{
+	size_t created = 0;
+	while (auto request = PopReady(false))
+	{
+		if (SUCCEEDED(Create(*request)))
+			++created;
+	}
+
+	return created;
+}
+
+HRESULT TextureLoadQueue::Flush()
+{
+	while (auto request = PopReady(true))
+		Create(*request);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const HRESULT hr = m_firstFailure;
+	m_firstFailure = S_OK;
+	return hr;
+}
+
+size_t TextureLoadQueue::Pending() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pending;
+}
+
+size_t TextureLoadQueue::Ready() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_ready.size();
+}
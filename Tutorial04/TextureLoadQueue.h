@@ -0,0 +1,121 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "TextureCache.h"
+#include "ThreadPool.h"
+
+class AssetArchive;
+
+//--------------------------------------------------------------------------------------
+// Where a TextureLoadQueue's textures come from. Both calls are made on the thread that
+// owns the device: Find from Submit, before a file is read, and Create from Pump and
+// Flush once it has been. DeviceTextureSink creates them on a device; AssetTool checks
+// the queue with a sink that creates nothing.
+//--------------------------------------------------------------------------------------
+class TextureSink
+{
+public:
+	virtual ~TextureSink() {}
+
+	// True, with a new reference in textureView, when the file need not be read at all
+	virtual bool Find(const wchar_t* fileName, size_t maxsize, ID3D11ShaderResourceView** textureView) = 0;
+
+	// Whether Create uses contentHash; the readers only hash the file images when it does
+	virtual bool WantsContentHash() const = 0;
+
+	// ddsData is the file image with its mips; contentHash is HashBytes over it as read
+	virtual HRESULT Create(const wchar_t* fileName, size_t maxsize, const uint8_t* ddsData, size_t ddsDataSize, uint64_t contentHash,
+	                       ID3D11ShaderResourceView** textureView) = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// Creates the textures on a device. With a cache, files it already holds are not read
+// again and new textures are created through it.
+//--------------------------------------------------------------------------------------
+class DeviceTextureSink : public TextureSink
+{
+public:
+	explicit DeviceTextureSink(ID3D11Device* const device, TextureCache* const cache = nullptr) : m_device(device), m_cache(cache) {}
+
+	bool Find(const wchar_t* fileName, size_t maxsize, ID3D11ShaderResourceView** textureView) override;
+	bool WantsContentHash() const override { return m_cache != nullptr; }
+	HRESULT Create(const wchar_t* fileName, size_t maxsize, const uint8_t* ddsData, size_t ddsDataSize, uint64_t contentHash,
+	               ID3D11ShaderResourceView** textureView) override;
+
+private:
+	ID3D11Device* const m_device;
+	TextureCache* const m_cache;
+};
+
+//--------------------------------------------------------------------------------------
+// Loads batches of DDS textures. Pool workers read and validate the files, then park the
+// file images in a bounded ready queue; the thread that owns the device hands them to the
+// sink in Pump() or Flush(), and calls Submit too since the sink may answer from there.
+// While the ready queue is full the readers wait, so no more than 'maxReady' file images
+// are held in memory at once. With an archive, textures packed in it are created straight
+// from its mapping and only the rest are read from loose files.
+//--------------------------------------------------------------------------------------
+class TextureLoadQueue
+{
+public:
+	TextureLoadQueue(ThreadPool& pool, TextureSink& sink, size_t maxReady = 4, const AssetArchive* archive = nullptr);
+	~TextureLoadQueue();
+
+	TextureLoadQueue(const TextureLoadQueue&) = delete;
+	TextureLoadQueue& operator=(const TextureLoadQueue&) = delete;
+
+	// The view is written once the texture has been created; the future carries the result
+	std::future<HRESULT> Submit(const wchar_t* fileName, ID3D11ShaderResourceView** textureView, size_t maxsize = 0);
+
+	// Creates the textures that are already read, without waiting. Returns how many were created
+	size_t Pump();
+
+	// Creates textures until every submitted load has finished. Returns the first failure
+	// since the previous Flush, including files that could not be read
+	HRESULT Flush();
+
+	size_t Pending() const;
+
+	// File images read and waiting for Pump or Flush; never more than maxReady
+	size_t Ready() const;
+
+private:
+	struct Request
+	{
+		std::wstring fileName;
+		size_t maxsize = 0;
+		ID3D11ShaderResourceView** textureView = nullptr;
+		std::promise<HRESULT> result;
+		std::unique_ptr<uint8_t[]> ddsData;
+		const uint8_t* archiveData = nullptr;   // into the archive mapping instead of ddsData
+		size_t ddsDataSize = 0;
+		uint64_t contentHash = 0;   // of the file image as read, when the sink wants it
+
+		const uint8_t* Data() const { return archiveData ? archiveData : ddsData.get(); }
+	};
+
+	void Read(const std::shared_ptr<Request>& request);
+	std::shared_ptr<Request> PopReady(bool wait);
+	HRESULT Create(Request& request);
+	void Finish(Request& request, HRESULT hr);   // called with m_mutex held
+
+	ThreadPool& m_pool;
+	TextureSink& m_sink;
+	const AssetArchive* const m_archive;
+	const size_t m_maxReady;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_readyChanged;
+	std::deque<std::shared_ptr<Request>> m_ready;
+	size_t m_pending = 0;   // submitted and not yet created or failed
+	size_t m_reading = 0;   // currently owned by a pool worker
+	HRESULT m_firstFailure = S_OK;
+	bool m_closing = false;
+};
@@ -0,0 +1,411 @@
+#include "TextureResidency.h"
+#include "DDSTextureLoader.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Frames without a request before a texture only wants its tail again
+	const uint64_t IDLE_FRAMES = 120;
+
+	// Frames to wait before reading a level again that was read but did not fit
+	const uint64_t RETRY_FRAMES = 60;
+}
+
+TextureResidency::TextureResidency(ThreadPool& pool, const size_t budgetBytes, const size_t tailSize, const size_t maxReads)
+	: m_pool(pool)
+	, m_budget(budgetBytes)
+	, m_tailSize(tailSize > 0 ? tailSize : 1)
+	, m_maxReads(maxReads > 0 ? maxReads : 1)
+{
+}
+
+TextureResidency::~TextureResidency()
+{
+	// Readers in flight post their levels here, so wait for them
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_readDone.wait(lock, [this] { return m_reading == 0; });
+	}
+
+	// The views belong to the callers, who release them
+	for (auto& texture : m_textures)
+	{
+		if (texture->resource)
+			texture->resource->Release();
+	}
+}
+
+HRESULT TextureResidency::Register(ID3D11Device* const device, const wchar_t* const fileName, ID3D11ShaderResourceView** const textureView,
+                                   Handle* const handle)
+{
+	if (!device || !fileName || !textureView || !handle)
+		return E_INVALIDARG;
+
+	*textureView = nullptr;
+
+	DDS_TEXTURE_INFO info;
+	HRESULT hr = GetDDSTextureInfo(fileName, &info);
+	if (FAILED(hr))
+		return hr;
+
+	std::unique_ptr<Texture> texture(new (std::nothrow) Texture);
+	if (!texture)
+		return E_OUTOFMEMORY;
+
+	texture->fileName = fileName;
+	texture->textureView = textureView;
+	texture->width = info.width;
+	texture->height = info.height;
+	texture->mipCount = info.mipCount;
+	texture->arraySize = info.arraySize;
+	texture->format = info.format;
+	texture->isCubeMap = info.isCubeMap;
+	texture->lastRequest = m_frame;
+
+	// The tail starts at the first level that fits, the rule FillInitData applies to maxsize
+	size_t tailMip = 0;
+	while (tailMip < info.mipCount &&
+	       (std::max<size_t>(info.width >> tailMip, 1) > m_tailSize || std::max<size_t>(info.height >> tailMip, 1) > m_tailSize))
+	{
+		++tailMip;
+	}
+
+	texture->streamable = info.resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D && tailMip > 0 && tailMip < info.mipCount;
+	texture->tailMip = texture->streamable ? tailMip : 0;
+	texture->residentMip = texture->tailMip;
+	texture->wantedMip = texture->tailMip;
+	texture->levelBytes.resize(info.mipCount, 0);
+
+	const size_t maxsize = texture->streamable ? m_tailSize : 0;
+
+	std::unique_ptr<uint8_t[]> ddsData;
+	size_t ddsDataSize = 0;
+	hr = LoadDDSDataFromFile(fileName, maxsize, ddsData, &ddsDataSize, &m_pool);
+
+	// Whole textures without mips get their chain here, as the load queue does
+	if (SUCCEEDED(hr) && !texture->streamable)
+		hr = GenerateDDSMipChain(ddsData, &ddsDataSize, MIP_FILTER_KAISER, false, &m_pool);
+
+	if (SUCCEEDED(hr))
+		hr = GetDDSTextureMemorySize(ddsData.get(), ddsDataSize, maxsize, &texture->bytes);
+
+	if (SUCCEEDED(hr))
+		hr = CreateDDSTextureFromMemoryEx(device, ddsData.get(), ddsDataSize, maxsize, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+		                                  false, &texture->resource, textureView);
+	if (FAILED(hr))
+		return hr;
+
+	// Resized views copy everything but the mip range from the one the loader made
+	(*textureView)->GetDesc(&texture->viewDesc);
+
+	m_residentBytes += texture->bytes;
+	*handle = m_textures.size();
+	m_textures.push_back(std::move(texture));
+	return S_OK;
+}
+
+void TextureResidency::RequestLod(const Handle handle, const float lod)
+{
+	if (handle >= m_textures.size())
+		return;
+
+	Texture& texture = *m_textures[handle];
+	texture.requestedLod = texture.lastRequest == m_frame ? std::min(texture.requestedLod, lod) : lod;
+	texture.lastRequest = m_frame;
+}
+
+float TextureResidency::LodForScreenSize(const Handle handle, const float screenPixels) const
+{
+	if (handle >= m_textures.size())
+		return 0.0f;
+
+	const Texture& texture = *m_textures[handle];
+	if (screenPixels < 1.0f)
+		return static_cast<float>(texture.mipCount - 1);
+
+	const float size = static_cast<float>(std::max(texture.width, texture.height));
+	return std::max(0.0f, log2f(size / screenPixels));
+}
+
+void TextureResidency::Read(const Handle handle, const std::wstring& fileName, const size_t mip)
+{
+	Level level;
+	level.handle = handle;
+	level.mip = mip;
+	level.rowPitch = 0;
+	level.slicePitch = 0;
+	level.hr = LoadDDSMipFromFile(fileName.c_str(), mip, level.data, &level.rowPitch, &level.slicePitch, &m_pool);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_levels.push_back(std::move(level));
+	--m_reading;
+	m_readDone.notify_all();
+}
+
+void TextureResidency::Update(ID3D11Device* const device, ID3D11DeviceContext* const context)
+{
+	if (!device || !context)
+		return;
+
+	std::vector<Level> levels;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		levels.swap(m_levels);
+	}
+
+	// What each texture wants, from the requests made while the last frame was drawn
+	for (auto& texture : m_textures)
+	{
+		if (texture->lastRequest == m_frame)
+		{
+			const float lod = std::max(0.0f, floorf(texture->requestedLod));
+			texture->wantedMip = std::min(static_cast<size_t>(lod), texture->tailMip);
+		}
+		else if (m_frame - texture->lastRequest > IDLE_FRAMES)
+		{
+			texture->wantedMip = texture->tailMip;
+		}
+	}
+
+	for (auto& level : levels)
+	{
+		Texture& texture = *m_textures[level.handle];
+		texture.reading = false;
+
+		// A file that cannot be read keeps whatever is resident and stops streaming
+		if (FAILED(level.hr))
+		{
+			texture.streamable = false;
+			continue;
+		}
+
+		// Trimmed while the level was read, or no longer wanted
+		if (level.mip + 1 != texture.residentMip || level.mip < texture.wantedMip)
+			continue;
+
+		if (!MakeRoom(device, context, level.slicePitch * texture.arraySize, &texture))
+		{
+			++m_stats.rejected;
+			texture.retryFrame = m_frame + RETRY_FRAMES;
+			continue;
+		}
+
+		if (SUCCEEDED(Resize(device, context, texture, level.mip, &level)))
+			++m_stats.uploads;
+		else
+			texture.streamable = false;
+	}
+	levels.clear();
+
+	MakeRoom(device, context, 0, nullptr);
+
+	// Read the next level of the textures furthest from what they want first
+	std::vector<Handle> wanted;
+	for (Handle handle = 0; handle < m_textures.size(); ++handle)
+	{
+		const Texture& texture = *m_textures[handle];
+		if (texture.streamable && !texture.reading && texture.wantedMip < texture.residentMip && texture.retryFrame <= m_frame)
+			wanted.push_back(handle);
+	}
+
+	std::sort(wanted.begin(), wanted.end(), [this](const Handle a, const Handle b)
+	{
+		const Texture& textureA = *m_textures[a];
+		const Texture& textureB = *m_textures[b];
+		const size_t gapA = textureA.residentMip - textureA.wantedMip;
+		const size_t gapB = textureB.residentMip - textureB.wantedMip;
+		return gapA != gapB ? gapA > gapB : textureA.lastRequest > textureB.lastRequest;
+	});
+
+	for (const Handle handle : wanted)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_reading >= m_maxReads)
+				break;
+			++m_reading;
+		}
+
+		Texture& texture = *m_textures[handle];
+		texture.reading = true;
+
+		const std::wstring fileName = texture.fileName;
+		const size_t mip = texture.residentMip - 1;
+		m_pool.Submit([this, handle, fileName, mip] { Read(handle, fileName, mip); });
+	}
+
+	++m_frame;
+}
+
+void TextureResidency::SetBudget(ID3D11Device* const device, ID3D11DeviceContext* const context, const size_t budgetBytes)
+{
+	m_budget = budgetBytes;
+	if (device && context)
+		MakeRoom(device, context, 0, nullptr);
+}
+
+size_t TextureResidency::ResidentMip(const Handle handle) const
+{
+	return handle < m_textures.size() ? m_textures[handle]->residentMip : 0;
+}
+
+TextureResidency::Stats TextureResidency::GetStats() const
+{
+	Stats stats = m_stats;
+	stats.residentBytes = m_residentBytes;
+	stats.textures = m_textures.size();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		stats.reading = m_reading;
+	}
+	return stats;
+}
+
+HRESULT TextureResidency::Resize(ID3D11Device* const device, ID3D11DeviceContext* const context, Texture& texture, const size_t topMip,
+                                 const Level* const level)
+{
+	// Growing needs the data of the one new level; shrinking only drops levels
+	if (topMip >= texture.mipCount || (topMip < texture.residentMip && (!level || topMip + 1 != texture.residentMip)))
+		return E_INVALIDARG;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = static_cast<UINT>(std::max<size_t>(texture.width >> topMip, 1));
+	desc.Height = static_cast<UINT>(std::max<size_t>(texture.height >> topMip, 1));
+	desc.MipLevels = static_cast<UINT>(texture.mipCount - topMip);
+	desc.ArraySize = static_cast<UINT>(texture.arraySize);
+	desc.Format = texture.format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = texture.isCubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+	ID3D11Texture2D* resized = nullptr;
+	HRESULT hr = device->CreateTexture2D(&desc, nullptr, &resized);
+	if (FAILED(hr))
+		return hr;
+
+	// Levels already resident move across on the GPU; only the new one comes from memory
+	const UINT oldLevels = static_cast<UINT>(texture.mipCount - texture.residentMip);
+	for (UINT slice = 0; slice < desc.ArraySize; ++slice)
+	{
+		for (UINT mipLevel = 0; mipLevel < desc.MipLevels; ++mipLevel)
+		{
+			const size_t mip = topMip + mipLevel;
+			const UINT dest = D3D11CalcSubresource(mipLevel, slice, desc.MipLevels);
+			if (mip < texture.residentMip)
+			{
+				context->UpdateSubresource(resized, dest, nullptr, level->data.get() + slice * level->slicePitch,
+				                           static_cast<UINT>(level->rowPitch), static_cast<UINT>(level->slicePitch));
+			}
+			else
+			{
+				const UINT source = D3D11CalcSubresource(static_cast<UINT>(mip - texture.residentMip), slice, oldLevels);
+				context->CopySubresourceRegion(resized, dest, 0, 0, 0, texture.resource, source, nullptr);
+			}
+		}
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = texture.viewDesc;
+	switch (viewDesc.ViewDimension)
+	{
+	case D3D11_SRV_DIMENSION_TEXTURE2DARRAY:
+		viewDesc.Texture2DArray.MostDetailedMip = 0;
+		viewDesc.Texture2DArray.MipLevels = desc.MipLevels;
+		break;
+
+	case D3D11_SRV_DIMENSION_TEXTURECUBE:
+		viewDesc.TextureCube.MostDetailedMip = 0;
+		viewDesc.TextureCube.MipLevels = desc.MipLevels;
+		break;
+
+	case D3D11_SRV_DIMENSION_TEXTURECUBEARRAY:
+		viewDesc.TextureCubeArray.MostDetailedMip = 0;
+		viewDesc.TextureCubeArray.MipLevels = desc.MipLevels;
+		break;
+
+	default:
+		viewDesc.Texture2D.MostDetailedMip = 0;
+		viewDesc.Texture2D.MipLevels = desc.MipLevels;
+		break;
+	}
+
+	ID3D11ShaderResourceView* view = nullptr;
+	hr = device->CreateShaderResourceView(resized, &viewDesc, &view);
+	if (FAILED(hr))
+	{
+		resized->Release();
+		return hr;
+	}
+
+	if (topMip < texture.residentMip)
+	{
+		texture.levelBytes[topMip] = level->slicePitch * texture.arraySize;
+		texture.bytes += texture.levelBytes[topMip];
+		m_residentBytes += texture.levelBytes[topMip];
+	}
+	else
+	{
+		for (size_t mip = texture.residentMip; mip < topMip; ++mip)
+		{
+			texture.bytes -= texture.levelBytes[mip];
+			m_residentBytes -= texture.levelBytes[mip];
+			texture.levelBytes[mip] = 0;
+		}
+	}
+
+	texture.resource->Release();
+	texture.resource = resized;
+	texture.residentMip = topMip;
+
+	if (*texture.textureView)
+		(*texture.textureView)->Release();
+	*texture.textureView = view;
+
+	return S_OK;
+}
+
+bool TextureResidency::MakeRoom(ID3D11Device* const device, ID3D11DeviceContext* const context, const size_t bytes, const Texture* const keep)
+{
+	while (m_residentBytes + bytes > m_budget)
+	{
+		Texture* const victim = PickVictim(keep);
+		if (!victim || FAILED(Resize(device, context, *victim, victim->residentMip + 1, nullptr)))
+			return false;
+
+		++m_stats.evictions;
+	}
+	return true;
+}
+
+TextureResidency::Texture* TextureResidency::PickVictim(const Texture* const keep)
+{
+	// Levels finer than a texture wants go first, largest first. After that only textures
+	// requested less recently than 'keep' give up levels, so two textures that are both
+	// in view do not take turns evicting each other.
+	Texture* surplus = nullptr;
+	Texture* stale = nullptr;
+	for (auto& texture : m_textures)
+	{
+		if (texture.get() == keep || texture->residentMip >= texture->tailMip)
+			continue;
+
+		const size_t topBytes = texture->levelBytes[texture->residentMip];
+		if (texture->residentMip < texture->wantedMip)
+		{
+			if (!surplus || topBytes > surplus->levelBytes[surplus->residentMip])
+				surplus = texture.get();
+		}
+		else if (!keep || texture->lastRequest < keep->lastRequest)
+		{
+			if (!stale || texture->lastRequest < stale->lastRequest ||
+			    (texture->lastRequest == stale->lastRequest && topBytes > stale->levelBytes[stale->residentMip]))
+			{
+				stale = texture.get();
+			}
+		}
+	}
+	return surplus ? surplus : stale;
+}
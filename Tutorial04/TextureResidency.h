@@ -0,0 +1,125 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+//--------------------------------------------------------------------------------------
+// Streams the mip levels of DDS textures in and out while the scene runs. Register creates
+// a texture from its mip tail only (the levels no larger than 'tailSize'), so start-up
+// reads a small fraction of each file. Every frame the renderer reports the finest level
+// it wants for each texture; Update then reads the next finer level on the pool and swaps
+// in a texture one level larger, copying the levels it already has on the GPU. When the
+// resident bytes would go over the budget, levels finer than wanted are dropped first,
+// then those of the textures requested least recently. Tails are never evicted.
+//
+// Resizing means a new resource, so the view written through 'textureView' changes; it
+// always carries one reference owned by the caller, and the old one is released when the
+// view is replaced. Everything but the reads runs on the thread that owns the device.
+//--------------------------------------------------------------------------------------
+class TextureResidency
+{
+public:
+	typedef size_t Handle;
+
+	struct Stats
+	{
+		size_t residentBytes;
+		size_t textures;
+		size_t reading;         // level reads currently on the pool
+		uint64_t uploads;       // levels streamed in
+		uint64_t evictions;     // levels dropped under pressure
+		uint64_t rejected;      // levels read but not uploaded because they did not fit
+	};
+
+	TextureResidency(ThreadPool& pool, size_t budgetBytes, size_t tailSize = 64, size_t maxReads = 2);
+	~TextureResidency();
+
+	TextureResidency(const TextureResidency&) = delete;
+	TextureResidency& operator=(const TextureResidency&) = delete;
+
+	// Reads the mip tail of a DDS file and creates the texture from it. Files that cannot be
+	// streamed (a single mip, or not 2D) are created whole and just keep their handle.
+	HRESULT Register(ID3D11Device* device, const wchar_t* fileName, ID3D11ShaderResourceView** textureView, Handle* handle);
+
+	// Feedback for the frame being drawn: 'lod' is the finest mip the texture is sampled
+	// at, 0 being the full-size level. The smallest value requested in a frame wins.
+	void RequestLod(Handle handle, float lod);
+
+	// The mip a texture covering about 'screenPixels' pixels across would be sampled at
+	float LodForScreenSize(Handle handle, float screenPixels) const;
+
+	// Once per frame: uploads the levels that have been read, evicts under pressure and
+	// starts reading the next levels that are wanted
+	void Update(ID3D11Device* device, ID3D11DeviceContext* context);
+
+	// Evicts straight away when the resident textures are already over the new budget
+	void SetBudget(ID3D11Device* device, ID3D11DeviceContext* context, size_t budgetBytes);
+	size_t Budget() const { return m_budget; }
+
+	size_t ResidentMip(Handle handle) const;
+	Stats GetStats() const;
+
+private:
+	struct Texture
+	{
+		std::wstring fileName;
+		ID3D11ShaderResourceView** textureView = nullptr;
+		ID3D11Resource* resource = nullptr;
+		D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+		size_t width = 0;
+		size_t height = 0;
+		size_t mipCount = 1;
+		size_t arraySize = 1;
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		bool isCubeMap = false;
+		bool streamable = false;
+
+		size_t tailMip = 0;             // coarsest top level; never evicted below this
+		size_t residentMip = 0;         // finest level currently in the texture
+		size_t wantedMip = 0;
+		std::vector<size_t> levelBytes; // bytes of each streamed level, all slices
+		size_t bytes = 0;               // of the whole resident texture
+
+		float requestedLod = 0.0f;      // smallest this frame
+		uint64_t lastRequest = 0;       // frame of the last RequestLod
+		uint64_t retryFrame = 0;        // a level that did not fit is not read again before this
+		bool reading = false;
+	};
+
+	struct Level
+	{
+		Handle handle;
+		size_t mip;
+		HRESULT hr;
+		std::unique_ptr<uint8_t[]> data;
+		size_t rowPitch;
+		size_t slicePitch;
+	};
+
+	void Read(Handle handle, const std::wstring& fileName, size_t mip);
+	HRESULT Resize(ID3D11Device* device, ID3D11DeviceContext* context, Texture& texture, size_t topMip, const Level* level);
+	bool MakeRoom(ID3D11Device* device, ID3D11DeviceContext* context, size_t bytes, const Texture* keep);
+	Texture* PickVictim(const Texture* keep);
+
+	ThreadPool& m_pool;
+	size_t m_budget;
+	const size_t m_tailSize;
+	const size_t m_maxReads;
+
+	std::vector<std::unique_ptr<Texture>> m_textures;
+	size_t m_residentBytes = 0;
+	uint64_t m_frame = 1;
+	Stats m_stats = {};
+
+	// shared with the readers
+	mutable std::mutex m_mutex;
+	std::condition_variable m_readDone;
+	std::vector<Level> m_levels;   // read and waiting for Update
+	size_t m_reading = 0;
+};
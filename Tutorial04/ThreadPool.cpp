@@ -0,0 +1,196 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+	{
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_threads.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; ++i)
+		m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_taskAdded.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_taskAdded.notify_one();
+}
+
+namespace
+{
+	struct StealRange
+	{
+		std::mutex mutex;
+		size_t begin = 0;
+		size_t end = 0;
+	};
+
+	// Shared with the helper tasks, which may only get to run after the loop is finished
+	struct ParallelForState
+	{
+		std::unique_ptr<StealRange[]> ranges;
+		unsigned int rangeCount = 0;
+		size_t grain = 1;
+		size_t remaining = 0;
+		const std::function<void(size_t, size_t)>* body = nullptr;
+
+		std::mutex doneMutex;
+		std::condition_variable done;
+
+		// Takes the next chunk off the front of our own range, or steals the back half of
+		// the largest other range. Returns false once there is nothing left anywhere.
+		bool Next(const unsigned int self, size_t& begin, size_t& end)
+		{
+			{
+				StealRange& own = ranges[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (own.begin < own.end)
+				{
+					begin = own.begin;
+					end = std::min(own.end, own.begin + grain);
+					own.begin = end;
+					return true;
+				}
+			}
+
+			for (;;)
+			{
+				unsigned int victim = rangeCount;
+				size_t largest = 0;
+				for (unsigned int i = 0; i < rangeCount; ++i)
+				{
+					if (i == self)
+						continue;
+
+					std::lock_guard<std::mutex> lock(ranges[i].mutex);
+					const size_t left = ranges[i].end - ranges[i].begin;
+					if (left > largest)
+					{
+						largest = left;
+						victim = i;
+					}
+				}
+
+				if (victim == rangeCount)
+					return false;
+
+				size_t stolenBegin;
+				size_t stolenEnd;
+				{
+					StealRange& range = ranges[victim];
+					std::lock_guard<std::mutex> lock(range.mutex);
+					const size_t left = range.end - range.begin;
+					if (left == 0)
+						continue;   // drained while we were looking, pick again
+
+					stolenEnd = range.end;
+					stolenBegin = left > grain ? range.end - left / 2 : range.begin;
+					range.end = stolenBegin;
+				}
+
+				// Keep the first chunk, park the rest in our own range for others to steal back
+				begin = stolenBegin;
+				end = std::min(stolenEnd, stolenBegin + grain);
+
+				StealRange& own = ranges[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				own.begin = end;
+				own.end = stolenEnd;
+				return true;
+			}
+		}
+
+		void Run(const unsigned int self)
+		{
+			size_t begin;
+			size_t end;
+			while (Next(self, begin, end))
+			{
+				(*body)(begin, end);
+
+				std::lock_guard<std::mutex> lock(doneMutex);
+				remaining -= end - begin;
+				if (remaining == 0)
+					done.notify_all();
+			}
+		}
+	};
+}
+
+void ThreadPool::ParallelFor(const size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body)
+{
+	if (count == 0)
+		return;
+
+	grain = std::max<size_t>(grain, 1);
+	const size_t chunks = (count + grain - 1) / grain;
+	const unsigned int participants = static_cast<unsigned int>(std::min<size_t>(chunks, m_threads.size() + 1));
+	if (participants <= 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+	state->ranges.reset(new StealRange[participants]);
+	state->rangeCount = participants;
+	state->grain = grain;
+	state->remaining = count;
+	state->body = &body;
+
+	for (unsigned int i = 0; i < participants; ++i)
+	{
+		state->ranges[i].begin = count * i / participants;
+		state->ranges[i].end = count * (i + 1) / participants;
+	}
+
+	for (unsigned int i = 1; i < participants; ++i)
+		Submit([state, i] { state->Run(i); });
+
+	// The caller works too, and only waits for chunks that are still running elsewhere
+	state->Run(0);
+
+	std::unique_lock<std::mutex> lock(state->doneMutex);
+	state->done.wait(lock, [&state] { return state->remaining == 0; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAdded.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+			// Drain whatever is left before exiting
+			if (m_tasks.empty())
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// Fixed set of worker threads pulling tasks from a shared FIFO. Tasks still queued when
+// the pool is destroyed are run before the workers are joined.
+//--------------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+	// 0 picks one thread per hardware thread, leaving one for the render thread
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> task);
+
+	// Runs body over [0, count) in chunks of at most 'grain' items and returns when all
+	// of them are done. The range is split evenly between the calling thread and the
+	// workers; anyone who runs out steals half of what is left of the fullest range, so
+	// blocks that take longer than others do not leave threads idle.
+	void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+	unsigned int ThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_taskAdded;
+	std::deque<std::function<void()>> m_tasks;
+	bool m_stopping = false;
+};
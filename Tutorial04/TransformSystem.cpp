@@ -0,0 +1,296 @@
+#include "TransformSystem.h"
+#include "ThreadPool.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define TRANSFORM_SYSTEM_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Batches of four per pool task when composing, and transforms per task when
+	// multiplying one depth by its parents; below two of these the pool is not worth waking
+	const size_t BATCH_GRAIN = 1024;
+	const size_t CHILD_GRAIN = 4096;
+
+	const size_t BATCH = 4;
+
+#ifndef TRANSFORM_SYSTEM_SSE2
+	// The local matrix of one transform the way the batches build it, for the platforms
+	// without SSE2
+	void ComposeOne(const float p[3], const float q[4], const float s[3], XMFLOAT4X4* const out)
+	{
+		const float x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+		const float xx = q[0] * x2, yy = q[1] * y2, zz = q[2] * z2;
+		const float xy = q[0] * y2, xz = q[0] * z2, yz = q[1] * z2;
+		const float wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+
+		const float rows[4][4] =
+		{
+			{ (1.0f - yy - zz) * s[0], (xy + wz) * s[0], (xz - wy) * s[0], 0.0f },
+			{ (xy - wz) * s[1], (1.0f - xx - zz) * s[1], (yz + wx) * s[1], 0.0f },
+			{ (xz + wy) * s[2], (yz - wx) * s[2], (1.0f - xx - yy) * s[2], 0.0f },
+			{ p[0], p[1], p[2], 1.0f },
+		};
+		memcpy(out->m, rows, sizeof(rows));
+	}
+#endif
+}
+
+void TransformSystem::Clear()
+{
+	for (std::vector<float>* const component : { &m_px, &m_py, &m_pz, &m_qx, &m_qy, &m_qz, &m_qw, &m_sx, &m_sy, &m_sz })
+		component->clear();
+	m_parents.clear();
+	m_depths.clear();
+	m_dirty.clear();
+	m_batchDirty.clear();
+	m_locals.clear();
+	m_worlds.clear();
+	m_levelOrder.clear();
+	m_levelStarts.clear();
+	m_levelsStale = false;
+	m_dirtyCount = 0;
+}
+
+void TransformSystem::Reserve(const size_t count)
+{
+	const size_t padded = (count + BATCH - 1) / BATCH * BATCH;
+	for (std::vector<float>* const component : { &m_px, &m_py, &m_pz, &m_qx, &m_qy, &m_qz, &m_qw, &m_sx, &m_sy, &m_sz })
+		component->reserve(padded);
+	m_parents.reserve(count);
+	m_depths.reserve(count);
+	m_dirty.reserve(count);
+	m_batchDirty.reserve(padded / BATCH);
+	m_locals.reserve(count);
+	m_worlds.reserve(count);
+}
+
+uint32_t TransformSystem::Add(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale, const uint32_t parent)
+{
+	const size_t index = Count();
+	if ((parent != NO_PARENT && parent >= index) || index >= NO_PARENT)
+		return NO_PARENT;
+
+	// Start a new batch of identities, so the loads past the last transform read sane values
+	if (index % BATCH == 0)
+	{
+		for (std::vector<float>* const component : { &m_px, &m_py, &m_pz, &m_qx, &m_qy, &m_qz })
+			component->resize(index + BATCH, 0.0f);
+		for (std::vector<float>* const component : { &m_qw, &m_sx, &m_sy, &m_sz })
+			component->resize(index + BATCH, 1.0f);
+		m_batchDirty.push_back(0);
+	}
+
+	m_px[index] = position.x;
+	m_py[index] = position.y;
+	m_pz[index] = position.z;
+	m_qx[index] = rotation.x;
+	m_qy[index] = rotation.y;
+	m_qz[index] = rotation.z;
+	m_qw[index] = rotation.w;
+	m_sx[index] = scale.x;
+	m_sy[index] = scale.y;
+	m_sz[index] = scale.z;
+	m_parents.push_back(parent);
+	m_depths.push_back(parent == NO_PARENT ? 0 : m_depths[parent] + 1);
+	m_dirty.push_back(0);
+	m_locals.push_back(XMFLOAT4X4());
+	m_worlds.push_back(XMFLOAT4X4());
+	m_levelsStale |= parent != NO_PARENT;
+
+	MarkDirty(static_cast<uint32_t>(index));
+	return static_cast<uint32_t>(index);
+}
+
+void TransformSystem::MarkDirty(const uint32_t index)
+{
+	if (!m_dirty[index])
+	{
+		m_dirty[index] = 1;
+		++m_dirtyCount;
+	}
+	m_batchDirty[index / BATCH] = 1;
+}
+
+void TransformSystem::SetPosition(const uint32_t index, const XMFLOAT3& position)
+{
+	m_px[index] = position.x;
+	m_py[index] = position.y;
+	m_pz[index] = position.z;
+	MarkDirty(index);
+}
+
+void TransformSystem::SetRotation(const uint32_t index, const XMFLOAT4& rotation)
+{
+	m_qx[index] = rotation.x;
+	m_qy[index] = rotation.y;
+	m_qz[index] = rotation.z;
+	m_qw[index] = rotation.w;
+	MarkDirty(index);
+}
+
+void TransformSystem::SetScale(const uint32_t index, const XMFLOAT3& scale)
+{
+	m_sx[index] = scale.x;
+	m_sy[index] = scale.y;
+	m_sz[index] = scale.z;
+	MarkDirty(index);
+}
+
+void TransformSystem::BuildLevels()
+{
+	uint32_t maxDepth = 0;
+	for (const uint32_t depth : m_depths)
+		maxDepth = depth > maxDepth ? depth : maxDepth;
+
+	// Counting sort of the transforms with a parent by depth, which keeps index order
+	// within each depth
+	m_levelStarts.assign(maxDepth + 1, 0);
+	for (const uint32_t depth : m_depths)
+	{
+		if (depth)
+			++m_levelStarts[depth];
+	}
+	size_t start = 0;
+	for (uint32_t depth = 1; depth <= maxDepth; ++depth)
+	{
+		const size_t count = m_levelStarts[depth];
+		m_levelStarts[depth - 1] = start;
+		start += count;
+	}
+	m_levelStarts[maxDepth] = start;
+
+	m_levelOrder.resize(start);
+	std::vector<size_t> next(m_levelStarts.begin(), m_levelStarts.end() - 1);
+	for (size_t i = 0; i < m_depths.size(); ++i)
+	{
+		if (m_depths[i])
+			m_levelOrder[next[m_depths[i] - 1]++] = static_cast<uint32_t>(i);
+	}
+	m_levelsStale = false;
+}
+
+void TransformSystem::ComposeLocals(const size_t beginBatch, const size_t endBatch)
+{
+	const size_t count = Count();
+	for (size_t batch = beginBatch; batch < endBatch; ++batch)
+	{
+		if (!m_batchDirty[batch])
+			continue;
+
+		// A whole batch is composed when any of it is dirty; the others come out as they were
+		const size_t base = batch * BATCH;
+		const size_t valid = count - base < BATCH ? count - base : BATCH;
+
+#ifdef TRANSFORM_SYSTEM_SSE2
+		const __m128 x = _mm_loadu_ps(&m_qx[base]);
+		const __m128 y = _mm_loadu_ps(&m_qy[base]);
+		const __m128 z = _mm_loadu_ps(&m_qz[base]);
+		const __m128 w = _mm_loadu_ps(&m_qw[base]);
+		const __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+		const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+		const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+		const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		const __m128 sx = _mm_loadu_ps(&m_sx[base]);
+		const __m128 sy = _mm_loadu_ps(&m_sy[base]);
+		const __m128 sz = _mm_loadu_ps(&m_sz[base]);
+
+		// Each row across the four transforms, then turned into each transform's row
+		__m128 rows[4][4] =
+		{
+			{ _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx), _mm_mul_ps(_mm_add_ps(xy, wz), sx), _mm_mul_ps(_mm_sub_ps(xz, wy), sx), zero },
+			{ _mm_mul_ps(_mm_sub_ps(xy, wz), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy), _mm_mul_ps(_mm_add_ps(yz, wx), sy), zero },
+			{ _mm_mul_ps(_mm_add_ps(xz, wy), sz), _mm_mul_ps(_mm_sub_ps(yz, wx), sz), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz), zero },
+			{ _mm_loadu_ps(&m_px[base]), _mm_loadu_ps(&m_py[base]), _mm_loadu_ps(&m_pz[base]), one },
+		};
+		for (__m128 (&row)[4] : rows)
+			_MM_TRANSPOSE4_PS(row[0], row[1], row[2], row[3]);
+
+		for (size_t k = 0; k < valid; ++k)
+		{
+			const size_t index = base + k;
+			XMFLOAT4X4& out = m_parents[index] == NO_PARENT ? m_worlds[index] : m_locals[index];
+			for (size_t row = 0; row < 4; ++row)
+				_mm_storeu_ps(out.m[row], rows[row][k]);
+		}
+#else
+		for (size_t index = base; index < base + valid; ++index)
+		{
+			const float p[3] = { m_px[index], m_py[index], m_pz[index] };
+			const float q[4] = { m_qx[index], m_qy[index], m_qz[index], m_qw[index] };
+			const float s[3] = { m_sx[index], m_sy[index], m_sz[index] };
+			ComposeOne(p, q, s, m_parents[index] == NO_PARENT ? &m_worlds[index] : &m_locals[index]);
+		}
+#endif
+	}
+}
+
+size_t TransformSystem::Update(ThreadPool* const pool)
+{
+	if (!m_dirtyCount)
+		return 0;
+	if (m_levelsStale)
+		BuildLevels();
+
+	// Whatever hangs under a dirty transform is dirty too; parents come first in index order
+	size_t updated = 0;
+	for (size_t i = 0; i < m_parents.size(); ++i)
+	{
+		if (!m_dirty[i] && m_parents[i] != NO_PARENT && m_dirty[m_parents[i]])
+		{
+			m_dirty[i] = 1;
+			m_batchDirty[i / BATCH] = 1;
+		}
+		updated += m_dirty[i];
+	}
+
+	const size_t batchCount = m_batchDirty.size();
+	if (pool && batchCount >= 2 * BATCH_GRAIN)
+		pool->ParallelFor(batchCount, BATCH_GRAIN, [this](const size_t begin, const size_t end) { ComposeLocals(begin, end); });
+	else
+		ComposeLocals(0, batchCount);
+
+	// Then each depth from its parents' finished world matrices
+	for (size_t level = 0; level + 1 < m_levelStarts.size(); ++level)
+	{
+		const uint32_t* const order = m_levelOrder.data() + m_levelStarts[level];
+		const size_t count = m_levelStarts[level + 1] - m_levelStarts[level];
+		const auto multiply = [&](const size_t begin, const size_t end)
+		{
+			for (size_t k = begin; k < end; ++k)
+			{
+				const uint32_t index = order[k];
+				if (m_dirty[index])
+				{
+					const XMMATRIX world = XMMatrixMultiply(XMLoadFloat4x4(&m_locals[index]), XMLoadFloat4x4(&m_worlds[m_parents[index]]));
+					XMStoreFloat4x4(&m_worlds[index], world);
+				}
+			}
+		};
+		if (pool && count >= 2 * CHILD_GRAIN)
+			pool->ParallelFor(count, CHILD_GRAIN, multiply);
+		else
+			multiply(0, count);
+	}
+
+	memset(m_dirty.data(), 0, m_dirty.size());
+	memset(m_batchDirty.data(), 0, m_batchDirty.size());
+	m_dirtyCount = 0;
+	return updated;
+}
+
+XMFLOAT4 TransformSystem::RotationFromEuler(const XMFLOAT3& radians)
+{
+	// XMQuaternionMultiply(a, b) rotates by a, then b, as a * b does for matrices
+	const XMVECTOR x = XMQuaternionRotationNormal(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), radians.x);
+	const XMVECTOR y = XMQuaternionRotationNormal(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), radians.y);
+	const XMVECTOR z = XMQuaternionRotationNormal(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), radians.z);
+	XMFLOAT4 rotation;
+	XMStoreFloat4(&rotation, XMQuaternionMultiply(XMQuaternionMultiply(x, y), z));
+	return rotation;
+}
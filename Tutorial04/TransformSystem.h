@@ -0,0 +1,83 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "SimpleVertex.h"
+
+class ThreadPool;
+
+//--------------------------------------------------------------------------------------
+// Positions, rotations (unit quaternions), scales and parents of many transforms, each
+// component in an array of its own, and the world matrices Update builds from them.
+//
+// A transform's local matrix is scale * rotation * translation, as XMMatrixScaling,
+// XMMatrixRotationQuaternion and XMMatrixTranslation would build it, and its world matrix
+// is that times its parent's world matrix. Parents are added before their children, so
+// index order is always a topological order.
+//
+// Update only rebuilds what the setters touched since the last one, and the descendants
+// of those. Local matrices are composed four transforms at a time with SSE2, straight
+// from the component arrays, over the pool for large counts. Children are then multiplied
+// by their parents one depth at a time, each depth over the pool, since everything at one
+// depth only reads the depth above.
+//--------------------------------------------------------------------------------------
+class TransformSystem
+{
+public:
+	static const uint32_t NO_PARENT = UINT32_MAX;
+
+	TransformSystem() = default;
+
+	TransformSystem(const TransformSystem&) = delete;
+	TransformSystem& operator=(const TransformSystem&) = delete;
+
+	void Clear();
+	void Reserve(size_t count);
+
+	// The new transform's index, or NO_PARENT when 'parent' is not an earlier transform
+	uint32_t Add(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale, uint32_t parent = NO_PARENT);
+
+	size_t Count() const { return m_parents.size(); }
+
+	void SetPosition(uint32_t index, const XMFLOAT3& position);
+	void SetRotation(uint32_t index, const XMFLOAT4& rotation);
+	void SetScale(uint32_t index, const XMFLOAT3& scale);
+
+	XMFLOAT3 Position(const uint32_t index) const { return XMFLOAT3(m_px[index], m_py[index], m_pz[index]); }
+	XMFLOAT4 Rotation(const uint32_t index) const { return XMFLOAT4(m_qx[index], m_qy[index], m_qz[index], m_qw[index]); }
+	XMFLOAT3 Scale(const uint32_t index) const { return XMFLOAT3(m_sx[index], m_sy[index], m_sz[index]); }
+	uint32_t Parent(const uint32_t index) const { return m_parents[index]; }
+
+	// Rebuilds the world matrices that changed and returns how many that was
+	size_t Update(ThreadPool* pool = nullptr);
+
+	// As of the last Update
+	const XMFLOAT4X4* Worlds() const { return m_worlds.data(); }
+
+	// The quaternion of XMMatrixRotationX(x) * XMMatrixRotationY(y) * XMMatrixRotationZ(z)
+	static XMFLOAT4 RotationFromEuler(const XMFLOAT3& radians);
+
+private:
+	void MarkDirty(uint32_t index);
+	void ComposeLocals(size_t beginBatch, size_t endBatch);
+	void BuildLevels();
+
+	// Padded with identity transforms to a multiple of four, so batches load whole
+	std::vector<float> m_px, m_py, m_pz;
+	std::vector<float> m_qx, m_qy, m_qz, m_qw;
+	std::vector<float> m_sx, m_sy, m_sz;
+
+	std::vector<uint32_t> m_parents;
+	std::vector<uint32_t> m_depths;
+	std::vector<uint8_t> m_dirty;             // set by the setters; everything under it is rebuilt
+	std::vector<uint8_t> m_batchDirty;        // one per four transforms
+	std::vector<XMFLOAT4X4> m_locals;         // only kept for transforms with a parent
+	std::vector<XMFLOAT4X4> m_worlds;
+
+	// Transforms with a parent, shallowest first, and where each depth starts among them
+	std::vector<uint32_t> m_levelOrder;
+	std::vector<size_t> m_levelStarts;
+	bool m_levelsStale = false;
+	size_t m_dirtyCount = 0;
+};
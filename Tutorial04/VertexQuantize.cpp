@@ -0,0 +1,221 @@
+#include "VertexQuantize.h"
+#include <DirectXPackedVector.h>
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <algorithm>
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	const D3D11_INPUT_ELEMENT_DESC s_compactLayout[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(CompactVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(CompactVertex, normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(CompactVertex, tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offsetof(CompactVertex, texCoord), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+
+	float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	XMFLOAT3 Normalize(const XMFLOAT3& v)
+	{
+		const float length = sqrtf(Dot(v, v));
+		return length > 0.0f ? XMFLOAT3(v.x / length, v.y / length, v.z / length) : XMFLOAT3(0.0f, 0.0f, 1.0f);
+	}
+
+	// Angle between two directions of any length, in degrees. acos of the dot product
+	// cannot resolve the hundredths of a degree the encoding is accurate to.
+	float AngleBetween(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		const XMFLOAT3 cross = Cross(a, b);
+		return atan2f(sqrtf(Dot(cross, cross)), Dot(a, b)) * (180.0f / 3.14159265f);
+	}
+
+	float DistanceSquared(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		const XMFLOAT3 offset(a.x - b.x, a.y - b.y, a.z - b.z);
+		return Dot(offset, offset);
+	}
+
+	// SNORM as the input assembler reads it: -32768 and -32767 both mean -1
+	float SnormToFloat(const int16_t value)
+	{
+		return std::max(value / 32767.0f, -1.0f);
+	}
+
+	XMFLOAT3 OctDecode(const int16_t (&encoded)[2])
+	{
+		XMFLOAT3 v(SnormToFloat(encoded[0]), SnormToFloat(encoded[1]), 0.0f);
+		v.z = 1.0f - fabsf(v.x) - fabsf(v.y);
+		const float fold = std::max(-v.z, 0.0f);
+		v.x += v.x >= 0.0f ? -fold : fold;
+		v.y += v.y >= 0.0f ? -fold : fold;
+		return Normalize(v);
+	}
+
+	// Projects onto the octahedron, unfolds the lower half over the upper, then keeps
+	// whichever of the four nearest SNORM pairs decodes closest to the direction
+	void OctEncode(const XMFLOAT3& direction, int16_t (&encoded)[2])
+	{
+		const float sum = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+		if (sum <= 0.0f)
+		{
+			encoded[0] = encoded[1] = 0;
+			return;
+		}
+
+		float u = direction.x / sum;
+		float v = direction.y / sum;
+		if (direction.z < 0.0f)
+		{
+			const float foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+			const float foldedV = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+			u = foldedU;
+			v = foldedV;
+		}
+
+		const XMFLOAT3 target = Normalize(direction);
+		const float baseU = floorf(u * 32767.0f);
+		const float baseV = floorf(v * 32767.0f);
+		float best = FLT_MAX;
+		for (int i = 0; i < 4; ++i)
+		{
+			const int16_t candidate[2] =
+			{
+				static_cast<int16_t>(std::min(std::max(baseU + (i & 1), -32767.0f), 32767.0f)),
+				static_cast<int16_t>(std::min(std::max(baseV + (i >> 1), -32767.0f), 32767.0f)),
+			};
+			const float distance = DistanceSquared(OctDecode(candidate), target);
+			if (distance < best)
+			{
+				best = distance;
+				encoded[0] = candidate[0];
+				encoded[1] = candidate[1];
+			}
+		}
+	}
+
+	uint16_t ToUnorm16(const float value)
+	{
+		return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+	}
+}
+
+const D3D11_INPUT_ELEMENT_DESC* CompactVertexLayout(UINT* const elementCount)
+{
+	if (elementCount)
+		*elementCount = ARRAYSIZE(s_compactLayout);
+	return s_compactLayout;
+}
+
+VERTEX_QUANTIZATION ComputeVertexQuantization(const SimpleVertex* const vertices, const size_t vertexCount)
+{
+	float boundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const float position[3] = { vertices[i].Pos.x, vertices[i].Pos.y, vertices[i].Pos.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			boundsMin[axis] = std::min(boundsMin[axis], position[axis]);
+			boundsMax[axis] = std::max(boundsMax[axis], position[axis]);
+		}
+	}
+
+	VERTEX_QUANTIZATION quantization = {};
+	for (int axis = 0; axis < 3 && vertexCount; ++axis)
+	{
+		quantization.offset[axis] = boundsMin[axis];
+		quantization.scale[axis] = boundsMax[axis] - boundsMin[axis];
+	}
+	return quantization;
+}
+
+void QuantizeVertices(const SimpleVertex* const vertices, const size_t vertexCount, const VERTEX_QUANTIZATION& quantization,
+                      CompactVertex* const compact)
+{
+	// A flat axis stores zeros, which decode to the offset whatever the scale
+	float inverseScale[3];
+	for (int axis = 0; axis < 3; ++axis)
+		inverseScale[axis] = quantization.scale[axis] > 0.0f ? 1.0f / quantization.scale[axis] : 0.0f;
+
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const SimpleVertex& vertex = vertices[i];
+		CompactVertex& out = compact[i];
+
+		const float position[3] = { vertex.Pos.x, vertex.Pos.y, vertex.Pos.z };
+		for (int axis = 0; axis < 3; ++axis)
+			out.position[axis] = ToUnorm16((position[axis] - quantization.offset[axis]) * inverseScale[axis]);
+
+		// Which way the bitangent points along cross(normal, tangent); zero counts as +1
+		out.position[3] = Dot(Cross(vertex.Normal, vertex.Tangent), vertex.BiNormal) < 0.0f ? 0 : 0xFFFF;
+
+		OctEncode(vertex.Normal, out.normal);
+		OctEncode(vertex.Tangent, out.tangent);
+
+		out.texCoord[0] = XMConvertFloatToHalf(vertex.TexCoord.x);
+		out.texCoord[1] = XMConvertFloatToHalf(vertex.TexCoord.y);
+	}
+}
+
+void DequantizeVertices(const CompactVertex* const compact, const size_t vertexCount, const VERTEX_QUANTIZATION& quantization,
+                        SimpleVertex* const vertices)
+{
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const CompactVertex& in = compact[i];
+		SimpleVertex& vertex = vertices[i];
+
+		vertex.Pos.x = quantization.offset[0] + in.position[0] / 65535.0f * quantization.scale[0];
+		vertex.Pos.y = quantization.offset[1] + in.position[1] / 65535.0f * quantization.scale[1];
+		vertex.Pos.z = quantization.offset[2] + in.position[2] / 65535.0f * quantization.scale[2];
+
+		vertex.Normal = OctDecode(in.normal);
+		vertex.Tangent = OctDecode(in.tangent);
+
+		const XMFLOAT3 bitangent = Normalize(Cross(vertex.Normal, vertex.Tangent));
+		const float sign = in.position[3] ? 1.0f : -1.0f;
+		vertex.BiNormal = XMFLOAT3(bitangent.x * sign, bitangent.y * sign, bitangent.z * sign);
+
+		vertex.TexCoord.x = XMConvertHalfToFloat(in.texCoord[0]);
+		vertex.TexCoord.y = XMConvertHalfToFloat(in.texCoord[1]);
+	}
+}
+
+VERTEX_QUANTIZATION_ERROR MeasureQuantizationError(const SimpleVertex* const vertices, const CompactVertex* const compact,
+                                                   const size_t vertexCount, const VERTEX_QUANTIZATION& quantization)
+{
+	VERTEX_QUANTIZATION_ERROR error = {};
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		SimpleVertex decoded;
+		DequantizeVertices(compact + i, 1, quantization, &decoded);
+
+		const SimpleVertex& vertex = vertices[i];
+		error.position = std::max(error.position, sqrtf(DistanceSquared(decoded.Pos, vertex.Pos)));
+
+		// Missing directions come out of the importer as zeros and decode to +z; there is
+		// nothing to compare them with
+		if (Dot(vertex.Normal, vertex.Normal) > 0.0f)
+			error.normal = std::max(error.normal, AngleBetween(decoded.Normal, vertex.Normal));
+		if (Dot(vertex.Tangent, vertex.Tangent) > 0.0f)
+			error.tangent = std::max(error.tangent, AngleBetween(decoded.Tangent, vertex.Tangent));
+		if (Dot(vertex.BiNormal, vertex.BiNormal) > 0.0f)
+			error.bitangent = std::max(error.bitangent, AngleBetween(decoded.BiNormal, vertex.BiNormal));
+
+		error.texCoord = std::max(error.texCoord, std::max(fabsf(decoded.TexCoord.x - vertex.TexCoord.x),
+		                                                   fabsf(decoded.TexCoord.y - vertex.TexCoord.y)));
+	}
+	return error;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <d3d11_1.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SimpleVertex.h"
+
+//--------------------------------------------------------------------------------------
+// A 20-byte alternative to the 56-byte SimpleVertex:
+//
+//   position    R16G16B16A16_UNORM  xyz across the mesh bounds; w is the bitangent sign,
+//                                   0 for -1 and 1 for +1
+//   normal      R16G16_SNORM        octahedral
+//   tangent     R16G16_SNORM        octahedral
+//   texCoord    R16G16_FLOAT
+//
+// The bitangent is not stored; it is cross(normal, tangent) times the sign. Positions
+// need the mesh's VERTEX_QUANTIZATION to decode, which SphereCompactVertex.hlsl reads
+// from a constant buffer in b1.
+//--------------------------------------------------------------------------------------
+struct CompactVertex
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t texCoord[2];
+};
+
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex is expected to be 20 tightly packed bytes");
+
+// Decoded position = offset + unorm * scale. Laid out to go into a constant buffer as is.
+struct VERTEX_QUANTIZATION
+{
+	float offset[4];
+	float scale[4];
+};
+
+// Largest difference between a vertex and its decoded CompactVertex over a mesh
+struct VERTEX_QUANTIZATION_ERROR
+{
+	float position;        // distance, in model units
+	float normal;          // angle, in degrees
+	float tangent;         // angle, in degrees
+	float bitangent;       // angle, in degrees; includes how far the source was from
+	                       // perpendicular to the normal and tangent, which is not kept
+	float texCoord;        // per coordinate
+};
+
+// Input layout matching CompactVertex, for the vertex shader input in SphereCompactVertex.hlsl
+const D3D11_INPUT_ELEMENT_DESC* CompactVertexLayout(UINT* elementCount);
+
+// Quantization spanning the bounds of the vertices
+VERTEX_QUANTIZATION ComputeVertexQuantization(const SimpleVertex* vertices, size_t vertexCount);
+
+void QuantizeVertices(const SimpleVertex* vertices, size_t vertexCount, const VERTEX_QUANTIZATION& quantization, CompactVertex* compact);
+
+// Decodes as the shader does, with the normal, tangent and bitangent normalized
+void DequantizeVertices(const CompactVertex* compact, size_t vertexCount, const VERTEX_QUANTIZATION& quantization, SimpleVertex* vertices);
+
+VERTEX_QUANTIZATION_ERROR MeasureQuantizationError(const SimpleVertex* vertices, const CompactVertex* compact, size_t vertexCount,
+                                                   const VERTEX_QUANTIZATION& quantization);